@@ -0,0 +1,57 @@
+#ifndef ADAPTIVE_POLLER_H
+#define ADAPTIVE_POLLER_H
+
+#include <cstdint>
+
+// Межі інтервалу опитування статусу. Максимум зберігається в NVS під старим
+// ключем update_interval (колишній фіксований інтервал), мінімум - poll_min
+static constexpr unsigned long POLL_MIN_DEFAULT_MS = 3000;
+static constexpr unsigned long POLL_MAX_DEFAULT_MS = 20000; // Як колишній фіксований інтервал
+static constexpr unsigned long POLL_MIN_LIMIT_MS = 2000;   // Нижче - Bluetti не встигає
+static constexpr unsigned long POLL_MAX_LIMIT_MS = 300000;
+
+// Стрибок, який вважається зміною навантаження
+static constexpr int POLL_POWER_DELTA_W = 30;
+static constexpr uint8_t POLL_SOC_DELTA = 2; // 1% - звичайний крок заряду між опитуваннями
+
+// Показники, за якими визначається перехідний процес
+struct PollSample {
+    uint8_t batteryLevel;
+    int acPower;
+    int dcPower;
+    int inputPower;
+};
+
+// Адаптивний інтервал опитування: стрибок потужності або SoC - одразу
+// мінімальний інтервал, кожне стабільне опитування - інтервал ×2 до максимуму.
+// Лише BLE worker.
+class AdaptivePoller {
+public:
+    void setBounds(unsigned long minMs, unsigned long maxMs);
+
+    // Новий блок статусу: повертає true, якщо це перехідний процес
+    bool observe(const PollSample& sample, unsigned long now);
+    // Команда користувача змінить показники - перевіряємо результат швидко
+    void speedUp() { current = minMs; }
+    // Нове з'єднання: перше порівняння нема з чим робити
+    void reset();
+
+    unsigned long interval() const { return current; }
+    unsigned long getMinMs() const { return minMs; }
+    unsigned long getMaxMs() const { return maxMs; }
+    // Фактична частота: середній проміжок між блоками статусу
+    unsigned long getAverageGapMs() const { return averageGapMs; }
+    uint32_t getTransients() const { return transients; }
+
+private:
+    unsigned long minMs = POLL_MIN_DEFAULT_MS;
+    unsigned long maxMs = POLL_MAX_DEFAULT_MS;
+    unsigned long current = POLL_MIN_DEFAULT_MS;
+    PollSample last = {};
+    bool hasLast = false;
+    unsigned long lastSampleAt = 0;
+    unsigned long averageGapMs = 0;
+    uint32_t transients = 0;
+};
+
+#endif
@@ -0,0 +1,57 @@
+#ifndef ADVERTISEMENT_CACHE_H
+#define ADVERTISEMENT_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "seqlock.h"
+
+static constexpr size_t ADVERTISEMENT_CACHE_SIZE = 8;
+// Пристрій, побачений не давніше, вважається доступним - підключаємося без сканування
+static constexpr unsigned long ADVERTISEMENT_FRESH_MS = 10000;
+
+struct AdvertisementEntry {
+    uint8_t address[6];   // NimBLEAddress::getNative()
+    int8_t rssi;
+    bool bluettiService;  // Рекламує сервіс 0xFF00
+    unsigned long lastSeen;
+};
+
+struct AdvertisementTable {
+    AdvertisementEntry entries[ADVERTISEMENT_CACHE_SIZE];
+    uint8_t count;
+};
+
+// Останні advertisement пристроїв Bluetti. Пише лише NimBLE host task
+// (callback сканування), читає BLE worker - через SeqLock, без блокувань.
+class AdvertisementCache {
+public:
+    // Лише NimBLE host task. Новий пристрій при повній таблиці витісняє найстаріший
+    void record(const uint8_t* address, int rssi, bool bluettiService, unsigned long now);
+    // Будь-яка задача
+    bool lookup(const uint8_t* address, AdvertisementEntry& out) const;
+    uint32_t getRecorded() const { return recorded.load(std::memory_order_relaxed); }
+
+private:
+    AdvertisementTable working = {};    // Лише host task
+    SeqLock<AdvertisementTable> published;
+    std::atomic<uint32_t> recorded{0};
+};
+
+// Медіана останніх вимірів часу підключення (мс)
+class ConnectTimeWindow {
+public:
+    static constexpr size_t SIZE = 8;
+
+    void add(unsigned long ms);
+    unsigned long median() const; // 0 - вимірів ще немає
+    uint32_t samples() const { return total; }
+
+private:
+    unsigned long values[SIZE] = {};
+    uint8_t next = 0;
+    uint8_t filled = 0;
+    uint32_t total = 0;
+};
+
+#endif
@@ -3,30 +3,200 @@
 
 #include <Arduino.h>
 #include <NimBLEDevice.h>
+#include <atomic>
+#include "adaptive_poller.h"
+#include "advertisement_cache.h"
+#include "burst_telemetry.h"
+#include "device_profile.h"
+#include "gatt_cache.h"
+#include "link_state.h"
+#include "lockfree_queue.h"
+#include "modbus_transaction.h"
+#include "notification_reassembler.h"
+#include "radio_scheduler.h"
+#include "register_cache.h"
+#include "register_capabilities.h"
+#include "seqlock.h"
+#include "status_pages.h"
 #include "system_status.h"
 
 static constexpr char BLUETTI_SERVICE_UUID[] = "0000ff00-0000-1000-8000-00805f9b34fb";
 static constexpr char BLUETTI_NOTIFY_UUID[]  = "0000ff01-0000-1000-8000-00805f9b34fb";
 static constexpr char BLUETTI_WRITE_UUID[]   = "0000ff02-0000-1000-8000-00805f9b34fb";
 
+// ATT MTU: запитуємо максимум, EB3A погоджує найбільше, що підтримує
+static constexpr uint16_t BLUETTI_PREFERRED_MTU = 517;
+static constexpr uint16_t BLE_DEFAULT_MTU = 23;
+// Найбільший payload notification при BLUETTI_PREFERRED_MTU (ATT header = 3 байти)
+static constexpr size_t BLE_FRAGMENT_MAX = BLUETTI_PREFERRED_MTU - 3;
+
+// Сирий фрагмент notification: NimBLE host task -> BLE worker
+struct BleFragment {
+    uint16_t length;
+    unsigned long receivedAt;
+    uint8_t data[BLE_FRAGMENT_MAX];
+};
+
+// Команда від loop/AsyncTCP для BLE worker (виконується в порядку надходження)
+enum class BluettiCommandType : uint8_t {
+    AC_OUTPUT = 0,
+    DC_OUTPUT,
+    CHARGING_SPEED,
+    ECO_MODE,
+    POWER_LIFTING,
+    LED_MODE,
+    ECO_SHUTDOWN, // Усе до ECO_SHUTDOWN включно - записи налаштувань
+    POWER_OFF,
+    DISCONNECT,
+    BURST,       // value = тривалість у секундах, 0 - зупинити
+    RESET_CAPABILITIES,
+    REFRESH_REGISTERS, // value = маска RegisterBlock
+    READ_REGISTER,     // value = адреса поза відомими блоками
+};
+
+// Блоки, які оновлюються одним запитом (або об'єднаними діапазонами)
+enum class RegisterBlock : uint8_t {
+    STATUS = 1 << 0,
+    FEATURES = 1 << 1,
+};
+
+// Номер запису для зіставлення з результатом; 0 - команду не прийнято
+typedef uint16_t WriteTicket;
+
+struct BluettiCommand {
+    BluettiCommandType type;
+    uint16_t value;
+    WriteTicket ticket;
+};
+
+enum class WriteOutcome : uint8_t {
+    CONFIRMED = 0, // Echo 0x06 з тим самим значенням
+    REJECTED,      // Exception 0x86 або echo з іншим значенням
+    TIMEOUT,       // Немає відповіді після повторів
+    NOT_SENT,      // Не дійшло до відправки (черга повна, регістр заблоковано, розрив)
+};
+
+struct WriteResult {
+    WriteTicket ticket;
+    uint16_t address;
+    uint16_t value;
+    WriteOutcome outcome;
+    unsigned long latencyMs; // Команда -> результат
+};
+
+// Викликається з drainRecords() (Arduino loop) уже після того, як підтверджений
+// стан потрапив у спільний SystemStatus
+typedef void (*WriteCallback)(const WriteResult& result, void* context);
+
+const char* writeOutcomeName(WriteOutcome outcome);
+
+// Діагностика BLE-каналу (віддається через /diagnostics)
+struct BluettiDiagnostics {
+    uint16_t mtu = BLE_DEFAULT_MTU;        // Погоджений ATT MTU
+    uint16_t maxRegistersPerNotification = 0; // Скільки регістрів вміщує одна notification
+    bool singleNotificationMode = false;   // Повний статус приходить однією notification
+    unsigned long pollRttMs = 0;           // RTT останнього запиту статусу
+    unsigned long pollRttSingleMs = 0;     // Середній RTT (одна notification)
+    unsigned long pollRttFragmentedMs = 0; // Середній RTT (кілька фрагментів)
+    uint32_t statusPolls = 0;
+    uint32_t statusTimeouts = 0;
+    unsigned long writeAckMs = 0;          // Команда -> echo 0x06 (остання)
+    unsigned long writeAckAvgMs = 0;       // Команда -> echo 0x06 (середнє)
+    unsigned long writeAckMaxMs = 0;       // Команда -> echo 0x06 (максимум)
+    uint32_t writeAcks = 0;
+    uint32_t writeFailures = 0;            // Exception 0x86 або вичерпані повтори
+    WriteResult lastWrite = {};            // Результат останнього запису з ticket
+    uint8_t featureReadsPerCycle = 0;      // Запитів на опитування додаткових функцій
+    uint8_t featureRoundTripsSaved = 0;    // Зекономлено round trip за останній цикл
+    uint32_t featureRoundTripsSavedTotal = 0;
+    uint32_t fragmentsDropped = 0;         // Черга фрагментів переповнена (лічить NimBLE host task)
+    uint32_t commandsDropped = 0;          // Черга команд переповнена (лічить задача-відправник)
+    uint32_t recordsPublished = 0;         // Знімків стану передано в loop
+    uint32_t recordsUnchanged = 0;         // З них без жодної зміненої групи (лише свіжість)
+    unsigned long pollIntervalMs = 0;      // Поточний адаптивний інтервал
+    unsigned long pollAverageGapMs = 0;    // Фактичний середній проміжок між блоками статусу
+    uint32_t pollTransients = 0;           // Стрибків навантаження, що прискорили опитування
+    bool burstActive = false;
+    unsigned long burstRemainingMs = 0;
+    uint32_t burstSamples = 0;             // Вибірок за останній burst
+    uint32_t burstSamplesDropped = 0;      // Кільце переповнене (немає споживача)
+    unsigned long burstAverageGapMs = 0;   // Фактичний проміжок між вибірками
+    unsigned long timeToFirstDataMs = 0;   // Початок підключення -> перший блок статусу
+    bool lastConnectFast = false;          // Останнє підключення пройшло з кешованими handles
+    uint32_t fastReconnects = 0;           // Підключень без discovery та активації
+    uint32_t fastReconnectFallbacks = 0;   // Кеш не спрацював - повний discovery
+    uint32_t advertisementsSeen = 0;       // Advertisement Bluetti у фоновому скануванні
+    uint32_t connectsFromCache = 0;        // Підключень без 5-секундного сканування
+    uint32_t connectsAfterScan = 0;
+    unsigned long connectMedianCachedMs = 0; // Медіана: початок спроби -> з'єднання (кеш)
+    unsigned long connectMedianScanMs = 0;   // Медіана: початок спроби -> з'єднання (сканування)
+    BluettiLinkState linkState = BluettiLinkState::IDLE;
+    unsigned long stateDurationMs[LINK_STATE_COUNT] = {}; // Останнє перебування в кожному стані
+    uint8_t connectFailures = 0;           // Невдалих спроб поспіль
+    unsigned long nextRetryMs = 0;         // Поточна пауза backoff
+};
+
+// Модель потоків: BLE worker (закріплений за ядром) викликає connect/loop і
+// єдиний володіє Modbus-рушієм та станом пристрою. NimBLE callback (через
+// BluettiManager, за connection handle) лише кладе фрагменти в SPSC-чергу,
+// сеттери з інших задач - команди в MPSC-чергу, а loop() забирає готові
+// знімки через drainRecords(). Один об'єкт - одна електростанція.
 class BluettiDevice {
 public:
-    explicit BluettiDevice(SystemStatus* status);
-    bool begin();
-    bool connectByMAC(const char* macAddress);
-    bool scanAndConnect(const char* macAddress);
-    void disconnect();
-    void loop();
-    bool isConnected() const;
-
-    bool setACOutput(bool state);
-    bool setDCOutput(bool state);
-    bool setChargingSpeed(uint8_t speed); // 0=Standard, 1=Silent, 2=Turbo
-    bool setEcoMode(bool state);
-    bool setPowerLifting(bool state);
-    bool setLedMode(uint8_t mode);      // 1=Low, 2=High, 3=SOS, 4=Off
-    bool setEcoShutdown(uint8_t hours); // 1..4 години
-    bool powerOff();
+    BluettiDevice() = default;
+    // До запуску BLE worker: номер пристрою, куди переносити стан, і спільний
+    // кеш advertisement (його пише сканер менеджера)
+    void attach(uint8_t index, SystemStatus* sharedStatus, const AdvertisementCache* advertisements);
+    // Лише BLE worker: пристрій, до якого loop() підключається сам (з backoff).
+    // nullptr або "" - відключитися та не підключатися
+    void setTarget(const char* macAddress);
+    void disconnect(); // Будь-яка задача: відключення виконає BLE worker
+    // Лише BLE worker. true - пристрій використав дозвіл на відправку
+    bool loop(const RadioSlot& slot);
+    // Будь-яка задача: стан з останнього goOnline/resetLinkState у worker
+    bool isConnected() const { return connected.load(std::memory_order_acquire); }
+
+    // Лише BLE worker: стан з'єднання для планування ефіру менеджером
+    bool wantsLinkSetup(unsigned long now) const;
+    bool inLinkSetup() const;
+    // Поновити власне активне сканування, яке менеджер перервав (лише SCANNING)
+    void resumeScan();
+    bool idleWithTarget() const { return link.state() == BluettiLinkState::IDLE && peerMac[0] != '\0'; }
+    // NimBLE host task: маршрутизація notifications і advertisement
+    uint16_t getConnHandle() const { return connHandle.load(std::memory_order_acquire); }
+    void acceptNotification(const uint8_t* data, size_t length);
+    void acceptFastNotification(uint16_t attrHandle, os_mbuf* om);
+    bool matchesTarget(const uint8_t* address) const {
+        return targetAddressSet && memcmp(address, targetAddress, sizeof(targetAddress)) == 0;
+    }
+    uint8_t getIndex() const { return index; }
+    const char* getPeerMac() const { return peerMac; } // Лише BLE worker пише
+
+    // Будь-яка задача: переносить останній знімок стану в спільний SystemStatus.
+    // Викликати з задачі, що читає SystemStatus (Arduino loop)
+    void drainRecords();
+
+    // Сеттери перевіряють аргументи та ставлять команду в чергу BLE worker і
+    // одразу повертають ticket (0 - команду не прийнято). Результат запису
+    // приходить у WriteCallback з тим самим ticket
+    WriteTicket setACOutput(bool state);
+    WriteTicket setDCOutput(bool state);
+    WriteTicket setChargingSpeed(uint8_t speed); // 0=Standard, 1=Silent, 2=Turbo
+    WriteTicket setEcoMode(bool state);
+    WriteTicket setPowerLifting(bool state);
+    WriteTicket setLedMode(uint8_t mode);      // 1=Low, 2=High, 3=SOS, 4=Off
+    WriteTicket setEcoShutdown(uint8_t hours); // 1..4 години
+    WriteTicket powerOff();
+    // Один слухач результатів записів; реєструвати до запуску BLE worker
+    void onWriteComplete(WriteCallback callback, void* context);
+    // Burst-вибірки потужності на seconds секунд (0 - зупинити достроково)
+    bool startBurst(uint16_t seconds);
+    // Забути дізнані можливості регістрів (усі моделі, разом з NVS)
+    bool resetCapabilities();
+
+    // Лише одна задача-споживач (MQTT у loop): вибірки burst-режиму по черзі
+    bool takeBurstSample(BurstSample& out) { return burstSamples.pop(out); }
+    size_t pendingBurstSamples() const { return burstSamples.size(); }
 
     uint8_t getBatteryLevel() const;
     int getACOutputPower() const;
@@ -42,52 +212,171 @@ public:
     uint8_t getLedMode() const;
     uint8_t getEcoShutdown() const;
     
-    // Налаштування інтервалу опитування (мс)
-    void setUpdateInterval(unsigned long intervalMs);
-    unsigned long getUpdateInterval() const;
+    // Межі адаптивного інтервалу опитування (мс), будь-яка задача
+    void setPollBounds(unsigned long minMs, unsigned long maxMs);
+    unsigned long getPollMinMs() const { return pollMinMs.load(std::memory_order_relaxed); }
+    unsigned long getPollMaxMs() const { return pollMaxMs.load(std::memory_order_relaxed); }
+
+    // Будь-яка задача: узгоджений знімок, який worker публікує щоітерації
+    BluettiDiagnostics getDiagnostics() const {
+        BluettiDiagnostics copy;
+        diagnosticsSnapshot.read(copy);
+        return copy;
+    }
+    const NotificationReassembler& getReassembler() const { return reassembler; }
+    const ModbusTransactionEngine& getTransactions() const { return transactions; }
+    // Будь-яка задача: read-through кеш регістрів. Значення віддаються одразу
+    // разом з часом отримання; для застарілих і відсутніх BLE worker отримує
+    // один запит оновлення на блок, доки попередній не виконано
+    CacheLookup readRegisters(const uint16_t* addresses, size_t count, CachedRegister* out);
+    const RegisterCache& getRegisterCache() const { return registerCache; }
+    // Будь-яка задача: знімок кешу можливостей регістрів
+    void getCapabilities(RegisterCapabilityTable& out) const { capabilities.snapshot(out); }
+    // Будь-яка задача: профіль розпізнаної моделі (до розпізнавання - EB3A)
+    const DeviceProfile& getProfile() const { return *profile.load(std::memory_order_acquire); }
+    // Будь-яка задача: скільки разів менеджер дав пристрою слот на відправку
+    uint32_t getDispatchGrants() const { return dispatchGrants.load(std::memory_order_relaxed); }
 
 private:
-    NimBLEClient* client;
-    NimBLERemoteCharacteristic* notifyCharacteristic;
-    NimBLERemoteCharacteristic* writeCharacteristic;
-    bool connected;
-    unsigned long lastRequest;
-    SystemStatus* status;
-    bool connecting;
-    unsigned long connectStartTime;
-    uint8_t connectAttempts;
-    bool scanning;
-    unsigned long scanStartTime;
-    NimBLEScan* scanner;
-    uint8_t cachedBattery;
-    int cachedAcPower;
-    int cachedDcPower;
-    uint8_t cachedInputPower;
-    bool cachedAcState;
-    bool cachedDcState;
-    unsigned long updateInterval; // Інтервал опитування в мс (за замовчуванням 4000)
-    uint8_t lastRequestedPage; // Останній запитаний page (0x00 або 0x0B)
-    uint16_t lastSingleRegisterRequested = 0; // Останній одноразовий запитаний регістр
-    uint8_t featurePollIndex = 0; // Черга опитування додаткових функцій
-    uint16_t lastWriteRegister = 0; // Останній записуваний регістр (для діагностики помилок)
-    bool ecoWriteBlocked = false; // Якщо пристрій відхилив ECO регістр, більше не пишемо
-    bool ledFallbackTried = false; // Якщо 0x0BDA відхилено, пробуємо 0x0BBA один раз
-    bool waitingForResponse = false; // Чи очікуємо відповідь від Bluetti
-    unsigned long requestStartTime = 0; // Час надсилання останнього запиту
-
-    bool setupCharacteristics();
+    uint8_t index = 0;
+    NimBLEClient* client = nullptr;
+    NimBLERemoteCharacteristic* notifyCharacteristic = nullptr;
+    NimBLERemoteCharacteristic* writeCharacteristic = nullptr;
+    std::atomic<bool> connected{false}; // Пише worker, читає будь-яка задача
+    unsigned long lastRequest = 0;
+    unsigned long lastDataReceived = 0; // Для повторної активації, якщо дані перестали йти
+    SystemStatus workerStatus = {}; // Стан пристрою, яким володіє BLE worker
+    SystemStatus* status = &workerStatus;
+    SystemStatus* sharedStatus = nullptr; // Спільний стан (оновлюється лише в drainRecords)
+    std::atomic<uint16_t> connHandle{BLE_HS_CONN_HANDLE_NONE}; // Ключ маршрутизації notifications
+    std::atomic<uint32_t> dispatchGrants{0};
+    LinkStateMachine link;               // Стан з'єднання, невдалі спроби та backoff
+    unsigned long stateTimer = 0;        // Пауза всередині стану (активація)
+    uint8_t subscribeStep = 0;
+    bool skipFastPath = false;           // Кешовані handles вже не спрацювали на цьому з'єднанні
+    uint8_t cachedBattery = 0;
+    int cachedAcPower = 0;
+    int cachedDcPower = 0;
+    int cachedInputPower = 0; // Сума DC + AC входу - легко перевищує 255 W
+    bool cachedAcState = false;
+    bool cachedDcState = false;
+    AdaptivePoller poller;        // Інтервал опитування статусу (лише worker)
+    std::atomic<uint32_t> pollMinMs{POLL_MIN_DEFAULT_MS}; // Пише будь-яка задача, poller бере в serviceLink
+    std::atomic<uint32_t> pollMaxMs{POLL_MAX_DEFAULT_MS};
+    uint8_t lastRequestedPage = 0x00; // Останній запитаний page (0x00 або 0x0B)
+    StatusPageAssembler statusPages;  // Блок статусу зі сторінок за MTU (лише worker)
+    unsigned long statusCycleStartedAt = 0; // Відправка першої сторінки - для RTT
+    std::atomic<const DeviceProfile*> profile{&defaultDeviceProfile()}; // Змінює лише worker
+    RegisterCapabilities capabilities;    // Що модель відхиляє/приймає, переживає перезавантаження
+    RegisterCache registerCache;          // Значення + час отримання (пише worker)
+    std::atomic<uint8_t> refreshPending{0}; // Маска RegisterBlock, що вже чекають у черзі команд
+    ModbusTransactionEngine transactions; // Черга з пріоритетами + транзакція в польоті з дедлайном
+    NotificationReassembler reassembler; // Збирає фрагментовані відповіді в цілі кадри
+    BluettiDiagnostics diagnostics;              // Лише worker
+    SeqLock<BluettiDiagnostics> diagnosticsSnapshot; // worker -> інші задачі
+    std::atomic<uint32_t> fragmentsDropped{0};   // Пише NimBLE host task
+    std::atomic<uint32_t> commandsDropped{0};    // Пише будь-яка задача (postCommand)
+    SpscQueue<BleFragment, 8> fragments;    // NimBLE host -> worker
+    MpscQueue<BluettiCommand, 16> commands; // loop/AsyncTCP -> worker
+    SpscQueue<BluettiRecord, 4> records;    // worker -> loop
+    SpscQueue<WriteResult, 8> writeResults; // worker -> loop, лише після запису зі станом
+    WriteResult completedWrites[4];         // Чекають publishRecord() (лише worker)
+    uint8_t completedWriteCount = 0;
+    std::atomic<uint16_t> nextTicket{1};
+    WriteCallback writeCallback = nullptr;
+    void* writeCallbackContext = nullptr;
+    SpscQueue<BurstSample, BURST_RING_SIZE> burstSamples; // worker -> MQTT, виділене заздалегідь
+    unsigned long burstUntil = 0;        // 0 - burst неактивний
+    unsigned long lastBurstSampleAt = 0;
+    BluettiRecord lastPublished = {};
+    bool hasPublished = false;
+    char peerMac[18] = "";               // MAC останнього підключення (ключ кешу GATT)
+    GattHandleCache gattCache = {};
+    bool gattCacheLoaded = false;
+    bool gattCacheSavePending = false;   // Зберегти handles після першої відповіді
+    std::atomic<bool> fastPathActive{false}; // Notifications приймає acceptFastNotification
+    uint16_t fastNotifyHandle = 0;       // Пише worker до fastPathActive = true
+    unsigned long fastPathStartedAt = 0; // Без даних після цього - повний discovery
+    unsigned long linkStartedAt = 0;     // Для timeToFirstDataMs
+    bool awaitingFirstData = false;
+
+    const AdvertisementCache* advertisements = nullptr; // Пише сканер BluettiManager
+    uint8_t targetAddress[6] = {};       // Змінюється лише при зупиненому скануванні
+    bool targetAddressSet = false;
+    unsigned long connectAttemptStartedAt = 0;
+    bool connectFromCache = false;
+    unsigned long cachedConnectFailedAt = 0; // Після невдачі потрібне новіше advertisement
+    ConnectTimeWindow connectTimesCached;
+    ConnectTimeWindow connectTimesScan;
+
+    bool serviceLink(const RadioSlot& slot);
+    void serviceConnection(unsigned long now, bool maySetup);
+    void enterState(BluettiLinkState next, unsigned long now);
+    void beginAttempt(unsigned long now);
+    bool startActiveScan();
+    void serviceScan(unsigned long now);
+    void serviceConnect(unsigned long now);
+    void serviceDiscovery(unsigned long now);
+    void serviceSubscribe(unsigned long now);
+    void goOnline(unsigned long now);
+    void failAttempt(unsigned long now, const char* reason);
+    void resetLinkState();
+    void stopLink(unsigned long now);
+    void setTargetAddress(const char* macAddress);
+    void recordConnectTime(unsigned long now);
+    void disconnectLink();
+    void applyBurst(uint16_t seconds);
+    void endBurst();
+    bool serviceBurst(unsigned long now);
+    void handlePowerSample(const ModbusFrameView& frame, unsigned long now);
+    WriteTicket postCommand(BluettiCommandType type, uint16_t value);
+    WriteTicket issueTicket(); // Будь-яка задача: наступний ненульовий ticket
+    // postCommand для запису параметра; 0, якщо модель його не має
+    WriteTicket postControl(ProfileControl control, BluettiCommandType type, uint16_t value);
+    void completeWrite(WriteTicket ticket, uint16_t address, uint16_t value, WriteOutcome outcome,
+                       unsigned long enqueuedAt);
+    void flushWriteResults();
+    // Записи, витіснені з повної черги, завершуються NOT_SENT
+    void reportEvictedWrites();
+    // Звітує про всі незавершені записи і скидає чергу транзакцій
+    void abandonTransactions();
+    void applyWrittenRegister(uint16_t reg, uint16_t value);
+    void runCommands();
+    void processFragments();
+    void publishRecord();
+    void publishDiagnostics();
+    // Блок статусу (будь-яка його сторінка) ще в черзі або в польоті
+    bool statusPollPending() const;
+    // Лише worker: з'єднання живе і на рівні NimBLE-клієнта
+    bool linkUp() const;
+    bool applyACOutput(bool state, WriteTicket ticket);
+    bool applyDCOutput(bool state, WriteTicket ticket);
+    bool applyChargingSpeed(uint8_t speed, WriteTicket ticket);
+    bool applyEcoMode(bool state, WriteTicket ticket);
+    bool applyPowerLifting(bool state, WriteTicket ticket);
+    bool applyLedMode(uint8_t mode, WriteTicket ticket);
+    bool applyEcoShutdown(uint8_t hours, WriteTicket ticket);
+    bool applyPowerOff(WriteTicket ticket);
+    bool setupFastPath();
+    bool discoverCharacteristics();
+    bool subscribeNotifications();
+    void fallBackToDiscovery(unsigned long now);
+    void recordFirstData(unsigned long now);
     bool sendCommand(const uint8_t* data, size_t length);
-    bool writeSingleRegister(uint16_t reg, uint16_t value);
-    void requestRegister(uint16_t reg);
+    bool writeSingleRegister(uint16_t reg, uint16_t value, WriteTicket ticket = 0);
+    void requestRegister(uint16_t reg, ModbusPriority priority = ModbusPriority::USER_READ);
+    void requestRegisters(uint16_t start, uint16_t count, ModbusPriority priority);
     void pollFeatureState();
+    uint16_t resolveWriteRegister(uint16_t reg) const; // 0 - запис відомо марний
+    void refreshRegisters(uint8_t blocks);
+    bool applyFeatureRegister(uint16_t reg, uint16_t valueRaw);
     void requestStatus();
-    void handleNotification(uint8_t* data, size_t length);
-
-    static void notificationThunk(NimBLERemoteCharacteristic* characteristic,
-                                  uint8_t* data,
-                                  size_t length,
-                                  bool isNotify);
-    static BluettiDevice* instance;
+    bool dispatchTransaction(unsigned long now);
+    void handleTransactionTimeout(const ModbusTransaction& txn, ModbusExpireResult result);
+    void recordWriteAck(unsigned long ackMs);
+    void refreshLinkMtu();
+    void recordPollRtt(unsigned long rttMs, bool fragmented);
+    void handleNotification(const ModbusFrameView& frame);
 };
 
 #endif
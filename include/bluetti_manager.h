@@ -0,0 +1,106 @@
+#ifndef BLUETTI_MANAGER_H
+#define BLUETTI_MANAGER_H
+
+#include <Arduino.h>
+#include <NimBLEDevice.h>
+#include "advertisement_cache.h"
+#include "bluetti_device.h"
+#include "lockfree_queue.h"
+#include "radio_scheduler.h"
+#include "seqlock.h"
+#include "system_status.h"
+
+// Скільки електростанцій обслуговує один ESP32. Кожна тримає окреме
+// з'єднання, тож не більше, ніж дозволяє NimBLE
+static constexpr size_t BLUETTI_MAX_DEVICES = 3;
+
+#ifdef CONFIG_BT_NIMBLE_MAX_CONNECTIONS
+static_assert(BLUETTI_MAX_DEVICES <= CONFIG_BT_NIMBLE_MAX_CONNECTIONS,
+              "Every Bluetti device needs its own NimBLE connection");
+#endif
+
+// Зміна цілей від loop/AsyncTCP для BLE worker (виконується в порядку надходження)
+enum class ManagerCommandType : uint8_t {
+    TARGET = 0, // index + mac ("" - пристрій не використовується)
+    ENABLED,    // enabled: false - усі пристрої відключені, цілі зберігаються
+};
+
+struct ManagerCommand {
+    ManagerCommandType type;
+    uint8_t index;
+    bool enabled;
+    char mac[18];
+};
+
+// Один радіомодуль на кілька пристроїв. Менеджер володіє всім, що в NimBLE
+// глобальне: ініціалізація, сканер з кешем advertisement та GAP handler.
+// Notifications маршрутизуються пристрою за connection handle, а ефір
+// ділиться по черзі: налаштування з'єднання (сканування, connect) - лише в
+// одного пристрою одночасно, відправка Modbus-запиту - одна за ітерацію
+// BLE worker, починаючи з пристрою після останнього, хто відправляв
+// (RadioScheduler). Цілі змінюються лише через чергу команд.
+//
+// Пристрій 0 пише в основний SystemStatus (разом із системними полями), решта
+// - у власні копії менеджера; знімки для читачів оновлює drainRecords().
+class BluettiManager {
+public:
+    BluettiManager(SystemStatus* primaryStatus, SeqLock<SystemStatus>* primarySnapshot);
+    bool begin();
+    // Будь-яка задача: MAC пристрою (nullptr або "" - не використовується) та
+    // загальне ввімкнення. Застосує BLE worker на початку наступного loop();
+    // false - черга повна
+    bool requestTarget(size_t index, const char* macAddress);
+    bool requestEnabled(bool enabled);
+    void loop(); // Лише BLE worker
+    // Лише loop(): результати всіх пристроїв у спільний стан і знімки
+    // (знімок пристрою 0 публікує main разом із системними полями)
+    void drainRecords();
+
+    static constexpr size_t deviceCount() { return BLUETTI_MAX_DEVICES; }
+    BluettiDevice& device(size_t index) { return devices[index]; }
+    const BluettiDevice& device(size_t index) const { return devices[index]; }
+    SeqLock<SystemStatus>* snapshot(size_t index) {
+        return index == 0 ? primarySnapshot : &snapshots[index - 1];
+    }
+    // Будь-яка задача: скільки налаштувань з'єднання дозволено (діагностика)
+    uint32_t getSetupGrants() const { return setupGrants.load(std::memory_order_relaxed); }
+
+    static void notificationThunk(NimBLERemoteCharacteristic* characteristic,
+                                  uint8_t* data,
+                                  size_t length,
+                                  bool isNotify);
+
+private:
+    BluettiDevice devices[BLUETTI_MAX_DEVICES];
+    SystemStatus statuses[BLUETTI_MAX_DEVICES - 1];
+    SeqLock<SystemStatus> snapshots[BLUETTI_MAX_DEVICES - 1];
+    SeqLock<SystemStatus>* primarySnapshot;
+
+    // Фонове пасивне сканування: callback на NimBLE host task пише в кеш
+    struct AdvertisementListener : public NimBLEAdvertisedDeviceCallbacks {
+        void onResult(NimBLEAdvertisedDevice* device) override;
+    };
+    AdvertisementListener advertisementListener;
+    AdvertisementCache advertisements;
+    bool backgroundScanning = false;
+
+    RadioScheduler<BLUETTI_MAX_DEVICES> scheduler;
+    std::atomic<uint32_t> setupGrants{0};
+
+    // Лише BLE worker: цілі з черги команд - жодна інша задача їх не пише
+    MpscQueue<ManagerCommand, 8> commands; // loop/AsyncTCP -> worker
+    char targets[BLUETTI_MAX_DEVICES][18] = {};
+    bool linkEnabled = true;
+
+    bool postCommand(const ManagerCommand& command);
+    void runCommands();
+    void setTarget(size_t index, const char* macAddress);
+    void startBackgroundScan();
+    void stopBackgroundScan();
+    BluettiDevice* deviceForConnection(uint16_t connHandle);
+
+    static int gapEventThunk(ble_gap_event* event, void* arg);
+    static BluettiManager* instance;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef BURST_TELEMETRY_H
+#define BURST_TELEMETRY_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Burst-режим: обмежений у часі потік вибірок потужності з максимальною
+// частотою, яку витримує BLE-канал (наступний запит - одразу після відповіді)
+static constexpr uint16_t BURST_DEFAULT_SECONDS = 120;
+static constexpr uint16_t BURST_MAX_SECONDS = 600;
+static constexpr unsigned long BURST_MIN_GAP_MS = 250;  // Не частіше 4 Гц
+static constexpr size_t BURST_RING_SIZE = 128;          // ~1 хв при 2 Гц без споживача
+// Вибірки публікуються пакетами: повний пакет або раз на BURST_BATCH_MS
+static constexpr size_t BURST_BATCH_SAMPLES = 20;
+static constexpr unsigned long BURST_BATCH_MS = 2000;
+
+struct BurstSample {
+    uint32_t at;      // millis() отримання відповіді
+    uint16_t acOutput; // W
+    uint16_t dcOutput;
+    uint16_t acInput;
+    uint16_t dcInput;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef CORE_REGISTERS_H
+#define CORE_REGISTERS_H
+
+#include "device_profile.h"
+#include "register_map.h"
+
+// Спільне ядро page 0x00 моделей AC200/EB70/AC180 (за bluetti_mqtt, AC200M):
+// той самий блок з 0x000A, що й у EB3A, але без напруги й температури в ньому.
+// Регістри, яких конкретна прошивка не віддає, відсіє кеш можливостей.
+static constexpr uint16_t CORE_STATUS_BASE = 0x000A;
+static constexpr uint16_t CORE_STATUS_COUNT = 40;
+
+static constexpr RegisterDescriptor CORE_STATUS_REGISTERS[] = {
+    // address  field                         type                  min              max              div  offset  index
+    // device_type: "AC200M", "EB70S"... - перші чотири символи
+    {0x000A, StatusField::MODEL_NAME,      RegisterType::ASCII,  MODEL_ASCII_MIN, MODEL_ASCII_MAX, 1,   0,     0},
+    {0x000B, StatusField::MODEL_NAME,      RegisterType::ASCII,  MODEL_ASCII_MIN, MODEL_ASCII_MAX, 1,   0,     2},
+    {0x0024, StatusField::DC_INPUT_POWER,  RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0025, StatusField::AC_INPUT_POWER,  RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0026, StatusField::AC_OUTPUT_POWER, RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0027, StatusField::DC_OUTPUT_POWER, RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    // total_battery_percent
+    {0x002B, StatusField::BATTERY_LEVEL,   RegisterType::UINT16, 0,               100,             1,   0,     0},
+    {0x0030, StatusField::AC_OUTPUT_STATE, RegisterType::BOOL,   0,               0xFFFF,          1,   0,     0},
+    {0x0031, StatusField::DC_OUTPUT_STATE, RegisterType::BOOL,   0,               0xFFFF,          1,   0,     0},
+};
+
+static constexpr uint16_t CORE_POWER_BASE = 0x0024; // DC in, AC in, AC out, DC out
+static constexpr uint16_t CORE_POWER_COUNT = 4;
+
+static constexpr FieldRegister CORE_FIELD_REGISTERS[] = {
+    {"battery_level",  0x002B},
+    {"dc_input_power", 0x0024},
+    {"ac_input_power", 0x0025},
+    {"ac_power",       0x0026},
+    {"dc_power",       0x0027},
+    {"ac_state",       0x0030},
+    {"dc_state",       0x0031},
+};
+
+// ac_output_on / dc_output_on (3007/3008)
+static constexpr ControlRegister CORE_CONTROLS[] = {
+    {ProfileControl::AC_OUTPUT, 0x0BBF, 0},
+    {ProfileControl::DC_OUTPUT, 0x0BC0, 0},
+};
+
+static_assert(registerMapSorted(CORE_STATUS_REGISTERS), "Core register map must be sorted by address");
+static_assert(registerMapWithin(CORE_STATUS_REGISTERS, CORE_STATUS_BASE, CORE_STATUS_COUNT),
+              "Core register map must fit the status block");
+
+#endif
@@ -0,0 +1,98 @@
+#ifndef DEVICE_PROFILE_H
+#define DEVICE_PROFILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "register_map.h"
+
+// Параметри, які можна змінити записом регістра
+enum class ProfileControl : uint8_t {
+    AC_OUTPUT = 0,
+    DC_OUTPUT,
+    CHARGING_MODE,  // 0=Standard, 1=Silent, 2=Turbo
+    ECO_MODE,
+    POWER_LIFTING,
+    LED_MODE,       // 1=Low, 2=High, 3=SOS, 4=Off
+    ECO_SHUTDOWN,   // 1..4 години
+    POWER_OFF,
+};
+
+// Регістр параметра; legacyAddress - стара адреса, що приймає запис на
+// частині прошивок (0 - немає)
+struct ControlRegister {
+    ProfileControl control;
+    uint16_t address;
+    uint16_t legacyAddress;
+};
+
+// Регістр-джерело поля API (вік значення - age_ms у /status)
+struct FieldRegister {
+    const char* name;
+    uint16_t address;
+};
+
+// Сутності Home Assistant, які публікує discovery
+enum class ProfileEntity : uint8_t {
+    BATTERY = 0,
+    AC_POWER,
+    DC_POWER,
+    INPUT_POWER,
+    VOLTAGE,
+    AC_OUTPUT,
+    DC_OUTPUT,
+    CHARGING_SPEED,
+    ECO_MODE,
+    POWER_LIFTING,
+    LED_MODE,
+    LED_SWITCH,
+    ECO_SHUTDOWN,
+    POWER_OFF,
+    COUNT
+};
+
+constexpr uint32_t entityBit(ProfileEntity entity) { return 1u << static_cast<uint8_t>(entity); }
+
+static constexpr size_t PROFILE_MAX_FEATURE_REGISTERS = 8;
+static constexpr size_t PROFILE_MAX_FIELD_REGISTERS = 16;
+
+// Усе, чим моделі відрізняються: карта блоку статусу, план опитування,
+// регістри керування та сутності discovery. Лише вказівники на static
+// constexpr таблиці - профіль обирається один раз за моделлю, кадр
+// декодується тим самим табличним проходом без віртуальних викликів.
+struct DeviceProfile {
+    const char* modelPrefix;  // Перші символи назви моделі з регістрів ("EB3A", "AC20")
+    const char* model;        // Модель для Home Assistant ("EB3A", "AC200")
+    const char* slug;         // Частина MQTT-топіків та unique_id ("eb3a")
+    const char* displayName;  // "Bluetti EB3A"
+    uint16_t statusBase;      // Блок статусу (page 0x00)
+    uint16_t statusCount;
+    const RegisterDescriptor* statusMap;
+    size_t statusMapSize;
+    uint16_t powerBase;       // Суміжні регістри потужності для burst (0 регістрів - без burst)
+    uint16_t powerCount;
+    const uint16_t* featureRegisters; // Додаткові функції, що опитуються разом зі статусом
+    size_t featureCount;
+    const ControlRegister* controls;
+    size_t controlCount;
+    const FieldRegister* fields;
+    size_t fieldCount;
+    uint32_t entities;        // Маска entityBit(ProfileEntity)
+
+    // 0 - модель не має такого параметра
+    uint16_t controlAddress(ProfileControl control) const;
+    uint16_t legacyAddress(uint16_t address) const;
+    // Параметр за адресою (основною або старою)
+    bool controlAt(uint16_t address, ProfileControl& out) const;
+    bool isFeatureRegister(uint16_t address) const;
+    bool inStatusBlock(uint16_t address) const {
+        return address >= statusBase && address < statusBase + statusCount;
+    }
+    bool hasEntity(ProfileEntity entity) const { return (entities & entityBit(entity)) != 0; }
+};
+
+// Профіль за назвою моделі з регістрів; nullptr - модель невідома
+const DeviceProfile* findDeviceProfile(const char* modelName);
+// До розпізнавання моделі (і для невідомих моделей) - EB3A
+const DeviceProfile& defaultDeviceProfile();
+
+#endif
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <TFT_eSPI.h>
 #include "bluetti_device.h"
+#include "seqlock.h"
 #include "system_status.h"
 
 constexpr uint8_t BUTTON_1 = 35; // Ліва кнопка
@@ -25,7 +26,7 @@ enum class MenuScreen {
 
 class DisplayManager {
 public:
-    DisplayManager(BluettiDevice* device, SystemStatus* status);
+    DisplayManager(BluettiDevice* device, SystemStatus* status, SeqLock<SystemStatus>* snapshot);
     void begin();
     void loop();
     void showConnecting(const char* message);
@@ -38,6 +39,8 @@ private:
     TFT_eSPI tft;
     BluettiDevice* bluetti;
     SystemStatus* status;
+    SeqLock<SystemStatus>* snapshot; // Лише читання
+    SystemStatus view;               // Копія для поточного кадру
     MenuScreen currentScreen;
 
     bool displayOn;
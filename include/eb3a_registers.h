@@ -0,0 +1,89 @@
+#ifndef EB3A_REGISTERS_H
+#define EB3A_REGISTERS_H
+
+#include "device_profile.h"
+#include "register_map.h"
+
+// Блок статусу EB3A: 40 регістрів від 0x000A (page 0x00)
+static constexpr uint16_t EB3A_STATUS_BASE = 0x000A;
+static constexpr uint16_t EB3A_STATUS_COUNT = 40;
+
+// Карта регістрів EB3A (за giovanne123/EB3A_Bluetti_ESP32_HA та польовими логами).
+// Записи для одного поля йдуть за пріоритетом: пізніший валідний перекриває попередній.
+static constexpr RegisterDescriptor EB3A_STATUS_REGISTERS[] = {
+    // address  field                         type                  min              max              div  offset  index
+    {0x000A, StatusField::MODEL_NAME,      RegisterType::ASCII,  MODEL_ASCII_MIN, MODEL_ASCII_MAX, 1,   0,     0},
+    {0x000B, StatusField::MODEL_NAME,      RegisterType::ASCII,  MODEL_ASCII_MIN, MODEL_ASCII_MAX, 1,   0,     2},
+    // У польових логах "EB3A" приходить у 0x000E-0x000F - перекриває 0x000A-0x000B,
+    // але лише коли 0x000E рівно "EB" (0x000F без нього не береться)
+    {0x000E, StatusField::MODEL_NAME,      RegisterType::ASCII,  0x4542,          0x4542,          1,   0,     0},
+    {0x000F, StatusField::MODEL_NAME,      RegisterType::ASCII_TAIL, MODEL_ASCII_MIN, MODEL_ASCII_MAX, 1, 0,   2},
+    // SoC у відсотках (1-100) або ×10 (1019 = 101.9% - обмежується до 100)
+    {0x0010, StatusField::BATTERY_LEVEL,   RegisterType::UINT16, 1,               100,             1,   0,     0},
+    {0x0010, StatusField::BATTERY_LEVEL,   RegisterType::UINT16, 101,             1100,            10,  0,     0},
+    // Напруга батареї ×10 (537 = 53.7V)
+    {0x0013, StatusField::BATTERY_VOLTAGE, RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0024, StatusField::DC_INPUT_POWER,  RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0025, StatusField::AC_INPUT_POWER,  RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0026, StatusField::AC_OUTPUT_POWER, RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    {0x0027, StatusField::DC_OUTPUT_POWER, RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    // Температура ×10 °C (10-70°C) або Кельвіни ×10 (2731 = 0°C)
+    {0x0028, StatusField::TEMPERATURE,     RegisterType::UINT16, 100,             700,             1,   0,     0},
+    {0x0028, StatusField::TEMPERATURE,     RegisterType::UINT16, 2731,            3531,            1,   -2731, 0},
+    {0x002B, StatusField::MAX_DC_LIMIT,    RegisterType::UINT16, 0,               0xFFFF,          1,   0,     0},
+    // SoC у відсотках - змінюється, коли 0x0010 "залипає" на 1019, тому перекриває його
+    {0x002B, StatusField::BATTERY_LEVEL,   RegisterType::UINT16, 1,               100,             1,   0,     0},
+    {0x0030, StatusField::AC_OUTPUT_STATE, RegisterType::BOOL,   0,               0xFFFF,          1,   0,     0},
+    {0x0031, StatusField::DC_OUTPUT_STATE, RegisterType::BOOL,   0,               0xFFFF,          1,   0,     0},
+};
+
+// Суміжні регістри потужності всередині блоку статусу (burst-режим читає лише їх)
+static constexpr uint16_t EB3A_POWER_BASE = 0x0024; // DC in, AC in, AC out, DC out
+static constexpr uint16_t EB3A_POWER_COUNT = 4;
+
+// Регістр-джерело кожного поля API
+static constexpr FieldRegister EB3A_FIELD_REGISTERS[] = {
+    {"battery_level",   0x002B},
+    {"battery_voltage", 0x0013},
+    {"dc_input_power",  0x0024},
+    {"ac_input_power",  0x0025},
+    {"ac_power",        0x0026},
+    {"dc_power",        0x0027},
+    {"temperature",     0x0028},
+    {"ac_state",        0x0030},
+    {"dc_state",        0x0031},
+    {"led_mode",        0x0BDA},
+    {"eco_mode",        0x0BF7},
+    {"eco_shutdown",    0x0BF8},
+    {"charging_speed",  0x0BF9},
+    {"power_lifting",   0x0BFA},
+};
+
+// Регістри додаткових функцій: 0x0BF7-0x0BFA суміжні, 0x0BDA окремо
+static constexpr uint16_t EB3A_FEATURE_REGISTERS[] = {
+    0x0BF7, // ECO Mode (3063)
+    0x0BFA, // Power Lifting (3066)
+    0x0BDA, // LED Mode (3034)
+    0x0BF8, // ECO Shutdown (3064)
+    0x0BF9, // Charging Mode (3065)
+};
+
+static constexpr ControlRegister EB3A_CONTROLS[] = {
+    {ProfileControl::AC_OUTPUT,     0x0BBF, 0},
+    {ProfileControl::DC_OUTPUT,     0x0BC0, 0},
+    {ProfileControl::LED_MODE,      0x0BDA, 0x0BBA}, // 3034; старі прошивки - 0x0BBA
+    {ProfileControl::POWER_OFF,     0x0BF4, 0},      // 3060
+    {ProfileControl::ECO_MODE,      0x0BF7, 0},
+    {ProfileControl::ECO_SHUTDOWN,  0x0BF8, 0},
+    {ProfileControl::CHARGING_MODE, 0x0BF9, 0},
+    {ProfileControl::POWER_LIFTING, 0x0BFA, 0},
+};
+
+static_assert(registerMapSorted(EB3A_STATUS_REGISTERS), "EB3A register map must be sorted by address");
+static_assert(registerMapWithin(EB3A_STATUS_REGISTERS, EB3A_STATUS_BASE, EB3A_STATUS_COUNT),
+              "EB3A register map must fit the status block");
+static_assert(EB3A_POWER_BASE >= EB3A_STATUS_BASE &&
+              EB3A_POWER_BASE + EB3A_POWER_COUNT <= EB3A_STATUS_BASE + EB3A_STATUS_COUNT,
+              "EB3A power registers must lie inside the status block");
+
+#endif
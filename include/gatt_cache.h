@@ -0,0 +1,28 @@
+#ifndef GATT_CACHE_H
+#define GATT_CACHE_H
+
+#include <cstdint>
+
+// Версія формату запису в NVS - при зміні структури старі записи ігноруються
+static constexpr uint8_t GATT_CACHE_VERSION = 1;
+
+// Handles сервісу Bluetti, знайдені повним discovery. Bonded пристрій не
+// змінює свою GATT-таблицю, тож після короткого розриву їх можна
+// використати без повторного discovery.
+struct GattHandleCache {
+    uint8_t version;
+    uint16_t serviceStart;
+    uint16_t serviceEnd;
+    uint16_t notifyHandle;    // Значення характеристики ff01
+    uint16_t writeHandle;     // Значення характеристики ff02
+    uint16_t cccdHandle;      // Дескриптор 0x2902 для ff01
+    bool indicate;            // Підписка через indications замість notifications
+    bool activationRequired;  // Без 0xAA 0x55 0x90 0xEB пристрій мовчав
+};
+
+// Кеш зберігається окремо для кожного MAC (namespace "gatt_cache")
+bool loadGattCache(const char* macAddress, GattHandleCache& out);
+bool saveGattCache(const char* macAddress, const GattHandleCache& cache);
+void clearGattCache(const char* macAddress);
+
+#endif
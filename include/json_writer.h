@@ -0,0 +1,127 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+// Компактний JSON-об'єкт у буфері викликача: без JsonDocument і без heap.
+// Значення - числа, текст або масив рядків чисел (пакет burst-вибірок).
+// Ключі та текстові значення - наші константи, екранування не потрібне.
+// Якщо буфер закінчився, overflowed() == true і документ не публікується.
+class JsonObjectWriter {
+public:
+    JsonObjectWriter(char* buffer, size_t size) : buffer(buffer), size(size) {
+        append("{", 1);
+    }
+
+    void number(const char* key, float value, unsigned decimals) {
+        if (!beginKey(key)) {
+            return;
+        }
+        int written = snprintf(buffer + used, size - used, "%.*f", (int)decimals, value);
+        advance(written);
+    }
+
+    // Ціле без втрати точності (number() іде через float - 24 біти мантиси)
+    void integer(const char* key, uint32_t value) {
+        if (!beginKey(key)) {
+            return;
+        }
+        appendUnsigned(value);
+    }
+
+    // "key":[[a,b,...],[...]] - рядки додаються через row() до endArray()
+    void beginArray(const char* key) {
+        if (!beginKey(key)) {
+            return;
+        }
+        append("[", 1);
+        firstRow = true;
+    }
+
+    void row(const uint32_t* values, size_t count) {
+        if (!firstRow) {
+            append(",", 1);
+        }
+        firstRow = false;
+        append("[", 1);
+        for (size_t i = 0; i < count; i++) {
+            if (i > 0) {
+                append(",", 1);
+            }
+            appendUnsigned(values[i]);
+        }
+        append("]", 1);
+    }
+
+    void endArray() {
+        append("]", 1);
+    }
+
+    void text(const char* key, const char* value) {
+        if (!beginKey(key)) {
+            return;
+        }
+        append("\"", 1);
+        append(value, strlen(value));
+        append("\"", 1);
+    }
+
+    // Закриває об'єкт; nullptr - не вмістився
+    const char* finish() {
+        append("}", 1);
+        return overflow ? nullptr : buffer;
+    }
+
+    size_t length() const { return used; }
+    bool overflowed() const { return overflow; }
+
+private:
+    char* buffer;
+    size_t size;
+    size_t used = 0;
+    bool first = true;
+    bool firstRow = true;
+    bool overflow = false;
+
+    bool beginKey(const char* key) {
+        if (!first) {
+            append(",", 1);
+        }
+        first = false;
+        append("\"", 1);
+        append(key, strlen(key));
+        append("\":", 2);
+        return !overflow;
+    }
+
+    void append(const char* data, size_t length) {
+        if (overflow || used + length >= size) {
+            overflow = true;
+            return;
+        }
+        memcpy(buffer + used, data, length);
+        used += length;
+        buffer[used] = '\0';
+    }
+
+    void appendUnsigned(uint32_t value) {
+        if (overflow) {
+            return;
+        }
+        int written = snprintf(buffer + used, size - used, "%lu", (unsigned long)value);
+        advance(written);
+    }
+
+    void advance(int written) {
+        if (written < 0 || used + (size_t)written >= size) {
+            overflow = true;
+            return;
+        }
+        used += written;
+    }
+};
+
+#endif
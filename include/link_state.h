@@ -0,0 +1,75 @@
+#ifndef LINK_STATE_H
+#define LINK_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Стан BLE-з'єднання з Bluetti. Повтори та паузи між спробами - лише тут
+// (IDLE з дедлайном наступної спроби), а не в main.cpp
+enum class BluettiLinkState : uint8_t {
+    IDLE = 0,    // Немає з'єднання; чекаємо nextAttemptAt (backoff)
+    SCANNING,    // Активне сканування - пристрою немає в кеші advertisement
+    CONNECTING,  // client->connect()
+    DISCOVERING, // Сервіс і характеристики (або кешовані handles)
+    SUBSCRIBING, // Активація + CCCD
+    ONLINE,
+    COUNT
+};
+
+static constexpr size_t LINK_STATE_COUNT = static_cast<size_t>(BluettiLinkState::COUNT);
+
+// Експоненційний backoff: перша повторна спроба через 2 с, далі ×2 до
+// 5 хвилин (як колишній "повільний режим"), ±25% jitter
+static constexpr unsigned long LINK_BACKOFF_BASE_MS = 2000;
+static constexpr unsigned long LINK_BACKOFF_MAX_MS = 5UL * 60UL * 1000UL;
+
+const char* linkStateName(BluettiLinkState state);
+
+// Пауза перед наступною спробою після failures невдалих спроб поспіль
+// (failures >= 1). randomValue - будь-яке випадкове 32-бітне число
+unsigned long linkBackoffMs(uint8_t failures, uint32_t randomValue);
+
+// Облік стану з'єднання без NimBLE: поточний стан, час в останньому
+// перебуванні в кожному стані, невдалі спроби поспіль і дедлайн наступної.
+// Дії (сканування, connect) виконує BluettiDevice, переходи й паузи рахує
+// тут. Лише BLE worker
+class LinkStateMachine {
+public:
+    BluettiLinkState state() const { return current; }
+    unsigned long enteredAt() const { return stateEnteredAt; }
+    unsigned long durationMs(BluettiLinkState state) const {
+        return durations[static_cast<size_t>(state)];
+    }
+    uint8_t failures() const { return failureCount; }
+    unsigned long nextAttemptAt() const { return attemptAt; }
+
+    // false - уже в цьому стані (нічого не змінено)
+    bool enter(BluettiLinkState next, unsigned long now);
+    // IDLE і пауза backoff минула
+    bool attemptDue(unsigned long now) const {
+        return current == BluettiLinkState::IDLE && (long)(now - attemptAt) >= 0;
+    }
+    // Спроба триває (сканування, connect, discovery, підписка)
+    bool inSetup() const {
+        return current != BluettiLinkState::IDLE && current != BluettiLinkState::ONLINE &&
+               current != BluettiLinkState::COUNT;
+    }
+    // Невдала спроба: наступна - не раніше now + backoff. Повертає паузу
+    unsigned long recordFailure(unsigned long now, uint32_t randomValue);
+    void recordSuccess() { failureCount = 0; }
+    // Нова ціль або розрив робочого з'єднання - пробуємо одразу, без backoff
+    void retryNow(unsigned long now) {
+        failureCount = 0;
+        attemptAt = now;
+    }
+    void deferUntil(unsigned long at) { attemptAt = at; }
+
+private:
+    BluettiLinkState current = BluettiLinkState::IDLE;
+    unsigned long stateEnteredAt = 0;
+    unsigned long durations[LINK_STATE_COUNT] = {};
+    unsigned long attemptAt = 0;
+    uint8_t failureCount = 0;
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef LOCKFREE_QUEUE_H
+#define LOCKFREE_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Черги фіксованого розміру для передачі даних між задачами FreeRTOS без
+// mutex та без алокацій. N - степінь двійки, індекси 32-бітні (атомарні на ESP32).
+
+// Один виробник, один споживач. reserve()/commit() та front()/release()
+// дозволяють писати та читати запис прямо в слоті, без копії на стеку.
+template <typename T, size_t N>
+class SpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscQueue size must be a power of two");
+
+public:
+    // Виробник: вільний слот або nullptr, якщо черга повна
+    T* reserve() {
+        uint32_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == N) {
+            return nullptr;
+        }
+        return &slots[head & (N - 1)];
+    }
+
+    // Виробник: публікує слот, отриманий з reserve()
+    void commit() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool push(const T& item) {
+        T* slot = reserve();
+        if (!slot) {
+            return false;
+        }
+        *slot = item;
+        commit();
+        return true;
+    }
+
+    // Споживач: найстаріший запис або nullptr, якщо черга порожня
+    T* front() {
+        uint32_t tail = tail_.load(std::memory_order_relaxed);
+        if (head_.load(std::memory_order_acquire) == tail) {
+            return nullptr;
+        }
+        return &slots[tail & (N - 1)];
+    }
+
+    // Споживач: звільняє слот, отриманий з front()
+    void release() {
+        tail_.store(tail_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    bool pop(T& out) {
+        T* slot = front();
+        if (!slot) {
+            return false;
+        }
+        out = *slot;
+        release();
+        return true;
+    }
+
+    size_t size() const {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    T slots[N];
+    std::atomic<uint32_t> head_{0}; // Пише лише виробник
+    std::atomic<uint32_t> tail_{0}; // Пише лише споживач
+};
+
+// Багато виробників (loop, AsyncTCP), один споживач. Обмежена черга
+// Д. В'юкова: кожен слот має лічильник послідовності, виробники
+// резервують позицію через compare-exchange.
+template <typename T, size_t N>
+class MpscQueue {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "MpscQueue size must be a power of two");
+
+public:
+    MpscQueue() {
+        for (uint32_t i = 0; i < N; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const T& item) {
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& cell = cells[pos & (N - 1)];
+            uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+            int32_t diff = (int32_t)(sequence - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = item;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Черга повна
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T& out) {
+        Cell& cell = cells[dequeuePos & (N - 1)];
+        uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+        if ((int32_t)(sequence - (dequeuePos + 1)) < 0) {
+            return false; // Порожньо або виробник ще пише
+        }
+        out = cell.value;
+        cell.sequence.store(dequeuePos + N, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+    Cell cells[N];
+    std::atomic<uint32_t> enqueuePos{0};
+    uint32_t dequeuePos = 0; // Лише споживач
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef MODBUS_CRC_H
+#define MODBUS_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC16 MODBUS RTU (поліном 0xA001, відображений). Таблицю на 256 записів
+// будує компілятор, тож у flash лежить готовий масив, а на байт припадає
+// один пошук замість восьми зсувів.
+struct ModbusCrcTable {
+  uint16_t entries[256];
+};
+
+constexpr ModbusCrcTable makeModbusCrcTable() {
+  ModbusCrcTable table{};
+  for (uint16_t byte = 0; byte < 256; byte++) {
+    uint16_t crc = byte;
+    for (int j = 0; j < 8; j++) {
+      crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    table.entries[byte] = crc;
+  }
+  return table;
+}
+
+inline constexpr ModbusCrcTable MODBUS_CRC_TABLE = makeModbusCrcTable();
+
+// Функція для розрахунку CRC16 MODBUS RTU (працює і в constexpr)
+constexpr uint16_t calculateCRC16(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc = (crc >> 8) ^ MODBUS_CRC_TABLE.entries[(crc ^ data[i]) & 0xFF];
+  }
+  return crc;
+}
+
+static_assert(MODBUS_CRC_TABLE.entries[1] == 0xC0C1 && MODBUS_CRC_TABLE.entries[255] == 0x4040,
+              "Modbus CRC table does not match polynomial 0xA001");
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef MODBUS_FRAME_H
+#define MODBUS_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include "modbus_crc.h"
+
+static constexpr uint8_t MODBUS_DEVICE_ID = 0x01;
+static constexpr size_t MODBUS_MIN_FRAME = 5; // ID, function, 1 байт, CRC16
+static constexpr size_t MODBUS_REQUEST_SIZE = 8; // ID, function, addr(2), value(2), CRC16
+
+// Запит 0x03 (адреса + кількість) або 0x06 (адреса + значення)
+struct ModbusRequestFrame {
+    uint8_t bytes[MODBUS_REQUEST_SIZE];
+};
+
+constexpr ModbusRequestFrame buildModbusRequest(uint8_t function, uint16_t address, uint16_t value) {
+    ModbusRequestFrame frame{{MODBUS_DEVICE_ID, function,
+                              (uint8_t)(address >> 8), (uint8_t)(address & 0xFF),
+                              (uint8_t)(value >> 8), (uint8_t)(value & 0xFF), 0, 0}};
+    uint16_t crc = calculateCRC16(frame.bytes, MODBUS_REQUEST_SIZE - 2);
+    frame.bytes[6] = crc & 0xFF;        // CRC low byte
+    frame.bytes[7] = (crc >> 8) & 0xFF; // CRC high byte
+    return frame;
+}
+
+// Незмінний запит, зібраний разом з CRC під час компіляції
+template <uint8_t Function, uint16_t Address, uint16_t Value>
+inline constexpr ModbusRequestFrame MODBUS_CONSTANT_REQUEST = buildModbusRequest(Function, Address, Value);
+
+constexpr bool modbusRequestEquals(const ModbusRequestFrame& frame, const uint8_t (&expected)[MODBUS_REQUEST_SIZE]) {
+    for (size_t i = 0; i < MODBUS_REQUEST_SIZE; i++) {
+        if (frame.bytes[i] != expected[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Кадри, які раніше збиралися вручну, - побайтово, разом з CRC
+static constexpr uint8_t MODBUS_STATUS_POLL_BYTES[] = {0x01, 0x03, 0x00, 0x0A, 0x00, 0x28, 0x65, 0xD6};
+static constexpr uint8_t MODBUS_AC_ON_BYTES[] = {0x01, 0x06, 0x0B, 0xBF, 0x00, 0x01, 0x7B, 0xCA};
+static constexpr uint8_t MODBUS_AC_OFF_BYTES[] = {0x01, 0x06, 0x0B, 0xBF, 0x00, 0x00, 0xBA, 0x0A};
+static constexpr uint8_t MODBUS_DC_ON_BYTES[] = {0x01, 0x06, 0x0B, 0xC0, 0x00, 0x01, 0x4A, 0x12};
+static constexpr uint8_t MODBUS_DC_OFF_BYTES[] = {0x01, 0x06, 0x0B, 0xC0, 0x00, 0x00, 0x8B, 0xD2};
+static_assert(modbusRequestEquals(MODBUS_CONSTANT_REQUEST<0x03, 0x000A, 40>, MODBUS_STATUS_POLL_BYTES),
+              "Status poll frame differs from the reference bytes");
+static_assert(modbusRequestEquals(MODBUS_CONSTANT_REQUEST<0x06, 0x0BBF, 1>, MODBUS_AC_ON_BYTES) &&
+              modbusRequestEquals(MODBUS_CONSTANT_REQUEST<0x06, 0x0BBF, 0>, MODBUS_AC_OFF_BYTES) &&
+              modbusRequestEquals(MODBUS_CONSTANT_REQUEST<0x06, 0x0BC0, 1>, MODBUS_DC_ON_BYTES) &&
+              modbusRequestEquals(MODBUS_CONSTANT_REQUEST<0x06, 0x0BC0, 0>, MODBUS_DC_OFF_BYTES),
+              "Output toggle frames differ from the reference bytes");
+
+// Які кадри приходять від Bluetti
+enum class ModbusFrameType : uint8_t {
+    READ_RESPONSE = 0, // 0x03: byte count + регістри
+    WRITE_ECHO,        // 0x06: адреса + записане значення
+    EXCEPTION,         // 0x83/0x86: код помилки
+};
+
+// Причина, з якої кадр відкинуто (NONE - кадр валідний)
+enum class ModbusFrameError : uint8_t {
+    NONE = 0,
+    TOO_SHORT,     // Менше за мінімальний кадр
+    BAD_DEVICE_ID,
+    BAD_FUNCTION,  // Function code, який Bluetti не надсилає
+    BAD_LENGTH,    // Довжина не збігається з byte count / типом кадру
+    BAD_CRC,
+    COUNT
+};
+
+static constexpr size_t MODBUS_FRAME_ERROR_COUNT = static_cast<size_t>(ModbusFrameError::COUNT);
+
+// Типізований вигляд кадру поверх вихідного буфера - нічого не копіює,
+// дійсний, поки живий буфер. Поля, що не стосуються типу, дорівнюють 0.
+struct ModbusFrameView {
+    ModbusFrameType type = ModbusFrameType::READ_RESPONSE;
+    uint8_t function = 0;        // Як у кадрі (з бітом 0x80 для exception)
+    const uint8_t* data = nullptr; // Весь кадр разом з CRC
+    size_t length = 0;
+    const uint8_t* payload = nullptr; // READ_RESPONSE: дані регістрів (big-endian)
+    uint8_t byteCount = 0;
+    uint16_t address = 0;        // WRITE_ECHO
+    uint16_t value = 0;          // WRITE_ECHO
+    uint8_t exceptionCode = 0;   // EXCEPTION
+
+    // Function code запиту, на який відповідає кадр (0x83 -> 0x03)
+    uint8_t requestFunction() const { return function & 0x7F; }
+    uint16_t registerCount() const { return byteCount / 2; }
+    // Без перевірки меж: index < registerCount()
+    uint16_t registerAt(uint16_t index) const {
+        return (payload[index * 2] << 8) | payload[index * 2 + 1];
+    }
+};
+
+// Повна довжина кадру за першими байтами: 0 - потрібно більше байт,
+// SIZE_MAX - початок буфера не схожий на кадр Bluetti
+size_t modbusFrameLength(const uint8_t* data, size_t available);
+
+// Перевіряє ID, function code, довжину та CRC рівно length байт і заповнює view.
+// Безпечна для будь-якого вводу: не читає за межами [data, data + length)
+ModbusFrameError parseModbusFrame(const uint8_t* data, size_t length, ModbusFrameView& view);
+
+const char* modbusFrameErrorName(ModbusFrameError error);
+
+#endif
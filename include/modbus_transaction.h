@@ -0,0 +1,131 @@
+#ifndef MODBUS_TRANSACTION_H
+#define MODBUS_TRANSACTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include "modbus_frame.h"
+
+// Тип транзакції визначає, як інтерпретувати відповідь
+enum class ModbusTxnKind : uint8_t {
+    STATUS_POLL = 0,   // Читання основного блоку регістрів (0x03, 40 регістрів)
+    READ_REGISTER,     // Читання окремого регістра (0x03, 1 регістр)
+    WRITE_REGISTER,    // Запис одного регістра (0x06)
+    POWER_SAMPLE,      // Burst-режим: лише регістри потужності (0x03)
+};
+
+// Пріоритет у черзі: команди користувача випереджають фонове опитування
+enum class ModbusPriority : uint8_t {
+    POLL = 0,
+    USER_READ = 1,
+    USER_WRITE = 2,
+};
+
+struct ModbusTransaction {
+    ModbusTxnKind kind = ModbusTxnKind::STATUS_POLL;
+    ModbusPriority priority = ModbusPriority::POLL;
+    uint8_t function = 0x03;   // Modbus function code
+    uint16_t address = 0;      // Початковий регістр
+    uint16_t value = 0;        // Кількість регістрів (0x03) або значення (0x06)
+    uint8_t retriesLeft = 0;   // Скільки разів повторити після таймауту
+    uint16_t timeoutMs = 2000; // Скільки чекати відповідь на одну спробу
+    unsigned long enqueuedAt = 0; // Час постановки в чергу (для latency команд)
+    unsigned long sentAt = 0;  // Час відправки (millis)
+    unsigned long deadline = 0; // Час, після якого спроба вважається втраченою
+    uint16_t ticket = 0;       // Запис, про результат якого чекає викликач (0 - ніхто)
+};
+
+enum class ModbusExpireResult : uint8_t {
+    NONE = 0,  // Нічого не прострочено
+    RETRY,     // Спроба втрачена, транзакцію повернуто в голову черги
+    FAILED,    // Ліміт повторів вичерпано або повна черга не має місця для повтору
+};
+
+// Неблокуючий рушій транзакцій: обмежена черга з пріоритетами та одна
+// транзакція "в польоті" з дедлайном. Відповідь завершує транзакцію з
+// notification callback і зіставляється з запитом за function code та
+// адресою/довжиною, loop() лише відправляє наступну та перевіряє дедлайн.
+class ModbusTransactionEngine {
+public:
+    static constexpr size_t QUEUE_CAPACITY = 8;
+    static constexpr size_t FRAME_SIZE = MODBUS_REQUEST_SIZE;
+
+    // Додає транзакцію в чергу. Дублікати (той самий запит уже в черзі)
+    // відкидаються як успіх. Коли черга повна, нова транзакція витісняє
+    // останню з нижчим пріоритетом; інакше повертається false.
+    // Витіснена транзакція з ticket чекає у takeEvicted().
+    bool enqueue(const ModbusTransaction& transaction, unsigned long now);
+
+    // Забирає голову черги у "політ" (дедлайн від now). Викликати ДО відправки:
+    // відповідь може прийти в callback раніше, ніж запис поверне керування.
+    bool startNext(unsigned long now, ModbusTransaction& out);
+
+    // Відправка не вдалася - рахується як спроба (повтор або відмова)
+    ModbusExpireResult sendFailed();
+
+    // Завершує транзакцію в польоті, якщо кадр є відповіддю саме на неї:
+    // 0x03 - byte count дорівнює 2 * кількість регістрів,
+    // 0x06 - echo з тією ж адресою, 0x8X - exception на той самий function code.
+    bool complete(const ModbusFrameView& frame, unsigned long now);
+
+    // Перевіряє дедлайн транзакції в польоті
+    ModbusExpireResult expire(unsigned long now);
+
+    // Остання транзакція, що була в польоті (дійсна і після complete/expire)
+    const ModbusTransaction& current() const { return txn; }
+    bool isBusy() const { return inFlight; }
+    size_t queued() const { return count; }
+    bool hasQueued(ModbusTxnKind kind, uint16_t address) const;
+    // Скидає чергу та транзакцію в польоті; витіснені лишаються для takeEvicted()
+    void clear();
+
+    // Наступна транзакція з ticket, яку витіснили з повної черги (новий запит
+    // вищого пріоритету або повтор). Викликач має завершити її запис (NOT_SENT)
+    bool takeEvicted(ModbusTransaction& out);
+
+    // Обходить транзакцію в польоті та чергу (напр. щоб звітувати про
+    // незавершені записи перед clear())
+    template <typename Fn>
+    void forEachPending(Fn fn) const {
+        if (inFlight) {
+            fn(txn);
+        }
+        for (size_t i = 0; i < count; i++) {
+            fn(queue[i]);
+        }
+    }
+
+    // Час "тиші" після відповіді - Bluetti потребує паузи між запитами
+    void holdOff(unsigned long until) { quietUntil = until; }
+    bool canSend(unsigned long now) const;
+
+    static size_t buildFrame(const ModbusTransaction& transaction, uint8_t* out);
+
+    uint32_t getCompleted() const { return completedCount; }
+    uint32_t getTimeouts() const { return timeoutCount; }
+    uint32_t getRetries() const { return retryCount; }
+    uint32_t getDropped() const { return droppedCount; }
+    unsigned long getLastLatency() const { return lastLatency; }
+
+private:
+    ModbusTransaction queue[QUEUE_CAPACITY]; // Відсортовано: пріоритет, потім FIFO
+    size_t count = 0;
+    ModbusTransaction txn;
+    bool inFlight = false;
+    // Витіснені транзакції з ticket (FIFO); між викликами takeEvicted() їх
+    // не більше, ніж вміщує черга
+    ModbusTransaction evicted[QUEUE_CAPACITY];
+    size_t evictedHead = 0;
+    size_t evictedCount = 0;
+    unsigned long quietUntil = 0;
+    uint32_t completedCount = 0;
+    uint32_t timeoutCount = 0;
+    uint32_t retryCount = 0;
+    uint32_t droppedCount = 0;
+    unsigned long lastLatency = 0;
+
+    void insertSorted(const ModbusTransaction& transaction, bool front);
+    void evictYoungest();
+    ModbusExpireResult failAttempt();
+};
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef MQTT_DEADBAND_H
+#define MQTT_DEADBAND_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Поля стану, що публікуються в MQTT (кожне - окремий retained топік)
+enum class StateField : uint8_t {
+    BATTERY = 0,
+    VOLTAGE,
+    AC_POWER,
+    DC_POWER,
+    INPUT_POWER,
+    TEMPERATURE,
+    AC_OUTPUT,
+    DC_OUTPUT,
+    CHARGING_SPEED,
+    ECO_MODE,
+    POWER_LIFTING,
+    LED_MODE,
+    LED_SWITCH,
+    ECO_SHUTDOWN,
+    COUNT
+};
+
+static constexpr size_t STATE_FIELD_COUNT = static_cast<size_t>(StateField::COUNT);
+
+// Значення публікується, коли відходить від останнього опублікованого
+// щонайменше на max(absolute, relative * |останнє|). Нулі - будь-яка зміна;
+// перехід до точного 0 або з нього публікується незалежно від порогу
+struct Deadband {
+    float absolute; // В одиницях поля (W, %, V, °C)
+    float relative; // Частка від останнього опублікованого (0.05 = 5%)
+};
+
+// Потужності шумлять на кілька ват між опитуваннями - без deadband кожне
+// опитування переписувало б retained топіки та базу recorder
+static constexpr Deadband DEFAULT_DEADBANDS[STATE_FIELD_COUNT] = {
+    {1.0f, 0.0f},   // BATTERY, %
+    {0.2f, 0.0f},   // VOLTAGE, V
+    {5.0f, 0.05f},  // AC_POWER, W
+    {5.0f, 0.05f},  // DC_POWER, W
+    {5.0f, 0.05f},  // INPUT_POWER, W
+    {0.5f, 0.0f},   // TEMPERATURE, °C
+    {0.0f, 0.0f},   // AC_OUTPUT
+    {0.0f, 0.0f},   // DC_OUTPUT
+    {0.0f, 0.0f},   // CHARGING_SPEED
+    {0.0f, 0.0f},   // ECO_MODE
+    {0.0f, 0.0f},   // POWER_LIFTING
+    {0.0f, 0.0f},   // LED_MODE
+    {0.0f, 0.0f},   // LED_SWITCH
+    {0.0f, 0.0f},   // ECO_SHUTDOWN
+};
+
+// Раз на стільки всі поля публікуються незалежно від deadband: retained
+// значення в брокері не застарівають, а дрейф у межах deadband доганяється
+static constexpr unsigned long MQTT_HEARTBEAT_DEFAULT_MS = 5UL * 60 * 1000;
+static constexpr unsigned long MQTT_HEARTBEAT_MIN_MS = 30000;
+// Не частіше за цей інтервал перевіряємо зміни (burst оновлює потужності щосекунди)
+static constexpr unsigned long MQTT_CHANGE_CHECK_MS = 1000;
+
+bool deadbandExceeded(float last, float value, const Deadband& band);
+
+// Останні опубліковані значення одного пристрою
+class DeadbandFilter {
+public:
+    // true - поле треба опублікувати (force, перша публікація або вихід за
+    // deadband); тоді value запам'ятовується як опубліковане
+    bool admit(StateField field, float value, const Deadband& band, bool force);
+    void forget() { known = 0; } // Нове з'єднання - наступна перевірка опублікує все
+
+private:
+    float last[STATE_FIELD_COUNT] = {};
+    uint32_t known = 0; // Біт на поле: значення вже публікувалося
+};
+
+#endif
@@ -5,37 +5,177 @@
 #include <WiFi.h>
 #include <PubSubClient.h>
 #include <ArduinoJson.h>
-#include "bluetti_device.h"
+#include <atomic>
+#include "bluetti_manager.h"
+#include "mqtt_deadband.h"
+#include "seqlock.h"
+#include "status_changes.h"
 #include "system_status.h"
 
+// Групи, які публікуються в окремі топіки
+static constexpr uint16_t MQTT_STATUS_GROUPS =
+    statusBit(StatusGroup::BATTERY) | statusBit(StatusGroup::AC_POWER) |
+    statusBit(StatusGroup::DC_POWER) | statusBit(StatusGroup::INPUT_POWER) |
+    statusBit(StatusGroup::OUTPUT_STATES) | statusBit(StatusGroup::TEMPERATURE) |
+    statusBit(StatusGroup::SETTINGS);
+
+// Як публікується стан: окремий retained топік на поле (як раніше) або один
+// JSON-документ "<base>/state", з якого HA бере поля через value_template
+enum class MqttStateMode : uint8_t {
+    PER_TOPIC = 0,
+    JSON,
+};
+
+const char* mqttStateModeName(MqttStateMode mode);
+
+struct StateValue; // Поточне значення поля стану (mqtt_handler.cpp)
+
+// Заздалегідь виділений буфер JSON-стану (~250 байт для EB3A)
+static constexpr size_t MQTT_STATE_JSON_SIZE = 384;
+// Пакет burst-вибірок: {"start":N,"samples":[[+ms,W,W,W,W],...]}, рядок до 40 байт
+static constexpr size_t MQTT_BURST_JSON_SIZE = 32 + BURST_BATCH_SAMPLES * 40;
+// Вікно, за яке рахуються пакети/с та байти/с топіків стану
+static constexpr unsigned long MQTT_RATE_WINDOW_MS = 60000;
+
+// Електростанція в MQTT: власні топіки, discovery та курсор змін.
+// Пристрій 0 - "homeassistant/bluetti/<slug>" (як до підтримки кількох
+// пристроїв), решта - "<slug>_<номер>", щоб сутності в HA не перетиналися
+struct MqttDeviceChannel {
+    uint8_t index = 0;
+    BluettiDevice* device = nullptr;
+    SeqLock<SystemStatus>* snapshot = nullptr; // Лише читання
+    StatusChangeCursor changes{MQTT_STATUS_GROUPS};
+    DeadbandFilter published;                  // Останні опубліковані значення полів
+    const DeviceProfile* profile = nullptr;    // Модель, під яку підписані команди та опубліковано discovery
+    char topicBase[48] = "";                   // "homeassistant/bluetti/<slug>[_<n>]"
+    char deviceId[40] = "";                    // "bluetti_<slug>[_<n>]" - ідентифікатор пристрою в HA
+    char deviceName[32] = "";                  // "Bluetti EB3A[ #n]"
+    bool announced = false;   // Підписки та discovery опубліковані
+    unsigned long lastBurstPublish = 0;
+    unsigned long lastHeartbeat = 0;           // Остання повна публікація
+    bool writeSettled = false; // Запис завершився - опублікувати стан, не чекаючи 5 с
+    bool writeFailed = false;  // ...повністю, щоб HA повернув перемикач до фактичного стану
+};
+
 class MQTTHandler {
 public:
-    MQTTHandler(BluettiDevice* device, SystemStatus* status);
+    MQTTHandler(BluettiManager* manager, SystemStatus* status);
     void configure(const char* server, uint16_t port, const char* user = nullptr, const char* pass = nullptr);
     void loop(bool wifiReady);
     bool isConnected();
-    void republishDiscovery(); // Публічний метод для повторної публікації Discovery
+    // Будь-яка задача. Discovery повторюється, лише якщо набір змінився
+    // відносно збереженого хешу; force - безумовно
+    void republishDiscovery(bool force = false);
+
+    // Будь-яка задача; діє з наступної перевірки змін
+    void setDeadband(StateField field, const Deadband& band) {
+        deadbandAbsolute[static_cast<size_t>(field)].store(band.absolute, std::memory_order_relaxed);
+        deadbandRelative[static_cast<size_t>(field)].store(band.relative, std::memory_order_relaxed);
+    }
+    Deadband getDeadband(StateField field) const {
+        return {deadbandAbsolute[static_cast<size_t>(field)].load(std::memory_order_relaxed),
+                deadbandRelative[static_cast<size_t>(field)].load(std::memory_order_relaxed)};
+    }
+    void setHeartbeatMs(unsigned long ms) {
+        heartbeatMs.store(ms < MQTT_HEARTBEAT_MIN_MS ? MQTT_HEARTBEAT_MIN_MS : ms, std::memory_order_relaxed);
+    }
+    unsigned long getHeartbeatMs() const { return heartbeatMs.load(std::memory_order_relaxed); }
+    // Будь-яка задача; loop() переопублікує discovery і стан у новому режимі
+    void setStateMode(MqttStateMode mode) { stateMode.store(mode, std::memory_order_relaxed); }
+    MqttStateMode getStateMode() const { return stateMode.load(std::memory_order_relaxed); }
+    // Трафік топіків стану: пакети та байти (топік + payload) з початку роботи
+    // і за останнє повне вікно MQTT_RATE_WINDOW_MS
+    uint32_t getStatePackets() const { return statePackets.load(std::memory_order_relaxed); }
+    uint32_t getStateBytes() const { return stateBytes.load(std::memory_order_relaxed); }
+    float getStatePacketsPerSec() const { return packetsPerMinute.load(std::memory_order_relaxed) / 60.0f; }
+    float getStateBytesPerSec() const { return bytesPerMinute.load(std::memory_order_relaxed) / 60.0f; }
+    // Лічильники полів стану: скільки опубліковано і скільки пропущено deadband
+    uint32_t getStatePublished() const { return statePublished.load(std::memory_order_relaxed); }
+    uint32_t getStateSkipped() const { return stateSkipped.load(std::memory_order_relaxed); }
+    uint32_t getHeartbeats() const { return heartbeats.load(std::memory_order_relaxed); }
+    // Останній burst discovery: тривалість, найбільше падіння вільної heap, кількість
+    uint32_t getDiscoveryMicros() const { return discoveryMicros.load(std::memory_order_relaxed); }
+    uint32_t getDiscoveryHeapPeak() const { return discoveryHeapPeak.load(std::memory_order_relaxed); }
+    uint32_t getDiscoveryBursts() const { return discoveryBursts.load(std::memory_order_relaxed); }
+    // Підключення, на яких discovery не публікувався (хеш збігся)
+    uint32_t getDiscoverySkipped() const { return discoverySkipped.load(std::memory_order_relaxed); }
+    // Від підключення до брокера до першої публікації стану (останнє підключення)
+    uint32_t getFirstStateMs() const { return firstStateMs.load(std::memory_order_relaxed); }
 
 private:
     WiFiClient wifiClient;
     PubSubClient mqttClient;
-    BluettiDevice* bluetti;
     SystemStatus* status;
+    MqttDeviceChannel channels[BLUETTI_MAX_DEVICES];
 
     String serverHost;
     uint16_t serverPort;
     String username;
     String password;
-    unsigned long lastPublish;
+    unsigned long lastChangeCheck;
+    // Пише AsyncTCP (сторінка налаштувань), читає loop(). Межі - окремі атоміки:
+    // одна перевірка зі старим absolute і новим relative нешкідлива
+    std::atomic<float> deadbandAbsolute[STATE_FIELD_COUNT];
+    std::atomic<float> deadbandRelative[STATE_FIELD_COUNT];
+    std::atomic<unsigned long> heartbeatMs;
+    std::atomic<uint32_t> statePublished{0};
+    std::atomic<uint32_t> stateSkipped{0};
+    std::atomic<uint32_t> heartbeats{0};
+    std::atomic<uint32_t> discoveryMicros{0};
+    std::atomic<uint32_t> discoveryHeapPeak{0};
+    std::atomic<uint32_t> discoveryBursts{0};
+    std::atomic<uint32_t> discoverySkipped{0};
+    std::atomic<uint32_t> firstStateMs{0};
+    std::atomic<bool> discoveryRequested{false}; // Birth message HA або /republish_discovery
+    std::atomic<bool> discoveryForced{false};
+    unsigned long connectedAt = 0;
+    bool firstStatePending = false;
+    std::atomic<MqttStateMode> stateMode{MqttStateMode::PER_TOPIC};
+    MqttStateMode appliedMode = MqttStateMode::PER_TOPIC; // Режим опублікованого discovery
+    char stateJson[MQTT_STATE_JSON_SIZE];
+    char burstJson[MQTT_BURST_JSON_SIZE];
+    std::atomic<uint32_t> statePackets{0};
+    std::atomic<uint32_t> stateBytes{0};
+    std::atomic<uint32_t> packetsPerMinute{0};
+    std::atomic<uint32_t> bytesPerMinute{0};
+    unsigned long rateWindowStart = 0;
+    uint32_t rateWindowPackets = 0;
+    uint32_t rateWindowBytes = 0;
     unsigned long lastMqttAttempt;
     bool mqttConnecting;
 
     bool ensureConnection();
     void onMessage(char* topic, byte* payload, unsigned int length);
-    void publishStatus();
-    void publishDiscovery();
+    // Пристрій 0 оголошується одразу, решта - після першого підключення
+    bool shouldAnnounce(const MqttDeviceChannel& channel) const;
+    void announce(MqttDeviceChannel& channel);
+    // Поля змінених груп, що вийшли за deadband; force - усі поля
+    void publishStatus(MqttDeviceChannel& channel, bool force);
+    void applyStateMode(MqttStateMode mode);
+    void publishStateDocument(MqttDeviceChannel& channel, const StateValue* values, size_t count,
+                              uint16_t changed, bool force);
+    void countStatePacket(size_t topicLength, size_t payloadLength);
+    void updateTrafficRates(unsigned long now);
+    // Рішення deadband для одного поля (з підрахунком пропусків)
+    bool admit(MqttDeviceChannel& channel, StateField field, float value, bool force);
+    // Хеш усього набору конфігів пристрою (FNV-1a по тих самих байтах)
+    uint32_t discoveryHash(const MqttDeviceChannel& channel) const;
+    // Публікує discovery, якщо хеш відрізняється від збереженого в NVS (або force)
+    void syncDiscovery(MqttDeviceChannel& channel, bool force);
+    bool publishDiscovery(MqttDeviceChannel& channel); // false - не все опубліковано
+    // Порожні retained конфігурації - HA прибирає сутності моделі
+    void clearDiscovery(const MqttDeviceChannel& channel);
+    void subscribeCommands(const MqttDeviceChannel& channel, bool subscribe = true);
+    // Модель визначилась або змінилась: нові топіки, підписки та discovery
+    void applyProfile(MqttDeviceChannel& channel, const DeviceProfile& next);
+    void publishValue(const MqttDeviceChannel& channel, const char* suffix, const char* value);
+    // Частина топіка після topicBase ("ac_output/set"); nullptr - чужий топік
+    static const char* commandSuffix(const MqttDeviceChannel& channel, const char* topic);
+    static void setIdentity(MqttDeviceChannel& channel, const DeviceProfile& profile);
+    void publishBurstSamples(MqttDeviceChannel& channel);
 
     static void callbackThunk(char* topic, byte* payload, unsigned int length);
+    static void writeResultThunk(const WriteResult& result, void* context);
     static MQTTHandler* instance;
 };
 
@@ -0,0 +1,57 @@
+#ifndef NOTIFICATION_REASSEMBLER_H
+#define NOTIFICATION_REASSEMBLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "modbus_frame.h"
+
+// Збирає Modbus кадри з BLE notifications.
+// Відповідь на 40 регістрів (85 байт) більша за payload стандартного ATT MTU,
+// тому приходить кількома фрагментами. Межі кадру визначаються за function code
+// та byte count, кадр-кандидат перевіряє parseModbusFrame(); назовні віддаються
+// лише валідні кадри, відкинуті рахуються за причиною.
+//
+// Кільцевий буфер "дзеркальний": кожен байт пишеться двічі (i та i + CAPACITY),
+// тож будь-який кадр довжиною <= CAPACITY лежить у пам'яті суцільно і
+// передається обробнику вказівником без копіювання. Жодних алокацій.
+class NotificationReassembler {
+public:
+    // Найдовший кадр 0x03: 5 + 255 байт даних
+    static constexpr size_t CAPACITY = 264;
+    // Незавершений кадр, старший за цей час, відкидається при новому фрагменті
+    static constexpr unsigned long STALE_FRAGMENT_MS = 1000;
+
+    void push(const uint8_t* data, size_t length, unsigned long now);
+
+    // Повертає наступний валідний кадр. View дійсний до наступного push()/reset().
+    bool nextFrame(ModbusFrameView& frame);
+
+    void reset();
+    size_t pending() const { return count; }
+
+    uint32_t getFramesAssembled() const { return framesAssembled; }
+    uint32_t getFragmentedFrames() const { return fragmentedFrames; }
+    uint32_t getCrcErrors() const { return getRejected(ModbusFrameError::BAD_CRC); }
+    uint32_t getRejected(ModbusFrameError reason) const { return rejected[static_cast<size_t>(reason)]; }
+    uint32_t getRejectedTotal() const;
+    uint32_t getBytesDropped() const { return bytesDropped; }
+    // Зі скількох notifications зібрано останній кадр (1 = без фрагментації)
+    uint8_t getLastFrameFragments() const { return lastFrameFragments; }
+
+private:
+    uint8_t buffer[CAPACITY * 2];
+    size_t head = 0;   // Індекс першого непрочитаного байта (0..CAPACITY-1)
+    size_t count = 0;  // Кількість байт у буфері
+    uint8_t fragmentsInFrame = 0; // Скільки push() припало на поточний кадр
+    uint8_t lastFrameFragments = 0;
+    unsigned long lastFragmentAt = 0;
+
+    uint32_t framesAssembled = 0;
+    uint32_t fragmentedFrames = 0;
+    uint32_t rejected[MODBUS_FRAME_ERROR_COUNT] = {}; // Кандидати, які не пройшли парсер
+    uint32_t bytesDropped = 0;
+
+    void drop(size_t bytes);
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef POLL_PLANNER_H
+#define POLL_PLANNER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Максимум регістрів в одному запиті 0x03 (обмеження Modbus PDU)
+static constexpr uint16_t MODBUS_MAX_READ_REGISTERS = 125;
+// Скільки непотрібних регістрів між запитаними дозволено прочитати заради
+// об'єднання: 2 зайві байти на регістр дешевші за окремий BLE round trip
+static constexpr uint16_t POLL_PLANNER_MAX_GAP = 4;
+
+struct PollRange {
+    uint16_t start;
+    uint16_t count;
+};
+
+// Об'єднує регістри (у будь-якому порядку, дублікати допустимі) у мінімум
+// діапазонів не довших за maxRegistersPerRead. Повертає кількість діапазонів,
+// записаних у ranges (не більше maxRanges).
+size_t planRegisterReads(const uint16_t* registers, size_t count,
+                         uint16_t maxRegistersPerRead, uint16_t maxGap,
+                         PollRange* ranges, size_t maxRanges);
+
+#endif
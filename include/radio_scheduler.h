@@ -0,0 +1,73 @@
+#ifndef RADIO_SCHEDULER_H
+#define RADIO_SCHEDULER_H
+
+#include <cstddef>
+
+// Що BluettiManager дозволяє пристрою на цій ітерації BLE worker
+struct RadioSlot {
+    bool maySetup;    // Почати спробу підключення: сканування та connect() - лише один пристрій
+    bool mayDispatch; // Відправити наступну Modbus-транзакцію
+};
+
+// Розподіл одного радіо між N пристроями. Налаштування з'єднання (сканування,
+// connect) - лише в одного пристрою одночасно, відправка Modbus-запиту - одна
+// за ітерацію; обидві черги йдуть по колу від пристрою після останнього
+// обслуженого, тож жоден пристрій не монополізує ефір.
+//
+// Peer: wantsLinkSetup(now), inLinkSetup() та loop(const RadioSlot&) -> true,
+// якщо пристрій використав дозвіл на відправку. Лише BLE worker.
+template <size_t N>
+class RadioScheduler {
+public:
+    // Кому дозволити налаштування на цій ітерації (-1 - нікому): поки власник
+    // не стане ONLINE або не повернеться в IDLE, решта чекає
+    template <typename Peer>
+    int grantSetup(Peer (&peers)[N], unsigned long now) {
+        if (owner >= 0 && !peers[owner].inLinkSetup()) {
+            owner = -1;
+        }
+        if (owner >= 0) {
+            return -1;
+        }
+        for (size_t step = 0; step < N; step++) {
+            size_t i = (nextSetup + step) % N;
+            if (peers[i].wantsLinkSetup(now)) {
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Кожен пристрій обробляє свої notifications і команди щоітерації, але
+    // запит у ефір відправляє лише перший готовий, починаючи з наступного
+    // після попереднього відправника. Повертає відправника або -1
+    template <typename Peer>
+    int run(Peer (&peers)[N], int grant) {
+        size_t start = nextDispatch;
+        int dispatcher = -1;
+        for (size_t step = 0; step < N; step++) {
+            size_t i = (start + step) % N;
+            RadioSlot slot = {static_cast<int>(i) == grant, dispatcher < 0};
+            if (peers[i].loop(slot) && dispatcher < 0) {
+                dispatcher = static_cast<int>(i);
+                nextDispatch = (i + 1) % N;
+            }
+        }
+        if (grant >= 0) {
+            nextSetup = (grant + 1) % N;
+            if (peers[grant].inLinkSetup()) {
+                owner = grant;
+            }
+        }
+        return dispatcher;
+    }
+
+    int setupOwner() const { return owner; }
+
+private:
+    int owner = -1;           // Пристрій, що зараз налаштовує з'єднання
+    size_t nextSetup = 0;     // З кого починати пошук наступного налаштування
+    size_t nextDispatch = 0;  // З кого починати роздачу слоту на відправку
+};
+
+#endif
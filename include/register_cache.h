@@ -0,0 +1,67 @@
+#ifndef REGISTER_CACHE_H
+#define REGISTER_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "seqlock.h"
+
+// Блок статусу (40) + додаткові функції та запасні місця
+static constexpr size_t REGISTER_CACHE_CAPACITY = 48;
+
+struct CachedRegister {
+    uint16_t address;
+    uint16_t value;           // Сире значення, як у кадрі
+    uint32_t ttlMs;           // Скільки значення вважається свіжим
+    unsigned long capturedAt; // millis() відповіді, з якої взято значення
+};
+
+// Впорядковано за адресою
+struct RegisterCacheTable {
+    CachedRegister entries[REGISTER_CACHE_CAPACITY];
+    uint8_t count;
+
+    const CachedRegister* find(uint16_t address) const;
+};
+
+enum class CacheLookup : uint8_t {
+    HIT = 0, // Значення свіже
+    STALE,   // Значення є, але старше за TTL
+    MISS,    // Регістр ще не читали
+};
+
+// Останні прочитані значення регістрів з часом отримання. Пише лише BLE
+// worker (кожна відповідь 0x03 та підтверджений запис), читачі беруть
+// знімок через SeqLock і бачать, наскільки старе кожне значення.
+class RegisterCache {
+public:
+    // Лише worker. Зміни стають видимі читачам після publish()
+    void store(uint16_t address, uint16_t value, uint32_t ttlMs, unsigned long now);
+    void publish();
+
+    // Будь-яка задача: count регістрів одним знімком, рахує hit/stale/miss.
+    // Повертає найгірший результат серед них
+    CacheLookup lookup(const uint16_t* addresses, size_t count, unsigned long now, CachedRegister* out) const;
+    void snapshot(RegisterCacheTable& out) const { published.read(out); }
+
+    void noteRefresh() { refreshes.fetch_add(1, std::memory_order_relaxed); }
+    uint32_t getHits() const { return hits.load(std::memory_order_relaxed); }
+    uint32_t getStale() const { return stale.load(std::memory_order_relaxed); }
+    uint32_t getMisses() const { return misses.load(std::memory_order_relaxed); }
+    uint32_t getRefreshes() const { return refreshes.load(std::memory_order_relaxed); }
+    uint32_t getDropped() const { return dropped; }
+
+private:
+    RegisterCacheTable working = {}; // Лише worker
+    SeqLock<RegisterCacheTable> published;
+    bool changed = false;
+    uint32_t dropped = 0;            // Нових регістрів не вмістилося
+    mutable std::atomic<uint32_t> hits{0};
+    mutable std::atomic<uint32_t> stale{0};
+    mutable std::atomic<uint32_t> misses{0};
+    std::atomic<uint32_t> refreshes{0};
+};
+
+const char* cacheLookupName(CacheLookup result);
+
+#endif
@@ -0,0 +1,77 @@
+#ifndef REGISTER_CAPABILITIES_H
+#define REGISTER_CAPABILITIES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "seqlock.h"
+
+// Версія формату запису в NVS - при зміні структури старі записи ігноруються
+static constexpr uint8_t REGISTER_CAPS_VERSION = 1;
+static constexpr size_t REGISTER_CAPS_CAPACITY = 16;
+static constexpr size_t REGISTER_CAPS_MODEL_SIZE = 5; // Як SystemStatus::modelName
+
+enum class RegisterSupport : uint8_t {
+    UNKNOWN = 0,
+    SUPPORTED,   // Пристрій відповів даними / echo
+    REJECTED,    // Exception "недопустима функція/адреса" - більше не запитуємо
+};
+
+struct RegisterCapability {
+    uint16_t address;
+    RegisterSupport read;
+    RegisterSupport write;
+    uint16_t writeFallback; // Регістр, що приймає запис замість address (0 - немає)
+};
+
+// Що модель вміє, дізнане з відповідей. Зберігається цілком в NVS
+// (namespace "reg_caps", ключ - назва моделі), ~110 байт
+struct RegisterCapabilityTable {
+    uint8_t version;
+    uint8_t count;
+    bool rangeReadsRejected; // Читання діапазону відхилено - опитуємо по одному регістру
+    char model[REGISTER_CAPS_MODEL_SIZE];
+    RegisterCapability entries[REGISTER_CAPS_CAPACITY];
+};
+
+// Кеш можливостей регістрів для підключеної моделі. Пише лише BLE worker,
+// решта задач читає знімок через SeqLock.
+class RegisterCapabilities {
+public:
+    // Лише worker. Модель стала відомою або змінилася: завантажує збережене
+    // з NVS; дізнане до того (ще без моделі) лишається поверх. true - змінено
+    bool select(const char* model);
+
+    RegisterSupport readSupport(uint16_t address) const;
+    RegisterSupport writeSupport(uint16_t address) const;
+    uint16_t writeFallback(uint16_t address) const;
+    bool rangeReadsRejected() const { return working.rangeReadsRejected; }
+
+    // Лише worker. Повертають true, якщо знання змінилося (таблиця стає "брудною")
+    bool markRead(uint16_t address, RegisterSupport support);
+    bool markWrite(uint16_t address, RegisterSupport support);
+    bool setWriteFallback(uint16_t address, uint16_t fallback);
+    bool rejectRangeReads();
+
+    // Лише worker. Записує в NVS, якщо є незбережені зміни та відома модель
+    bool saveIfDirty();
+    bool isDirty() const { return dirty; }
+    // Лише worker. Забуває все дізнане для всіх моделей (пам'ять і NVS)
+    void reset();
+
+    // Будь-яка задача
+    void snapshot(RegisterCapabilityTable& out) const { published.read(out); }
+
+private:
+    RegisterCapabilityTable working = {}; // Лише worker
+    SeqLock<RegisterCapabilityTable> published;
+    bool dirty = false;
+
+    RegisterCapability* find(uint16_t address);
+    const RegisterCapability* find(uint16_t address) const;
+    RegisterCapability* findOrAdd(uint16_t address);
+    void changed();
+};
+
+const char* registerSupportName(RegisterSupport support);
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef REGISTER_MAP_H
+#define REGISTER_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include "system_status.h"
+
+// Символи моделі: кожен байт у межах '0'..'Z' - відсікає нулі та сміття
+static constexpr uint16_t MODEL_ASCII_MIN = 0x3030;
+static constexpr uint16_t MODEL_ASCII_MAX = 0x5A5A;
+
+// Як інтерпретувати сире значення регістра
+enum class RegisterType : uint8_t {
+    UINT16 = 0, // (raw + offset) / divisor
+    BOOL,       // raw == 1
+    ASCII,      // Два символи (старший байт першим), min/max - межі кожного байта
+    ASCII_TAIL, // Як ASCII, але лише якщо регістр address - 1 щойно прийнято як ASCII
+};
+
+// Поле SystemStatus, яке заповнює регістр
+enum class StatusField : uint8_t {
+    MODEL_NAME = 0,  // index = позиція першого символу в modelName
+    BATTERY_LEVEL,   // Також зберігає сире значення в batteryRaw
+    BATTERY_VOLTAGE,
+    TEMPERATURE,
+    DC_INPUT_POWER,
+    AC_INPUT_POWER,
+    AC_OUTPUT_POWER,
+    DC_OUTPUT_POWER,
+    MAX_DC_LIMIT,
+    AC_OUTPUT_STATE,
+    DC_OUTPUT_STATE,
+};
+
+// Опис одного регістра. Значення поза [minRaw, maxRaw] пропускається, тож
+// кілька записів для одного поля працюють як пріоритет: пізніший валідний
+// запис (за порядком у таблиці) перекриває попередній.
+struct RegisterDescriptor {
+    uint16_t address;
+    StatusField field;
+    RegisterType type;
+    uint16_t minRaw;
+    uint16_t maxRaw;
+    uint16_t divisor;
+    int16_t offset;
+    uint8_t index;
+};
+
+// Біт поля в масці, яку повертає decodeRegisterBlock()
+constexpr uint32_t statusFieldBit(StatusField field) {
+    return 1u << static_cast<uint8_t>(field);
+}
+
+// Записує декодоване значення у відповідне поле
+void storeRegister(const RegisterDescriptor& descriptor, uint16_t raw, SystemStatus& out);
+
+// Таблиця має бути впорядкована за адресою - декодер іде по кадру один раз
+template <size_t N>
+constexpr bool registerMapSorted(const RegisterDescriptor (&map)[N]) {
+    for (size_t i = 1; i < N; i++) {
+        if (map[i].address < map[i - 1].address) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Усі регістри таблиці мають потрапляти в блок, який читає опитування
+template <size_t N>
+constexpr bool registerMapWithin(const RegisterDescriptor (&map)[N], uint16_t base, uint16_t count) {
+    for (size_t i = 0; i < N; i++) {
+        if (map[i].address < base || map[i].address >= base + count || map[i].divisor == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Декодує блок регістрів (payload без заголовка Modbus, big-endian) за
+// таблицею: один лінійний прохід, без евристик. Повертає маску полів
+// (statusFieldBit), які отримали значення - решта лишилася як була.
+uint32_t decodeRegisterBlock(const RegisterDescriptor* map, size_t mapSize, uint16_t baseAddress,
+                             const uint8_t* payload, uint16_t registerCount, SystemStatus& out);
+
+template <size_t N>
+uint32_t decodeRegisterBlock(const RegisterDescriptor (&map)[N], uint16_t baseAddress,
+                             const uint8_t* payload, uint16_t registerCount, SystemStatus& out) {
+    return decodeRegisterBlock(map, N, baseAddress, payload, registerCount, out);
+}
+
+#endif
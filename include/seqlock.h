@@ -0,0 +1,57 @@
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstdint>
+
+// Версіонований знімок для одного писача та багатьох читачів. Писач ніколи
+// не чекає. Два буфери: писач заповнює той, що не опублікований, тож читач,
+// який витіснив писача на тому ж ядрі (AsyncTCP має вищий пріоритет за loop),
+// читає завершений буфер і не крутиться. Лічильник кожного буфера ловить
+// рідкісний випадок, коли писач двічі обійшов читача під час копіювання.
+// T копіюється присвоєнням, тому не повинен містити вказівників на динамічну пам'ять.
+template <typename T>
+class SeqLock {
+public:
+    // Лише одна задача-писач
+    void write(const T& value) {
+        uint32_t next = published.load(std::memory_order_relaxed) + 1;
+        Slot& slot = slots[next & 1];
+        uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+        slot.sequence.store(sequence + 1, std::memory_order_relaxed); // Непарний - запис триває
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.data = value;
+        slot.sequence.store(sequence + 2, std::memory_order_release);
+        published.store(next, std::memory_order_release);
+    }
+
+    // Будь-яка задача: копіює останній завершений знімок, повертає його версію
+    uint32_t read(T& out) const {
+        for (;;) {
+            uint32_t version = published.load(std::memory_order_acquire);
+            const Slot& slot = slots[version & 1];
+            uint32_t before = slot.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                continue; // Писач уже переписує цей буфер - є новіша версія
+            }
+            out = slot.data;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.sequence.load(std::memory_order_relaxed) == before) {
+                return version;
+            }
+        }
+    }
+
+    // Кількість опублікованих знімків (0 - ще нічого не записано)
+    uint32_t version() const { return published.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> sequence{0};
+        T data{};
+    };
+    Slot slots[2];
+    std::atomic<uint32_t> published{0};
+};
+
+#endif
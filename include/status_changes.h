@@ -0,0 +1,89 @@
+#ifndef STATUS_CHANGES_H
+#define STATUS_CHANGES_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Логічні групи Bluetti-полів SystemStatus. BLE worker порівнює кожен новий
+// знімок з попереднім і позначає змінені групи бітами маски.
+enum class StatusGroup : uint8_t {
+    CONNECTION = 0, // bluettiConnected
+    BATTERY,        // batteryLevel, batteryRaw, batteryVoltage
+    AC_POWER,
+    DC_POWER,
+    INPUT_POWER,    // inputPower, dcInputPower, acInputPower
+    OUTPUT_STATES,  // acOutputState, dcOutputState
+    TEMPERATURE,
+    SETTINGS,       // ecoMode, powerLifting, ledMode, ecoShutdown, chargingSpeed
+    DEVICE_INFO,    // modelName, maxDcLimit
+    REGISTERS,      // Сирий блок статусу
+    COUNT
+};
+
+static constexpr size_t STATUS_GROUP_COUNT = static_cast<size_t>(StatusGroup::COUNT);
+
+constexpr uint16_t statusBit(StatusGroup group) { return 1u << static_cast<uint8_t>(group); }
+
+static constexpr uint16_t STATUS_DIRTY_ALL = (1u << STATUS_GROUP_COUNT) - 1;
+
+static constexpr uint8_t STATUS_REGISTER_COUNT = 40;
+
+// Знімок Bluetti-полів SystemStatus: BLE worker -> loop. Фіксований розмір,
+// без вказівників - копіюється в слот черги цілком
+struct BluettiRecord {
+    bool bluettiConnected;
+    uint8_t batteryLevel;
+    int acPower;
+    int dcPower;
+    int inputPower;
+    int dcInputPower;
+    int acInputPower;
+    bool acOutputState;
+    bool dcOutputState;
+    bool ecoMode;
+    bool powerLifting;
+    uint8_t ledMode;
+    uint8_t ecoShutdown;
+    uint8_t chargingSpeed;
+    uint16_t batteryVoltage;
+    uint16_t batteryRaw;
+    uint16_t temperature;
+    uint16_t maxDcLimit;
+    char modelName[5];
+    uint16_t registers[STATUS_REGISTER_COUNT];
+    unsigned long lastBluettiUpdate;
+    uint16_t dirty; // Біти StatusGroup, змінені відносно попереднього запису
+};
+
+// Маска змінених груп (біти StatusGroup): порівняння полів, без копій та
+// алокацій - дешево на кожен кадр
+uint16_t diffBluettiRecords(const BluettiRecord& prev, const BluettiRecord& next);
+
+// Лічильники змін лежать у самому SystemStatus, тож маска завжди узгоджена
+// зі знімком, з якого її отримано. Кожен споживач тримає власний курсор і
+// бачить лише групи, на які підписався.
+class StatusChangeCursor {
+public:
+    explicit StatusChangeCursor(uint16_t interest) : interest(interest) {}
+
+    // Групи з interest, що змінилися від попереднього виклику (перший виклик - усі)
+    uint16_t take(const uint32_t (&versions)[STATUS_GROUP_COUNT]) {
+        uint16_t changed = 0;
+        for (size_t i = 0; i < STATUS_GROUP_COUNT; i++) {
+            uint16_t bit = 1u << i;
+            if ((interest & bit) && (!primed || versions[i] != seen[i])) {
+                changed |= bit;
+            }
+            seen[i] = versions[i];
+        }
+        primed = true;
+        return changed;
+    }
+
+private:
+    uint16_t interest;
+    bool primed = false;
+    uint32_t seen[STATUS_GROUP_COUNT] = {};
+};
+
+#endif
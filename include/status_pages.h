@@ -0,0 +1,34 @@
+#ifndef STATUS_PAGES_H
+#define STATUS_PAGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "status_changes.h"
+
+// Скільки регістрів блоку статусу читати одним запитом. Блок цілком, якщо
+// вміщується в одну notification або пристрій не погодив більший MTU (тоді
+// фрагменти одного кадру збирає reassembler - один round trip замість шести).
+// Інакше - сторінки по perNotification, кожна відповідь в одній notification
+uint16_t statusPageSize(uint16_t statusCount, uint16_t perNotification, bool mtuNegotiated);
+
+// Збирає блок статусу зі сторінок, що приходять по черзі. Сторінка не по
+// порядку (попередня втрачена або запізнилася) відкидає незавершений блок -
+// наступне опитування почне заново з першої
+class StatusPageAssembler {
+public:
+    // Перша сторінка нового опитування; count - регістрів у всьому блоці
+    void begin(uint16_t count);
+    // Регістри [offset, offset + registers); false - не та сторінка, що очікувалась
+    bool accept(uint16_t offset, const uint8_t* payload, uint16_t registers);
+    bool complete() const { return total > 0 && received == total; }
+    // Дані всього блоку (big-endian, як payload кадру 0x03), дійсні після complete()
+    const uint8_t* payload() const { return data; }
+    uint16_t registerCount() const { return total; }
+
+private:
+    uint8_t data[STATUS_REGISTER_COUNT * 2] = {};
+    uint16_t total = 0;
+    uint16_t received = 0;
+};
+
+#endif
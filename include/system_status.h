@@ -3,6 +3,7 @@
 
 #include <Arduino.h>
 #include <WiFi.h>
+#include "status_changes.h"
 
 struct SystemStatus {
     bool wifiConnected = false;
@@ -39,6 +40,7 @@ struct SystemStatus {
     uint8_t chargingSpeed = 0; // Швидкість зарядки: 0=Standard, 1=Silent, 2=Turbo
     
     unsigned long lastBluettiUpdate = 0;
+    uint32_t bluettiChanges[STATUS_GROUP_COUNT] = {}; // Лічильник змін кожної StatusGroup
     unsigned long uptime = 0;
     int wifiRssi = 0;
 };
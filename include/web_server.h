@@ -4,12 +4,13 @@
 #include <Arduino.h>
 #include <WiFi.h>
 #include <ESPAsyncWebServer.h>
-#include "bluetti_device.h"
+#include "bluetti_manager.h"
+#include "seqlock.h"
 #include "system_status.h"
 
 class WebServerManager {
 public:
-    WebServerManager(BluettiDevice* device, SystemStatus* status);
+    WebServerManager(BluettiManager* manager, SystemStatus* status, SeqLock<SystemStatus>* snapshot);
     void begin();
     void handleClient(); // Заглушка для сумісності
     bool isBluettiEnabled() const;
@@ -17,8 +18,13 @@ public:
 
 private:
     AsyncWebServer server;
-    BluettiDevice* bluetti;
+    BluettiManager* manager;
     SystemStatus* status;
+    SeqLock<SystemStatus>* snapshot; // Лише читання (пристрій 0 та системні поля)
+
+    // Параметр device=<n> (query або форма), за замовчуванням 0; -1 - невідомий пристрій
+    int deviceIndex(AsyncWebServerRequest* request) const;
+    BluettiDevice* deviceFor(AsyncWebServerRequest* request);
 
     String buildHtml();
     String buildConfigHtml();
@@ -0,0 +1,51 @@
+#include "adaptive_poller.h"
+#include <cstdlib>
+
+void AdaptivePoller::setBounds(unsigned long newMinMs, unsigned long newMaxMs) {
+  if (newMinMs < POLL_MIN_LIMIT_MS) {
+    newMinMs = POLL_MIN_LIMIT_MS;
+  }
+  if (newMaxMs > POLL_MAX_LIMIT_MS) {
+    newMaxMs = POLL_MAX_LIMIT_MS;
+  }
+  if (newMaxMs < newMinMs) {
+    newMaxMs = newMinMs;
+  }
+  minMs = newMinMs;
+  maxMs = newMaxMs;
+  if (current < minMs) {
+    current = minMs;
+  } else if (current > maxMs) {
+    current = maxMs;
+  }
+}
+
+bool AdaptivePoller::observe(const PollSample &sample, unsigned long now) {
+  if (lastSampleAt != 0) {
+    unsigned long gap = now - lastSampleAt;
+    averageGapMs = (averageGapMs == 0) ? gap : (averageGapMs * 7 + gap) / 8;
+  }
+  lastSampleAt = now;
+
+  bool transient = hasLast &&
+                   (abs(sample.acPower - last.acPower) >= POLL_POWER_DELTA_W ||
+                    abs(sample.dcPower - last.dcPower) >= POLL_POWER_DELTA_W ||
+                    abs(sample.inputPower - last.inputPower) >= POLL_POWER_DELTA_W ||
+                    abs((int)sample.batteryLevel - (int)last.batteryLevel) >= POLL_SOC_DELTA);
+  last = sample;
+  hasLast = true;
+
+  if (transient) {
+    transients++;
+    current = minMs;
+  } else {
+    current = (current > maxMs / 2) ? maxMs : current * 2;
+  }
+  return transient;
+}
+
+void AdaptivePoller::reset() {
+  hasLast = false;
+  lastSampleAt = 0;
+  current = minMs;
+}
@@ -0,0 +1,72 @@
+#include "advertisement_cache.h"
+#include <cstring>
+
+void AdvertisementCache::record(const uint8_t *address, int rssi, bool bluettiService, unsigned long now) {
+  AdvertisementEntry *entry = nullptr;
+  for (uint8_t i = 0; i < working.count; i++) {
+    if (memcmp(working.entries[i].address, address, sizeof(working.entries[i].address)) == 0) {
+      entry = &working.entries[i];
+      break;
+    }
+  }
+  if (!entry) {
+    if (working.count < ADVERTISEMENT_CACHE_SIZE) {
+      entry = &working.entries[working.count++];
+    } else {
+      entry = &working.entries[0];
+      for (uint8_t i = 1; i < working.count; i++) {
+        if (now - working.entries[i].lastSeen > now - entry->lastSeen) {
+          entry = &working.entries[i];
+        }
+      }
+    }
+    memcpy(entry->address, address, sizeof(entry->address));
+  }
+
+  entry->rssi = (int8_t)rssi;
+  entry->bluettiService = entry->bluettiService || bluettiService;
+  entry->lastSeen = now;
+  published.write(working);
+  recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool AdvertisementCache::lookup(const uint8_t *address, AdvertisementEntry &out) const {
+  AdvertisementTable table;
+  if (published.read(table) == 0) {
+    return false; // Ще нічого не бачили
+  }
+  for (uint8_t i = 0; i < table.count && i < ADVERTISEMENT_CACHE_SIZE; i++) {
+    if (memcmp(table.entries[i].address, address, sizeof(table.entries[i].address)) == 0) {
+      out = table.entries[i];
+      return true;
+    }
+  }
+  return false;
+}
+
+void ConnectTimeWindow::add(unsigned long ms) {
+  values[next] = ms;
+  next = (next + 1) % SIZE;
+  if (filled < SIZE) {
+    filled++;
+  }
+  total++;
+}
+
+unsigned long ConnectTimeWindow::median() const {
+  if (filled == 0) {
+    return 0;
+  }
+  // Вставками - вікно маленьке
+  unsigned long sorted[SIZE];
+  for (uint8_t i = 0; i < filled; i++) {
+    unsigned long value = values[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > value) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = value;
+  }
+  return (filled % 2) ? sorted[filled / 2] : (sorted[filled / 2 - 1] + sorted[filled / 2]) / 2;
+}
@@ -1,1153 +1,1500 @@
 #include "bluetti_device.h"
+#include "bluetti_manager.h"
+#include "poll_planner.h"
 #include <cstring>
 
-BluettiDevice* BluettiDevice::instance = nullptr;
-
-// Функція для розрахунку CRC16 MODBUS RTU
-static uint16_t calculateCRC16(const uint8_t *data, size_t length) {
-  uint16_t crc = 0xFFFF;
+// Таймаути транзакцій (мс) - loop() не чекає, лише перевіряє дедлайни
+static constexpr unsigned long STATUS_RESPONSE_TIMEOUT_MS = 2000;
+static constexpr unsigned long REGISTER_RESPONSE_TIMEOUT_MS = 3000;
+static constexpr unsigned long WRITE_RESPONSE_TIMEOUT_MS = 2000;
+// Запис повторюємо один раз: echo 0x06 могло загубитися, запис регістра ідемпотентний
+static constexpr uint8_t WRITE_RETRIES = 1;
+// Пауза після великого запиту, перш ніж запитувати окремі регістри
+static constexpr unsigned long POST_STATUS_QUIET_MS = 1000;
+// Скільки значення в кеші регістрів вважається свіжим
+static constexpr uint32_t REGISTER_TTL_POWER_MS = 10000;   // Потужності та SoC
+static constexpr uint32_t REGISTER_TTL_STATUS_MS = 30000;  // Решта блоку статусу
+static constexpr uint32_t REGISTER_TTL_SETTING_MS = 60000; // Налаштування змінюються лише командою
+// Час на обробку команди активації перед наступним запитом
+static constexpr unsigned long ACTIVATION_SETTLE_MS = 500;
+// Скільки чекати першої відповіді через кешовані handles до повного discovery
+static constexpr unsigned long FAST_RECONNECT_DATA_TIMEOUT_MS = 4000;
+static const uint8_t ACTIVATION_COMMAND[] = {0xAA, 0x55, 0x90, 0xEB};
+// Активне сканування, коли пристрою немає в кеші advertisement
+static constexpr uint32_t ACTIVE_SCAN_SECONDS = 5;
+// connect() блокує BLE worker не довше за це
+static constexpr uint8_t CONNECT_TIMEOUT_S = 10;
+// Команда активації після discovery: двічі з паузою на обробку (як bluetti_mqtt)
+static constexpr uint8_t ACTIVATION_REPEATS = 2;
+static constexpr unsigned long ACTIVATION_WAIT_MS = 2500;
+
+// Hex-дамп кожного Modbus-кадру в Serial: лише для налагодження протоколу,
+// вмикається -D BLUETTI_FRAME_DUMP=1 у build_flags
+#ifndef BLUETTI_FRAME_DUMP
+#define BLUETTI_FRAME_DUMP 0
+#endif
+
+static void dumpFrame(const char *direction, const uint8_t *data, size_t length) {
+#if BLUETTI_FRAME_DUMP
+  Serial.printf("[Bluetti] %s:", direction);
   for (size_t i = 0; i < length; i++) {
-    crc ^= data[i];
-    for (int j = 0; j < 8; j++) {
-      if (crc & 0x0001) {
-        crc = (crc >> 1) ^ 0xA001;
-      } else {
-        crc >>= 1;
-      }
+    Serial.printf(" %02X", data[i]);
+  }
+  Serial.println();
+#else
+  (void)direction;
+  (void)data;
+  (void)length;
+#endif
+}
+
+static uint8_t registerBlockOf(const DeviceProfile &profile, uint16_t reg) {
+  if (profile.inStatusBlock(reg)) {
+    return static_cast<uint8_t>(RegisterBlock::STATUS);
+  }
+  return profile.isFeatureRegister(reg) ? static_cast<uint8_t>(RegisterBlock::FEATURES) : 0;
+}
+
+static uint32_t registerTtlMs(const DeviceProfile &profile, uint16_t reg) {
+  if (reg >= profile.powerBase && reg < profile.powerBase + profile.powerCount) {
+    return REGISTER_TTL_POWER_MS;
+  }
+  for (size_t i = 0; i < profile.statusMapSize; i++) {
+    const RegisterDescriptor &descriptor = profile.statusMap[i];
+    if (descriptor.address == reg && descriptor.field == StatusField::BATTERY_LEVEL) {
+      return REGISTER_TTL_POWER_MS;
     }
   }
-  return crc;
+  return registerBlockOf(profile, reg) == static_cast<uint8_t>(RegisterBlock::STATUS) ? REGISTER_TTL_STATUS_MS
+                                                                                       : REGISTER_TTL_SETTING_MS;
 }
 
-BluettiDevice::BluettiDevice(SystemStatus *sharedStatus)
-    : client(nullptr), notifyCharacteristic(nullptr),
-      writeCharacteristic(nullptr), connected(false), lastRequest(0),
-      status(sharedStatus), cachedBattery(0), cachedAcPower(0),
-      cachedDcPower(0), cachedInputPower(0), cachedAcState(false),
-      cachedDcState(false), connecting(false), connectStartTime(0),
-      connectAttempts(0), scanning(false), scanStartTime(0), scanner(nullptr),
-      updateInterval(20000), lastRequestedPage(0x00) { // За замовчуванням 20 секунд
-  instance = this;
+// Exception означає "модель цього не вміє", а не тимчасову відмову:
+// 0x01 функція, 0x02 адреса, для читання ще 0x03 (кількість регістрів).
+// 0x03 на запис - недопустиме значення, регістр при цьому існує
+static bool isCapabilityException(const ModbusFrameView &frame) {
+  uint8_t code = frame.exceptionCode;
+  return code == 0x01 || code == 0x02 || (code == 0x03 && frame.requestFunction() == 0x03);
 }
 
-bool BluettiDevice::begin() {
-  Serial.println("[Bluetti] Initializing BLE...");
-  NimBLEDevice::init("ESP32-BLUETTI");
-  
-  // Встановлюємо TX power для BLE
-  // ESP_PWR_LVL_P3 = +3dBm (помірний рівень, добрий баланс між дальністю та енергією)
-  // Для WiFi coexistence краще використовувати помірний рівень
-  NimBLEDevice::setPower(ESP_PWR_LVL_P3);
-  Serial.println("[Bluetti] BLE TX Power set to +3dBm (balanced for WiFi coexistence)");
-  
-  // Не видаляємо bonding - EB3A потребує збереження bonding для стабільного з'єднання
-  // NimBLEDevice::deleteAllBonds();
-  // delay(100);
-  Serial.println("[Bluetti] Keeping existing bonds for EB3A compatibility");
-  
-  Serial.println("[Bluetti] BLE initialized with WiFi coexistence support");
-  Serial.println("[Bluetti] ⚠️  IMPORTANT: Bluetti allows only ONE BLE connection at a time!");
-  Serial.println("[Bluetti] ⚠️  Make sure:");
-  Serial.println("[Bluetti]     1. 'Bluetti to MQTT' addon is STOPPED in Home Assistant");
-  Serial.println("[Bluetti]     2. No mobile apps are connected to Bluetti");
-  Serial.println("[Bluetti]     3. Bluetti was RESTARTED after disabling addon");
-  Serial.println("[Bluetti]     4. Wait 30 seconds after restart before connecting");
-  return true;
+void BluettiDevice::attach(uint8_t deviceIndex, SystemStatus *shared, const AdvertisementCache *cache) {
+  index = deviceIndex;
+  sharedStatus = shared;
+  advertisements = cache;
 }
 
-bool BluettiDevice::scanAndConnect(const char *macAddress) {
-  if (!macAddress || strlen(macAddress) == 0) {
-    return false;
+void BluettiDevice::setTarget(const char *macAddress) {
+  unsigned long now = millis();
+  if (!macAddress || macAddress[0] == '\0') {
+    if (peerMac[0] == '\0') {
+      return;
+    }
+    Serial.printf("[Bluetti] #%u auto-connect disabled\n", index);
+    peerMac[0] = '\0';
+    targetAddressSet = false;
+    stopLink(now);
+    return;
   }
+  if (strcasecmp(peerMac, macAddress) == 0) {
+    return;
+  }
+  if (peerMac[0] != '\0') {
+    stopLink(now); // Інший пристрій - поточне з'єднання вже не потрібне
+  }
+  strncpy(peerMac, macAddress, sizeof(peerMac) - 1);
+  peerMac[sizeof(peerMac) - 1] = '\0';
+  setTargetAddress(macAddress);
+  link.retryNow(now);
+  Serial.printf("[Bluetti] #%u target %s, connecting automatically\n", index, peerMac);
+}
 
-  // Якщо вже скануємо, перевіряємо результати
-  if (scanning) {
-    if (millis() - scanStartTime > 5000) { // Таймаут сканування 5 секунд
-      Serial.println("[Bluetti] Scan timeout, trying direct connection...");
-      scanning = false;
-      if (scanner) {
-        scanner->stop();
-        scanner = nullptr;
-      }
-      // Після сканування спробуємо пряме підключення
-      return connectByMAC(macAddress);
-    }
-    
-    // Перевіряємо результати сканування
-    if (scanner && scanner->isScanning()) {
-      return false; // Ще скануємо
+void BluettiDevice::setTargetAddress(const char *macAddress) {
+  NimBLEAddress address(macAddress);
+  const uint8_t *native = address.getNative();
+  if (targetAddressSet && memcmp(targetAddress, native, sizeof(targetAddress)) == 0) {
+    return;
+  }
+  // Host task читає targetAddress лише в callback сканування - BluettiManager
+  // зупиняє будь-яке сканування (фонове чи активне) до виклику setTarget()
+  memcpy(targetAddress, native, sizeof(targetAddress));
+  targetAddressSet = true;
+}
+
+void BluettiDevice::recordConnectTime(unsigned long now) {
+  if (connectAttemptStartedAt != 0) {
+    unsigned long elapsed = now - connectAttemptStartedAt;
+    (connectFromCache ? connectTimesCached : connectTimesScan).add(elapsed);
+    diagnostics.connectsFromCache = connectTimesCached.samples();
+    diagnostics.connectsAfterScan = connectTimesScan.samples();
+    diagnostics.connectMedianCachedMs = connectTimesCached.median();
+    diagnostics.connectMedianScanMs = connectTimesScan.median();
+    Serial.printf("[Bluetti] Connected in %lums (%s); median cached %lums (n=%u), scan %lums (n=%u)\n",
+                  elapsed, connectFromCache ? "advertisement cache" : "scan",
+                  diagnostics.connectMedianCachedMs, diagnostics.connectsFromCache,
+                  diagnostics.connectMedianScanMs, diagnostics.connectsAfterScan);
+  }
+  connectAttemptStartedAt = 0;
+  connectFromCache = false;
+  cachedConnectFailedAt = 0;
+}
+
+void BluettiDevice::enterState(BluettiLinkState next, unsigned long now) {
+  BluettiLinkState previous = link.state();
+  if (!link.enter(next, now)) {
+    return;
+  }
+  unsigned long spent = link.durationMs(previous);
+  diagnostics.stateDurationMs[static_cast<size_t>(previous)] = spent;
+  Serial.printf("[Bluetti] #%u link %s -> %s (%lums in %s)\n", index, linkStateName(previous),
+                linkStateName(next), spent, linkStateName(previous));
+  diagnostics.linkState = next;
+}
+
+bool BluettiDevice::wantsLinkSetup(unsigned long now) const {
+  return peerMac[0] != '\0' && link.attemptDue(now);
+}
+
+bool BluettiDevice::inLinkSetup() const {
+  // ONLINE у стані очікування першої відповіді ще не завершив налаштування,
+  // але ефір уже не займає - інші пристрої можуть підключатися
+  return link.inSetup();
+}
+
+void BluettiDevice::serviceConnection(unsigned long now, bool maySetup) {
+  // Розрив після connect() - з будь-якого наступного стану
+  if (link.state() >= BluettiLinkState::DISCOVERING && (!client || !client->isConnected())) {
+    Serial.printf("[Bluetti] ⚠️  Link lost while %s\n", linkStateName(link.state()));
+    if (link.state() == BluettiLinkState::ONLINE) {
+      // Пристрій працював - перепідключаємося одразу, backoff лише для невдалих спроб
+      resetLinkState();
+      link.retryNow(now);
+      enterState(BluettiLinkState::IDLE, now);
+    } else {
+      failAttempt(now, "link lost during setup");
     }
-    
-    // Сканування завершено, перевіряємо результати
-    NimBLEScanResults results = scanner->getResults();
-    bool found = false;
-    
-    for (int i = 0; i < results.getCount(); i++) {
-      NimBLEAdvertisedDevice device = results.getDevice(i);
-      String deviceAddress = device.getAddress().toString().c_str();
-      deviceAddress.toUpperCase();
-      
-      String targetMac = String(macAddress);
-      targetMac.toUpperCase();
-      targetMac.replace(":", "");
-      deviceAddress.replace(":", "");
-      
-      if (deviceAddress == targetMac || 
-          device.getName().find("EB3A") != std::string::npos ||
-          device.getName().find("BLUETTI") != std::string::npos) {
-        Serial.printf("[Bluetti] ✅ Found device: %s (%s)\n", 
-                      device.getName().c_str(), 
-                      device.getAddress().toString().c_str());
-        found = true;
+  }
+
+  switch (link.state()) {
+    case BluettiLinkState::IDLE:
+      if (peerMac[0] == '\0') {
         break;
       }
-    }
-    
-    scanning = false;
-    scanner = nullptr;
-    
-    if (found) {
-      Serial.println("[Bluetti] Device found, attempting connection...");
-      return connectByMAC(macAddress);
-    } else {
-      Serial.println("[Bluetti] ❌ Device not found in scan");
-      Serial.println("[Bluetti] 💡 Make sure:");
-      Serial.println("[Bluetti]    1. Bluetti is powered ON");
-      Serial.println("[Bluetti]    2. Bluetti is within range (10m)");
-      Serial.println("[Bluetti]    3. MAC address is correct");
-      return false;
-    }
+      // Поки з'єднання немає, менеджер слухає advertisement - наступна спроба
+      // обійдеться без сканування. Спробу починаємо лише з дозволу менеджера:
+      // сканування та connect() займають ефір для всіх пристроїв
+      diagnostics.advertisementsSeen = advertisements->getRecorded();
+      if (maySetup && link.attemptDue(now)) {
+        beginAttempt(now);
+      }
+      break;
+    case BluettiLinkState::SCANNING:
+      serviceScan(now);
+      break;
+    case BluettiLinkState::CONNECTING:
+      serviceConnect(now);
+      break;
+    case BluettiLinkState::DISCOVERING:
+      serviceDiscovery(now);
+      break;
+    case BluettiLinkState::SUBSCRIBING:
+      serviceSubscribe(now);
+      break;
+    case BluettiLinkState::ONLINE:
+    case BluettiLinkState::COUNT:
+      break;
   }
-  
-  // Починаємо сканування
-  Serial.println("[Bluetti] 🔍 Scanning for Bluetti device...");
-  scanner = NimBLEDevice::getScan();
-  scanner->setActiveScan(true);
-  scanner->setInterval(1349);
-  scanner->setWindow(449);
-  scanner->start(5, false); // Скануємо 5 секунд, не блокуємо
-  
-  scanning = true;
-  scanStartTime = millis();
-  return false;
 }
 
-bool BluettiDevice::connectByMAC(const char *macAddress) {
-  if (!macAddress || strlen(macAddress) == 0) {
-    return false;
+void BluettiDevice::beginAttempt(unsigned long now) {
+  connectAttemptStartedAt = now;
+  connectFromCache = false;
+
+  // Фонове сканування нещодавно бачило пристрій - 5-секундне сканування не потрібне
+  AdvertisementEntry seen;
+  if (advertisements->lookup(targetAddress, seen) && now - seen.lastSeen <= ADVERTISEMENT_FRESH_MS &&
+      (cachedConnectFailedAt == 0 || (long)(seen.lastSeen - cachedConnectFailedAt) > 0)) {
+    Serial.printf("[Bluetti] #%u ⚡ %s advertised %lums ago (RSSI %d), connecting without scan\n",
+                  index, peerMac, now - seen.lastSeen, seen.rssi);
+    connectFromCache = true;
+    enterState(BluettiLinkState::CONNECTING, now);
+    return;
   }
 
-  // Неблокуюче підключення з агресивними спробами "витіснити" інше підключення
-  if (!connecting) {
-    // Починаємо підключення
-    NimBLEAddress address(macAddress);
+  Serial.printf("[Bluetti] #%u 🔍 Scanning for Bluetti device...\n", index);
+  if (!startActiveScan()) {
+    failAttempt(now, "scan did not start");
+    return;
+  }
+  enterState(BluettiLinkState::SCANNING, now);
+}
 
+bool BluettiDevice::startActiveScan() {
+  NimBLEScan *scan = NimBLEDevice::getScan();
+  scan->setActiveScan(true);
+  scan->setInterval(1349);
+  scan->setWindow(449);
+  scan->setMaxResults(0); // Збіг фіксує callback у кеші advertisement
+  return scan->start(ACTIVE_SCAN_SECONDS, nullptr, false);
+}
+
+void BluettiDevice::resumeScan() {
+  // Таймаут serviceScan рахується від входу в SCANNING, тож перерване
+  // сканування не подовжує спробу
+  if (link.state() == BluettiLinkState::SCANNING && !startActiveScan()) {
+    failAttempt(millis(), "scan did not resume");
+  }
+}
+
+void BluettiDevice::serviceScan(unsigned long now) {
+  NimBLEScan *scan = NimBLEDevice::getScan();
+  AdvertisementEntry seen;
+  if (advertisements->lookup(targetAddress, seen) && (long)(seen.lastSeen - link.enteredAt()) >= 0) {
+    scan->stop();
+    Serial.printf("[Bluetti] ✅ Found device %s (RSSI %d)\n", peerMac, seen.rssi);
+    enterState(BluettiLinkState::CONNECTING, now);
+    return;
+  }
+  if (scan->isScanning() && now - link.enteredAt() < ACTIVE_SCAN_SECONDS * 1000UL + 1000) {
+    return; // Ще скануємо
+  }
+
+  scan->stop();
+  Serial.println("[Bluetti] ❌ Device not found in scan");
+  Serial.println("[Bluetti] 💡 Make sure:");
+  Serial.println("[Bluetti]    1. Bluetti is powered ON");
+  Serial.println("[Bluetti]    2. Bluetti is within range (10m)");
+  Serial.println("[Bluetti]    3. MAC address is correct");
+  failAttempt(now, "not found in scan");
+}
+
+void BluettiDevice::serviceConnect(unsigned long now) {
+  if (!client) {
+    client = NimBLEDevice::createClient();
     if (!client) {
-      client = NimBLEDevice::createClient();
-      if (!client) {
-        Serial.println("Failed to create NimBLE client");
-        connecting = false;
-        connectAttempts = 0;
-        return false;
-      }
+      Serial.println("Failed to create NimBLE client");
+      failAttempt(now, "no NimBLE client");
+      return;
     }
+    client->setConnectTimeout(CONNECT_TIMEOUT_S);
+  }
 
-    // Відключаємося від попереднього з'єднання, якщо є
-    if (client->isConnected()) {
-      client->disconnect();
-      delay(500); // Даємо час на відключення
-    }
-    
-    // Не видаляємо bonding - EB3A потребує збереження bonding
-    // NimBLEDevice::deleteBond(address); // ВИМКНЕНО
-    delay(200);
+  Serial.printf("[Bluetti] #%u connecting to %s... (attempt %u)\n", index, peerMac, link.failures() + 1);
+  if (link.failures() == 0) {
+    Serial.println("[Bluetti] ⚠️  Attempting to DISCONNECT 'Bluetti to MQTT' addon...");
+    Serial.println("[Bluetti] ⚠️  This may take several attempts if addon is still connected");
+  }
 
-    connectAttempts++;
-    Serial.printf("[Bluetti] Connecting to %s... (attempt %d/5)\n", macAddress, connectAttempts);
-    
-    if (connectAttempts == 1) {
-      Serial.println("[Bluetti] ⚠️  Attempting to DISCONNECT 'Bluetti to MQTT' addon...");
-      Serial.println("[Bluetti] ⚠️  This may take several attempts if addon is still connected");
+  // connect() блокує лише BLE worker (не довше CONNECT_TIMEOUT_S) - loop,
+  // дисплей та веб-сервер працюють далі. Bonding не видаляємо: EB3A його потребує
+  linkStartedAt = now;
+  NimBLEAddress address(peerMac);
+  if (!client->connect(address, true)) {
+    failAttempt(millis(), "connect failed");
+    return;
+  }
+
+  // Від цього моменту notifications з'єднання маршрутизуються сюди
+  connHandle.store(client->getConnId(), std::memory_order_release);
+
+  // Параметри з'єднання для стабільності: інтервал 45-90 мс, supervision timeout 5 с
+  client->updateConnParams(6, 12, 0, 500);
+  skipFastPath = false;
+  enterState(BluettiLinkState::DISCOVERING, millis());
+}
+
+void BluettiDevice::serviceDiscovery(unsigned long now) {
+  awaitingFirstData = true;
+  gattCacheSavePending = false;
+
+  if (!skipFastPath) {
+    // activationRequired переживає невдалий кеш: його знання не залежить від handles
+    bool activationRequired = gattCache.activationRequired;
+    gattCacheLoaded = loadGattCache(peerMac, gattCache);
+    if (!gattCacheLoaded) {
+      gattCache = {};
+      gattCache.activationRequired = activationRequired;
     }
-    
-    // ВАЖЛИВО: Додаємо затримку перед підключенням, щоб уникнути перезавантажень
-    yield();
-    delay(500);
-    
-    // Підключення з bonding (як bluetti-mqtt)
-    // EB3A вимагає bonding для стабільного з'єднання
-    bool connected = client->connect(address, true); // true = використовувати bonding
-    
-    yield();
-    delay(200);
-    
-    if (!connected) {
-      // Помилка підключення - можливо Bluetti зайнятий або вже підключений
-      Serial.println("[Bluetti] ⚠️  Connection failed");
-      Serial.println("[Bluetti] 💡 Possible causes:");
-      Serial.println("[Bluetti]     - Bluetti may be busy or already connected");
-      Serial.println("[Bluetti]     - 'Bluetti to MQTT' addon may still be connected");
-      Serial.println("[Bluetti]     - Wait 5 seconds and try again...");
-      
-      if (connectAttempts < 5) {
-        Serial.printf("[Bluetti] ⚠️  Connection failed, retrying in 2 seconds... (%d/5)\n", connectAttempts);
-        Serial.println("[Bluetti] 💡 This will try to disconnect 'Bluetti to MQTT' addon");
-        connecting = false; // Дозволяємо повторну спробу
-        yield();
-        delay(2000);
-        return false;
-      } else {
-        Serial.printf("[Bluetti] ❌ Connection failed after %d attempts\n", connectAttempts);
-        Serial.println("[Bluetti] 💡 Solutions:");
-        Serial.println("[Bluetti]    1. STOP 'Bluetti to MQTT' addon in Home Assistant");
-        Serial.println("[Bluetti]    2. Wait 30 seconds after stopping addon");
-        Serial.println("[Bluetti]    3. Restart Bluetti if possible");
-        Serial.println("[Bluetti]    4. Check MAC address");
-        connecting = false;
-        connectAttempts = 0;
-        return false;
-      }
+    if (gattCacheLoaded && setupFastPath()) {
+      diagnostics.lastConnectFast = true;
+      goOnline(millis());
+      return;
     }
-    
-    // ВАЖЛИВО: Дозволяємо іншим задачам виконуватися (кнопки!)
-    yield();
-    connecting = true;
-    connectStartTime = millis();
-    connectAttempts = 0; // Скидаємо лічильник при успішному початку підключення
-    return false; // Ще не підключено
   }
 
-  // Перевіряємо статус підключення (неблокуюче)
-  if (client->isConnected()) {
-    yield(); // Дозволяємо кнопкам працювати
-    
-    // ВАЖЛИВО: Встановлюємо connection parameters для стабільного з'єднання
-    // Це допомагає уникнути розривів з'єднання та покращує стабільність
-    Serial.println("[Bluetti] Setting connection parameters...");
-    client->updateConnParams(
-      6,   // min_interval (7.5ms * 6 = 45ms)
-      12,  // max_interval (7.5ms * 12 = 90ms)
-      0,   // latency (0 = no latency)
-      500  // timeout (10ms * 500 = 5000ms = 5s)
-    );
-    yield();
-    delay(500); // Даємо час на встановлення параметрів
-    
-    if (!setupCharacteristics()) {
-      status->bluettiConnected = false;
-      connected = false;
-      connecting = false;
-      return false;
+  diagnostics.lastConnectFast = false;
+  if (!discoverCharacteristics()) {
+    failAttempt(millis(), "service discovery failed");
+    return;
+  }
+  subscribeStep = 0;
+  enterState(BluettiLinkState::SUBSCRIBING, millis());
+}
+
+void BluettiDevice::serviceSubscribe(unsigned long now) {
+  // Команду активації (як bluetti_mqtt) надсилаємо двічі з паузою на обробку.
+  // Паузи - дедлайни стану, а не delay(): worker тим часом обробляє команди
+  if (subscribeStep < ACTIVATION_REPEATS) {
+    if (subscribeStep > 0 && now - stateTimer < ACTIVATION_WAIT_MS) {
+      return;
     }
-    yield(); // Дозволяємо кнопкам працювати
+    Serial.printf("[Bluetti] Sending activation command (0xAA 0x55 0x90 0xEB) %u/%u\n",
+                  subscribeStep + 1, ACTIVATION_REPEATS);
+    writeCharacteristic->writeValue(ACTIVATION_COMMAND, sizeof(ACTIVATION_COMMAND), false);
+    subscribeStep++;
+    stateTimer = now;
+    return;
+  }
+  if (now - stateTimer < ACTIVATION_WAIT_MS) {
+    return;
+  }
 
-    connected = true;
-    status->bluettiConnected = true;
-    status->lastBluettiUpdate = millis();
-    connecting = false;
-    Serial.println("Bluetti connected");
-    return true;
+  if (!subscribeNotifications()) {
+    // Без notifications відповіді не прийдуть - "online" з мовчазним каналом
+    // лише марнував би таймаути опитувань; повторюємо з backoff
+    failAttempt(now, "subscribe failed");
+    return;
   }
 
-  // Таймаут підключення (10 секунд) та перевірка помилок
-  if (millis() - connectStartTime > 10000) {
-    Serial.println("[Bluetti] ❌ Connection timeout (10s)");
+  // MTU вже погоджено під час підключення - визначаємо режим читання статусу
+  refreshLinkMtu();
+
+  // Відправляємо перший запит ВІДРАЗУ після підключення
+  Serial.println("[Bluetti] Sending initial status request...");
+  requestStatus();
+  goOnline(millis());
+}
+
+void BluettiDevice::goOnline(unsigned long now) {
+  connected.store(true, std::memory_order_release);
+  status->bluettiConnected = true;
+  status->lastBluettiUpdate = now;
+  link.recordSuccess();
+  diagnostics.connectFailures = 0;
+  diagnostics.nextRetryMs = 0;
+  enterState(BluettiLinkState::ONLINE, now);
+  recordConnectTime(now);
+  Serial.printf("Bluetti #%u connected\n", index);
+}
+
+void BluettiDevice::failAttempt(unsigned long now, const char *reason) {
+  BluettiLinkState failedIn = link.state();
+  if (failedIn == BluettiLinkState::SCANNING) {
+    NimBLEDevice::getScan()->stop();
+  }
+  if (client && client->isConnected()) {
+    client->disconnect();
+  }
+  resetLinkState();
+
+  if (connectFromCache) {
+    cachedConnectFailedAt = now; // Наступного разу - лише з новішим advertisement
+  }
+  connectAttemptStartedAt = 0;
+  connectFromCache = false;
+
+  unsigned long backoff = link.recordFailure(now, esp_random());
+  uint8_t connectFailures = link.failures();
+  diagnostics.connectFailures = connectFailures;
+  diagnostics.nextRetryMs = backoff;
+  Serial.printf("[Bluetti] #%u ❌ Connection attempt failed while %s (%s), failure #%u, retry in %lums\n",
+                index, linkStateName(failedIn), reason, connectFailures, backoff);
+  if (connectFailures == 1 || connectFailures % 5 == 0) {
     Serial.println("[Bluetti] 💡 Possible causes:");
-    Serial.println("[Bluetti]    1. 'Bluetti to MQTT' addon is still connected");
-    Serial.println("[Bluetti]    2. Bluetti Bluetooth is OFF");
-    Serial.println("[Bluetti]    3. Bluetti is out of range");
+    Serial.println("[Bluetti]    1. 'Bluetti to MQTT' addon is still connected (STOP it, wait 30 s)");
+    Serial.println("[Bluetti]    2. A mobile app is connected to Bluetti");
+    Serial.println("[Bluetti]    3. Bluetti Bluetooth is OFF or out of range");
     Serial.println("[Bluetti]    4. Wrong MAC address");
-    
-    // Відключаємо клієнта перед наступною спробою
-    if (client) {
-      client->disconnect();
-    }
-    
-    status->bluettiConnected = false;
-    connected = false;
-    connecting = false;
-    connectAttempts = 0; // Скидаємо лічильник для нової серії спроб
+  }
+  enterState(BluettiLinkState::IDLE, now);
+}
+
+void BluettiDevice::resetLinkState() {
+  connected.store(false, std::memory_order_release);
+  status->bluettiConnected = false;
+  // Очищаємо характеристики при відключенні
+  notifyCharacteristic = nullptr;
+  writeCharacteristic = nullptr;
+  fastPathActive.store(false, std::memory_order_release);
+  connHandle.store(BLE_HS_CONN_HANDLE_NONE, std::memory_order_release);
+  lastDataReceived = 0;
+  awaitingFirstData = false;
+  reassembler.reset(); // Недобраний кадр від старого з'єднання не потрібен
+  capabilities.saveIfDirty();
+  abandonTransactions(); // Відповіді на запити старого з'єднання вже не прийдуть
+  diagnostics.mtu = BLE_DEFAULT_MTU; // Нове з'єднання погоджує MTU заново
+  diagnostics.maxRegistersPerNotification = 0;
+  diagnostics.singleNotificationMode = false;
+  poller.reset();
+  if (burstUntil != 0) {
+    endBurst(); // Вибірки нема звідки брати; нове з'єднання почне зі звичайного опитування
+  }
+}
+
+void BluettiDevice::stopLink(unsigned long now) {
+  if (link.state() == BluettiLinkState::SCANNING) {
+    NimBLEDevice::getScan()->stop();
+  }
+  if (client && client->isConnected()) {
+    client->disconnect();
+  }
+  resetLinkState();
+  connectAttemptStartedAt = 0;
+  connectFromCache = false;
+  enterState(BluettiLinkState::IDLE, now);
+}
+
+bool BluettiDevice::setupFastPath() {
+
+  uint16_t conn = client->getConnId();
+  Serial.printf("[Bluetti] ⚡ Fast reconnect with cached handles (notify 0x%04X, write 0x%04X, CCCD 0x%04X)%s\n",
+                gattCache.notifyHandle, gattCache.writeHandle, gattCache.cccdHandle,
+                gattCache.activationRequired ? ", with activation" : "");
+
+  // Приймач вмикаємо до запису CCCD, щоб не втратити першу notification
+  fastNotifyHandle = gattCache.notifyHandle;
+  fastPathActive.store(true, std::memory_order_release);
+
+  // Підписка - запис CCCD напряму за handle, без discovery сервісів і дескрипторів
+  uint8_t cccdValue[2] = {(uint8_t)(gattCache.indicate ? 0x02 : 0x01), 0x00};
+  if (ble_gattc_write_flat(conn, gattCache.cccdHandle, cccdValue, sizeof(cccdValue), nullptr, nullptr) != 0) {
+    Serial.println("[Bluetti] ⚠️  Cached CCCD write failed, running full discovery");
+    fastPathActive.store(false, std::memory_order_release);
+    diagnostics.fastReconnectFallbacks++;
     return false;
   }
-  
-  // Перевіряємо, чи є помилка підключення
-  if (client && !client->isConnected() && millis() - connectStartTime > 2000) {
-    // Якщо пройшло 2 секунди і все ще не підключено, можлива помилка
-    // Але даємо ще час (до 10 секунд)
+
+  unsigned long now = millis();
+  if (gattCache.activationRequired) {
+    // Одна команда замість двох з паузами по 2.5 с - пауза лише перед першим запитом
+    ble_gattc_write_no_rsp_flat(conn, gattCache.writeHandle, ACTIVATION_COMMAND, sizeof(ACTIVATION_COMMAND));
+    transactions.holdOff(now + ACTIVATION_SETTLE_MS);
   }
+  fastPathStartedAt = now;
+  diagnostics.fastReconnects++;
 
-  return false; // Ще підключаємося
+  refreshLinkMtu();
+  requestStatus();
+  return true;
 }
 
-bool BluettiDevice::setupCharacteristics() {
-  Serial.println("[Bluetti] Setting up characteristics...");
-  
-  // ВАЖЛИВО: Додаємо затримку перед BLE операціями, щоб уникнути перезавантажень
-  yield();
-  delay(200);
-  
+bool BluettiDevice::discoverCharacteristics() {
+  Serial.println("[Bluetti] Discovering service and characteristics...");
   NimBLERemoteService *service = client->getService(BLUETTI_SERVICE_UUID);
-  yield(); // Дозволяємо кнопкам працювати
-  delay(100);
-  
   if (!service) {
     Serial.println("[Bluetti] ERROR: Service missing");
-    client->disconnect();
     return false;
   }
-  Serial.println("[Bluetti] Service found");
-
-  yield();
-  delay(100);
   notifyCharacteristic = service->getCharacteristic(BLUETTI_NOTIFY_UUID);
-  yield();
-  delay(100);
   writeCharacteristic = service->getCharacteristic(BLUETTI_WRITE_UUID);
-  yield(); // Дозволяємо кнопкам працювати
-  delay(100);
-
   if (!notifyCharacteristic || !writeCharacteristic) {
     Serial.println("[Bluetti] ERROR: Characteristics missing");
-    Serial.printf("[Bluetti] notifyCharacteristic: %p, writeCharacteristic: %p\n", 
+    Serial.printf("[Bluetti] notifyCharacteristic: %p, writeCharacteristic: %p\n",
                   notifyCharacteristic, writeCharacteristic);
-    client->disconnect();
     return false;
   }
   Serial.println("[Bluetti] Characteristics found");
-  Serial.printf("[Bluetti] notifyCharacteristic: %p, writeCharacteristic: %p\n", 
-                notifyCharacteristic, writeCharacteristic);
-
-  // ВАЖЛИВО: Спробуємо різні команди активації ПЕРЕД підпискою
-  // Деякі пристрої Bluetti потребують активації перед підпискою
-  // ВАЖЛИВО: Додаємо більше затримок, щоб уникнути перезавантаження ESP32
-  if (writeCharacteristic) {
-    Serial.println("[Bluetti] Sending activation commands BEFORE subscription...");
-    
-    // ВАЖЛИВО: Додаємо велику затримку перед командою активації, щоб уникнути перезавантажень
-    // ESP32 може перезавантажуватися, якщо BLE операції виконуються занадто швидко
-    yield();
-    delay(500); // Збільшена затримка перед командою
-    
-    // ВАЖЛИВО: Команда активації для Bluetti (використовується bluetti_mqtt)
-    // Ця команда "пробуджує" Bluetti і дозволяє йому приймати команди
-    static const uint8_t activateCmd1[] = {0xAA, 0x55, 0x90, 0xEB};
-    Serial.println("[Bluetti] Sending activation command (0xAA 0x55 0x90 0xEB)...");
-    Serial.println("[Bluetti] This command is used by bluetti_mqtt to wake up the device");
-    
-    // ВАЖЛИВО: Додаємо yield() перед BLE операціями, щоб уникнути перезавантажень
-    yield();
-    delay(200); // Збільшена затримка
-    writeCharacteristic->writeValue(activateCmd1, sizeof(activateCmd1), false);
-    Serial.println("[Bluetti] Activation command sent (write-without-response)");
-    yield();
-    delay(500); // Збільшена затримка після команди
-    delay(2000); // Даємо час Bluetti на обробку
-    
-    // Відправляємо ще раз для надійності (як у bluetti_mqtt)
-    yield();
-    delay(500); // Збільшена затримка перед другою командою
-    writeCharacteristic->writeValue(activateCmd1, sizeof(activateCmd1), false);
-    Serial.println("[Bluetti] Activation command sent again");
-    yield();
-    delay(500); // Збільшена затримка після команди
-    delay(2000); // Збільшена затримка для активації
-  }
-
-  if (notifyCharacteristic->canNotify()) {
-    Serial.println("[Bluetti] Subscribing to notifications...");
-    Serial.printf("[Bluetti] Instance pointer: %p\n", instance);
-    Serial.printf("[Bluetti] notifyCharacteristic pointer: %p\n", notifyCharacteristic);
-    Serial.printf("[Bluetti] notificationThunk function pointer: %p\n", (void*)notificationThunk);
-    
-    // ВАЖЛИВО: Додаємо затримку перед BLE операціями, щоб уникнути перезавантажень
-    yield();
-    delay(200);
-    
-    // ВАЖЛИВО: Перевіряємо, чи instance встановлено
-    if (!instance) {
-      Serial.println("[Bluetti] ERROR: Instance is NULL! Cannot subscribe!");
-      return false;
-    }
-    
-    // ВАЖЛИВО: Спробуємо встановити descriptor ПЕРЕД підпискою
-    Serial.println("[Bluetti] Setting descriptor BEFORE subscription...");
-    yield();
-    delay(100);
-    NimBLERemoteDescriptor* descriptor = notifyCharacteristic->getDescriptor(NimBLEUUID((uint16_t)0x2902));
-    if (descriptor) {
-      Serial.println("[Bluetti] Found descriptor 0x2902, setting value to enable notifications...");
-      uint8_t notifyValue[] = {0x01, 0x00}; // Enable notifications
-      bool descSet = descriptor->writeValue(notifyValue, sizeof(notifyValue), true);
-      Serial.printf("[Bluetti] Descriptor set (before subscribe): %s\n", descSet ? "OK" : "FAILED");
-      yield();
-      delay(500);
-      
-      // ВАЖЛИВО: Перевіряємо значення descriptor після встановлення
-      Serial.println("[Bluetti] Verifying descriptor value...");
-      try {
-        std::string descValue = descriptor->readValue();
-        Serial.printf("[Bluetti] Descriptor value after set: ");
-        for (size_t i = 0; i < descValue.length(); i++) {
-          Serial.printf("%02X ", (uint8_t)descValue[i]);
-        }
-        Serial.println();
-        if (descValue.length() >= 2 && descValue[0] == 0x01 && descValue[1] == 0x00) {
-          Serial.println("[Bluetti] Descriptor verified: notifications ENABLED");
-        } else {
-          Serial.println("[Bluetti] WARNING: Descriptor value mismatch!");
-        }
-      } catch (...) {
-        Serial.println("[Bluetti] Could not read descriptor value (may be normal)");
-      }
-      yield();
-      delay(500);
-    } else {
-      Serial.println("[Bluetti] Descriptor 0x2902 not found (will be set by subscribe)");
-    }
-    
-    // ВАЖЛИВО: Спробуємо підписатися на notifications
-    // Деякі пристрої Bluetti використовують indications, але спочатку спробуємо notifications
-    bool subscribed = false;
-    
-    // ВАЖЛИВО: Спочатку спробуємо notifications (більшість пристроїв використовують notifications)
-    Serial.println("[Bluetti] Subscribing to notifications...");
-    Serial.printf("[Bluetti] canNotify: %d, canIndicate: %d\n", 
-                  notifyCharacteristic->canNotify(), 
-                  notifyCharacteristic->canIndicate());
-    subscribed = notifyCharacteristic->subscribe(true, notificationThunk); // true = notifications
-    Serial.printf("[Bluetti] subscribe() (notifications) returned: %s\n", subscribed ? "true" : "false");
-    
-    // Якщо notifications не спрацювали, спробуємо indications
-    if (!subscribed && notifyCharacteristic->canIndicate()) {
-      Serial.println("[Bluetti] Notifications failed, trying indications...");
-      subscribed = notifyCharacteristic->subscribe(false, notificationThunk); // false = indications
-      Serial.printf("[Bluetti] subscribe() (indications) returned: %s\n", subscribed ? "true" : "false");
-    }
-    
-    // Додаткова перевірка після підписки
-    if (subscribed) {
-      delay(1000);
-      // Перевіряємо descriptor після підписки
-      NimBLERemoteDescriptor* desc = notifyCharacteristic->getDescriptor(NimBLEUUID((uint16_t)0x2902));
-      if (desc) {
-        try {
-          std::string descVal = desc->readValue();
-          Serial.printf("[Bluetti] Descriptor after subscribe: ");
-          for (size_t i = 0; i < descVal.length(); i++) {
-            Serial.printf("%02X ", (uint8_t)descVal[i]);
-          }
-          Serial.println();
-        } catch (...) {
-          Serial.println("[Bluetti] Could not read descriptor after subscribe");
-        }
-      }
-    }
-    
-    // ВАЖЛИВО: Перевіряємо, чи callback функція правильно зареєстрована
-    Serial.printf("[Bluetti] Callback function pointer: %p\n", (void*)notificationThunk);
-    Serial.printf("[Bluetti] Instance pointer: %p\n", instance);
-    
-    yield();
-    delay(1000); // Затримка для встановлення підписки
-    
-    if (subscribed) {
-      Serial.println("[Bluetti] Successfully subscribed to notifications/indications");
-      Serial.println("[Bluetti] Callback should be called when Bluetti sends data");
-      
-      yield();
-      delay(1000); // Затримка для встановлення підписки
-      
-      Serial.println("[Bluetti] Successfully subscribed to notifications");
-      Serial.println("[Bluetti] Status requests will be sent from loop()");
-    } else {
-      Serial.println("[Bluetti] WARNING: Failed to subscribe to notifications!");
-      Serial.println("[Bluetti] This may indicate that Bluetti Bluetooth is turned off");
-    }
-  } else {
+
+  gattCache.serviceStart = service->getStartHandle();
+  gattCache.serviceEnd = service->getEndHandle();
+  gattCache.notifyHandle = notifyCharacteristic->getHandle();
+  gattCache.writeHandle = writeCharacteristic->getHandle();
+  return true;
+}
+
+bool BluettiDevice::subscribeNotifications() {
+  if (!notifyCharacteristic->canNotify()) {
     Serial.println("[Bluetti] WARNING: Characteristic cannot notify!");
     Serial.println("[Bluetti] This may indicate that Bluetti Bluetooth is turned off");
+    return false;
   }
-  yield();
 
-  // Відправляємо перший запит ВІДРАЗУ після підключення
-  Serial.println("[Bluetti] Sending initial status request...");
-  requestStatus();
-  
-  Serial.println("[Bluetti] Setup complete - status will be requested in loop()");
+  // Деякі прошивки Bluetti чекають CCCD ще до subscribe() - пишемо його явно
+  uint16_t cccdHandle = 0;
+  NimBLERemoteDescriptor *descriptor = notifyCharacteristic->getDescriptor(NimBLEUUID((uint16_t)0x2902));
+  if (descriptor) {
+    cccdHandle = descriptor->getHandle();
+    uint8_t notifyValue[] = {0x01, 0x00}; // Enable notifications
+    bool descSet = descriptor->writeValue(notifyValue, sizeof(notifyValue), true);
+    Serial.printf("[Bluetti] Descriptor 0x2902 set (before subscribe): %s\n", descSet ? "OK" : "FAILED");
+  } else {
+    Serial.println("[Bluetti] Descriptor 0x2902 not found (will be set by subscribe)");
+  }
+
+  // Спочатку notifications (більшість пристроїв), потім indications
+  Serial.printf("[Bluetti] canNotify: %d, canIndicate: %d\n",
+                notifyCharacteristic->canNotify(), notifyCharacteristic->canIndicate());
+  bool viaIndications = false;
+  bool subscribed = notifyCharacteristic->subscribe(true, BluettiManager::notificationThunk);
+  Serial.printf("[Bluetti] subscribe() (notifications) returned: %s\n", subscribed ? "true" : "false");
+  if (!subscribed && notifyCharacteristic->canIndicate()) {
+    Serial.println("[Bluetti] Notifications failed, trying indications...");
+    subscribed = notifyCharacteristic->subscribe(false, BluettiManager::notificationThunk);
+    viaIndications = subscribed;
+    Serial.printf("[Bluetti] subscribe() (indications) returned: %s\n", subscribed ? "true" : "false");
+  }
+
+  if (!subscribed) {
+    Serial.println("[Bluetti] WARNING: Failed to subscribe to notifications!");
+    Serial.println("[Bluetti] This may indicate that Bluetti Bluetooth is turned off");
+    return false;
+  }
+  Serial.println("[Bluetti] Successfully subscribed to notifications/indications");
+
+  // Handles для швидкого перепідключення - зберігаються в NVS лише після
+  // першої відповіді, щоб кеш завжди описував робочу конфігурацію
+  if (cccdHandle != 0) {
+    gattCache.version = GATT_CACHE_VERSION;
+    gattCache.cccdHandle = cccdHandle;
+    gattCache.indicate = viaIndications;
+    gattCacheSavePending = true;
+  }
   return true;
 }
 
-void BluettiDevice::disconnect() {
-  if (client && client->isConnected()) {
-    client->disconnect();
+void BluettiDevice::fallBackToDiscovery(unsigned long now) {
+  fastPathActive.store(false, std::memory_order_release);
+  diagnostics.fastReconnectFallbacks++;
+  abandonTransactions();
+  reassembler.reset();
+
+  if (!gattCache.activationRequired) {
+    // Handles могли бути правильними - пристрій чекав на команду активації
+    gattCache.activationRequired = true;
+    Serial.println("[Bluetti] ⚠️  No data via cached handles, falling back to full setup (activation will be kept)");
+  } else {
+    clearGattCache(peerMac);
+    gattCacheLoaded = false;
+    Serial.println("[Bluetti] ⚠️  No data via cached handles, cache cleared, falling back to full discovery");
   }
-  connected = false;
+
+  // Те саме з'єднання, але вже через discovery та повну активацію
+  diagnostics.lastConnectFast = false;
+  connected.store(false, std::memory_order_release);
   status->bluettiConnected = false;
+  skipFastPath = true;
+  enterState(BluettiLinkState::DISCOVERING, now);
 }
 
-bool BluettiDevice::isConnected() const {
-  return connected && client && client->isConnected();
+void BluettiDevice::recordFirstData(unsigned long now) {
+  awaitingFirstData = false;
+  if (linkStartedAt != 0) {
+    diagnostics.timeToFirstDataMs = now - linkStartedAt;
+    linkStartedAt = 0;
+    Serial.printf("[Bluetti] ⏱️  Time to first data: %lums (%s)\n", diagnostics.timeToFirstDataMs,
+                  diagnostics.lastConnectFast ? "cached GATT handles" : "full discovery");
+  }
+  if (gattCacheSavePending) {
+    gattCacheSavePending = false;
+    if (saveGattCache(peerMac, gattCache)) {
+      Serial.printf("[Bluetti] GATT handles cached for %s (fast reconnect enabled)\n", peerMac);
+    }
+  }
 }
 
-void BluettiDevice::loop() {
-  // Перевіряємо підключення через client
-  if (!client || !client->isConnected()) {
-    connected = false;
-    status->bluettiConnected = false;
-    // Очищаємо характеристики при відключенні
-    notifyCharacteristic = nullptr;
-    writeCharacteristic = nullptr;
-    return;
+void BluettiDevice::disconnect() {
+  postCommand(BluettiCommandType::DISCONNECT, 0);
+}
+
+bool BluettiDevice::loop(const RadioSlot &slot) {
+  processFragments(); // Кадри від NimBLE callback - до нових запитів
+  runCommands();
+  bool dispatched = serviceLink(slot);
+  reportEvictedWrites(); // Повна черга могла витіснити запис у командах або опитуванні
+  publishRecord();
+  publishDiagnostics();
+  return dispatched;
+}
+
+WriteTicket BluettiDevice::setACOutput(bool state) {
+  return postControl(ProfileControl::AC_OUTPUT, BluettiCommandType::AC_OUTPUT, state ? 1 : 0);
+}
+
+WriteTicket BluettiDevice::setDCOutput(bool state) {
+  return postControl(ProfileControl::DC_OUTPUT, BluettiCommandType::DC_OUTPUT, state ? 1 : 0);
+}
+
+WriteTicket BluettiDevice::setChargingSpeed(uint8_t speed) {
+  if (speed > 2) {
+    Serial.println("[Bluetti] ERROR: Invalid charging speed");
+    return 0;
   }
-  
-  // Встановлюємо connected = true, якщо підключення є
-  if (!connected && client && client->isConnected()) {
-    Serial.println("[Bluetti] Connection confirmed in loop(), setting up characteristics...");
-    
-    // ВАЖЛИВО: Встановлюємо connection parameters для стабільного з'єднання
-    // Це допомагає уникнути розривів з'єднання та покращує стабільність
-    Serial.println("[Bluetti] Setting connection parameters...");
-    client->updateConnParams(
-      6,   // min_interval (7.5ms * 6 = 45ms)
-      12,  // max_interval (7.5ms * 12 = 90ms)
-      0,   // latency (0 = no latency)
-      500  // timeout (10ms * 500 = 5000ms = 5s)
-    );
-    yield();
-    delay(500); // Даємо час на встановлення параметрів
-    
-    if (setupCharacteristics()) {
-      connected = true;
-      status->bluettiConnected = true;
-      status->lastBluettiUpdate = millis();
-      Serial.println("[Bluetti] Setup complete, connected = true");
+  return postControl(ProfileControl::CHARGING_MODE, BluettiCommandType::CHARGING_SPEED, speed);
+}
+
+WriteTicket BluettiDevice::setEcoMode(bool state) {
+  return postControl(ProfileControl::ECO_MODE, BluettiCommandType::ECO_MODE, state ? 1 : 0);
+}
+
+WriteTicket BluettiDevice::setPowerLifting(bool state) {
+  return postControl(ProfileControl::POWER_LIFTING, BluettiCommandType::POWER_LIFTING, state ? 1 : 0);
+}
+
+WriteTicket BluettiDevice::setLedMode(uint8_t mode) {
+  // 1=Low, 2=High, 3=SOS, 4=Off
+  if (mode < 1 || mode > 4) {
+    Serial.println("[Bluetti] ERROR: Invalid LED mode (1-4)");
+    return 0;
+  }
+  return postControl(ProfileControl::LED_MODE, BluettiCommandType::LED_MODE, mode);
+}
+
+WriteTicket BluettiDevice::setEcoShutdown(uint8_t hours) {
+  // 1-4 години
+  if (hours < 1 || hours > 4) {
+    Serial.println("[Bluetti] ERROR: Invalid ECO shutdown hours (1-4)");
+    return 0;
+  }
+  return postControl(ProfileControl::ECO_SHUTDOWN, BluettiCommandType::ECO_SHUTDOWN, hours);
+}
+
+WriteTicket BluettiDevice::powerOff() {
+  return postControl(ProfileControl::POWER_OFF, BluettiCommandType::POWER_OFF, 1);
+}
+
+WriteTicket BluettiDevice::postControl(ProfileControl control, BluettiCommandType type, uint16_t value) {
+  // Параметра, якого модель не має, не ставимо в чергу взагалі
+  if (!isConnected() || getProfile().controlAddress(control) == 0) {
+    return 0;
+  }
+  return postCommand(type, value);
+}
+
+bool BluettiDevice::startBurst(uint16_t seconds) {
+  if (seconds > BURST_MAX_SECONDS) {
+    return false;
+  }
+  // Зупинка дозволена завжди, старт - лише з активним з'єднанням
+  return (seconds == 0 || isConnected()) && postCommand(BluettiCommandType::BURST, seconds) != 0;
+}
+
+CacheLookup BluettiDevice::readRegisters(const uint16_t *addresses, size_t count, CachedRegister *out) {
+  unsigned long now = millis();
+  CacheLookup result = registerCache.lookup(addresses, count, now, out);
+  if (result == CacheLookup::HIT || !isConnected()) {
+    return result;
+  }
+
+  const DeviceProfile &profile = getProfile();
+  uint8_t blocks = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (out[i].ttlMs != 0 && now - out[i].capturedAt <= out[i].ttlMs) {
+      continue; // Свіже
+    }
+    uint8_t block = registerBlockOf(profile, addresses[i]);
+    if (block != 0) {
+      blocks |= block;
+    } else if (postCommand(BluettiCommandType::READ_REGISTER, addresses[i]) != 0) {
+      registerCache.noteRefresh(); // Окремий регістр - дублікат відкине черга транзакцій
+    }
+  }
+  // Блок, оновлення якого вже в черзі команд, не запитуємо вдруге
+  uint8_t fresh = blocks & ~refreshPending.fetch_or(blocks, std::memory_order_acq_rel);
+  if (fresh != 0) {
+    if (postCommand(BluettiCommandType::REFRESH_REGISTERS, fresh) != 0) {
+      registerCache.noteRefresh();
     } else {
-      Serial.println("[Bluetti] ERROR: Failed to setup characteristics in loop()");
-      connected = false;
-      status->bluettiConnected = false;
+      refreshPending.fetch_and(~fresh, std::memory_order_acq_rel);
     }
   }
-  
-  // Перевіряємо характеристики - якщо втрачені, отримуємо їх знову
-  if (connected && (!writeCharacteristic || !notifyCharacteristic)) {
-    Serial.println("[Bluetti] Characteristics lost, reacquiring...");
-    NimBLERemoteService *service = client->getService(BLUETTI_SERVICE_UUID);
-    if (service) {
-      if (!notifyCharacteristic) {
-        notifyCharacteristic = service->getCharacteristic(BLUETTI_NOTIFY_UUID);
-        if (notifyCharacteristic && notifyCharacteristic->canNotify()) {
-          Serial.println("[Bluetti] Re-subscribing to notifications...");
-          bool subscribed = notifyCharacteristic->subscribe(true, notificationThunk);
-          Serial.printf("[Bluetti] Re-subscribe result: %s\n", subscribed ? "OK" : "FAILED");
-          if (subscribed) {
-            Serial.println("[Bluetti] Notify characteristic reacquired and subscribed");
-          }
-        }
-      }
-      if (!writeCharacteristic) {
-        writeCharacteristic = service->getCharacteristic(BLUETTI_WRITE_UUID);
-        if (writeCharacteristic) {
-          Serial.println("[Bluetti] Write characteristic reacquired");
+  return result;
+}
+
+void BluettiDevice::refreshRegisters(uint8_t blocks) {
+  refreshPending.fetch_and(~blocks, std::memory_order_acq_rel);
+  if (!isConnected()) {
+    return;
+  }
+  if ((blocks & static_cast<uint8_t>(RegisterBlock::STATUS)) &&
+      !statusPollPending()) {
+    requestStatus();
+  }
+  if (blocks & static_cast<uint8_t>(RegisterBlock::FEATURES)) {
+    pollFeatureState(); // Ті самі об'єднані діапазони; дублікати відкине черга
+  }
+}
+
+bool BluettiDevice::resetCapabilities() {
+  return postCommand(BluettiCommandType::RESET_CAPABILITIES, 0) != 0;
+}
+
+WriteTicket BluettiDevice::issueTicket() {
+  WriteTicket ticket = nextTicket.fetch_add(1, std::memory_order_relaxed);
+  if (ticket == 0) {
+    ticket = nextTicket.fetch_add(1, std::memory_order_relaxed); // 0 зарезервовано
+  }
+  return ticket;
+}
+
+WriteTicket BluettiDevice::postCommand(BluettiCommandType type, uint16_t value) {
+  WriteTicket ticket = issueTicket();
+  BluettiCommand command = {type, value, ticket};
+  if (!commands.push(command)) {
+    commandsDropped.fetch_add(1, std::memory_order_relaxed);
+    Serial.println("[Bluetti] ⚠️  Command queue full, command dropped");
+    return 0;
+  }
+  return ticket;
+}
+
+const char *writeOutcomeName(WriteOutcome outcome) {
+  switch (outcome) {
+    case WriteOutcome::CONFIRMED: return "confirmed";
+    case WriteOutcome::REJECTED:  return "rejected";
+    case WriteOutcome::TIMEOUT:   return "timeout";
+    case WriteOutcome::NOT_SENT:  return "not_sent";
+  }
+  return "unknown";
+}
+
+void BluettiDevice::onWriteComplete(WriteCallback callback, void *context) {
+  writeCallbackContext = context;
+  writeCallback = callback;
+}
+
+void BluettiDevice::completeWrite(WriteTicket ticket, uint16_t address, uint16_t value,
+                                  WriteOutcome outcome, unsigned long enqueuedAt) {
+  if (ticket == 0) {
+    return;
+  }
+  WriteResult result = {ticket, address, value, outcome, millis() - enqueuedAt};
+  diagnostics.lastWrite = result;
+  if (completedWriteCount == sizeof(completedWrites) / sizeof(completedWrites[0])) {
+    flushWriteResults(); // Рідко: не чекаємо на publishRecord()
+  }
+  if (completedWriteCount < sizeof(completedWrites) / sizeof(completedWrites[0])) {
+    completedWrites[completedWriteCount++] = result;
+  }
+}
+
+void BluettiDevice::flushWriteResults() {
+  uint8_t sent = 0;
+  while (sent < completedWriteCount && writeResults.push(completedWrites[sent])) {
+    sent++;
+  }
+  for (uint8_t i = sent; i < completedWriteCount; i++) {
+    completedWrites[i - sent] = completedWrites[i];
+  }
+  completedWriteCount -= sent;
+}
+
+void BluettiDevice::reportEvictedWrites() {
+  ModbusTransaction txn;
+  while (transactions.takeEvicted(txn)) {
+    Serial.printf("[Bluetti] ⚠️  Write 0x%04X = %d evicted from a full queue, not sent\n", txn.address,
+                  txn.value);
+    completeWrite(txn.ticket, txn.address, txn.value, WriteOutcome::NOT_SENT, txn.enqueuedAt);
+  }
+}
+
+void BluettiDevice::abandonTransactions() {
+  reportEvictedWrites();
+  transactions.forEachPending([this](const ModbusTransaction& txn) {
+    if (txn.ticket != 0) {
+      completeWrite(txn.ticket, txn.address, txn.value, WriteOutcome::NOT_SENT, txn.enqueuedAt);
+    }
+  });
+  transactions.clear();
+}
+
+void BluettiDevice::runCommands() {
+  BluettiCommand command;
+  while (commands.pop(command)) {
+    switch (command.type) {
+      case BluettiCommandType::AC_OUTPUT:      applyACOutput(command.value != 0, command.ticket); break;
+      case BluettiCommandType::DC_OUTPUT:      applyDCOutput(command.value != 0, command.ticket); break;
+      case BluettiCommandType::CHARGING_SPEED: applyChargingSpeed(command.value, command.ticket); break;
+      case BluettiCommandType::ECO_MODE:       applyEcoMode(command.value != 0, command.ticket); break;
+      case BluettiCommandType::POWER_LIFTING:  applyPowerLifting(command.value != 0, command.ticket); break;
+      case BluettiCommandType::LED_MODE:       applyLedMode(command.value, command.ticket); break;
+      case BluettiCommandType::ECO_SHUTDOWN:   applyEcoShutdown(command.value, command.ticket); break;
+      case BluettiCommandType::POWER_OFF:      applyPowerOff(command.ticket); break;
+      case BluettiCommandType::DISCONNECT:     disconnectLink(); break;
+      case BluettiCommandType::BURST:          applyBurst(command.value); break;
+      case BluettiCommandType::RESET_CAPABILITIES: capabilities.reset(); break;
+      case BluettiCommandType::REFRESH_REGISTERS:  refreshRegisters(command.value); break;
+      case BluettiCommandType::READ_REGISTER:
+        if (linkUp()) {
+          requestRegister(command.value);
         }
+        break;
+    }
+    if (command.type <= BluettiCommandType::ECO_SHUTDOWN) {
+      poller.speedUp(); // Запис налаштування: наступний статус покаже результат
+    }
+  }
+}
+
+void BluettiDevice::processFragments() {
+  BleFragment *fragment;
+  while ((fragment = fragments.front()) != nullptr) {
+    // Фрагменти накопичуються, в обробник йдуть лише валідні типізовані кадри
+    reassembler.push(fragment->data, fragment->length, fragment->receivedAt);
+    fragments.release();
+
+    ModbusFrameView frame;
+    while (reassembler.nextFrame(frame)) {
+      handleNotification(frame);
+    }
+    registerCache.publish(); // Один знімок на пакет кадрів
+  }
+}
+
+// Одне місце, що перелічує Bluetti-поля: працює в обидва боки
+// (SystemStatus -> BluettiRecord у worker, BluettiRecord -> SystemStatus у loop)
+template <typename From, typename To>
+static void copyBluettiFields(const From &from, To &to) {
+  to.bluettiConnected = from.bluettiConnected;
+  to.batteryLevel = from.batteryLevel;
+  to.acPower = from.acPower;
+  to.dcPower = from.dcPower;
+  to.inputPower = from.inputPower;
+  to.dcInputPower = from.dcInputPower;
+  to.acInputPower = from.acInputPower;
+  to.acOutputState = from.acOutputState;
+  to.dcOutputState = from.dcOutputState;
+  to.ecoMode = from.ecoMode;
+  to.powerLifting = from.powerLifting;
+  to.ledMode = from.ledMode;
+  to.ecoShutdown = from.ecoShutdown;
+  to.chargingSpeed = from.chargingSpeed;
+  to.batteryVoltage = from.batteryVoltage;
+  to.batteryRaw = from.batteryRaw;
+  to.temperature = from.temperature;
+  to.maxDcLimit = from.maxDcLimit;
+  memcpy(to.modelName, from.modelName, sizeof(to.modelName));
+  memcpy(to.registers, from.registers, sizeof(to.registers));
+  to.lastBluettiUpdate = from.lastBluettiUpdate;
+}
+
+void BluettiDevice::publishDiagnostics() {
+  // Лічильники інших задач - атомарні поза структурою; решту пише лише worker,
+  // тож web-задача бачить цілий знімок, а не напівзаписані поля
+  diagnostics.fragmentsDropped = fragmentsDropped.load(std::memory_order_relaxed);
+  diagnostics.commandsDropped = commandsDropped.load(std::memory_order_relaxed);
+  diagnosticsSnapshot.write(diagnostics);
+}
+
+void BluettiDevice::publishRecord() {
+  BluettiRecord record = {};
+  copyBluettiFields(*status, record);
+  record.dirty = hasPublished ? diffBluettiRecords(lastPublished, record) : STATUS_DIRTY_ALL;
+  if (hasPublished && record.dirty == 0 &&
+      record.lastBluettiUpdate == lastPublished.lastBluettiUpdate) {
+    flushWriteResults(); // Стан, який підтвердили записи, уже опубліковано
+    return; // Нічого не змінилося
+  }
+  // Черга повна - loop ще не забрав попередні знімки; спробуємо на наступній
+  // ітерації (маска рахується від lastPublished, тож зміни не губляться).
+  // Результати записів чекають разом зі станом, який вони підтверджують
+  if (!records.push(record)) {
+    return;
+  }
+  flushWriteResults();
+  lastPublished = record;
+  hasPublished = true;
+  diagnostics.recordsPublished++;
+  if (record.dirty == 0) {
+    diagnostics.recordsUnchanged++;
+  }
+}
+
+void BluettiDevice::drainRecords() {
+  // Спершу забираємо результати: worker кладе їх після свого запису стану,
+  // тож усі записи, які вони підтверджують, уже в черзі нижче
+  WriteResult results[8];
+  size_t resultCount = 0;
+  while (resultCount < sizeof(results) / sizeof(results[0]) && writeResults.pop(results[resultCount])) {
+    resultCount++;
+  }
+
+  BluettiRecord *record;
+  while ((record = records.front()) != nullptr) {
+    copyBluettiFields(*record, *sharedStatus);
+    for (size_t i = 0; i < STATUS_GROUP_COUNT; i++) {
+      if (record->dirty & (1u << i)) {
+        sharedStatus->bluettiChanges[i]++;
       }
-      yield();
-    } else {
-      Serial.println("[Bluetti] ERROR: Service not available for reacquiring");
+    }
+    records.release();
+  }
+
+  for (size_t i = 0; i < resultCount; i++) {
+    if (writeCallback) {
+      writeCallback(results[i], writeCallbackContext);
     }
   }
+}
 
-  // Запитуємо статус з налаштованим інтервалом
-  if (millis() - lastRequest > updateInterval) {
+void BluettiDevice::applyBurst(uint16_t seconds) {
+  if (seconds == 0) {
+    if (burstUntil != 0) {
+      endBurst();
+    }
+    return;
+  }
+  unsigned long now = millis();
+  burstUntil = now + seconds * 1000UL;
+  if (burstUntil == 0) {
+    burstUntil = 1; // 0 означає "неактивний"
+  }
+  lastBurstSampleAt = 0;
+  diagnostics.burstActive = true;
+  diagnostics.burstRemainingMs = seconds * 1000UL;
+  diagnostics.burstSamples = 0;
+  diagnostics.burstAverageGapMs = 0;
+  Serial.printf("[Bluetti] 📈 Burst mode for %us: power registers only\n", seconds);
+}
+
+void BluettiDevice::endBurst() {
+  burstUntil = 0;
+  diagnostics.burstActive = false;
+  diagnostics.burstRemainingMs = 0;
+  lastRequest = 0; // Звичайне опитування відновлюється одразу з повного статусу
+  Serial.printf("[Bluetti] Burst finished: %u samples (avg gap %lums), resuming normal polling\n",
+                diagnostics.burstSamples, diagnostics.burstAverageGapMs);
+}
+
+bool BluettiDevice::serviceBurst(unsigned long now) {
+  if (burstUntil == 0) {
+    return false;
+  }
+  if ((long)(now - burstUntil) >= 0) {
+    endBurst();
+    return false;
+  }
+  diagnostics.burstRemainingMs = burstUntil - now;
+
+  // Наступна вибірка - щойно попередня отримала відповідь (hasQueued враховує
+  // транзакцію в польоті), але не частіше за BURST_MIN_GAP_MS
+  const DeviceProfile &profile = getProfile();
+  if (profile.powerCount == 0) {
+    endBurst(); // Модель без суміжного блоку потужностей
+    return false;
+  }
+  if (!transactions.hasQueued(ModbusTxnKind::POWER_SAMPLE, profile.powerBase) &&
+      now - lastRequest >= BURST_MIN_GAP_MS) {
+    ModbusTransaction txn;
+    txn.kind = ModbusTxnKind::POWER_SAMPLE;
+    txn.priority = ModbusPriority::POLL;
+    txn.function = 0x03;
+    txn.address = profile.powerBase;
+    txn.value = profile.powerCount;
+    txn.timeoutMs = STATUS_RESPONSE_TIMEOUT_MS;
+    if (transactions.enqueue(txn, now)) {
+      lastRequest = now;
+    }
+  }
+  return true;
+}
+
+void BluettiDevice::handlePowerSample(const ModbusFrameView &frame, unsigned long now) {
+  // Та сама таблиця, що й для блоку статусу, - лише з іншою базовою адресою
+  const DeviceProfile &profile = getProfile();
+  decodeRegisterBlock(profile.statusMap, profile.statusMapSize, profile.powerBase, frame.payload,
+                      frame.registerCount(), *status);
+  for (uint16_t i = 0; i < frame.registerCount(); i++) {
+    registerCache.store(profile.powerBase + i, frame.registerAt(i), REGISTER_TTL_POWER_MS, now);
+  }
+  status->inputPower = status->dcInputPower + status->acInputPower;
+  status->lastBluettiUpdate = now;
+
+  BurstSample sample = {(uint32_t)now, (uint16_t)status->acPower, (uint16_t)status->dcPower,
+                        (uint16_t)status->acInputPower, (uint16_t)status->dcInputPower};
+  if (!burstSamples.push(sample)) {
+    diagnostics.burstSamplesDropped++;
+  }
+  if (lastBurstSampleAt != 0) {
+    unsigned long gap = now - lastBurstSampleAt;
+    diagnostics.burstAverageGapMs = (diagnostics.burstAverageGapMs == 0)
+                                        ? gap
+                                        : (diagnostics.burstAverageGapMs * 7 + gap) / 8;
+  }
+  lastBurstSampleAt = now;
+  diagnostics.burstSamples++;
+}
+
+void BluettiDevice::disconnectLink() {
+  // Ціль лишається - наступна спроба після базової паузи (вимкнення - setTarget(nullptr))
+  unsigned long now = millis();
+  stopLink(now);
+  link.deferUntil(now + LINK_BACKOFF_BASE_MS);
+}
+
+bool BluettiDevice::linkUp() const {
+  return connected.load(std::memory_order_relaxed) && client && client->isConnected();
+}
+
+bool BluettiDevice::serviceLink(const RadioSlot &slot) {
+  serviceConnection(millis(), slot.maySetup);
+  if (link.state() != BluettiLinkState::ONLINE) {
+    return false;
+  }
+
+  unsigned long now = millis();
+
+  // Кешовані handles не дали даних - пристрій міг змінитися або потребує активації
+  if (awaitingFirstData && fastPathActive.load(std::memory_order_relaxed) &&
+      now - fastPathStartedAt > FAST_RECONNECT_DATA_TIMEOUT_MS) {
+    fallBackToDiscovery(now);
+    return false;
+  }
+
+  // Транзакція без відповіді до дедлайну - повтор або відмова, loop() не чекає
+  ModbusExpireResult expired = transactions.expire(now);
+  if (expired != ModbusExpireResult::NONE) {
+    handleTransactionTimeout(transactions.current(), expired);
+  }
+
+  // Запитуємо статус з адаптивним інтервалом; додаткові функції стають у
+  // чергу слідом за статусом, команди користувача випереджають обидва
+  poller.setBounds(pollMinMs.load(std::memory_order_relaxed), pollMaxMs.load(std::memory_order_relaxed));
+  if (serviceBurst(now)) {
+    // Burst: лише регістри потужності, статус і додаткові функції чекають завершення
+  } else if (now - lastRequest > poller.interval() && !statusPollPending()) {
+    capabilities.saveIfDirty(); // Дізнане за попередній цикл - одним записом у NVS
     requestStatus();
-    // delay() перенесено в кінець requestStatus() після обробки відповіді
-    pollFeatureState(); // Опитуємо додаткові функції (ротація) - включає Charging Mode
+    pollFeatureState(); // Опитуємо всі додаткові функції (об'єднаними діапазонами)
+  }
+
+  // Черги кожного пристрою наповнюються завжди, а відправляє лише той, кому
+  // менеджер дав слот - пристрої по черзі ділять ефір
+  bool dispatched = slot.mayDispatch && dispatchTransaction(now);
+  if (dispatched) {
+    dispatchGrants.fetch_add(1, std::memory_order_relaxed);
   }
   
   // ВАЖЛИВО: Якщо не отримуємо дані більше 10 секунд, спробуємо перепідключитися
   // Це може допомогти, якщо Bluetti Bluetooth вимкнено
-  static unsigned long lastDataReceived = 0;
-  if (connected && status->lastBluettiUpdate > 0) {
+  if (connected.load(std::memory_order_relaxed) && status->lastBluettiUpdate > 0) {
     lastDataReceived = status->lastBluettiUpdate;
   }
-  
-  // Використовуємо updateInterval + 10 секунд як таймаут
-  unsigned long timeout = updateInterval + 10000;
-  if (connected && lastDataReceived > 0 && millis() - lastDataReceived > timeout) {
-    Serial.printf("[Bluetti] WARNING: No data received for %lu seconds!\n", timeout / 1000);
-    Serial.println("[Bluetti] Bluetti Bluetooth may be turned off - trying to reactivate...");
-    
-    // Спробуємо відправити команду активації знову
-    if (writeCharacteristic) {
-      static const uint8_t activateCmd[] = {0xAA, 0x55, 0x90, 0xEB};
-      writeCharacteristic->writeValue(activateCmd, sizeof(activateCmd), false);
-      yield();
-      delay(500);
-      
-      // ВАЖЛИВО: Використовуємо write-without-response (як bluetti_mqtt)
-      static const uint8_t statusCmd[] = {0x01, 0x03, 0x00, 0x00, 0x00, 0x10};
-      writeCharacteristic->writeValue(statusCmd, sizeof(statusCmd), false);
-      yield();
+  
+  // Найдовший інтервал опитування + 10 секунд як таймаут
+  unsigned long timeout = poller.getMaxMs() + 10000;
+  if (connected.load(std::memory_order_relaxed) && lastDataReceived > 0 && now - lastDataReceived > timeout) {
+    Serial.printf("[Bluetti] WARNING: No data received for %lu seconds!\n", timeout / 1000);
+    Serial.println("[Bluetti] Bluetti Bluetooth may be turned off - trying to reactivate...");
+    
+    // Спробуємо відправити команду активації знову
+    if (sendCommand(ACTIVATION_COMMAND, sizeof(ACTIVATION_COMMAND))) {
+      // Замість delay(500): дозволяємо наступний запит статусу через 500 мс
+      transactions.holdOff(now + ACTIVATION_SETTLE_MS);
+      lastRequest = now - poller.interval() - 1;
+    }
+    
+    lastDataReceived = now; // Оновлюємо, щоб не повторювати занадто часто
+  }
+  return dispatched;
+}
+
+void BluettiDevice::requestStatus() {
+  // Перевіряємо підключення через client
+  if (!client || !client->isConnected()) {
+    Serial.println("[Bluetti] requestStatus: Not connected (client check)");
+    return;
+  }
+
+  // EB3A підтримує тільки page 0x00 (Core registers)
+  // Page 0x0B не підтримується (повертає MODBUS Exception 0x02)
+  const DeviceProfile &profile = getProfile();
+  ModbusTransaction txn;
+  txn.kind = ModbusTxnKind::STATUS_POLL;
+  txn.priority = ModbusPriority::POLL;
+  txn.function = 0x03;
+  txn.timeoutMs = STATUS_RESPONSE_TIMEOUT_MS;
+  lastRequestedPage = 0x00;
+
+  // Кожна відповідь - в одній notification: блок ділиться на сторінки за
+  // погодженим MTU. Опитування без повторів - наступний цикл запитає знову
+  uint16_t pageSize = statusPageSize(profile.statusCount, diagnostics.maxRegistersPerNotification,
+                                     diagnostics.mtu > BLE_DEFAULT_MTU);
+  unsigned long now = millis();
+  for (uint16_t offset = 0; offset < profile.statusCount; offset += pageSize) {
+    txn.address = profile.statusBase + offset;
+    txn.value = profile.statusCount - offset < pageSize ? profile.statusCount - offset : pageSize;
+    if (!transactions.enqueue(txn, now)) {
+      break; // Решту сторінок не прийнято - неповний блок відкине збирач
+    }
+    lastRequest = now;
+  }
+}
+
+bool BluettiDevice::statusPollPending() const {
+  const DeviceProfile &profile = getProfile();
+  for (uint16_t reg = profile.statusBase; reg < profile.statusBase + profile.statusCount; reg++) {
+    if (transactions.hasQueued(ModbusTxnKind::STATUS_POLL, reg)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool BluettiDevice::dispatchTransaction(unsigned long now) {
+  if (transactions.queued() == 0 || !transactions.canSend(now) ||
+      (!writeCharacteristic && !fastPathActive.load(std::memory_order_relaxed))) {
+    return false;
+  }
+
+  // Обмін MTU міг завершитися вже після підписки
+  if (diagnostics.mtu <= BLE_DEFAULT_MTU) {
+    refreshLinkMtu();
+  }
+
+  // Транзакцію переводимо "в політ" ДО відправки: відповідь може прийти в
+  // callback раніше, ніж writeValue() поверне керування
+  ModbusTransaction txn;
+  if (!transactions.startNext(now, txn)) {
+    return false;
+  }
+
+  uint8_t cmd[ModbusTransactionEngine::FRAME_SIZE];
+  size_t cmdLength = ModbusTransactionEngine::buildFrame(txn, cmd);
+
+  switch (txn.kind) {
+    case ModbusTxnKind::STATUS_POLL:
+      Serial.printf("[Bluetti] Sending status request (%u regs from 0x%04X)\n", txn.value, txn.address);
+      break;
+    case ModbusTxnKind::READ_REGISTER:
+      Serial.printf("[Bluetti] 📤 Requesting register 0x%04X\n", txn.address);
+      break;
+    case ModbusTxnKind::WRITE_REGISTER:
+      Serial.printf("[Bluetti] Write reg 0x%04X = %d\n", txn.address, txn.value);
+      break;
+    case ModbusTxnKind::POWER_SAMPLE:
+      break; // Щосекунди під час burst - без рядка в лозі
+  }
+  dumpFrame("TX", cmd, cmdLength);
+
+  // ВАЖЛИВО: EB3A вимагає write-without-response (як bluetti_mqtt)
+  bool sent = sendCommand(cmd, cmdLength);
+  if (txn.kind == ModbusTxnKind::STATUS_POLL) {
+    const char *mode = txn.value < getProfile().statusCount ? "page"
+                       : diagnostics.singleNotificationMode ? "single notification"
+                                                            : "multi-fragment";
+    Serial.printf("[Bluetti] Command sent: %s (%s)\n", sent ? "OK" : "FAILED", mode);
+  } else if (!sent) {
+    Serial.println("[Bluetti] ❌ Command send failed");
+  }
+
+  if (!sent) {
+    ModbusExpireResult result = transactions.sendFailed();
+    if (result == ModbusExpireResult::FAILED) {
+      handleTransactionTimeout(txn, result);
     }
-    
-    lastDataReceived = millis(); // Оновлюємо, щоб не повторювати занадто часто
+    return true; // Спроба однаково зайняла слот
   }
+  if (txn.kind == ModbusTxnKind::STATUS_POLL && txn.address == getProfile().statusBase) {
+    diagnostics.statusPolls++;
+  }
+  return true;
 }
 
-void BluettiDevice::requestStatus() {
-  // Перевіряємо підключення через client
-  if (!client || !client->isConnected()) {
-    Serial.println("[Bluetti] requestStatus: Not connected (client check)");
+void BluettiDevice::handleTransactionTimeout(const ModbusTransaction &txn, ModbusExpireResult result) {
+  unsigned long waited = millis() - txn.sentAt;
+  // Пауза перед наступним запитом, як після звичайної відповіді
+  transactions.holdOff(millis() + POST_STATUS_QUIET_MS);
+
+  if (txn.kind == ModbusTxnKind::STATUS_POLL) {
+    diagnostics.statusTimeouts++;
+    Serial.printf("[Bluetti] ⚠️  No response to status request after %lums\n", waited);
+    Serial.println("[Bluetti] 💡 Possible reasons:");
+    Serial.println("[Bluetti]     1. EB3A Bluetooth is turned off (auto-off after ~1h)");
+    Serial.println("[Bluetti]     2. EB3A requires different command format");
+    Serial.println("[Bluetti]     3. EB3A doesn't send data through BLE notifications");
     return;
   }
-  
-  // Якщо writeCharacteristic втрачено, спробуємо отримати його знову
-  if (!writeCharacteristic) {
-    Serial.println("[Bluetti] Write characteristic lost, reacquiring...");
-    NimBLERemoteService *service = client->getService(BLUETTI_SERVICE_UUID);
-    if (service) {
-      writeCharacteristic = service->getCharacteristic(BLUETTI_WRITE_UUID);
-      if (writeCharacteristic) {
-        Serial.println("[Bluetti] Write characteristic reacquired");
-      } else {
-        Serial.println("[Bluetti] ERROR: Failed to reacquire write characteristic");
-        return;
-      }
-    } else {
-      Serial.println("[Bluetti] ERROR: Service not available");
-      return;
-    }
-  }
-  
-  // EB3A підтримує тільки page 0x00 (Core registers)
-  // Page 0x0B не підтримується (повертає MODBUS Exception 0x02)
-  
-  uint8_t cmd[8];
-  cmd[0] = 0x01; // Device ID
-  cmd[1] = 0x03; // Function code (Read Holding Registers)
-  cmd[2] = 0x00; // Start address high
-  cmd[3] = 0x0A; // Start address low (0x000A)
-  cmd[4] = 0x00; // Quantity high
-  cmd[5] = 0x28; // Quantity low (40 registers)
-  lastRequestedPage = 0x00;
-  
-  // Розраховуємо CRC16
-  uint16_t crc = calculateCRC16(cmd, 6);
-  cmd[6] = crc & 0xFF;        // CRC low byte
-  cmd[7] = (crc >> 8) & 0xFF; // CRC high byte
-  
-  uint16_t startAddr = (cmd[2] << 8) | cmd[3];
-  Serial.printf("[Bluetti] Sending status request (40 regs from 0x%04X) WITH CRC: ", startAddr);
-  for (size_t i = 0; i < sizeof(cmd); i++) {
-    Serial.printf("%02X ", cmd[i]);
+
+  if (result == ModbusExpireResult::RETRY) {
+    Serial.printf("[Bluetti] ⚠️  Response timeout for 0x%04X after %lums, retrying (%u left)\n",
+                  txn.address, waited, txn.retriesLeft);
+    return;
   }
-  Serial.println();
-  
-  // ВАЖЛИВО: EB3A вимагає write-without-response (як bluetti_mqtt)
-  Serial.println("[Bluetti] Sending command (write-without-response)...");
-  bool sent = writeCharacteristic->writeValue(cmd, sizeof(cmd), false); // false = without response
-  Serial.printf("[Bluetti] Command sent: %s\n", sent ? "OK" : "FAILED");
-  
-  if (sent) {
-    lastRequest = millis();
-    Serial.println("[Bluetti] Waiting for response...");
-    
-    // ВАЖЛИВО: Чекаємо на відповідь через callback (notifications)
-    // Але також спробуємо прочитати response з write characteristic
-    unsigned long waitStart = millis();
-    bool callbackReceived = false;
-    
-    // Чекаємо до 2 секунд на callback
-    while (millis() - waitStart < 2000) {
-      yield(); // Дозволяємо callback виконатися
-      delay(50); // Невелика затримка
-      
-      // Перевіряємо, чи callback викликався
-      if (status->lastBluettiUpdate > lastRequest) {
-        callbackReceived = true;
-        Serial.println("[Bluetti] ✅ Callback received (data updated)!");
-        break;
-      }
-    }
-    
-    if (!callbackReceived) {
-      Serial.println("[Bluetti] ⚠️  No callback received, trying alternative methods...");
-      Serial.println("[Bluetti] 💡 EB3A may not send data automatically through notifications");
-      Serial.println("[Bluetti] 💡 Trying to read data directly after command...");
-      
-      // ВАЖЛИВО: EB3A може не відправляти дані через notifications автоматично
-      // Спробуємо прочитати дані безпосередньо після команди
-      // Деякі Bluetti пристрої вимагають polling замість notifications
-      
-      // ВАЖЛИВО: Notify characteristic зазвичай не підтримує read (rc=258 - це нормально)
-      // Дані мають надходити через notifications callback, а не через read
-      Serial.println("[Bluetti] Method 1: Notify characteristic typically doesn't support read");
-      Serial.println("[Bluetti] 💡 Data should come through notifications callback, not read");
-      Serial.println("[Bluetti] 💡 If callback is not called, EB3A may not send data automatically");
-      
-      // Спробуємо ще раз прочитати, але очікуємо помилку
-      if (notifyCharacteristic) {
-        Serial.println("[Bluetti] Attempting read anyway (will likely fail with rc=258)...");
-        yield();
-        delay(500);
-        try {
-          std::string value = notifyCharacteristic->readValue();
-          if (value.length() > 0) {
-            Serial.printf("[Bluetti] ✅ Unexpectedly read %d bytes from notify characteristic!\n", value.length());
-            Serial.print("[Bluetti] Data: ");
-            for (size_t i = 0; i < value.length() && i < 67; i++) {
-              Serial.printf("%02X ", (uint8_t)value[i]);
-            }
-            Serial.println();
-            handleNotification((uint8_t*)value.data(), value.length());
-            return;
-          }
-        } catch (...) {
-          Serial.println("[Bluetti] Read failed (expected - notify characteristic doesn't support read)");
-        }
-      }
-      
-      // МЕТОД 2: Спробуємо прочитати response з write characteristic
-      Serial.println("[Bluetti] Method 2: Checking write characteristic response...");
-      if (writeCharacteristic && writeCharacteristic->canRead()) {
-        Serial.println("[Bluetti] Write characteristic supports read, trying...");
-        delay(500);
-        try {
-          std::string value = writeCharacteristic->readValue();
-          if (value.length() > 0) {
-            Serial.printf("[Bluetti] ✅ Read %d bytes from write characteristic!\n", value.length());
-            Serial.print("[Bluetti] Data: ");
-            for (size_t i = 0; i < value.length() && i < 67; i++) {
-              Serial.printf("%02X ", (uint8_t)value[i]);
-            }
-            Serial.println();
-            handleNotification((uint8_t*)value.data(), value.length());
-            return;
-          }
-        } catch (...) {
-          Serial.println("[Bluetti] Write characteristic read failed");
-        }
-      }
-      
-      Serial.println("[Bluetti] ❌ All methods failed - EB3A may not support data reading");
-      Serial.println("[Bluetti] 💡 Possible reasons:");
-      Serial.println("[Bluetti]     1. EB3A Bluetooth is turned off (auto-off after ~1h)");
-      Serial.println("[Bluetti]     2. EB3A requires different command format");
-      Serial.println("[Bluetti]     3. EB3A doesn't send data through BLE notifications");
-    }
-    
-    // Перевіряємо, чи callback викликався
-    static unsigned long lastCallbackCheck = 0;
-    if (millis() - lastCallbackCheck > 5000) {
-      lastCallbackCheck = millis();
-      Serial.println("[Bluetti] DIAGNOSTIC: No callback received in last 5 seconds");
-      Serial.println("[Bluetti] Trying alternative methods...");
-    }
+
+  if (txn.kind == ModbusTxnKind::WRITE_REGISTER) {
+    diagnostics.writeFailures++;
+    Serial.printf("[Bluetti] ❌ Write 0x%04X = %d not acknowledged, giving up\n", txn.address, txn.value);
+    completeWrite(txn.ticket, txn.address, txn.value, WriteOutcome::TIMEOUT, txn.enqueuedAt);
+    return;
   }
-  
-  // ВАЖЛИВО: Даємо час Bluetti "заспокоїтися" після обробки великого запиту
-  // перш ніж робити наступні запити окремих регістрів
-  delay(1000);
+  Serial.printf("[Bluetti] ⚠️  Response timeout for 0x%04X after %lums\n", txn.address, waited);
 }
 
 bool BluettiDevice::sendCommand(const uint8_t *data, size_t length) {
-  if (!writeCharacteristic || !isConnected()) {
+  if (!linkUp()) {
     return false;
   }
   // Використовуємо write-without-response (як bluetti_mqtt)
+  if (fastPathActive.load(std::memory_order_relaxed)) {
+    return ble_gattc_write_no_rsp_flat(connHandle.load(std::memory_order_relaxed), gattCache.writeHandle, data, length) == 0;
+  }
+  if (!writeCharacteristic) {
+    return false;
+  }
   return writeCharacteristic->writeValue(data, length, false);
 }
 
-bool BluettiDevice::setACOutput(bool state) {
+// Стан у status змінюється лише після echo 0x06 (applyWrittenRegister), тож
+// опубліковане значення завжди підтверджене пристроєм
+bool BluettiDevice::applyACOutput(bool state, WriteTicket ticket) {
   // Команда: 0x01 0x06 0x0BBF VALUE CRC16 (Write Single Register)
-  uint8_t cmd[8];
-  cmd[0] = 0x01; // Device ID
-  cmd[1] = 0x06; // Function code (Write Single Register)
-  cmd[2] = 0x0B; // Register address high
-  cmd[3] = 0xBF; // Register address low (0x0BBF = AC output)
-  cmd[4] = 0x00; // Value high
-  cmd[5] = state ? 0x01 : 0x00; // Value low (0=OFF, 1=ON)
-  
-  // Розраховуємо CRC16
-  uint16_t crc = calculateCRC16(cmd, 6);
-  cmd[6] = crc & 0xFF;        // CRC low byte
-  cmd[7] = (crc >> 8) & 0xFF; // CRC high byte
-  
-  lastWriteRegister = 0x0BBF;
-  bool ok = sendCommand(cmd, sizeof(cmd));
-  if (ok) {
-    cachedAcState = state;
-    status->acOutputState = state;
-  }
-  return ok;
+  return writeSingleRegister(getProfile().controlAddress(ProfileControl::AC_OUTPUT), state ? 1 : 0, ticket);
 }
 
-bool BluettiDevice::setDCOutput(bool state) {
+bool BluettiDevice::applyDCOutput(bool state, WriteTicket ticket) {
   // Команда: 0x01 0x06 0x0BC0 VALUE CRC16 (Write Single Register)
-  uint8_t cmd[8];
-  cmd[0] = 0x01; // Device ID
-  cmd[1] = 0x06; // Function code (Write Single Register)
-  cmd[2] = 0x0B; // Register address high
-  cmd[3] = 0xC0; // Register address low (0x0BC0 = DC output)
-  cmd[4] = 0x00; // Value high
-  cmd[5] = state ? 0x01 : 0x00; // Value low (0=OFF, 1=ON)
-  
-  // Розраховуємо CRC16
-  uint16_t crc = calculateCRC16(cmd, 6);
-  cmd[6] = crc & 0xFF;        // CRC low byte
-  cmd[7] = (crc >> 8) & 0xFF; // CRC high byte
-  
-  lastWriteRegister = 0x0BC0;
-  bool ok = sendCommand(cmd, sizeof(cmd));
-  if (ok) {
-    cachedDcState = state;
-    status->dcOutputState = state;
-  }
-  return ok;
+  return writeSingleRegister(getProfile().controlAddress(ProfileControl::DC_OUTPUT), state ? 1 : 0, ticket);
 }
 
-bool BluettiDevice::setChargingSpeed(uint8_t speed) {
+bool BluettiDevice::applyChargingSpeed(uint8_t speed, WriteTicket ticket) {
   // EB3A Charging Mode (CONFIRMED from bluetti_mqtt repo):
   // 0 = STANDARD (max 268W)
   // 1 = SILENT (low power, ~100W) 
   // 2 = TURBO (max 350W)
-  
-  if (speed > 2) {
-    Serial.println("[Bluetti] ERROR: Invalid charging speed");
-    return false;
-  }
-  
   const char* modeNames[] = {"STANDARD", "SILENT", "TURBO"};
   const uint16_t powerWatts[] = {268, 100, 350};
   
   Serial.printf("[Bluetti] 🔋 Setting charging mode: %s (max %dW)\n", modeNames[speed], powerWatts[speed]);
   
-  // Регістр 0x0BF9 (3065 decimal) = charging_mode
-  const uint16_t CHARGING_MODE_REGISTER = 0x0BF9;
+  // Регістр 0x0BF9 (3065 decimal) = charging_mode на EB3A
+  const uint16_t CHARGING_MODE_REGISTER = getProfile().controlAddress(ProfileControl::CHARGING_MODE);
   
-  uint8_t cmd[8];
-  cmd[0] = 0x01; // Device ID
-  cmd[1] = 0x06; // Function: Write Single Register
-  cmd[2] = (CHARGING_MODE_REGISTER >> 8) & 0xFF;
-  cmd[3] = CHARGING_MODE_REGISTER & 0xFF;
-  cmd[4] = 0x00; // Value High
-  cmd[5] = speed; // Value Low: 0, 1, or 2
-  
-  uint16_t crc = calculateCRC16(cmd, 6);
-  cmd[6] = crc & 0xFF;
-  cmd[7] = (crc >> 8) & 0xFF;
-  
-  lastWriteRegister = CHARGING_MODE_REGISTER;
-  lastSingleRegisterRequested = CHARGING_MODE_REGISTER; // Для правильної інтерпретації відповіді
-  Serial.printf("[Bluetti] Writing 0x%04X (charging_mode) = %d (%s)... ", CHARGING_MODE_REGISTER, speed, modeNames[speed]);
-  bool success = sendCommand(cmd, sizeof(cmd));
-  Serial.println(success ? "✅" : "❌");
+  Serial.printf("[Bluetti] Writing 0x%04X (charging_mode) = %d (%s)\n", CHARGING_MODE_REGISTER, speed, modeNames[speed]);
+  bool success = writeSingleRegister(CHARGING_MODE_REGISTER, speed, ticket); // 0, 1, or 2
   
   if (success) {
-    status->chargingSpeed = speed;
-    Serial.printf("[Bluetti] ✅ Charging mode set to: %s (max %dW)\n", modeNames[speed], powerWatts[speed]);
-    
-    // Запитуємо поточний режим зарядки для підтвердження
-    delay(500);
-    requestRegister(CHARGING_MODE_REGISTER); // Підтвердження через стандартний requestRegister
+    // Читання стає в чергу після запису (нижчий пріоритет) - без delay()
+    requestRegister(CHARGING_MODE_REGISTER);
   }
   
   return success;
 }
 
-bool BluettiDevice::setEcoMode(bool state) {
-  if (ecoWriteBlocked) {
-    Serial.println("[Bluetti] ECO write skipped: device rejected ECO register earlier");
-    return false;
-  }
-  constexpr uint16_t ECO_MODE_REGISTER = 0x0BF7; // 3063 decimal (eco_on)
-  
-  // Спроба 1: звичайний запис
-  bool ok = writeSingleRegister(ECO_MODE_REGISTER, state ? 1 : 0);
+bool BluettiDevice::applyEcoMode(bool state, WriteTicket ticket) {
+  const uint16_t ECO_MODE_REGISTER = getProfile().controlAddress(ProfileControl::ECO_MODE); // eco_on
+  // Echo 0x06 підтверджує запис, втрачене echo повторює рушій транзакцій
+  bool ok = writeSingleRegister(ECO_MODE_REGISTER, state ? 1 : 0, ticket);
   if (ok) {
-    delay(300); // Затримка для обробки пристроєм
-    
-    // Спроба 2: повторний запис для гарантії
-    Serial.printf("[Bluetti] ECO mode: sending confirmation write (%s)\n", state ? "ON" : "OFF");
-    writeSingleRegister(ECO_MODE_REGISTER, state ? 1 : 0);
-    delay(200);
-    
-    status->ecoMode = state; // Optimistic update for HA/state topic
     requestRegister(ECO_MODE_REGISTER); // Confirm new state from device
   }
   return ok;
 }
 
-bool BluettiDevice::setPowerLifting(bool state) {
-  constexpr uint16_t POWER_LIFTING_REGISTER = 0x0BFA; // 3066 decimal (power_lifting_on)
-  bool ok = writeSingleRegister(POWER_LIFTING_REGISTER, state ? 1 : 0);
+bool BluettiDevice::applyPowerLifting(bool state, WriteTicket ticket) {
+  const uint16_t POWER_LIFTING_REGISTER = getProfile().controlAddress(ProfileControl::POWER_LIFTING);
+  bool ok = writeSingleRegister(POWER_LIFTING_REGISTER, state ? 1 : 0, ticket);
   if (ok) {
-    status->powerLifting = state;
     requestRegister(POWER_LIFTING_REGISTER);
   }
   return ok;
 }
 
-bool BluettiDevice::setLedMode(uint8_t mode) {
+bool BluettiDevice::applyLedMode(uint8_t mode, WriteTicket ticket) {
   // 1=Low, 2=High, 3=SOS, 4=Off
-  if (mode < 1 || mode > 4) {
-    Serial.println("[Bluetti] ERROR: Invalid LED mode (1-4)");
-    return false;
-  }
-  ledFallbackTried = false; // скидати перед записом
-  constexpr uint16_t LED_MODE_REGISTER = 0x0BDA; // 3034 decimal (led_mode)
+  const uint16_t LED_MODE_REGISTER = getProfile().controlAddress(ProfileControl::LED_MODE); // led_mode
   Serial.printf("[Bluetti] LED set request: mode=%u (1=Low,2=High,3=SOS,4=Off) -> reg 0x%04X\n", mode, LED_MODE_REGISTER);
-  bool ok = writeSingleRegister(LED_MODE_REGISTER, mode);
-  // Деякі прошивки приймають OFF як 0. Якщо просимо OFF (4), додатково шлемо 0.
+  bool ok = writeSingleRegister(LED_MODE_REGISTER, mode, ticket);
+  // Деякі прошивки приймають OFF як 0. Якщо просимо OFF (4), додатково шлемо 0
+  // (черга відправить його після першого запису). Власний ticket: витіснення
+  // з повної черги чи відмову видно в лозі та у слухача записів, як і для першого
   if (ok && mode == 4) {
-    delay(200);
     Serial.println("[Bluetti] LED OFF: sending secondary 0 to ensure off");
-    writeSingleRegister(LED_MODE_REGISTER, 0);
+    writeSingleRegister(LED_MODE_REGISTER, 0, issueTicket());
   }
   if (ok) {
-    status->ledMode = mode;
     requestRegister(LED_MODE_REGISTER);
   }
   return ok;
 }
 
-bool BluettiDevice::setEcoShutdown(uint8_t hours) {
-  // 1-4 години
-  if (hours < 1 || hours > 4) {
-    Serial.println("[Bluetti] ERROR: Invalid ECO shutdown hours (1-4)");
-    return false;
-  }
-  constexpr uint16_t ECO_SHUTDOWN_REGISTER = 0x0BF8; // 3064 decimal (eco_shutdown)
-  bool ok = writeSingleRegister(ECO_SHUTDOWN_REGISTER, hours);
+bool BluettiDevice::applyEcoShutdown(uint8_t hours, WriteTicket ticket) {
+  const uint16_t ECO_SHUTDOWN_REGISTER = getProfile().controlAddress(ProfileControl::ECO_SHUTDOWN);
+  bool ok = writeSingleRegister(ECO_SHUTDOWN_REGISTER, hours, ticket);
   if (ok) {
-    status->ecoShutdown = hours;
     requestRegister(ECO_SHUTDOWN_REGISTER);
   }
   return ok;
 }
 
-bool BluettiDevice::powerOff() {
-  constexpr uint16_t POWER_OFF_REGISTER = 0x0BF4; // 3060 decimal (power_off)
-  return writeSingleRegister(POWER_OFF_REGISTER, 1);
+bool BluettiDevice::applyPowerOff(WriteTicket ticket) {
+  const uint16_t POWER_OFF_REGISTER = getProfile().controlAddress(ProfileControl::POWER_OFF); // power_off
+  return writeSingleRegister(POWER_OFF_REGISTER, 1, ticket);
+}
+
+void BluettiDevice::applyWrittenRegister(uint16_t reg, uint16_t value) {
+  ProfileControl control;
+  if (getProfile().controlAt(reg, control) && control == ProfileControl::AC_OUTPUT) {
+    cachedAcState = (value == 1);
+    status->acOutputState = cachedAcState;
+  } else if (getProfile().controlAt(reg, control) && control == ProfileControl::DC_OUTPUT) {
+    cachedDcState = (value == 1);
+    status->dcOutputState = cachedDcState;
+  } else {
+    applyFeatureRegister(reg, value); // Стара адреса теж розпізнається через профіль
+  }
 }
 
-uint8_t BluettiDevice::getBatteryLevel() const { return cachedBattery; }
+// Геттери читають спільний стан - викликаються з loop/AsyncTCP, а не з BLE worker
+uint8_t BluettiDevice::getBatteryLevel() const { return sharedStatus->batteryLevel; }
 
-int BluettiDevice::getACOutputPower() const { return cachedAcPower; }
+int BluettiDevice::getACOutputPower() const { return sharedStatus->acPower; }
 
-int BluettiDevice::getDCOutputPower() const { return cachedDcPower; }
+int BluettiDevice::getDCOutputPower() const { return sharedStatus->dcPower; }
 
-bool BluettiDevice::getACOutputState() const { return cachedAcState; }
+bool BluettiDevice::getACOutputState() const { return sharedStatus->acOutputState; }
 
-bool BluettiDevice::getDCOutputState() const { return cachedDcState; }
+bool BluettiDevice::getDCOutputState() const { return sharedStatus->dcOutputState; }
 
-int BluettiDevice::getInputPower() const { return cachedInputPower; }
+int BluettiDevice::getInputPower() const { return sharedStatus->inputPower; }
 
 float BluettiDevice::getTemperature() const { 
   // Температура зберігається в форматі ×10 (наприклад 250 = 25.0°C)
-  return status->temperature / 10.0f; 
+  return sharedStatus->temperature / 10.0f; 
 }
 
 float BluettiDevice::getBatteryVoltage() const { 
   // Напруга зберігається в форматі ×10 (наприклад 537 = 53.7V)
-  return status->batteryVoltage / 10.0f; 
+  return sharedStatus->batteryVoltage / 10.0f; 
 }
 
 uint8_t BluettiDevice::getChargingSpeed() const {
-  return status->chargingSpeed;
+  return sharedStatus->chargingSpeed;
 }
 
 bool BluettiDevice::getEcoMode() const {
-  return status->ecoMode;
+  return sharedStatus->ecoMode;
 }
 
 bool BluettiDevice::getPowerLifting() const {
-  return status->powerLifting;
+  return sharedStatus->powerLifting;
 }
 
 uint8_t BluettiDevice::getLedMode() const {
-  return status->ledMode;
+  return sharedStatus->ledMode;
 }
 
 uint8_t BluettiDevice::getEcoShutdown() const {
-  return status->ecoShutdown;
+  return sharedStatus->ecoShutdown;
 }
 
-bool BluettiDevice::writeSingleRegister(uint16_t reg, uint16_t value) {
-  if (!connected || !client || !client->isConnected() || !writeCharacteristic) {
+bool BluettiDevice::writeSingleRegister(uint16_t reg, uint16_t value, WriteTicket ticket) {
+  if (reg == 0) {
+    // Профіль моделі змінився після того, як команду поставили в чергу
+    Serial.printf("[Bluetti] Write skipped: %s has no such control\n", getProfile().displayName);
+    completeWrite(ticket, reg, value, WriteOutcome::REJECTED, millis());
     return false;
   }
-  
-  uint8_t cmd[8];
-  cmd[0] = 0x01; // Device ID
-  cmd[1] = 0x06; // Function: Write Single Register
-  cmd[2] = (reg >> 8) & 0xFF;
-  cmd[3] = reg & 0xFF;
-  cmd[4] = (value >> 8) & 0xFF;
-  cmd[5] = value & 0xFF;
-  
-  uint16_t crc = calculateCRC16(cmd, 6);
-  cmd[6] = crc & 0xFF;
-  cmd[7] = (crc >> 8) & 0xFF;
-  
-  lastWriteRegister = reg;
-  Serial.printf("[Bluetti] Write reg 0x%04X = %d... ", reg, value);
-  bool success = sendCommand(cmd, sizeof(cmd));
-  Serial.println(success ? "✅" : "❌");
-  return success;
+  if (!linkUp()) {
+    completeWrite(ticket, reg, value, WriteOutcome::NOT_SENT, millis());
+    return false;
+  }
+  uint16_t target = resolveWriteRegister(reg);
+  if (target == 0) {
+    Serial.printf("[Bluetti] Write 0x%04X skipped: %s rejects this register\n", reg, status->modelName);
+    completeWrite(ticket, reg, value, WriteOutcome::REJECTED, millis());
+    return false;
+  }
+  if (target != reg) {
+    Serial.printf("[Bluetti] Write 0x%04X redirected to legacy 0x%04X\n", reg, target);
+    reg = target;
+  }
+
+  // Запис випереджає фонове опитування в черзі; echo 0x06 підтверджує його
+  ModbusTransaction txn;
+  txn.kind = ModbusTxnKind::WRITE_REGISTER;
+  txn.priority = ModbusPriority::USER_WRITE;
+  txn.function = 0x06;
+  txn.address = reg;
+  txn.value = value;
+  txn.retriesLeft = WRITE_RETRIES;
+  txn.timeoutMs = WRITE_RESPONSE_TIMEOUT_MS;
+  txn.ticket = ticket;
+
+  bool queued = transactions.enqueue(txn, millis());
+  Serial.printf("[Bluetti] Write reg 0x%04X = %d queued... %s\n", reg, value, queued ? "✅" : "❌ (queue full)");
+  if (!queued) {
+    completeWrite(ticket, reg, value, WriteOutcome::NOT_SENT, millis());
+  }
+  return queued;
+}
+
+void BluettiDevice::requestRegister(uint16_t reg, ModbusPriority priority) {
+  requestRegisters(reg, 1, priority);
 }
 
-void BluettiDevice::requestRegister(uint16_t reg) {
-  if (!connected || !client || !client->isConnected() || !writeCharacteristic) {
+void BluettiDevice::requestRegisters(uint16_t start, uint16_t count, ModbusPriority priority) {
+  if (!linkUp()) {
     return;
   }
-  
-  // Перевірка: чи очікуємо відповідь?
-  if (waitingForResponse) {
-    unsigned long waitTime = millis() - requestStartTime;
-    if (waitTime < 3000) { // Таймаут 3 секунди
-      // Тихо ігноруємо - запит надійде коли отримаємо відповідь
-      return; // Не надсилаємо новий запит
-    } else {
-      Serial.printf("[Bluetti] ⚠️  Response timeout after %lums, resetting...\n", waitTime);
-      waitingForResponse = false; // Скидаємо флаг після таймауту
-      lastSingleRegisterRequested = 0;
-    }
-  }
-  
-  Serial.printf("[Bluetti] 📤 Requesting register 0x%04X...\n", reg);
-  
-  uint8_t cmd[8];
-  cmd[0] = 0x01; // Device ID
-  cmd[1] = 0x03; // Function: Read Holding Registers
-  cmd[2] = (reg >> 8) & 0xFF;
-  cmd[3] = reg & 0xFF;
-  cmd[4] = 0x00; // Quantity High
-  cmd[5] = 0x01; // Quantity Low (1 register)
-  
-  uint16_t crc = calculateCRC16(cmd, 6);
-  cmd[6] = crc & 0xFF;
-  cmd[7] = (crc >> 8) & 0xFF;
-  
-  sendCommand(cmd, sizeof(cmd));
-  lastSingleRegisterRequested = reg;
-  waitingForResponse = true; // Встановлюємо флаг очікування
-  requestStartTime = millis(); // Запам'ятовуємо час запиту
-  
-  Serial.printf("[Bluetti] ✅ Request sent for 0x%04X\n", reg);
-}
 
-void BluettiDevice::pollFeatureState() {
-  // Ротація опитування додаткових функцій (не критичні, опитуємо рідко)
-  // ВАЖЛИВО: Затримки між запитами, щоб уникнути плутанини відповідей
-  // Опитуємо тільки ОДИН регістр за виклик з великою затримкою
-  switch (featurePollIndex % 5) {
-    case 0: requestRegister(0x0BF7); break; // ECO Mode (3063)
-    case 1: requestRegister(0x0BFA); break; // Power Lifting (3066)
-    case 2: requestRegister(0x0BDA); break; // LED Mode (3034)
-    case 3: requestRegister(0x0BF8); break; // ECO Shutdown (3064)
-    case 4: requestRegister(0x0BF9); break; // Charging Mode (3065)
-  }
-  featurePollIndex++;
-}
-
-void BluettiDevice::handleNotification(uint8_t *data, size_t length) {
-  // ВАЖЛИВО: Ця функція викликається коли Bluetti відправляє дані через notifications
-  // Якщо ця функція ніколи не викликається, це означає що Bluetti не відправляє дані
-  Serial.println("\n\n\n[Bluetti] ========================================");
-  Serial.println("[Bluetti] *** NOTIFICATION RECEIVED ***");
-  Serial.printf("[Bluetti] Length: %d bytes\n", length);
-  Serial.print("[Bluetti] Data: ");
-  for (size_t i = 0; i < length && i < 67; i++) {
-    Serial.printf("%02X ", data[i]);
-    if ((i + 1) % 16 == 0) Serial.println("    ");
+  ModbusTransaction txn;
+  txn.kind = ModbusTxnKind::READ_REGISTER;
+  txn.priority = priority;
+  txn.function = 0x03;
+  txn.address = start;
+  txn.value = count;
+  // Фонове опитування не повторюємо - регістр опитається в наступному циклі
+  txn.retriesLeft = (priority == ModbusPriority::POLL) ? 0 : 1;
+  txn.timeoutMs = REGISTER_RESPONSE_TIMEOUT_MS;
+
+  if (!transactions.enqueue(txn, millis())) {
+    Serial.printf("[Bluetti] ⚠️  Register 0x%04X (+%u) not queued (queue full)\n", start, count);
   }
-  Serial.println();
-  Serial.println("[Bluetti] ========================================\n\n\n");
+}
 
-  // Перевіряємо заголовок
-  if (length < 5) {
-    Serial.printf("[Bluetti] WARNING: Notification too short: length=%d\n", length);
-    return;
+uint16_t BluettiDevice::resolveWriteRegister(uint16_t reg) const {
+  if (capabilities.writeSupport(reg) != RegisterSupport::REJECTED) {
+    return reg;
   }
-  
-  // Перевіряємо на помилку MODBUS (0x83 = 0x03 + 0x80, 0x86 = 0x06 + 0x80)
-  if (data[0] == 0x01 && (data[1] == 0x83 || data[1] == 0x86)) {
-    uint8_t exceptionCode = (length >= 3) ? data[2] : 0;
-    Serial.printf("[Bluetti] ERROR: MODBUS Exception received (code 0x%02X): ", data[1]);
-    for (size_t i = 0; i < length && i < 10; i++) {
-      Serial.printf("%02X ", data[i]);
-    }
-    Serial.println();
-    Serial.printf("[Bluetti] Exception code: 0x%02X\n", exceptionCode);
-    Serial.println("[Bluetti] 💡 This usually means:");
-    Serial.println("[Bluetti]    1. Register address is invalid or not supported");
-    Serial.println("[Bluetti]    2. Device doesn't support this function");
-    Serial.println("[Bluetti]    3. Register is read-only");
-    if (data[1] == 0x86) {
-      Serial.printf("[Bluetti] Last write register: 0x%04X\n", lastWriteRegister);
-      switch (lastWriteRegister) {
-        case 0x0BF9: Serial.println("[Bluetti] ⚠️  Charging speed may not be supported on this device"); break;
-        case 0x0BF7:
-          Serial.println("[Bluetti] ⚠️  ECO mode register not supported (will skip further ECO writes)");
-          ecoWriteBlocked = true;
-          break;
-        case 0x0BFA: Serial.println("[Bluetti] ⚠️  Power Lifting register not supported (ignored)"); break;
-        case 0x0BDA:
-          Serial.println("[Bluetti] ⚠️  LED mode register 0x0BDA rejected, trying legacy 0x0BBA once");
-          if (!ledFallbackTried) {
-            ledFallbackTried = true;
-            // Спробуємо старий регістр 0x0BBA (3034 старе зміщення)
-            writeSingleRegister(0x0BBA, status->ledMode);
-          }
-          break;
-        case 0x0BF8: Serial.println("[Bluetti] ⚠️  ECO shutdown register not supported (ignored)"); break;
-        case 0x0BBF: Serial.println("[Bluetti] ⚠️  AC output write rejected"); break;
-        case 0x0BC0: Serial.println("[Bluetti] ⚠️  DC output write rejected"); break;
-        default:     Serial.println("[Bluetti] ⚠️  Write rejected by device"); break;
-      }
-    }
-    return;
+  uint16_t fallback = capabilities.writeFallback(reg);
+  if (fallback == 0) {
+    fallback = getProfile().legacyAddress(reg);
   }
-  
-  // 0x06 = write single register response (OK), 0x03 = read response
-  if (data[0] == 0x01 && data[1] == 0x06) {
-    Serial.println("[Bluetti] ✅ Write command acknowledged");
-    return;
+  if (fallback != 0 && capabilities.writeSupport(fallback) != RegisterSupport::REJECTED) {
+    return fallback;
   }
-  
-  if (data[0] != 0x01 || data[1] != 0x03) {
-    Serial.printf("[Bluetti] WARNING: Unexpected header: data[0]=%02X, data[1]=%02X (expected 01 03 or 01 06)\n", data[0], data[1]);
-    Serial.printf("[Bluetti] Full response: ");
-    for (size_t i = 0; i < length && i < 20; i++) {
-      Serial.printf("%02X ", data[i]);
+  return 0;
+}
+
+void BluettiDevice::pollFeatureState() {
+  // Усі додаткові функції за один цикл: суміжні регістри читаємо одним
+  // запитом, не довшим за одну notification (або за межу Modbus PDU)
+  uint16_t maxPerRead = diagnostics.maxRegistersPerNotification > 0
+                            ? diagnostics.maxRegistersPerNotification
+                            : MODBUS_MAX_READ_REGISTERS;
+  if (capabilities.rangeReadsRejected()) {
+    maxPerRead = 1; // Пристрій відхилив діапазон - по одному регістру
+  }
+
+  // Регістри, які модель уже відхилила, не опитуємо взагалі
+  const DeviceProfile &profile = getProfile();
+  uint16_t registers[PROFILE_MAX_FEATURE_REGISTERS];
+  size_t registerCount = 0;
+  for (size_t i = 0; i < profile.featureCount; i++) {
+    if (capabilities.readSupport(profile.featureRegisters[i]) != RegisterSupport::REJECTED) {
+      registers[registerCount++] = profile.featureRegisters[i];
     }
-    Serial.println();
-    return;
   }
 
-  uint8_t dataLength = data[2];
-  if (length < 3 + dataLength) {
-    Serial.printf("[Bluetti] Invalid length: expected %d, got %d\n", 3 + dataLength, length);
-    return;
+  PollRange ranges[PROFILE_MAX_FEATURE_REGISTERS];
+  size_t rangeCount = planRegisterReads(registers, registerCount, maxPerRead,
+                                        POLL_PLANNER_MAX_GAP, ranges, PROFILE_MAX_FEATURE_REGISTERS);
+  for (size_t i = 0; i < rangeCount; i++) {
+    requestRegisters(ranges[i].start, ranges[i].count, ModbusPriority::POLL);
   }
 
-  // Перевірка: чи це відповідь на запит окремого регістра? (1 регістр = 2 байти)
-  if (dataLength == 2 && length == 7) {
-    uint16_t valueRaw = (data[3] << 8) | data[4];
-    uint16_t requestedReg = lastSingleRegisterRequested;
-    
-    // Перевірка: якщо lastSingleRegisterRequested == 0, ігноруємо (застаріла відповідь)
-    if (requestedReg == 0 || !waitingForResponse) {
-      Serial.printf("[Bluetti] ⚠️  Ignoring unexpected single register response: value=%d (no pending request or not waiting)\n", valueRaw);
-      return;
-    }
-    
-    Serial.printf("[Bluetti] Single register response for 0x%04X: value=%d (0x%04X)\n", 
-                  requestedReg, valueRaw, valueRaw);
-    
-    // Визначаємо за останнім запитаним регістром
-    if (requestedReg == 0x0BF9) {
-      // Charging mode (register 0x0BF9 = 3065)
+  diagnostics.featureReadsPerCycle = rangeCount;
+  diagnostics.featureRoundTripsSaved = profile.featureCount - rangeCount;
+  diagnostics.featureRoundTripsSavedTotal += profile.featureCount - rangeCount;
+}
+
+bool BluettiDevice::applyFeatureRegister(uint16_t reg, uint16_t valueRaw) {
+  ProfileControl control;
+  if (!getProfile().controlAt(reg, control)) {
+    return false;
+  }
+  switch (control) {
+    case ProfileControl::CHARGING_MODE:
+      // Charging mode (0x0BF9 = 3065 на EB3A)
       if (valueRaw <= 2) {
         status->chargingSpeed = (uint8_t)valueRaw;
         const char* modeNames[] = {"STANDARD", "SILENT", "TURBO"};
@@ -1155,372 +1502,375 @@ void BluettiDevice::handleNotification(uint8_t *data, size_t length) {
       } else {
         Serial.printf("[Bluetti] ⚠️  Invalid charging mode value: %d (expected 0-2)\n", valueRaw);
       }
-    } else if (requestedReg == 0x0BF7) {
-      // ECO Mode (register 0x0BF7 = 3063)
+      return true;
+    case ProfileControl::ECO_MODE:
+      // ECO Mode (0x0BF7 = 3063 на EB3A)
       status->ecoMode = (valueRaw == 1);
-      Serial.printf("[Bluetti] 🌿 ECO mode: %s (reg=0x0BF7, value=%d)\n", status->ecoMode ? "ON" : "OFF", valueRaw);
+      Serial.printf("[Bluetti] 🌿 ECO mode: %s (reg=0x%04X, value=%d)\n", status->ecoMode ? "ON" : "OFF", reg, valueRaw);
       if (valueRaw != 0 && valueRaw != 1) {
         Serial.printf("[Bluetti] ⚠️  Unexpected ECO mode value: %d\n", valueRaw);
       }
-    } else if (requestedReg == 0x0BFA) {
-      // Power Lifting
+      return true;
+    case ProfileControl::POWER_LIFTING:
       status->powerLifting = (valueRaw == 1);
       Serial.printf("[Bluetti] ⚡ Power Lifting: %s\n", status->powerLifting ? "ON" : "OFF");
-    } else if (requestedReg == 0x0BDA) {
-      // LED Mode
+      return true;
+    case ProfileControl::LED_MODE:
+      // Основний або старий регістр LED
       if (valueRaw >= 1 && valueRaw <= 4) {
         status->ledMode = (uint8_t)valueRaw;
         const char* ledNames[] = {"", "Low", "High", "SOS", "Off"};
         Serial.printf("[Bluetti] 💡 LED mode: %s (%d)\n", ledNames[valueRaw], status->ledMode);
       }
-    } else if (requestedReg == 0x0BF8) {
-      // ECO Shutdown (register 0x0BF8 = 3064)
+      return true;
+    case ProfileControl::ECO_SHUTDOWN:
+      // ECO Shutdown (0x0BF8 = 3064 на EB3A)
       if (valueRaw >= 1 && valueRaw <= 4) {
         status->ecoShutdown = (uint8_t)valueRaw;
-        Serial.printf("[Bluetti] ⏰ ECO shutdown: %dh (reg=0x0BF8, value=%d)\n", status->ecoShutdown, valueRaw);
+        Serial.printf("[Bluetti] ⏰ ECO shutdown: %dh (reg=0x%04X, value=%d)\n", status->ecoShutdown, reg, valueRaw);
       } else {
         Serial.printf("[Bluetti] ⚠️  Invalid ECO shutdown value: %d (expected 1-4)\n", valueRaw);
       }
-    } else {
-      // Невідомий регістр - виводимо для дебагу
-      Serial.printf("[Bluetti] 📊 Single register 0x%04X response: %d (0x%04X)\n", 
-                    requestedReg, valueRaw, valueRaw);
-    }
-    
-    // ВАЖЛИВО: Очищаємо lastSingleRegisterRequested після обробки
-    lastSingleRegisterRequested = 0;
-    waitingForResponse = false; // Скидаємо флаг очікування
-    // Успішна обробка - готові до наступного запиту
-    return;
+      return true;
+    default:
+      return false; // Виходи та вимкнення приходять у блоці статусу
   }
+}
 
-  // EB3A MODBUS структура від адреси 0x000A (40 registers), response starts at offset 3
-  // Зберігаємо всі регістри для аналізу
-  for (int i = 0; i < 40 && (3 + i*2 + 1) < (int)length; i++) {
-    status->registers[i] = (data[3 + i*2] << 8) | data[3 + i*2 + 1];
-  }
-  
-  Serial.println("\n[Bluetti] ========================================");
-  Serial.println("[Bluetti] === ВСІ ДАНІ BLUETTI ===");
-  Serial.println("[Bluetti] ========================================");
-  
-  // ✅ CORRECT REGISTER MAPPING (from giovanne123/EB3A_Bluetti_ESP32_HA):
-  // Reading from address 0x000A (40 registers), response starts at offset 3
-  // Offset розрахунок: 3 + (register - 0x0A) × 2
-  // Battery:   0x2B = 3 + (0x2B-0x0A)×2 = 3 + 33×2 = 69 → raw/10
-  // AC Power:  0x26 = 3 + (0x26-0x0A)×2 = 3 + 28×2 = 59 → Watts
-  // DC Power:  0x27 = 3 + (0x27-0x0A)×2 = 3 + 29×2 = 61 → Watts
-  // AC State:  0x30 = 3 + (0x30-0x0A)×2 = 3 + 38×2 = 79 → 0=OFF, 1=ON
-  // DC State:  0x31 = 3 + (0x31-0x0A)×2 = 3 + 39×2 = 81 → 0=OFF, 1=ON
-  
-  // 1. Модель пристрою (регістри 0x000A-0x000B)
-  // Регістр 0x000A = offset 3 + (0x0A - 0x0A) * 2 = 3 (байти 3-4)
-  // Регістр 0x000B = offset 3 + (0x0B - 0x0A) * 2 = 5 (байти 5-6)
-  // Але згідно документації "EB3A" на offsets 11-14, що відповідає регістрам 0x000A-0x000B
-  // Тобто: data[11]=0x45, data[12]=0x42, data[13]=0x33, data[14]=0x41
-  // Але це означає, що регістр 0x000A знаходиться на offset 11-12
-  // Перевіримо обидва варіанти
-  if (length >= 15) {
-    // Спробуємо offsets 11-14 (згідно документації)
-    if (data[11] == 0x45 && data[12] == 0x42) {
-      status->modelName[0] = (char)data[11];
-      status->modelName[1] = (char)data[12];
-      status->modelName[2] = (char)data[13];
-      status->modelName[3] = (char)data[14];
-      status->modelName[4] = '\0';
-    } else {
-      // Спробуємо регістри 0x000A-0x000B (offsets 3-6)
-      uint16_t reg0A = (data[3] << 8) | data[4];
-      uint16_t reg0B = (data[5] << 8) | data[6];
-      status->modelName[0] = (char)((reg0A >> 8) & 0xFF);
-      status->modelName[1] = (char)(reg0A & 0xFF);
-      status->modelName[2] = (char)((reg0B >> 8) & 0xFF);
-      status->modelName[3] = (char)(reg0B & 0xFF);
-      status->modelName[4] = '\0';
-    }
-    Serial.printf("[Bluetti] Модель: %s\n", status->modelName);
-  }
-  
-  // 2. Battery SOC (регістр 0x0010)
-  // Регістр 0x0010 = offset 3 + (0x10 - 0x0A) × 2 = 3 + 6 × 2 = 15 (байти 15-16)
-  // Значення 1019 = 101.9% → обмежуємо до 100%
-  int batteryRegOffset = -1;
-  uint16_t batteryReg0010 = 0;
-  uint16_t batteryReg002B = 0;
-
-  // Читаємо обидва потенційні регістри SoC
-  if (length >= 17) {
-    batteryReg0010 = (data[15] << 8) | data[16]; // 0x0010
-  }
-  if (length >= 71) {
-    batteryReg002B = (data[69] << 8) | data[70]; // 0x002B
-  }
-
-  // Основна логіка: віддаємо перевагу 0x002B, якщо він у межах 0-100%.
-  // У польових логах саме 0x002B змінюється (84→85), тоді як 0x0010 часто «залипає» на 1019.
-  bool reg002BValid = (batteryReg002B > 0 && batteryReg002B <= 100);
-  bool reg0010ValidPercent = (batteryReg0010 > 0 && batteryReg0010 <= 100);
-  bool reg0010ValidX10 = (batteryReg0010 > 100 && batteryReg0010 <= 1100);
-
-  if (reg002BValid) {
-    cachedBattery = batteryReg002B;
-    batteryRegOffset = 69; // offset у відповіді (0x002B)
-    status->batteryRaw = batteryReg002B;
-  } else if (reg0010ValidX10) {
-    cachedBattery = batteryReg0010 / 10;
-    batteryRegOffset = 15; // offset у відповіді (0x0010)
-    status->batteryRaw = batteryReg0010;
-  } else if (reg0010ValidPercent) {
-    cachedBattery = batteryReg0010;
-    batteryRegOffset = 15;
-    status->batteryRaw = batteryReg0010;
-  }
-
-  // Обмежуємо до 0-100
-  if (cachedBattery > 100) cachedBattery = 100;
-
-  if (batteryRegOffset == -1) {
-    cachedBattery = 100;
-    status->batteryRaw = 1000;
-    Serial.println("[Bluetti] ⚠️  Battery not detected, using default 100%");
-  } else {
-    Serial.printf("[Bluetti] Батарея: %d%% (reg 0x%04X raw: %d%s)\n",
-                  cachedBattery,
-                  (batteryRegOffset == 69) ? 0x002B : 0x0010,
-                  status->batteryRaw,
-                  reg0010ValidX10 ? " ÷10" : "");
-    if (reg002BValid && reg0010ValidX10) {
-      Serial.printf("[Bluetti]     Debug: reg0x0010=%d, reg0x002B=%d -> using 0x002B as SoC\n",
-                    batteryReg0010, batteryReg002B);
-    }
-  }
-  
-  // 3. Напруга батареї (регістр 0x0013)
-  // Регістр 0x0013 = offset 3 + (0x13 - 0x0A) × 2 = 3 + 9 × 2 = 21 (байти 21-22)
-  if (length >= 23) {
-    status->batteryVoltage = (data[21] << 8) | data[22];
-    // Напруга в форматі ×10 (537 = 53.7V) або ×100 (537 = 5.37V)
-    // Зазвичай для EB3A це ×10, тобто 537 = 53.7V
-    Serial.printf("[Bluetti] Напруга батареї: %d (%.1fV)\n", 
-                  status->batteryVoltage, status->batteryVoltage / 10.0f);
-  }
-  
-  // 4. Температура
-  // EB3A зберігає температуру в регістрах page 0x00 в форматі Кельвіни або прямі °C × 10
-  // Регістр 0x0028 або 0x0029 може містити температуру для деяких моделей
-  // Формат: значення / 10 = температура в °C
-  // Або формат Кельвіни: (значення - 2731) / 10 = °C
-  status->temperature = 0; // За замовчуванням невідомо
-  
-  if (length >= 35) {
-    // Спробуємо кілька відомих регістрів для температури
-    // Регістр 0x0028 (offset 63-64) - часто використовується для внутрішньої температури
-    int tempOffset = 3 + (0x28 - 0x0A) * 2; // = 3 + 30*2 = 63
-    if (tempOffset + 1 < (int)length) {
-      uint16_t regVal = (data[tempOffset] << 8) | data[tempOffset + 1];
-      // Перевіряємо чи це розумне значення температури
-      // Формат ×10: 200-500 = 20-50°C
-      // Формат Кельвіни: 2931-3231 = 20-50°C (2731 + 200 to 2731 + 500)
-      if (regVal >= 100 && regVal <= 700) {
-        // Прямий формат ×10 (наприклад 250 = 25.0°C)
-        status->temperature = regVal;
-        Serial.printf("[Bluetti] Температура (reg 0x0028): %d (%.1f°C)\n", 
-                      status->temperature, status->temperature / 10.0f);
-      } else if (regVal >= 2731 && regVal <= 3531) {
-        // Формат Кельвіни (2731 = 0°C, 2981 = 25°C)
-        status->temperature = (regVal - 2731); // Конвертуємо в ×10 °C
-        Serial.printf("[Bluetti] Температура (reg 0x0028, Kelvin): %d K = %.1f°C\n", 
-                      regVal, status->temperature / 10.0f);
+void BluettiDevice::handleNotification(const ModbusFrameView &frame) {
+  // ID, довжину та CRC вже перевірив parseModbusFrame() у reassembler
+  // Відповідь зіставляється з транзакцією в польоті за function code та
+  // адресою (echo 0x06) або довжиною (0x03) - чужий кадр її не завершить
+  unsigned long now = millis();
+  bool matched = transactions.complete(frame, now);
+  const ModbusTransaction &txn = transactions.current();
+
+  // Помилка MODBUS (0x83 = 0x03 + 0x80, 0x86 = 0x06 + 0x80)
+  if (frame.type == ModbusFrameType::EXCEPTION) {
+    Serial.printf("[Bluetti] ERROR: MODBUS Exception received (code 0x%02X)\n", frame.function);
+    dumpFrame("RX", frame.data, frame.length);
+    Serial.printf("[Bluetti] Exception code: 0x%02X\n", frame.exceptionCode);
+    if (matched) {
+      transactions.holdOff(now + POST_STATUS_QUIET_MS);
+      if (frame.function == 0x83 && txn.kind == ModbusTxnKind::READ_REGISTER && isCapabilityException(frame)) {
+        if (txn.value > 1 && capabilities.rejectRangeReads()) {
+          // Діапазон містить регістр, який пристрій не віддає - далі читаємо по одному
+          Serial.printf("[Bluetti] ⚠️  Range read 0x%04X (+%u) rejected, falling back to single-register polling\n",
+                        txn.address, txn.value);
+        } else if (txn.value == 1 && capabilities.markRead(txn.address, RegisterSupport::REJECTED)) {
+          Serial.printf("[Bluetti] ⚠️  Register 0x%04X not readable on %s, dropped from polling\n",
+                        txn.address, status->modelName);
+        }
       }
     }
-    
-    // Якщо не знайдено в 0x0028, спробуємо 0x0029
-    if (status->temperature == 0) {
-      tempOffset = 3 + (0x29 - 0x0A) * 2; // = 3 + 31*2 = 65
-      if (tempOffset + 1 < (int)length) {
-        uint16_t regVal = (data[tempOffset] << 8) | data[tempOffset + 1];
-        if (regVal >= 100 && regVal <= 700) {
-          status->temperature = regVal;
-          Serial.printf("[Bluetti] Температура (reg 0x0029): %d (%.1f°C)\n", 
-                        status->temperature, status->temperature / 10.0f);
-        } else if (regVal >= 2731 && regVal <= 3531) {
-          status->temperature = (regVal - 2731);
-          Serial.printf("[Bluetti] Температура (reg 0x0029, Kelvin): %d K = %.1f°C\n", 
-                        regVal, status->temperature / 10.0f);
+    Serial.println("[Bluetti] 💡 This usually means:");
+    Serial.println("[Bluetti]    1. Register address is invalid or not supported");
+    Serial.println("[Bluetti]    2. Device doesn't support this function");
+    Serial.println("[Bluetti]    3. Register is read-only");
+    if (frame.function == 0x86) {
+      if (!matched) {
+        Serial.println("[Bluetti] ⚠️  Write exception without a pending write (ignored)");
+        return;
+      }
+      diagnostics.writeFailures++;
+      Serial.printf("[Bluetti] Rejected write register: 0x%04X\n", txn.address);
+      if (isCapabilityException(frame) && capabilities.markWrite(txn.address, RegisterSupport::REJECTED)) {
+        Serial.printf("[Bluetti] ⚠️  %s rejects writes to 0x%04X (will skip further writes)\n",
+                      status->modelName, txn.address);
+        if (resolveWriteRegister(txn.address) != 0) {
+          // Є старий регістр, який ще не відхилено - той самий ticket,
+          // результат запису повідомить уже fallback
+          // txn - слот рушія, який writeSingleRegister перезапише: копіюємо поля
+          uint16_t address = txn.address;
+          uint16_t value = txn.value;
+          WriteTicket ticket = txn.ticket;
+          Serial.printf("[Bluetti] Trying legacy register for 0x%04X\n", address);
+          writeSingleRegister(address, value, ticket);
+          return;
         }
       }
-    }
-    
-    // Якщо все ще не знайдено, шукаємо будь-яке значення в розумному діапазоні
-    if (status->temperature == 0) {
-      for (int i = 0; i < 40; i++) {
-        int offset = 3 + i * 2;
-        if (offset + 1 < (int)length) {
-          uint16_t regVal = (data[offset] << 8) | data[offset + 1];
-          // Шукаємо значення 150-500 (15-50°C в форматі ×10)
-          if (regVal >= 150 && regVal <= 500) {
-            // Пропускаємо регістри з відомими іншими значеннями
-            uint16_t regAddr = 0x000A + i;
-            if (regAddr != 0x0010 && regAddr != 0x0013 && 
-                regAddr != 0x0017 && regAddr != 0x0019 &&
-                regAddr != 0x002B) {
-              status->temperature = regVal;
-              Serial.printf("[Bluetti] Температура (reg 0x%04X): %d (%.1f°C) - можливо\n", 
-                            regAddr, status->temperature, status->temperature / 10.0f);
-              break;
-            }
-          }
+      ProfileControl control;
+      if (!getProfile().controlAt(txn.address, control)) {
+        Serial.println("[Bluetti] ⚠️  Write rejected by device");
+      } else {
+        switch (control) {
+          case ProfileControl::CHARGING_MODE: Serial.println("[Bluetti] ⚠️  Charging speed may not be supported on this device"); break;
+          case ProfileControl::ECO_MODE:      Serial.println("[Bluetti] ⚠️  ECO mode register not supported"); break;
+          case ProfileControl::POWER_LIFTING: Serial.println("[Bluetti] ⚠️  Power Lifting register not supported (ignored)"); break;
+          case ProfileControl::LED_MODE:      Serial.println("[Bluetti] ⚠️  LED mode register rejected"); break;
+          case ProfileControl::ECO_SHUTDOWN:  Serial.println("[Bluetti] ⚠️  ECO shutdown register not supported (ignored)"); break;
+          case ProfileControl::AC_OUTPUT:     Serial.println("[Bluetti] ⚠️  AC output write rejected"); break;
+          case ProfileControl::DC_OUTPUT:     Serial.println("[Bluetti] ⚠️  DC output write rejected"); break;
+          case ProfileControl::POWER_OFF:     Serial.println("[Bluetti] ⚠️  Power off write rejected"); break;
         }
       }
+      completeWrite(txn.ticket, txn.address, txn.value, WriteOutcome::REJECTED, txn.enqueuedAt);
     }
-    
-    // EB3A doesn't have temperature sensors in this register page
+    return;
   }
   
-  // 5. Input Power (регістри 0x0024=DC_INPUT, 0x0025=AC_INPUT, offsets 55-58)
-  if (length >= 57) {
-    status->dcInputPower = (data[55] << 8) | data[56];
-  }
-  if (length >= 59) {
-    status->acInputPower = (data[57] << 8) | data[58];
+  // 0x06 = write single register response (OK)
+  if (frame.type == ModbusFrameType::WRITE_ECHO) {
+    if (!matched) {
+      Serial.println("[Bluetti] ⚠️  Write echo without a pending write (ignored)");
+      return;
+    }
+    recordWriteAck(now - txn.enqueuedAt);
+    if (frame.value != txn.value) {
+      // Пристрій прийняв запис, але зберіг інше значення - джерело правди читання
+      Serial.printf("[Bluetti] ⚠️  Write 0x%04X echoed %u instead of %u\n", txn.address, frame.value, txn.value);
+      completeWrite(txn.ticket, txn.address, txn.value, WriteOutcome::REJECTED, txn.enqueuedAt);
+      return;
+    }
+    Serial.printf("[Bluetti] ✅ Write 0x%04X acknowledged (%lums after command)\n",
+                  txn.address, diagnostics.writeAckMs);
+    capabilities.markWrite(txn.address, RegisterSupport::SUPPORTED);
+    const DeviceProfile &profile = getProfile();
+    for (size_t i = 0; i < profile.controlCount; i++) {
+      const ControlRegister &entry = profile.controls[i];
+      if (entry.legacyAddress != 0 && entry.legacyAddress == txn.address &&
+          capabilities.writeSupport(entry.address) == RegisterSupport::REJECTED) {
+        capabilities.setWriteFallback(entry.address, entry.legacyAddress);
+      }
+    }
+    applyWrittenRegister(txn.address, txn.value);
+    registerCache.store(txn.address, txn.value, registerTtlMs(profile, txn.address), now); // Echo - значення пристрою
+    completeWrite(txn.ticket, txn.address, txn.value, WriteOutcome::CONFIRMED, txn.enqueuedAt);
+    return;
   }
-  cachedInputPower = status->dcInputPower + status->acInputPower;
-  Serial.printf("[Bluetti] Вхідна потужність: %dW (DC: %dW, AC: %dW)\n", 
-                cachedInputPower, status->dcInputPower, status->acInputPower);
   
-  // 6. AC Output Power (регістр 0x0026, offset 59-60)
-  if (length >= 61) {
-    cachedAcPower = (data[59] << 8) | data[60];
-    Serial.printf("[Bluetti] AC вихідна потужність: %dW\n", cachedAcPower);
-  } else {
-    cachedAcPower = 0;
+  // Лишається 0x03 = read response
+  uint8_t dataLength = frame.byteCount;
+
+  if (matched && txn.kind == ModbusTxnKind::POWER_SAMPLE) {
+    handlePowerSample(frame, now);
+    return;
   }
-  
-  // 7. DC Output Power (регістр 0x0027, offset 61-62)
-  if (length >= 63) {
-    cachedDcPower = (data[61] << 8) | data[62];
-    Serial.printf("[Bluetti] DC вихідна потужність: %dW\n", cachedDcPower);
-  } else {
-    cachedDcPower = 0;
+
+  // Блок статусу самоописний (80 байт даних), тож запізнілу відповідь після
+  // таймауту ще можна використати; решту відповідей без запиту ігноруємо
+  bool statusBlock = matched ? txn.kind == ModbusTxnKind::STATUS_POLL
+                             : dataLength == getProfile().statusCount * 2;
+  if (!matched && !statusBlock) {
+    Serial.printf("[Bluetti] ⚠️  Ignoring unexpected 0x03 response: %d data bytes (no pending request)\n", dataLength);
+    return;
+  }
+
+  // Відповідь на читання регістрів - адресу та кількість знає транзакція,
+  // весь діапазон декодуємо за один прохід
+  if (!statusBlock) {
+    Serial.printf("[Bluetti] Register response for 0x%04X..0x%04X (%u regs)\n",
+                  txn.address, txn.address + txn.value - 1, txn.value);
+    for (uint16_t i = 0; i < txn.value; i++) {
+      uint16_t reg = txn.address + i;
+      uint16_t valueRaw = frame.registerAt(i);
+      capabilities.markRead(reg, RegisterSupport::SUPPORTED);
+      registerCache.store(reg, valueRaw, registerTtlMs(getProfile(), reg), now);
+      if (!applyFeatureRegister(reg, valueRaw) && txn.value == 1) {
+        // Невідомий регістр - виводимо для дебагу (проміжні регістри діапазону мовчки пропускаємо)
+        Serial.printf("[Bluetti] 📊 Single register 0x%04X response: %d (0x%04X)\n",
+                      reg, valueRaw, valueRaw);
+      }
+    }
+
+    // Транзакцію завершено вище - готові до наступного запиту
+    return;
   }
 
-  // 8. Max DC Limit (регістр 0x002B, offset 69-70)
-  // Регістр 0x002B = offset 3 + (0x2B - 0x0A) × 2 = 3 + 33 × 2 = 69
-  if (length >= 71) {
-    status->maxDcLimit = (data[69] << 8) | data[70];
-    Serial.printf("[Bluetti] Макс. DC ліміт: %dW\n", status->maxDcLimit);
+  // Сторінка блоку статусу: декодуємо, лише коли зібрано весь блок
+  const DeviceProfile *active = &getProfile();
+  ModbusFrameView block = frame;
+  if (matched && txn.value < active->statusCount) {
+    uint16_t offset = txn.address - active->statusBase;
+    if (offset == 0) {
+      statusPages.begin(active->statusCount);
+      statusCycleStartedAt = txn.sentAt;
+    }
+    if (!statusPages.accept(offset, frame.payload, frame.registerCount())) {
+      Serial.printf("[Bluetti] ⚠️  Status page 0x%04X out of sequence - waiting for next poll\n", txn.address);
+      return;
+    }
+    if (!statusPages.complete()) {
+      return; // Наступна сторінка - одразу, без паузи
+    }
+    block.payload = statusPages.payload();
+    block.byteCount = statusPages.registerCount() * 2;
   }
 
-  // 9. AC Output State (регістр 0x0030, offset 79-80)
-  // ВАЖЛИВО: 0x0001 = ON, 0x0000 = OFF
-  if (length >= 81) {
-    uint16_t acStateReg = (data[79] << 8) | data[80];
-    cachedAcState = (acStateReg == 1);
-    Serial.printf("[Bluetti] AC вихід: %s (reg=0x%04X)\n", cachedAcState ? "УВІМКНЕНО" : "ВИМКНЕНО", acStateReg);
+  // Відповідь на запит статусу - даємо Bluetti паузу перед наступним запитом
+  if (matched) {
+    transactions.holdOff(now + POST_STATUS_QUIET_MS);
+    bool paged = block.payload != frame.payload;
+    recordPollRtt(paged ? now - statusCycleStartedAt : transactions.getLastLatency(),
+                  paged || reassembler.getLastFrameFragments() > 1);
   } else {
-    cachedAcState = (cachedAcPower > 0);
+    Serial.println("[Bluetti] Late status response (after timeout) - using data anyway");
   }
-  
-  // 10. DC Output State (регістр 0x0031, offset 81-82)
-  // ВАЖЛИВО: 0x0001 = ON, 0x0000 = OFF
-  if (length >= 83) {
-    uint16_t dcStateReg = (data[81] << 8) | data[82];
-    cachedDcState = (dcStateReg == 1);
-    Serial.printf("[Bluetti] DC вихід: %s (reg=0x%04X)\n", cachedDcState ? "УВІМКНЕНО" : "ВИМКНЕНО", dcStateReg);
-  } else {
-    cachedDcState = (cachedDcPower > 0);
+
+  // MODBUS блок статусу профілю (EB3A: від 0x000A, 40 registers), response starts at offset 3
+  // Зберігаємо всі регістри для аналізу
+  for (uint16_t i = 0; i < STATUS_REGISTER_COUNT && i < block.registerCount(); i++) {
+    status->registers[i] = block.registerAt(i);
+  }
+
+  // Декодування за таблицею профілю: один прохід по кадру.
+  // Температура невідома (0), якщо 0x0028 поза діапазоном
+  status->temperature = 0;
+  uint32_t decoded = decodeRegisterBlock(active->statusMap, active->statusMapSize, active->statusBase,
+                                         block.payload, block.registerCount(), *status);
+
+  // Назва моделі - у самому блоці статусу: перший кадр обирає профіль, і
+  // той самий кадр декодується ще раз уже його таблицею
+  const DeviceProfile *detected = findDeviceProfile(status->modelName);
+  if (detected && detected != active) {
+    Serial.printf("[Bluetti] Model %s detected - using %s register profile\n", status->modelName,
+                  detected->displayName);
+    active = detected;
+    profile.store(active, std::memory_order_release);
+    status->temperature = 0;
+    status->batteryVoltage = 0;
+    status->maxDcLimit = 0;
+    decoded = decodeRegisterBlock(active->statusMap, active->statusMapSize, active->statusBase,
+                                  block.payload, block.registerCount(), *status);
+  } else if (!detected && status->modelName[0] != '\0' && active == &defaultDeviceProfile()) {
+    Serial.printf("[Bluetti] ⚠️  Unknown model %s - keeping %s register profile\n", status->modelName,
+                  active->displayName);
+  }
+  if (!(decoded & statusFieldBit(StatusField::BATTERY_LEVEL))) {
+    // Жоден регістр SoC не пройшов перевірку - як і раніше, показуємо 100%
+    status->batteryLevel = 100;
+    status->batteryRaw = 1000;
+    Serial.println("[Bluetti] ⚠️  Battery not detected, using default 100%");
   }
-  
-  // Виводимо всі регістри для аналізу
-  Serial.println("\n[Bluetti] --- Всі 40 регістрів ---");
-  for (int i = 0; i < 40; i++) {
-    uint16_t regAddr = 0x000A + i;
-    uint16_t regVal = status->registers[i];
-    Serial.printf("[Bluetti] Reg 0x%04X [%2d]: %5d (0x%04X)", regAddr, i, regVal, regVal);
-    
-    // Додаємо інтерпретацію для відомих регістрів
-    if (regAddr == 0x000A || regAddr == 0x000B) {
-      Serial.print(" [Модель]");
-    } else if (regAddr == 0x0010) {
-      Serial.print(" [Battery SOC ×10]");
-    } else if (regAddr == 0x0013) {
-      Serial.print(" [Напруга]");
-    } else if (regAddr == 0x0017) {
-      Serial.print(" [Температура?]");
-    } else if (regAddr == 0x0024) {
-      Serial.print(" [DC Input]");
-    } else if (regAddr == 0x0025) {
-      Serial.print(" [AC Input]");
-    } else if (regAddr == 0x0026) {
-      Serial.print(" [AC Output Power]");
-    } else if (regAddr == 0x0027) {
-      Serial.print(" [DC Output Power]");
-    } else if (regAddr == 0x002B) {
-      Serial.print(" [Max DC Limit]");
-    } else if (regAddr == 0x002D) {
-      Serial.print(" [DC State?]");
-    } else if (regAddr == 0x0030) {
-      Serial.print(" [AC State]");
-    } else if (regAddr == 0x0031) {
-      Serial.print(" [DC State]");
-    }
-    Serial.println();
+  for (uint16_t i = 0; i < STATUS_REGISTER_COUNT && i < block.registerCount(); i++) {
+    registerCache.store(active->statusBase + i, status->registers[i], registerTtlMs(*active, active->statusBase + i), now);
+  }
+  capabilities.select(status->modelName); // Можливості регістрів - окремо для кожної моделі
+
+  PollSample sample = {status->batteryLevel, status->acPower, status->dcPower,
+                       status->dcInputPower + status->acInputPower};
+  if (poller.observe(sample, now)) {
+    Serial.printf("[Bluetti] ⚡ Load transient - polling every %lu ms\n", poller.interval());
   }
+  diagnostics.pollIntervalMs = poller.interval();
+  diagnostics.pollAverageGapMs = poller.getAverageGapMs();
+  diagnostics.pollTransients = poller.getTransients();
+
+  cachedBattery = status->batteryLevel;
+  cachedAcPower = status->acPower;
+  cachedDcPower = status->dcPower;
+  cachedInputPower = status->dcInputPower + status->acInputPower;
+  cachedAcState = status->acOutputState;
+  cachedDcState = status->dcOutputState;
 
   // Оновлюємо статус
   status->bluettiConnected = true;
-  status->batteryLevel = cachedBattery;
-  status->acPower = cachedAcPower;
-  status->dcPower = cachedDcPower;
   status->inputPower = cachedInputPower;
-  status->acOutputState = cachedAcState;
-  status->dcOutputState = cachedDcState;
   status->lastBluettiUpdate = millis();
+  if (awaitingFirstData) {
+    recordFirstData(now);
+  }
   
-  Serial.println("\n[Bluetti] === ПІДСУМОК ===");
-  Serial.printf("[Bluetti] Батарея: %d%%\n", cachedBattery);
-  Serial.printf("[Bluetti] Напруга: %d (%.1fV)\n", status->batteryVoltage, status->batteryVoltage / 10.0f);
-  Serial.printf("[Bluetti] Вхід: %dW (DC: %dW, AC: %dW)\n", cachedInputPower, status->dcInputPower, status->acInputPower);
-  Serial.printf("[Bluetti] AC вихід: %s, %dW\n", cachedAcState ? "УВІМКНЕНО" : "ВИМКНЕНО", cachedAcPower);
-  Serial.printf("[Bluetti] DC вихід: %s, %dW\n", cachedDcState ? "УВІМКНЕНО" : "ВИМКНЕНО", cachedDcPower);
-  Serial.printf("[Bluetti] Макс. DC ліміт: %dW\n", status->maxDcLimit);
-  Serial.println("[Bluetti] ========================================\n");
-}
-
-void BluettiDevice::notificationThunk(
-    NimBLERemoteCharacteristic *characteristic, uint8_t *data,
-    size_t length, bool isNotify) {
-  // ВАЖЛИВО: Використовуємо Serial.print замість Serial.println для швидшої обробки
-  // Це може допомогти, якщо callback викликається, але дані втрачаються
-  // ДОДАТКОВО: Використовуємо Serial.flush() для гарантії виводу
-  Serial.flush();
-  Serial.print("\n\n\n[Bluetti] ========================================\n");
-  Serial.print("[Bluetti] *** CALLBACK CALLED ***\n");
-  Serial.printf("[Bluetti] characteristic=%p\n", characteristic);
-  Serial.printf("[Bluetti] length=%d, isNotify=%d\n", length, isNotify);
-  Serial.printf("[Bluetti] instance=%p\n", instance);
-  Serial.flush();
-  
-  if (!instance) {
-    Serial.print("[Bluetti] ERROR: Instance is NULL!\n");
-    Serial.print("[Bluetti] This should never happen!\n");
-    Serial.flush();
+  Serial.printf("[Bluetti] %s: %d%% (raw %d), %.1fV, %.1f°C, in %dW (DC %dW, AC %dW), "
+                "AC %s %dW, DC %s %dW, max DC %dW\n",
+                status->modelName, cachedBattery, status->batteryRaw,
+                status->batteryVoltage / 10.0f, status->temperature / 10.0f,
+                cachedInputPower, status->dcInputPower, status->acInputPower,
+                cachedAcState ? "ON" : "OFF", cachedAcPower,
+                cachedDcState ? "ON" : "OFF", cachedDcPower, status->maxDcLimit);
+}
+
+void BluettiDevice::acceptNotification(const uint8_t *data, size_t length) {
+  // Працює на NimBLE host task: лише копіюємо фрагмент у чергу, розбір та
+  // логування - у BLE worker (processFragments)
+  BleFragment *slot = fragments.reserve();
+  if (!slot) {
+    fragmentsDropped.fetch_add(1, std::memory_order_relaxed);
     return;
   }
-  
-  Serial.print("[Bluetti] Instance found, calling handleNotification...\n");
-  Serial.flush();
-  instance->handleNotification(data, length);
-  Serial.print("[Bluetti] handleNotification completed\n");
-  Serial.print("[Bluetti] ========================================\n");
-  Serial.flush();
+  if (length > BLE_FRAGMENT_MAX) {
+    length = BLE_FRAGMENT_MAX;
+  }
+  memcpy(slot->data, data, length);
+  slot->length = length;
+  slot->receivedAt = millis();
+  fragments.commit();
+}
+
+void BluettiDevice::acceptFastNotification(uint16_t attrHandle, os_mbuf *om) {
+  // NimBLE host task. Без discovery NimBLEClient не знає характеристики і
+  // відкидає notification - на швидкому шляху забираємо її тут за handle
+  if (!fastPathActive.load(std::memory_order_acquire) || attrHandle != fastNotifyHandle) {
+    return;
+  }
+
+  BleFragment *slot = fragments.reserve();
+  if (!slot) {
+    fragmentsDropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  uint16_t length = 0;
+  ble_hs_mbuf_to_flat(om, slot->data, sizeof(slot->data), &length);
+  if (length == 0) {
+    return;
+  }
+  slot->length = length;
+  slot->receivedAt = millis();
+  fragments.commit();
+}
+
+void BluettiDevice::refreshLinkMtu() {
+  if (!client || !client->isConnected()) {
+    return;
+  }
+  uint16_t mtu = client->getMTU();
+  if (mtu < BLE_DEFAULT_MTU) {
+    mtu = BLE_DEFAULT_MTU;
+  }
+  bool changed = (mtu != diagnostics.mtu) || diagnostics.maxRegistersPerNotification == 0;
+  diagnostics.mtu = mtu;
+
+  // Payload notification = MTU - 3 (ATT header); кадр 0x03 = 5 байт + 2 на регістр
+  diagnostics.maxRegistersPerNotification = (mtu - 3 - 5) / 2;
+  diagnostics.singleNotificationMode =
+      diagnostics.maxRegistersPerNotification >= STATUS_REGISTER_COUNT;
+
+  if (changed) {
+    if (diagnostics.singleNotificationMode) {
+      Serial.printf("[Bluetti] ATT MTU %u: full status (%u regs) fits in one notification\n",
+                    mtu, STATUS_REGISTER_COUNT);
+    } else {
+      // Пристрій не погодився на більший MTU - відповідь приходить фрагментами
+      Serial.printf("[Bluetti] ATT MTU %u: up to %u regs per notification, using multi-fragment mode\n",
+                    mtu, diagnostics.maxRegistersPerNotification);
+    }
+  }
+}
+
+void BluettiDevice::recordPollRtt(unsigned long rttMs, bool fragmented) {
+  diagnostics.pollRttMs = rttMs;
+  // Експоненційне згладжування (1/8), перший вимір береться як є
+  unsigned long &avg = fragmented ? diagnostics.pollRttFragmentedMs : diagnostics.pollRttSingleMs;
+  avg = (avg == 0) ? rttMs : (avg * 7 + rttMs) / 8;
+  Serial.printf("[Bluetti] Status RTT: %lums (%s, MTU %u)\n", rttMs,
+                fragmented ? "fragmented" : "single notification", diagnostics.mtu);
 }
 
-void BluettiDevice::setUpdateInterval(unsigned long intervalMs) {
-  updateInterval = intervalMs;
-  Serial.printf("[Bluetti] Update interval set to %lu ms (%lu seconds)\n", intervalMs, intervalMs/1000);
+void BluettiDevice::recordWriteAck(unsigned long ackMs) {
+  // Від постановки команди в чергу до echo - включає очікування опитування в польоті
+  diagnostics.writeAcks++;
+  diagnostics.writeAckMs = ackMs;
+  diagnostics.writeAckAvgMs = (diagnostics.writeAckAvgMs == 0)
+                                  ? ackMs
+                                  : (diagnostics.writeAckAvgMs * 7 + ackMs) / 8;
+  if (ackMs > diagnostics.writeAckMaxMs) {
+    diagnostics.writeAckMaxMs = ackMs;
+  }
 }
 
-unsigned long BluettiDevice::getUpdateInterval() const {
-  return updateInterval;
+void BluettiDevice::setPollBounds(unsigned long minMs, unsigned long maxMs) {
+  // Межі остаточно обмежує poller у worker; тут лише публікуємо значення
+  pollMinMs.store(minMs, std::memory_order_relaxed);
+  pollMaxMs.store(maxMs, std::memory_order_relaxed);
+  Serial.printf("[Bluetti] Poll interval bounds set to %lu..%lu ms\n", minMs, maxMs);
 }
@@ -0,0 +1,238 @@
+#include "bluetti_manager.h"
+#include <cstring>
+
+BluettiManager* BluettiManager::instance = nullptr;
+
+// Фонове пасивне сканування: вікно 100 мс кожну секунду (10% ефіру, WiFi coexistence)
+static constexpr uint16_t BACKGROUND_SCAN_INTERVAL_MS = 1000;
+static constexpr uint16_t BACKGROUND_SCAN_WINDOW_MS = 100;
+
+BluettiManager::BluettiManager(SystemStatus *primaryStatus, SeqLock<SystemStatus> *primarySnapshot)
+    : primarySnapshot(primarySnapshot) {
+  devices[0].attach(0, primaryStatus, &advertisements);
+  for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+    devices[i].attach(i, &statuses[i - 1], &advertisements);
+  }
+  instance = this;
+}
+
+bool BluettiManager::begin() {
+  Serial.println("[Bluetti] Initializing BLE...");
+  NimBLEDevice::init("ESP32-BLUETTI");
+
+  // Встановлюємо TX power для BLE
+  // ESP_PWR_LVL_P3 = +3dBm (помірний рівень, добрий баланс між дальністю та енергією)
+  // Для WiFi coexistence краще використовувати помірний рівень
+  NimBLEDevice::setPower(ESP_PWR_LVL_P3);
+  Serial.println("[Bluetti] BLE TX Power set to +3dBm (balanced for WiFi coexistence)");
+
+  // Більший MTU дозволяє отримати всі 40 регістрів однією notification.
+  // NimBLE обмінюється MTU одразу після підключення, EB3A відповідає своїм максимумом
+  NimBLEDevice::setMTU(BLUETTI_PREFERRED_MTU);
+  Serial.printf("[Bluetti] Preferred ATT MTU: %u\n", BLUETTI_PREFERRED_MTU);
+
+  // Notifications для кешованих handles (швидке перепідключення без discovery)
+  NimBLEDevice::setCustomGapHandler(gapEventThunk);
+  // Advertisement Bluetti з будь-якого сканування (фонового чи активного) - у кеш
+  NimBLEDevice::getScan()->setAdvertisedDeviceCallbacks(&advertisementListener, true);
+
+  // Не видаляємо bonding - EB3A потребує збереження bonding для стабільного з'єднання
+  // NimBLEDevice::deleteAllBonds();
+  // delay(100);
+  Serial.println("[Bluetti] Keeping existing bonds for EB3A compatibility");
+
+  Serial.printf("[Bluetti] BLE initialized with WiFi coexistence support, up to %u devices\n",
+                (unsigned)BLUETTI_MAX_DEVICES);
+  Serial.println("[Bluetti] ⚠️  IMPORTANT: Bluetti allows only ONE BLE connection at a time!");
+  Serial.println("[Bluetti] ⚠️  Make sure:");
+  Serial.println("[Bluetti]     1. 'Bluetti to MQTT' addon is STOPPED in Home Assistant");
+  Serial.println("[Bluetti]     2. No mobile apps are connected to Bluetti");
+  Serial.println("[Bluetti]     3. Bluetti was RESTARTED after disabling addon");
+  Serial.println("[Bluetti]     4. Wait 30 seconds after restart before connecting");
+  return true;
+}
+
+bool BluettiManager::requestTarget(size_t index, const char *macAddress) {
+  if (index >= BLUETTI_MAX_DEVICES) {
+    return false;
+  }
+  ManagerCommand command = {ManagerCommandType::TARGET, static_cast<uint8_t>(index), false, {}};
+  if (macAddress) {
+    strncpy(command.mac, macAddress, sizeof(command.mac) - 1);
+  }
+  return postCommand(command);
+}
+
+bool BluettiManager::requestEnabled(bool enabled) {
+  ManagerCommand command = {ManagerCommandType::ENABLED, 0, enabled, {}};
+  return postCommand(command);
+}
+
+bool BluettiManager::postCommand(const ManagerCommand &command) {
+  if (!commands.push(command)) {
+    Serial.println("[Bluetti] ⚠️  Manager command queue full, target change dropped");
+    return false;
+  }
+  return true;
+}
+
+void BluettiManager::runCommands() {
+  ManagerCommand command;
+  bool changed = false;
+  while (commands.pop(command)) {
+    switch (command.type) {
+      case ManagerCommandType::TARGET:
+        memcpy(targets[command.index], command.mac, sizeof(targets[command.index]));
+        break;
+      case ManagerCommandType::ENABLED:
+        linkEnabled = command.enabled;
+        break;
+    }
+    changed = true;
+  }
+  if (!changed) {
+    return;
+  }
+  for (size_t i = 0; i < BLUETTI_MAX_DEVICES; i++) {
+    setTarget(i, linkEnabled ? targets[i] : nullptr);
+  }
+}
+
+void BluettiManager::setTarget(size_t index, const char *macAddress) {
+  BluettiDevice &device = devices[index];
+  const char *current = device.getPeerMac();
+  bool clearing = !macAddress || macAddress[0] == '\0';
+  if (clearing ? current[0] == '\0' : strcasecmp(current, macAddress) == 0) {
+    return;
+  }
+  // Host task читає адреси цілей у callback будь-якого сканування: і
+  // фонового, і активного з beginAttempt власника налаштування. Зупиняємо
+  // обидва до запису, активне потім поновлюємо
+  stopBackgroundScan();
+  NimBLEScan *scan = NimBLEDevice::getScan();
+  bool interrupted = scan->isScanning();
+  if (interrupted) {
+    scan->stop();
+  }
+  device.setTarget(macAddress);
+  int owner = scheduler.setupOwner();
+  if (interrupted && owner >= 0) {
+    devices[owner].resumeScan(); // Якщо власник - цей пристрій, setTarget вже повернув його в IDLE
+  }
+}
+
+void BluettiManager::loop() {
+  unsigned long now = millis();
+  runCommands();
+
+  int grant = scheduler.grantSetup(devices, now);
+  if (grant >= 0) {
+    stopBackgroundScan();
+    setupGrants.fetch_add(1, std::memory_order_relaxed);
+  }
+  scheduler.run(devices, grant);
+
+  // Поки хтось без з'єднання, слухаємо advertisement - наступна спроба
+  // обійдеться без сканування
+  bool waiting = false;
+  for (const BluettiDevice &device : devices) {
+    waiting = waiting || device.idleWithTarget();
+  }
+  if (!waiting) {
+    stopBackgroundScan();
+  } else if (scheduler.setupOwner() < 0) {
+    startBackgroundScan();
+  }
+}
+
+void BluettiManager::drainRecords() {
+  for (BluettiDevice &device : devices) {
+    device.drainRecords();
+  }
+  for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+    snapshots[i - 1].write(statuses[i - 1]);
+  }
+}
+
+void BluettiManager::startBackgroundScan() {
+  NimBLEScan *scan = NimBLEDevice::getScan();
+  if (scan->isScanning()) {
+    return;
+  }
+  // Пасивне: без scan request; callback (з дублікатами) оновлює час та RSSI
+  scan->setActiveScan(false);
+  scan->setInterval(BACKGROUND_SCAN_INTERVAL_MS);
+  scan->setWindow(BACKGROUND_SCAN_WINDOW_MS);
+  scan->setMaxResults(0); // Лише callback - результати не накопичуються в пам'яті
+  backgroundScanning = scan->start(0, nullptr, false);
+  if (backgroundScanning) {
+    Serial.println("[Bluetti] Background passive scan started");
+  }
+}
+
+void BluettiManager::stopBackgroundScan() {
+  if (!backgroundScanning) {
+    return;
+  }
+  NimBLEDevice::getScan()->stop();
+  backgroundScanning = false;
+}
+
+BluettiDevice *BluettiManager::deviceForConnection(uint16_t connHandle) {
+  if (connHandle == BLE_HS_CONN_HANDLE_NONE) {
+    return nullptr;
+  }
+  for (BluettiDevice &device : devices) {
+    if (device.getConnHandle() == connHandle) {
+      return &device;
+    }
+  }
+  return nullptr;
+}
+
+void BluettiManager::AdvertisementListener::onResult(NimBLEAdvertisedDevice *device) {
+  // NimBLE host task: лише фільтр і запис у таблицю
+  static const NimBLEUUID serviceUuid(BLUETTI_SERVICE_UUID);
+  if (!instance) {
+    return;
+  }
+  NimBLEAddress address = device->getAddress();
+  const uint8_t *native = address.getNative();
+  bool bluettiService = device->isAdvertisingService(serviceUuid);
+  bool target = false;
+  for (const BluettiDevice &candidate : instance->devices) {
+    target = target || candidate.matchesTarget(native);
+  }
+  if (!bluettiService && !target) {
+    return;
+  }
+  instance->advertisements.record(native, device->getRSSI(), bluettiService, millis());
+}
+
+void BluettiManager::notificationThunk(
+    NimBLERemoteCharacteristic *characteristic, uint8_t *data,
+    size_t length, bool isNotify) {
+  // NimBLE host task: пристрій - за з'єднанням, якому належить характеристика
+  if (!instance) {
+    Serial.print("[Bluetti] ERROR: Instance is NULL!\n");
+    return;
+  }
+  uint16_t connHandle = characteristic->getRemoteService()->getClient()->getConnId();
+  BluettiDevice *device = instance->deviceForConnection(connHandle);
+  if (device) {
+    device->acceptNotification(data, length);
+  }
+}
+
+int BluettiManager::gapEventThunk(ble_gap_event *event, void *arg) {
+  // NimBLE host task. Швидкий шлях (кешовані handles) - notifications, яких
+  // NimBLEClient не знає; пристрій обираємо за connection handle
+  if (!instance || event->type != BLE_GAP_EVENT_NOTIFY_RX) {
+    return 0;
+  }
+  BluettiDevice *device = instance->deviceForConnection(event->notify_rx.conn_handle);
+  if (device) {
+    device->acceptFastNotification(event->notify_rx.attr_handle, event->notify_rx.om);
+  }
+  return 0;
+}
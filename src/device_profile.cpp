@@ -0,0 +1,139 @@
+#include "device_profile.h"
+#include "core_registers.h"
+#include "eb3a_registers.h"
+#include <cstring>
+
+template <typename T, size_t N>
+constexpr size_t countOf(const T (&)[N]) {
+  return N;
+}
+
+static constexpr uint32_t CORE_ENTITIES =
+    entityBit(ProfileEntity::BATTERY) | entityBit(ProfileEntity::AC_POWER) |
+    entityBit(ProfileEntity::DC_POWER) | entityBit(ProfileEntity::INPUT_POWER) |
+    entityBit(ProfileEntity::AC_OUTPUT) | entityBit(ProfileEntity::DC_OUTPUT);
+
+static constexpr uint32_t EB3A_ENTITIES =
+    CORE_ENTITIES | entityBit(ProfileEntity::VOLTAGE) | entityBit(ProfileEntity::CHARGING_SPEED) |
+    entityBit(ProfileEntity::ECO_MODE) | entityBit(ProfileEntity::POWER_LIFTING) |
+    entityBit(ProfileEntity::LED_MODE) | entityBit(ProfileEntity::LED_SWITCH) |
+    entityBit(ProfileEntity::ECO_SHUTDOWN) | entityBit(ProfileEntity::POWER_OFF);
+
+static constexpr DeviceProfile EB3A_PROFILE = {
+    "EB3A", "EB3A", "eb3a", "Bluetti EB3A",
+    EB3A_STATUS_BASE, EB3A_STATUS_COUNT, EB3A_STATUS_REGISTERS, countOf(EB3A_STATUS_REGISTERS),
+    EB3A_POWER_BASE, EB3A_POWER_COUNT,
+    EB3A_FEATURE_REGISTERS, countOf(EB3A_FEATURE_REGISTERS),
+    EB3A_CONTROLS, countOf(EB3A_CONTROLS),
+    EB3A_FIELD_REGISTERS, countOf(EB3A_FIELD_REGISTERS),
+    EB3A_ENTITIES,
+};
+
+// AC200/EB70/AC180 поки відрізняються лише ідентичністю: ядро спільне,
+// додаткових функцій у таблицях немає
+static constexpr DeviceProfile AC200_PROFILE = {
+    "AC20", "AC200", "ac200", "Bluetti AC200",
+    CORE_STATUS_BASE, CORE_STATUS_COUNT, CORE_STATUS_REGISTERS, countOf(CORE_STATUS_REGISTERS),
+    CORE_POWER_BASE, CORE_POWER_COUNT,
+    nullptr, 0,
+    CORE_CONTROLS, countOf(CORE_CONTROLS),
+    CORE_FIELD_REGISTERS, countOf(CORE_FIELD_REGISTERS),
+    CORE_ENTITIES,
+};
+
+static constexpr DeviceProfile EB70_PROFILE = {
+    "EB70", "EB70", "eb70", "Bluetti EB70",
+    CORE_STATUS_BASE, CORE_STATUS_COUNT, CORE_STATUS_REGISTERS, countOf(CORE_STATUS_REGISTERS),
+    CORE_POWER_BASE, CORE_POWER_COUNT,
+    nullptr, 0,
+    CORE_CONTROLS, countOf(CORE_CONTROLS),
+    CORE_FIELD_REGISTERS, countOf(CORE_FIELD_REGISTERS),
+    CORE_ENTITIES,
+};
+
+static constexpr DeviceProfile AC180_PROFILE = {
+    "AC18", "AC180", "ac180", "Bluetti AC180",
+    CORE_STATUS_BASE, CORE_STATUS_COUNT, CORE_STATUS_REGISTERS, countOf(CORE_STATUS_REGISTERS),
+    CORE_POWER_BASE, CORE_POWER_COUNT,
+    nullptr, 0,
+    CORE_CONTROLS, countOf(CORE_CONTROLS),
+    CORE_FIELD_REGISTERS, countOf(CORE_FIELD_REGISTERS),
+    CORE_ENTITIES,
+};
+
+static constexpr const DeviceProfile *DEVICE_PROFILES[] = {
+    &EB3A_PROFILE,
+    &AC200_PROFILE,
+    &EB70_PROFILE,
+    &AC180_PROFILE,
+};
+
+// Обмеження, на які спирається BluettiDevice (буфер регістрів, план опитування)
+template <size_t N>
+constexpr bool profilesFit(const DeviceProfile *const (&profiles)[N]) {
+  for (size_t i = 0; i < N; i++) {
+    const DeviceProfile &profile = *profiles[i];
+    if (profile.statusCount > sizeof(SystemStatus::registers) / sizeof(SystemStatus::registers[0]) ||
+        profile.featureCount > PROFILE_MAX_FEATURE_REGISTERS || profile.fieldCount > PROFILE_MAX_FIELD_REGISTERS ||
+        profile.powerBase < profile.statusBase ||
+        profile.powerBase + profile.powerCount > profile.statusBase + profile.statusCount) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static_assert(profilesFit(DEVICE_PROFILES),
+              "Every profile must fit the status buffer and keep power registers inside its status block");
+
+uint16_t DeviceProfile::controlAddress(ProfileControl control) const {
+  for (size_t i = 0; i < controlCount; i++) {
+    if (controls[i].control == control) {
+      return controls[i].address;
+    }
+  }
+  return 0;
+}
+
+uint16_t DeviceProfile::legacyAddress(uint16_t address) const {
+  for (size_t i = 0; i < controlCount; i++) {
+    if (controls[i].address == address) {
+      return controls[i].legacyAddress;
+    }
+  }
+  return 0;
+}
+
+bool DeviceProfile::controlAt(uint16_t address, ProfileControl &out) const {
+  for (size_t i = 0; i < controlCount; i++) {
+    if (controls[i].address == address ||
+        (controls[i].legacyAddress != 0 && controls[i].legacyAddress == address)) {
+      out = controls[i].control;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool DeviceProfile::isFeatureRegister(uint16_t address) const {
+  for (size_t i = 0; i < featureCount; i++) {
+    if (featureRegisters[i] == address) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const DeviceProfile *findDeviceProfile(const char *modelName) {
+  if (!modelName || modelName[0] == '\0') {
+    return nullptr;
+  }
+  for (const DeviceProfile *profile : DEVICE_PROFILES) {
+    if (strncmp(modelName, profile->modelPrefix, strlen(profile->modelPrefix)) == 0) {
+      return profile;
+    }
+  }
+  return nullptr;
+}
+
+const DeviceProfile &defaultDeviceProfile() { return EB3A_PROFILE; }
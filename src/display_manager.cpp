@@ -11,9 +11,11 @@ constexpr uint16_t WARN_COLOR = TFT_YELLOW;
 constexpr uint16_t ERROR_COLOR = TFT_RED;
 }
 
-DisplayManager::DisplayManager(BluettiDevice* device, SystemStatus* sharedStatus)
+DisplayManager::DisplayManager(BluettiDevice* device, SystemStatus* sharedStatus,
+                               SeqLock<SystemStatus>* statusSnapshot)
     : bluetti(device),
       status(sharedStatus),
+      snapshot(statusSnapshot),
       currentScreen(MenuScreen::STATUS),
       displayOn(true),
       button1Latched(false),
@@ -273,6 +275,8 @@ void DisplayManager::processButton(uint8_t pin, bool& latched, unsigned long& la
 }
 
 void DisplayManager::render() {
+    // Малюємо з узгодженої копії - екран не змішує поля двох опитувань
+    snapshot->read(view);
     switch (currentScreen) {
         case MenuScreen::STATUS:
             drawStatusScreen();
@@ -298,28 +302,28 @@ void DisplayManager::drawStatusScreen() {
         tft.fillScreen(BG_COLOR);
         lastRenderedScreen = currentScreen;
     }
-    tft.setTextColor(TITLE_COLOR);
+    tft.setTextColor(TITLE_COLOR, BG_COLOR); // З фоном - назва моделі може змінитись після підключення
     tft.setTextSize(2);
     tft.setCursor(20, 6);
-    tft.println("BLUETTI EB3A");
+    tft.printf("BLUETTI %-5s\n", bluetti->getProfile().model);
 
     tft.setTextSize(1);
     tft.setCursor(10, 40);
     tft.setTextColor(TEXT_COLOR);
-    if (!status->bluettiEnabled) {
+    if (!view.bluettiEnabled) {
         tft.setTextColor(WARN_COLOR);
         tft.println("Bluetti disabled");
-    } else if (!status->bluettiConnected) {
+    } else if (!view.bluettiConnected) {
         tft.setTextColor(ERROR_COLOR);
         tft.println("No BLE connection");
     } else {
-        tft.printf("Battery: %u%%\n", status->batteryLevel);
-        tft.printf("AC: %s %dW\n", status->acOutputState ? "ON " : "OFF", status->acPower);
-        tft.printf("DC: %s %dW\n", status->dcOutputState ? "ON " : "OFF", status->dcPower);
-        tft.printf("Input: %dW\n", status->inputPower);
+        tft.printf("Battery: %u%%\n", view.batteryLevel);
+        tft.printf("AC: %s %dW\n", view.acOutputState ? "ON " : "OFF", view.acPower);
+        tft.printf("DC: %s %dW\n", view.dcOutputState ? "ON " : "OFF", view.dcPower);
+        tft.printf("Input: %dW\n", view.inputPower);
     }
 
-    drawBatteryIcon(170, 25, status->batteryLevel);
+    drawBatteryIcon(170, 25, view.batteryLevel);
     drawFooter("Status");
 }
 
@@ -335,17 +339,17 @@ void DisplayManager::drawWiFiScreen() {
     tft.println("WiFi");
 
     tft.setTextSize(1);
-    tft.setTextColor(status->wifiConnected ? TEXT_COLOR : ERROR_COLOR);
+    tft.setTextColor(view.wifiConnected ? TEXT_COLOR : ERROR_COLOR);
     tft.setCursor(10, 40);
-    tft.printf("Status: %s\n", status->wifiConnected ? "Connected" : "Lost");
+    tft.printf("Status: %s\n", view.wifiConnected ? "Connected" : "Lost");
     tft.setCursor(10, 55);
     tft.setTextColor(TEXT_COLOR);
-    tft.printf("IP: %s\n", status->wifiConnected ? status->wifiIp.toString().c_str() : "0.0.0.0");
+    tft.printf("IP: %s\n", view.wifiConnected ? view.wifiIp.toString().c_str() : "0.0.0.0");
     tft.setCursor(10, 70);
-    tft.printf("RSSI: %d dBm\n", status->wifiConnected ? WiFi.RSSI() : 0);
+    tft.printf("RSSI: %d dBm\n", view.wifiConnected ? WiFi.RSSI() : 0);
     tft.setCursor(10, 85);
-    tft.setTextColor(status->mqttConnected ? TEXT_COLOR : WARN_COLOR);
-    tft.printf("MQTT: %s\n", status->mqttConnected ? "Connected" : "Waiting");
+    tft.setTextColor(view.mqttConnected ? TEXT_COLOR : WARN_COLOR);
+    tft.printf("MQTT: %s\n", view.mqttConnected ? "Connected" : "Waiting");
 
     drawFooter("WiFi");
 }
@@ -365,12 +369,12 @@ void DisplayManager::drawEsp32Screen() {
     tft.setCursor(10, 40);
     tft.setTextColor(TEXT_COLOR);
     // Напруга акумулятора (якщо підключений) або USB живлення
-    if (status->esp32UsbPowered) {
+    if (view.esp32UsbPowered) {
         // USB підключений - показуємо останню відому напругу батареї
-        if (status->esp32BatteryVoltage > 0.1f) {
-            tft.printf("Battery: %.2f V\n", status->esp32BatteryVoltage);
+        if (view.esp32BatteryVoltage > 0.1f) {
+            tft.printf("Battery: %.2f V\n", view.esp32BatteryVoltage);
             tft.setCursor(10, 50);
-            tft.printf("Percent: %u%%\n", status->esp32BatteryPercent);
+            tft.printf("Percent: %u%%\n", view.esp32BatteryPercent);
             tft.setCursor(10, 60);
             tft.setTextColor(0x07E0); // Зелений колір для USB
             tft.println("USB Charging");
@@ -382,20 +386,20 @@ void DisplayManager::drawEsp32Screen() {
             tft.println("USB Powered");
             tft.setTextColor(TEXT_COLOR);
         }
-    } else if (status->esp32Voltage < 0.05f) {
+    } else if (view.esp32Voltage < 0.05f) {
         tft.println("Battery: 0.00 V (USB?)");
-    } else if (status->esp32Voltage >= 2.5f) {
+    } else if (view.esp32Voltage >= 2.5f) {
         // Нормальна батарея - показуємо з відсотком
-        tft.printf("Battery: %.2f V\n", status->esp32Voltage);
+        tft.printf("Battery: %.2f V\n", view.esp32Voltage);
         tft.setCursor(10, 50);
-        tft.printf("Percent: %u%%\n", status->esp32BatteryPercent);
+        tft.printf("Percent: %u%%\n", view.esp32BatteryPercent);
     } else {
         // Низька напруга - можливо розряджена батарея, показуємо без відсотка
-        tft.printf("Battery: %.2f V\n", status->esp32Voltage);
+        tft.printf("Battery: %.2f V\n", view.esp32Voltage);
     }
     // Визначаємо початкову позицію Y для наступних рядків
     int startY = 60;
-    if (status->esp32UsbPowered) {
+    if (view.esp32UsbPowered) {
         startY = 70; // Якщо USB підключений, є додатковий рядок
     }
     tft.setCursor(10, startY);
@@ -405,7 +409,7 @@ void DisplayManager::drawEsp32Screen() {
     tft.setCursor(10, startY + 20);
     tft.printf("CPU: %u MHz\n", ESP.getCpuFreqMHz());
     tft.setCursor(10, startY + 30);
-    tft.printf("Uptime: %lu s\n", status->uptime);
+    tft.printf("Uptime: %lu s\n", view.uptime);
 
     drawFooter("ESP32");
 }
@@ -423,18 +427,18 @@ void DisplayManager::drawBluettiScreen() {
 
     tft.setTextSize(1);
     tft.setCursor(10, 40);
-    if (!status->bluettiEnabled) {
+    if (!view.bluettiEnabled) {
         tft.setTextColor(WARN_COLOR);
         tft.println("Connection disabled");
-    } else if (!status->bluettiConnected) {
+    } else if (!view.bluettiConnected) {
         tft.setTextColor(ERROR_COLOR);
         tft.println("Not connected");
     } else {
         tft.setTextColor(TEXT_COLOR);
-        tft.printf("Battery: %u%%\n", status->batteryLevel);
-        tft.printf("Last update: %lus\n", (millis() - status->lastBluettiUpdate) / 1000UL);
-        tft.printf("AC: %s %dW\n", status->acOutputState ? "ON " : "OFF", status->acPower);
-        tft.printf("DC: %s %dW\n", status->dcOutputState ? "ON " : "OFF", status->dcPower);
+        tft.printf("Battery: %u%%\n", view.batteryLevel);
+        tft.printf("Last update: %lus\n", (millis() - view.lastBluettiUpdate) / 1000UL);
+        tft.printf("AC: %s %dW\n", view.acOutputState ? "ON " : "OFF", view.acPower);
+        tft.printf("DC: %s %dW\n", view.dcOutputState ? "ON " : "OFF", view.dcPower);
     }
 
     drawFooter("Bluetti");
@@ -0,0 +1,66 @@
+#include "gatt_cache.h"
+#include <Preferences.h>
+#include <cctype>
+
+static constexpr char GATT_CACHE_NAMESPACE[] = "gatt_cache";
+
+// Ключ NVS - MAC без двокрапок (12 символів, ліміт NVS - 15)
+static bool macToKey(const char *macAddress, char (&key)[13]) {
+  size_t length = 0;
+  for (const char *p = macAddress; p && *p; p++) {
+    if (*p == ':') {
+      continue;
+    }
+    if (length >= sizeof(key) - 1) {
+      return false;
+    }
+    key[length++] = (char)tolower((unsigned char)*p);
+  }
+  key[length] = '\0';
+  return length == sizeof(key) - 1;
+}
+
+bool loadGattCache(const char *macAddress, GattHandleCache &out) {
+  char key[13];
+  if (!macToKey(macAddress, key)) {
+    return false;
+  }
+  Preferences prefs;
+  prefs.begin(GATT_CACHE_NAMESPACE, true); // read-only
+  GattHandleCache cache = {};
+  size_t length = 0;
+  if (prefs.isKey(key) && prefs.getBytesLength(key) == sizeof(cache)) {
+    length = prefs.getBytes(key, &cache, sizeof(cache));
+  }
+  prefs.end();
+
+  if (length != sizeof(cache) || cache.version != GATT_CACHE_VERSION ||
+      cache.notifyHandle == 0 || cache.writeHandle == 0 || cache.cccdHandle == 0) {
+    return false;
+  }
+  out = cache;
+  return true;
+}
+
+bool saveGattCache(const char *macAddress, const GattHandleCache &cache) {
+  char key[13];
+  if (!macToKey(macAddress, key)) {
+    return false;
+  }
+  Preferences prefs;
+  prefs.begin(GATT_CACHE_NAMESPACE, false); // read-write
+  size_t written = prefs.putBytes(key, &cache, sizeof(cache));
+  prefs.end();
+  return written == sizeof(cache);
+}
+
+void clearGattCache(const char *macAddress) {
+  char key[13];
+  if (!macToKey(macAddress, key)) {
+    return;
+  }
+  Preferences prefs;
+  prefs.begin(GATT_CACHE_NAMESPACE, false); // read-write
+  prefs.remove(key);
+  prefs.end();
+}
@@ -0,0 +1,46 @@
+#include "link_state.h"
+
+const char *linkStateName(BluettiLinkState state) {
+  switch (state) {
+    case BluettiLinkState::IDLE:        return "idle";
+    case BluettiLinkState::SCANNING:    return "scanning";
+    case BluettiLinkState::CONNECTING:  return "connecting";
+    case BluettiLinkState::DISCOVERING: return "discovering";
+    case BluettiLinkState::SUBSCRIBING: return "subscribing";
+    case BluettiLinkState::ONLINE:      return "online";
+    case BluettiLinkState::COUNT:       break;
+  }
+  return "unknown";
+}
+
+unsigned long linkBackoffMs(uint8_t failures, uint32_t randomValue) {
+  unsigned long delay = LINK_BACKOFF_BASE_MS;
+  for (uint8_t i = 1; i < failures && delay < LINK_BACKOFF_MAX_MS; i++) {
+    delay *= 2;
+  }
+  if (delay > LINK_BACKOFF_MAX_MS) {
+    delay = LINK_BACKOFF_MAX_MS;
+  }
+  // Jitter ±25%: кілька мостів після спільного збою живлення не стукають синхронно
+  unsigned long spread = delay / 2;
+  return delay - delay / 4 + (spread ? randomValue % (spread + 1) : 0);
+}
+
+bool LinkStateMachine::enter(BluettiLinkState next, unsigned long now) {
+  if (next == current) {
+    return false;
+  }
+  durations[static_cast<size_t>(current)] = now - stateEnteredAt;
+  current = next;
+  stateEnteredAt = now;
+  return true;
+}
+
+unsigned long LinkStateMachine::recordFailure(unsigned long now, uint32_t randomValue) {
+  if (failureCount < UINT8_MAX) {
+    failureCount++;
+  }
+  unsigned long backoff = linkBackoffMs(failureCount, randomValue);
+  attemptAt = now + backoff;
+  return backoff;
+}
@@ -7,10 +7,11 @@
 #include <Update.h>
 #include <esp_wifi.h>
 
-#include "bluetti_device.h"
+#include "bluetti_manager.h"
 #include "display_manager.h"
 #include "mqtt_handler.h"
 #include "secrets.h"
+#include "seqlock.h"
 #include "system_status.h"
 #include "web_server.h"
 
@@ -27,6 +28,8 @@ static constexpr char DEFAULT_BLUETTI_MAC[] = "D1:4C:11:6B:6A:3D";
 // Глобальні змінні для конфігурації (можуть бути змінені через веб)
 char mqttServer[64] = "";
 char bluettiMac[18] = "";
+// Додаткові електростанції (пристрої 1..N-1); порожньо - не використовуються
+char extraBluettiMacs[BLUETTI_MAX_DEVICES - 1][18] = {};
 char wifiSsid[64] = "";
 char wifiPassword[64] = "";
 
@@ -34,14 +37,17 @@ char wifiPassword[64] = "";
 // Globals
 //------------------------------------------------------------------------------
 SystemStatus systemStatus;
-BluettiDevice bluetti(&systemStatus);
-DisplayManager display(&bluetti, &systemStatus);
-MQTTHandler mqtt(&bluetti, &systemStatus);
-WebServerManager webServer(&bluetti, &systemStatus);
+// Узгоджена копія для читачів (дисплей, MQTT, веб на AsyncTCP). Пише лише loop()
+SeqLock<SystemStatus> statusSnapshot;
+BluettiManager bluettiManager(&systemStatus, &statusSnapshot);
+// Пристрій 0 - основний: дисплей, налаштування опитування
+BluettiDevice& bluetti = bluettiManager.device(0);
+DisplayManager display(&bluetti, &systemStatus, &statusSnapshot);
+MQTTHandler mqtt(&bluettiManager, &systemStatus);
+WebServerManager webServer(&bluettiManager, &systemStatus, &statusSnapshot);
 
 unsigned long lastWiFiAttempt = 0;
 unsigned long lastVoltageSample = 0;
-unsigned long lastBluettiAttempt = 0;
 bool otaReady = false;
 bool webServerStarted = false;
 bool apMode = false;
@@ -53,15 +59,17 @@ const unsigned long AP_TIMEOUT_MS = 10 * 60 * 1000;   // 10 хвилин
 // Power Save - Smart polling інтервали
 const unsigned long WIFI_RETRY_FAST_MS = 3000;         // Швидкі спроби - кожні 3 секунди
 const unsigned long WIFI_RETRY_SLOW_MS = 5 * 60 * 1000; // Повільні спроби - кожні 5 хвилин
-const unsigned long BLUETTI_RETRY_FAST_MS = 10000;      // Швидкі спроби - кожні 10 секунд  
-const unsigned long BLUETTI_RETRY_SLOW_MS = 5 * 60 * 1000; // Повільні спроби - кожні 5 хвилин
 const uint8_t WIFI_FAST_ATTEMPTS = 10;    // Кількість швидких спроб перед переходом на повільний режим
-const uint8_t BLUETTI_FAST_ATTEMPTS = 6;  // Кількість швидких спроб перед переходом на повільний режим
 
 uint8_t wifiFailedAttempts = 0;    // Лічильник невдалих спроб підключення WiFi
-uint8_t bluettiFailedAttempts = 0; // Лічильник невдалих спроб підключення Bluetti
 bool wifiSlowMode = false;         // Режим повільного опитування WiFi
-bool bluettiSlowMode = false;      // Режим повільного опитування Bluetti
+
+// BLE worker: підключення та Modbus-обмін з Bluetti. Ядро 0 - там же NimBLE host,
+// Arduino loop() (дисплей, кнопки, MQTT) лишається на ядрі 1
+TaskHandle_t bluettiTaskHandle = nullptr;
+static constexpr BaseType_t BLUETTI_TASK_CORE = 0;
+static constexpr uint32_t BLUETTI_TASK_STACK = 8192;
+static constexpr UBaseType_t BLUETTI_TASK_PRIORITY = 2;
 
 //------------------------------------------------------------------------------
 // Читання напруги акумулятора/живлення ESP32
@@ -318,70 +326,18 @@ void ensureWiFi() {
 }
 
 void manageBluetti() {
-  if (!systemStatus.bluettiEnabled) {
-    if (bluetti.isConnected()) {
-      bluetti.disconnect();
-    }
-    return;
-  }
+  // BLE підключення до Bluetti - ESP32 підключається напряму. Стан з'єднання,
+  // повтори та backoff веде BluettiDevice, чергу до ефіру - BluettiManager.
+  // Цілі (MAC та ввімкнення) приходять через його чергу команд
+  bluettiManager.loop(); // Обробка BLE підключень та отримання даних
+}
 
-  // BLE підключення до Bluetti - ESP32 підключається напряму
-  // Smart polling: швидкі спроби (10 сек), потім повільні (5 хвилин)
-  if (!bluetti.isConnected()) {
-    // Використовуємо smart polling - швидкий або повільний режим
-    unsigned long retryInterval = bluettiSlowMode ? BLUETTI_RETRY_SLOW_MS : BLUETTI_RETRY_FAST_MS;
-    
-    if (millis() - lastBluettiAttempt > retryInterval) {
-      if (strlen(bluettiMac) > 0) {
-        if (bluettiSlowMode) {
-          Serial.println("[Bluetti] Slow mode: attempting reconnection (every 5 minutes)");
-        }
-        
-        // ВАЖЛИВО: Викликаємо display.loop() ПЕРЕД блокуючою операцією!
-        display.loop();
-        Serial.println("[Main] Attempting to connect to Bluetti...");
-        
-        bool connectStarted = bluetti.scanAndConnect(bluettiMac);
-        
-        // Якщо підключення не вдалось, збільшуємо лічильник
-        if (!connectStarted && !bluetti.isConnected()) {
-          bluettiFailedAttempts++;
-          Serial.printf("[Bluetti] Connection failed (attempt %d/%d)\n", 
-                        bluettiFailedAttempts, BLUETTI_FAST_ATTEMPTS);
-          
-          // Після декількох невдалих спроб переходимо на повільний режим
-          if (bluettiFailedAttempts >= BLUETTI_FAST_ATTEMPTS && !bluettiSlowMode) {
-            bluettiSlowMode = true;
-            Serial.printf("[Bluetti] Switching to slow polling mode (every %lu minutes)\n", 
-                          BLUETTI_RETRY_SLOW_MS / 60000);
-            Serial.println("[Bluetti] 💡 This saves power when Bluetti is OFF");
-          }
-        }
-        
-        display.loop();
-      } else {
-        Serial.println("[Main] ⚠️  Bluetti MAC address not configured!");
-      }
-      lastBluettiAttempt = millis();
-    }
-  } else {
-    // Bluetti підключений - скидаємо лічильники
-    if (bluettiFailedAttempts > 0 || bluettiSlowMode) {
-      bluettiFailedAttempts = 0;
-      bluettiSlowMode = false;
-      Serial.println("[Bluetti] Connected, reset to fast polling mode");
-    }
+// Задача BLE worker: блокуючі операції підключення не зупиняють дисплей та кнопки
+void bluettiTask(void *parameter) {
+  for (;;) {
+    manageBluetti();
+    vTaskDelay(pdMS_TO_TICKS(10));
   }
-  
-  // Також обробляємо сканування, якщо воно активне
-  if (!bluetti.isConnected() && millis() - lastBluettiAttempt < 15000) {
-    if (strlen(bluettiMac) > 0) {
-      bluetti.scanAndConnect(bluettiMac);
-    }
-  }
-
-  bluetti.loop(); // Обробка BLE підключення та отримання даних
-  display.loop(); // Після bluetti.loop()
 }
 
 void loadConfig() {
@@ -407,6 +363,15 @@ void loadConfig() {
     strncpy(bluettiMac, DEFAULT_BLUETTI_MAC, sizeof(bluettiMac) - 1);
     Serial.printf("Using default Bluetti MAC: %s\n", bluettiMac);
   }
+  for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+    char key[16];
+    snprintf(key, sizeof(key), "bluetti_mac_%u", (unsigned)i);
+    String extraMac = prefs.getString(key, "");
+    extraMac.toCharArray(extraBluettiMacs[i - 1], sizeof(extraBluettiMacs[i - 1]));
+    if (extraMac.length() > 0) {
+      Serial.printf("Loaded Bluetti #%u MAC from Preferences: %s\n", (unsigned)i, extraBluettiMacs[i - 1]);
+    }
+  }
 
   // Завантажуємо WiFi SSID
   String savedSsid = prefs.getString("wifi_ssid", "");
@@ -428,10 +393,29 @@ void loadConfig() {
     Serial.println("Using default WiFi password");
   }
   
-  // Завантажуємо інтервал опитування Bluetti
-  unsigned long savedInterval = prefs.getULong("update_interval", 20000); // За замовчуванням 20 секунд
-  bluetti.setUpdateInterval(savedInterval);
-  Serial.printf("Loaded Bluetti update interval: %lu ms (%lu seconds)\n", savedInterval, savedInterval/1000);
+  // Завантажуємо межі адаптивного опитування Bluetti. update_interval - колишній
+  // фіксований інтервал, тепер це стеля, до якої опитування сповільнюється
+  unsigned long savedPollMin = prefs.getULong("poll_min", POLL_MIN_DEFAULT_MS);
+  unsigned long savedPollMax = prefs.getULong("update_interval", POLL_MAX_DEFAULT_MS);
+  for (size_t i = 0; i < BLUETTI_MAX_DEVICES; i++) {
+    bluettiManager.device(i).setPollBounds(savedPollMin, savedPollMax);
+  }
+  Serial.printf("Loaded Bluetti poll interval: %lu..%lu ms\n", savedPollMin, savedPollMax);
+
+  // Deadband потужностей для MQTT (решта полів - за замовчуванням) та heartbeat
+  Deadband powerBand = DEFAULT_DEADBANDS[static_cast<size_t>(StateField::AC_POWER)];
+  powerBand.absolute = prefs.getFloat("mqtt_power_db", powerBand.absolute);
+  powerBand.relative = prefs.getFloat("mqtt_power_pct", powerBand.relative * 100.0f) / 100.0f;
+  mqtt.setDeadband(StateField::AC_POWER, powerBand);
+  mqtt.setDeadband(StateField::DC_POWER, powerBand);
+  mqtt.setDeadband(StateField::INPUT_POWER, powerBand);
+  mqtt.setHeartbeatMs(prefs.getULong("mqtt_heartbeat", MQTT_HEARTBEAT_DEFAULT_MS));
+  Serial.printf("Loaded MQTT power deadband: %.0f W / %.0f%%, heartbeat %lu s\n", powerBand.absolute,
+                powerBand.relative * 100.0f, mqtt.getHeartbeatMs() / 1000);
+  uint8_t stateMode = prefs.getUChar("mqtt_state_mode", static_cast<uint8_t>(MqttStateMode::PER_TOPIC));
+  mqtt.setStateMode(stateMode == static_cast<uint8_t>(MqttStateMode::JSON) ? MqttStateMode::JSON
+                                                                          : MqttStateMode::PER_TOPIC);
+  Serial.printf("Loaded MQTT state mode: %s\n", mqttStateModeName(mqtt.getStateMode()));
 
   prefs.end();
 }
@@ -536,7 +520,14 @@ void setup() {
   loadConfig();
 
   // Ініціалізуємо BLE для прямого підключення до Bluetti
-  bluetti.begin();
+  bluettiManager.begin();
+  bluettiManager.requestEnabled(systemStatus.bluettiEnabled);
+  bluettiManager.requestTarget(0, bluettiMac);
+  for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+    bluettiManager.requestTarget(i, extraBluettiMacs[i - 1]);
+  }
+  xTaskCreatePinnedToCore(bluettiTask, "bluetti", BLUETTI_TASK_STACK, nullptr,
+                          BLUETTI_TASK_PRIORITY, &bluettiTaskHandle, BLUETTI_TASK_CORE);
   
   // Налаштовуємо MQTT з username та password
   mqtt.configure(mqttServer, MQTT_PORT, MQTT_USER, MQTT_PASSWORD);
@@ -552,13 +543,13 @@ void setup() {
   Serial.printf("  - Fast retry: every %lu seconds\n", WIFI_RETRY_FAST_MS / 1000);
   Serial.printf("  - Slow retry: every %lu minutes (after %d failed attempts)\n", 
                 WIFI_RETRY_SLOW_MS / 60000, WIFI_FAST_ATTEMPTS);
-  Serial.println("[Bluetti] Smart polling:");
-  Serial.printf("  - Fast retry: every %lu seconds\n", BLUETTI_RETRY_FAST_MS / 1000);
-  Serial.printf("  - Slow retry: every %lu minutes (after %d failed attempts)\n", 
-                BLUETTI_RETRY_SLOW_MS / 60000, BLUETTI_FAST_ATTEMPTS);
+  Serial.println("[Bluetti] Reconnect backoff:");
+  Serial.printf("  - First retry after %lu seconds, doubling up to %lu minutes (±25%% jitter)\n",
+                LINK_BACKOFF_BASE_MS / 1000, LINK_BACKOFF_MAX_MS / 60000);
 
   wifiConnectStartTime = millis();
   connectWiFi();
+  statusSnapshot.write(systemStatus);
 }
 
 void loop() {
@@ -597,8 +588,8 @@ void loop() {
   mqtt.loop(systemStatus.wifiConnected);
   display.loop(); // Після MQTT - обробляємо кнопки одразу після блокування
 
-  manageBluetti();
-  display.loop(); // Після Bluetti
+  // Bluetti обробляє BLE worker - тут лише забираємо готові знімки стану
+  bluettiManager.drainRecords();
 
   // Дозволяємо іншим задачам виконуватися
   yield();
@@ -695,6 +686,9 @@ void loop() {
     systemStatus.wifiRssi = WiFi.RSSI();
   }
 
+  // Публікуємо знімок один раз за ітерацію - після всіх змін стану
+  statusSnapshot.write(systemStatus);
+
   // Невелика затримка для стабільності
   delay(10);
 }
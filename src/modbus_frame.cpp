@@ -0,0 +1,83 @@
+#include "modbus_frame.h"
+#include "modbus_crc.h"
+
+size_t modbusFrameLength(const uint8_t *data, size_t available) {
+  if (available < 1) {
+    return 0;
+  }
+  if (data[0] != MODBUS_DEVICE_ID) {
+    return SIZE_MAX;
+  }
+  if (available < 2) {
+    return 0;
+  }
+  uint8_t function = data[1];
+  if (function == 0x83 || function == 0x86) {
+    return 5; // ID, 0x8X, exception code, CRC16
+  }
+  if (function == 0x06) {
+    return 8; // Echo: ID, 0x06, addr(2), value(2), CRC16
+  }
+  if (function == 0x03) {
+    if (available < 3) {
+      return 0;
+    }
+    return 5 + data[2]; // ID, 0x03, byte count, data, CRC16
+  }
+  return SIZE_MAX;
+}
+
+ModbusFrameError parseModbusFrame(const uint8_t *data, size_t length,
+                                  ModbusFrameView &view) {
+  view = ModbusFrameView();
+  if (length < MODBUS_MIN_FRAME) {
+    return ModbusFrameError::TOO_SHORT;
+  }
+  size_t expected = modbusFrameLength(data, length);
+  if (expected == SIZE_MAX) {
+    return data[0] != MODBUS_DEVICE_ID ? ModbusFrameError::BAD_DEVICE_ID
+                                       : ModbusFrameError::BAD_FUNCTION;
+  }
+  // Непарний byte count не ділиться на регістри
+  if (expected != length || (data[1] == 0x03 && (data[2] & 1))) {
+    return ModbusFrameError::BAD_LENGTH;
+  }
+  uint16_t crc = calculateCRC16(data, length - 2);
+  if (crc != (data[length - 2] | (data[length - 1] << 8))) {
+    return ModbusFrameError::BAD_CRC;
+  }
+
+  view.function = data[1];
+  view.data = data;
+  view.length = length;
+  switch (view.function) {
+    case 0x03:
+      view.type = ModbusFrameType::READ_RESPONSE;
+      view.byteCount = data[2];
+      view.payload = data + 3;
+      break;
+    case 0x06:
+      view.type = ModbusFrameType::WRITE_ECHO;
+      view.address = (data[2] << 8) | data[3];
+      view.value = (data[4] << 8) | data[5];
+      break;
+    default:
+      view.type = ModbusFrameType::EXCEPTION;
+      view.exceptionCode = data[2];
+      break;
+  }
+  return ModbusFrameError::NONE;
+}
+
+const char *modbusFrameErrorName(ModbusFrameError error) {
+  switch (error) {
+    case ModbusFrameError::NONE:          return "none";
+    case ModbusFrameError::TOO_SHORT:     return "too_short";
+    case ModbusFrameError::BAD_DEVICE_ID: return "bad_device_id";
+    case ModbusFrameError::BAD_FUNCTION:  return "bad_function";
+    case ModbusFrameError::BAD_LENGTH:    return "bad_length";
+    case ModbusFrameError::BAD_CRC:       return "bad_crc";
+    case ModbusFrameError::COUNT:         break;
+  }
+  return "unknown";
+}
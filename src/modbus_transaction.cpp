@@ -0,0 +1,190 @@
+#include "modbus_transaction.h"
+#include <cstring>
+
+static bool sameRequest(const ModbusTransaction &a, const ModbusTransaction &b) {
+  // Записи з різними ticket не зливаються - кожен викликач отримує свій результат
+  return a.kind == b.kind && a.function == b.function && a.address == b.address &&
+         a.value == b.value && a.ticket == b.ticket;
+}
+
+bool ModbusTransactionEngine::enqueue(const ModbusTransaction &transaction,
+                                      unsigned long now) {
+  for (size_t i = 0; i < count; i++) {
+    if (sameRequest(queue[i], transaction)) {
+      // Такий самий запит уже чекає - новий нічого не додасть
+      if (transaction.priority > queue[i].priority) {
+        ModbusTransaction promoted = queue[i];
+        promoted.priority = transaction.priority;
+        for (size_t j = i; j + 1 < count; j++) {
+          queue[j] = queue[j + 1];
+        }
+        count--;
+        insertSorted(promoted, false);
+      }
+      return true;
+    }
+  }
+
+  if (count == QUEUE_CAPACITY) {
+    // Черга повна: витісняємо наймолодший запит з нижчим пріоритетом
+    if (queue[count - 1].priority >= transaction.priority) {
+      droppedCount++;
+      return false;
+    }
+    evictYoungest();
+  }
+
+  ModbusTransaction entry = transaction;
+  entry.enqueuedAt = now;
+  insertSorted(entry, false);
+  return true;
+}
+
+void ModbusTransactionEngine::insertSorted(const ModbusTransaction &transaction,
+                                           bool front) {
+  // front = true: повтор стає першим серед свого пріоритету
+  size_t pos = count;
+  while (pos > 0) {
+    const ModbusTransaction &prev = queue[pos - 1];
+    bool shift = front ? prev.priority <= transaction.priority
+                       : prev.priority < transaction.priority;
+    if (!shift) {
+      break;
+    }
+    queue[pos] = prev;
+    pos--;
+  }
+  queue[pos] = transaction;
+  count++;
+}
+
+void ModbusTransactionEngine::evictYoungest() {
+  const ModbusTransaction &victim = queue[count - 1];
+  count--;
+  droppedCount++;
+  if (victim.ticket == 0) {
+    return; // Опитування повториться саме, про нього ніхто не чекає
+  }
+  if (evictedCount == QUEUE_CAPACITY) {
+    // Викликач давно не забирав - найстаріший результат уже не врятувати
+    evictedHead = (evictedHead + 1) % QUEUE_CAPACITY;
+    evictedCount--;
+  }
+  evicted[(evictedHead + evictedCount) % QUEUE_CAPACITY] = victim;
+  evictedCount++;
+}
+
+bool ModbusTransactionEngine::takeEvicted(ModbusTransaction &out) {
+  if (evictedCount == 0) {
+    return false;
+  }
+  out = evicted[evictedHead];
+  evictedHead = (evictedHead + 1) % QUEUE_CAPACITY;
+  evictedCount--;
+  return true;
+}
+
+bool ModbusTransactionEngine::startNext(unsigned long now, ModbusTransaction &out) {
+  if (!canSend(now) || count == 0) {
+    return false;
+  }
+  txn = queue[0];
+  for (size_t i = 1; i < count; i++) {
+    queue[i - 1] = queue[i];
+  }
+  count--;
+
+  txn.sentAt = now;
+  txn.deadline = now + txn.timeoutMs;
+  inFlight = true;
+  out = txn;
+  return true;
+}
+
+ModbusExpireResult ModbusTransactionEngine::sendFailed() {
+  if (!inFlight) {
+    return ModbusExpireResult::NONE;
+  }
+  return failAttempt();
+}
+
+bool ModbusTransactionEngine::complete(const ModbusFrameView &frame,
+                                       unsigned long now) {
+  // Exception-відповідь має старший біт (0x83 для 0x03, 0x86 для 0x06)
+  if (!inFlight || frame.requestFunction() != txn.function) {
+    return false;
+  }
+  if (frame.type == ModbusFrameType::READ_RESPONSE && frame.registerCount() != txn.value) {
+    return false; // Відповідь на запит іншої довжини
+  }
+  if (frame.type == ModbusFrameType::WRITE_ECHO && frame.address != txn.address) {
+    return false; // Echo запису іншого регістра
+  }
+
+  inFlight = false;
+  completedCount++;
+  lastLatency = now - txn.sentAt;
+  return true;
+}
+
+ModbusExpireResult ModbusTransactionEngine::expire(unsigned long now) {
+  if (!inFlight) {
+    return ModbusExpireResult::NONE;
+  }
+  // Порівняння через різницю - коректне при переповненні millis()
+  if ((long)(now - txn.deadline) < 0) {
+    return ModbusExpireResult::NONE;
+  }
+  timeoutCount++;
+  return failAttempt();
+}
+
+ModbusExpireResult ModbusTransactionEngine::failAttempt() {
+  inFlight = false;
+  if (txn.retriesLeft == 0) {
+    return ModbusExpireResult::FAILED;
+  }
+  if (count == QUEUE_CAPACITY) {
+    // Повтор витісняє лише запит нижчого пріоритету: повтор опитування не
+    // сміє викинути запис користувача, що ще чекає на першу спробу
+    if (queue[count - 1].priority >= txn.priority) {
+      droppedCount++;
+      return ModbusExpireResult::FAILED;
+    }
+    evictYoungest();
+  }
+  ModbusTransaction retry = txn;
+  retry.retriesLeft--;
+  retryCount++;
+  insertSorted(retry, true);
+  return ModbusExpireResult::RETRY;
+}
+
+bool ModbusTransactionEngine::hasQueued(ModbusTxnKind kind, uint16_t address) const {
+  if (inFlight && txn.kind == kind && txn.address == address) {
+    return true;
+  }
+  for (size_t i = 0; i < count; i++) {
+    if (queue[i].kind == kind && queue[i].address == address) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void ModbusTransactionEngine::clear() {
+  count = 0;
+  inFlight = false;
+}
+
+bool ModbusTransactionEngine::canSend(unsigned long now) const {
+  return !inFlight && (long)(now - quietUntil) >= 0;
+}
+
+size_t ModbusTransactionEngine::buildFrame(const ModbusTransaction &transaction,
+                                           uint8_t *out) {
+  ModbusRequestFrame frame = buildModbusRequest(transaction.function, transaction.address,
+                                                transaction.value);
+  memcpy(out, frame.bytes, FRAME_SIZE);
+  return FRAME_SIZE;
+}
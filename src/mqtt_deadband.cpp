@@ -0,0 +1,29 @@
+#include "mqtt_deadband.h"
+#include <cmath>
+
+static_assert(STATE_FIELD_COUNT <= 32, "DeadbandFilter keeps one bit per field");
+
+bool deadbandExceeded(float last, float value, const Deadband &band) {
+  float delta = std::fabs(value - last);
+  if (delta == 0.0f) {
+    return false;
+  }
+  // Увімкнення/вимкнення навантаження (0 W <-> 3 W) менше за поріг, але саме
+  // його і треба побачити: перехід до нуля чи з нуля публікується завжди
+  if (last == 0.0f || value == 0.0f) {
+    return true;
+  }
+  float threshold = std::fmax(band.absolute, band.relative * std::fabs(last));
+  return delta >= threshold;
+}
+
+bool DeadbandFilter::admit(StateField field, float value, const Deadband &band, bool force) {
+  size_t index = static_cast<size_t>(field);
+  uint32_t bit = 1u << index;
+  if (!force && (known & bit) && !deadbandExceeded(last[index], value, band)) {
+    return false;
+  }
+  last[index] = value;
+  known |= bit;
+  return true;
+}
@@ -1,14 +1,107 @@
 #include "mqtt_handler.h"
+#include "json_writer.h"
+#include <Preferences.h>
 
 MQTTHandler *MQTTHandler::instance = nullptr;
 
-MQTTHandler::MQTTHandler(BluettiDevice *device, SystemStatus *sharedStatus)
-    : mqttClient(wifiClient), bluetti(device), status(sharedStatus),
-      serverPort(1883), lastPublish(0), lastMqttAttempt(0),
-      mqttConnecting(false) {
+// Хеш опублікованого discovery кожного пристрою: "hash_<index>"
+static constexpr char DISCOVERY_NAMESPACE[] = "mqtt_disc";
+// Birth message Home Assistant: після його рестарту discovery треба повторити
+static constexpr char HA_STATUS_TOPIC[] = "homeassistant/status";
+// "online", що прийшов одразу після підписки, - retained копія, а не рестарт HA
+static constexpr unsigned long HA_BIRTH_GRACE_MS = 3000;
+
+static uint32_t loadDiscoveryHash(size_t index) {
+  char key[12];
+  snprintf(key, sizeof(key), "hash_%u", (unsigned)index);
+  Preferences prefs;
+  prefs.begin(DISCOVERY_NAMESPACE, true); // read-only
+  uint32_t hash = prefs.getULong(key, 0);
+  prefs.end();
+  return hash;
+}
+
+static void saveDiscoveryHash(size_t index, uint32_t hash) {
+  char key[12];
+  snprintf(key, sizeof(key), "hash_%u", (unsigned)index);
+  Preferences prefs;
+  prefs.begin(DISCOVERY_NAMESPACE, false); // read-write
+  prefs.putULong(key, hash);
+  prefs.end();
+}
+
+const char *mqttStateModeName(MqttStateMode mode) {
+  return mode == MqttStateMode::JSON ? "json" : "per_topic";
+}
+
+// Сутності Home Assistant. Топіки стану й команд - відносно topicBase,
+// unique_id = bluetti_<slug>_<uniqueId>; публікуються лише ті, що є в профілі
+struct DiscoveryEntity {
+  ProfileEntity entity;
+  const char *component;
+  const char *object;       // homeassistant/<component>/bluetti_<slug>/<object>/config
+  const char *uniqueId;
+  const char *name;
+  const char *stateTopic;   // nullptr - без стану (кнопка)
+  const char *stateKey;     // Ключ поля в JSON-стані
+  bool attributes;          // JSON-режим: увесь стан - атрибути цієї сутності
+  const char *commandTopic; // nullptr - лише сенсор
+  const char *unit;
+  const char *deviceClass;
+  const char *stateClass;
+  const char *options[4];
+};
+
+static constexpr DiscoveryEntity DISCOVERY_ENTITIES[] = {
+    {ProfileEntity::BATTERY, "sensor", "battery", "battery", "Bluetti Battery",
+     "battery", "battery", true, nullptr, "%", "battery", nullptr, {}},
+    {ProfileEntity::AC_POWER, "sensor", "ac_power", "ac_power", "Bluetti AC Power",
+     "ac_power", "ac_power", false, nullptr, "W", "power", "measurement", {}},
+    {ProfileEntity::DC_POWER, "sensor", "dc_power", "dc_power", "Bluetti DC Power",
+     "dc_power", "dc_power", false, nullptr, "W", "power", "measurement", {}},
+    {ProfileEntity::INPUT_POWER, "sensor", "input_power", "input_power", "Bluetti Input Power",
+     "input_power", "input_power", false, nullptr, "W", "power", "measurement", {}},
+    {ProfileEntity::VOLTAGE, "sensor", "voltage", "voltage", "Bluetti Battery Voltage",
+     "voltage", "voltage", false, nullptr, "V", "voltage", "measurement", {}},
+    {ProfileEntity::AC_OUTPUT, "switch", "ac_output", "ac_switch", "Bluetti AC Output",
+     "ac_output/state", "ac_output", false, "ac_output/set", nullptr, nullptr, nullptr, {}},
+    {ProfileEntity::DC_OUTPUT, "switch", "dc_output", "dc_switch", "Bluetti DC Output",
+     "dc_output/state", "dc_output", false, "dc_output/set", nullptr, nullptr, nullptr, {}},
+    {ProfileEntity::CHARGING_SPEED, "select", "charging_speed", "charging_speed", "Bluetti Charging Speed",
+     "charging_speed", "charging_speed", false, "charging_speed/set", nullptr, nullptr, nullptr, {"Standard", "Silent", "Turbo"}},
+    {ProfileEntity::ECO_MODE, "switch", "eco_mode", "eco_mode", "Bluetti ECO Mode",
+     "eco_mode/state", "eco_mode", false, "eco_mode/set", nullptr, nullptr, nullptr, {}},
+    {ProfileEntity::POWER_LIFTING, "switch", "power_lifting", "power_lifting", "Bluetti Power Lifting",
+     "power_lifting/state", "power_lifting", false, "power_lifting/set", nullptr, nullptr, nullptr, {}},
+    {ProfileEntity::LED_MODE, "select", "led_mode", "led_mode", "Bluetti LED Mode",
+     "led_mode", "led_mode", false, "led_mode/set", nullptr, nullptr, nullptr, {"Low", "High", "SOS", "Off"}},
+    // Flashlight: простий ON/OFF для LED
+    {ProfileEntity::LED_SWITCH, "switch", "led_switch", "led_switch", "Bluetti Flashlight",
+     "led_switch/state", "led_switch", false, "led_switch/set", nullptr, nullptr, nullptr, {}},
+    {ProfileEntity::ECO_SHUTDOWN, "select", "eco_shutdown", "eco_shutdown", "Bluetti ECO Shutdown",
+     "eco_shutdown", "eco_shutdown", false, "eco_shutdown/set", nullptr, nullptr, nullptr, {"1h", "2h", "3h", "4h"}},
+    {ProfileEntity::POWER_OFF, "button", "power_off", "power_off", "Bluetti Power Off",
+     nullptr, nullptr, false, "power_off", nullptr, "restart", nullptr, {}},
+};
+
+MQTTHandler::MQTTHandler(BluettiManager *manager, SystemStatus *sharedStatus)
+    : mqttClient(wifiClient), status(sharedStatus), serverPort(1883), lastMqttAttempt(0),
+      mqttConnecting(false), lastChangeCheck(0), heartbeatMs(MQTT_HEARTBEAT_DEFAULT_MS) {
   instance = this;
+  for (size_t i = 0; i < STATE_FIELD_COUNT; i++) {
+    setDeadband(static_cast<StateField>(i), DEFAULT_DEADBANDS[i]);
+  }
+  for (size_t i = 0; i < BLUETTI_MAX_DEVICES; i++) {
+    MqttDeviceChannel &channel = channels[i];
+    channel.index = i;
+    channel.device = &manager->device(i);
+    channel.snapshot = manager->snapshot(i);
+    setIdentity(channel, channel.device->getProfile());
+    channel.device->onWriteComplete(writeResultThunk, &channel);
+  }
   mqttClient.setCallback(callbackThunk);
-  // Збільшуємо буфер для MQTT Discovery (потрібно мінімум 512 байт)
+  // Буфер для пакетів burst (768 байт) і JSON-стану; discovery пишеться
+  // потоком повз буфер
   mqttClient.setBufferSize(1024);
   // ВАЖЛИВО: Встановлюємо мінімальний таймаут для WiFiClient, щоб не блокувати
   // кнопки!
@@ -42,6 +135,14 @@ void MQTTHandler::loop(bool wifiReady) {
     return;
   }
 
+  // Модель визначається з першого блоку статусу - до того топіки EB3A
+  for (MqttDeviceChannel &channel : channels) {
+    const DeviceProfile &current = channel.device->getProfile();
+    if (&current != channel.profile) {
+      applyProfile(channel, current);
+    }
+  }
+
   // Неблокуюче підключення
   // ВАЖЛИВО: ensureConnection() може блокувати, тому викликаємо display.loop()
   // всередині
@@ -54,20 +155,162 @@ void MQTTHandler::loop(bool wifiReady) {
   mqttClient.loop();
   status->mqttConnected = true;
 
-  // Публікуємо статус кожні 5 секунд (дані отримуються з Bluetti через BLE)
-  if (millis() - lastPublish > 5000) {
-    publishStatus();
-    lastPublish = millis();
+  if (stateMode.load(std::memory_order_relaxed) != appliedMode) {
+    applyStateMode(stateMode.load(std::memory_order_relaxed));
   }
+  if (discoveryRequested.exchange(false, std::memory_order_relaxed)) {
+    // Birth message HA або запит з web: HA після рестарту чекає і стан
+    bool force = discoveryForced.exchange(false, std::memory_order_relaxed);
+    for (MqttDeviceChannel &channel : channels) {
+      if (channel.announced) {
+        syncDiscovery(channel, force);
+        publishStatus(channel, true);
+        channel.lastHeartbeat = millis();
+      }
+    }
+  }
+
+  // Публікуємо лише поля, що вийшли за deadband (дані отримуються з Bluetti
+  // через BLE), і зрідка - усе одразу як heartbeat
+  unsigned long now = millis();
+  bool checkChanges = now - lastChangeCheck >= MQTT_CHANGE_CHECK_MS;
+  for (MqttDeviceChannel &channel : channels) {
+    if (!channel.announced) {
+      if (!shouldAnnounce(channel)) {
+        continue;
+      }
+      announce(channel);
+    }
+
+    publishBurstSamples(channel);
+
+    if (now - channel.lastHeartbeat >= getHeartbeatMs()) {
+      publishStatus(channel, true);
+      channel.lastHeartbeat = now;
+      heartbeats.fetch_add(1, std::memory_order_relaxed);
+      Serial.printf("[MQTT] Heartbeat #%u: %u state publishes, %u skipped by deadband since boot\n",
+                    channel.index, getStatePublished(), getStateSkipped());
+    } else if (channel.writeSettled || checkChanges) {
+      // Результат запису прийшов у попередньому drainRecords(), знімок уже
+      // оновлено. Невдалий запис - повна публікація, щоб HA повернув перемикач
+      publishStatus(channel, channel.writeSettled && channel.writeFailed);
+    }
+    channel.writeSettled = false;
+    channel.writeFailed = false;
+  }
+  if (checkChanges) {
+    lastChangeCheck = now;
+  }
+  updateTrafficRates(now);
 }
 
 bool MQTTHandler::isConnected() { return mqttClient.connected(); }
 
-void MQTTHandler::republishDiscovery() {
-  if (mqttClient.connected()) {
-    publishDiscovery();
-    Serial.println("MQTT Discovery republished");
+void MQTTHandler::setIdentity(MqttDeviceChannel &channel, const DeviceProfile &profile) {
+  channel.profile = &profile;
+  if (channel.index == 0) {
+    snprintf(channel.topicBase, sizeof(channel.topicBase), "homeassistant/bluetti/%s", profile.slug);
+    snprintf(channel.deviceId, sizeof(channel.deviceId), "bluetti_%s", profile.slug);
+    snprintf(channel.deviceName, sizeof(channel.deviceName), "%s", profile.displayName);
+    return;
+  }
+  unsigned number = channel.index + 1;
+  snprintf(channel.topicBase, sizeof(channel.topicBase), "homeassistant/bluetti/%s_%u", profile.slug, number);
+  snprintf(channel.deviceId, sizeof(channel.deviceId), "bluetti_%s_%u", profile.slug, number);
+  snprintf(channel.deviceName, sizeof(channel.deviceName), "%s #%u", profile.displayName, number);
+}
+
+bool MQTTHandler::shouldAnnounce(const MqttDeviceChannel &channel) const {
+  if (channel.index == 0) {
+    return true;
   }
+  // Додатковий пристрій без цілі не з'являється в HA
+  SystemStatus snap;
+  channel.snapshot->read(snap);
+  return snap.bluettiConnected;
+}
+
+void MQTTHandler::announce(MqttDeviceChannel &channel) {
+  // Підписуємося на команди від Home Assistant
+  subscribeCommands(channel);
+  yield();
+  syncDiscovery(channel, false);
+  yield();
+  publishStatus(channel, true);
+  channel.lastHeartbeat = millis();
+  if (firstStatePending) {
+    firstStatePending = false;
+    firstStateMs.store(channel.lastHeartbeat - connectedAt, std::memory_order_relaxed);
+    Serial.printf("[MQTT] First state published %lu ms after connect\n", channel.lastHeartbeat - connectedAt);
+  }
+  yield();
+  channel.announced = true;
+}
+
+void MQTTHandler::applyProfile(MqttDeviceChannel &channel, const DeviceProfile &next) {
+  Serial.printf("[MQTT] Device #%u profile %s -> %s\n", channel.index, channel.profile->displayName,
+                next.displayName);
+  bool online = channel.announced && mqttClient.connected();
+  if (online) {
+    subscribeCommands(channel, false);
+    clearDiscovery(channel);
+  }
+  setIdentity(channel, next);
+  if (online) {
+    subscribeCommands(channel);
+    syncDiscovery(channel, false);
+    publishStatus(channel, true);
+  }
+}
+
+void MQTTHandler::subscribeCommands(const MqttDeviceChannel &channel, bool subscribe) {
+  // Усі команди - <base>/<object>/set, плюс кнопка вимкнення
+  char setTopic[64];
+  char powerOffTopic[64];
+  snprintf(setTopic, sizeof(setTopic), "%s/+/set", channel.topicBase);
+  snprintf(powerOffTopic, sizeof(powerOffTopic), "%s/power_off", channel.topicBase);
+  if (!subscribe) {
+    mqttClient.unsubscribe(setTopic);
+    mqttClient.unsubscribe(powerOffTopic);
+    return;
+  }
+  mqttClient.subscribe(setTopic);
+  mqttClient.subscribe(powerOffTopic);
+  Serial.printf("[MQTT] ✅ Subscribed to control commands (%s)\n", channel.topicBase);
+}
+
+const char *MQTTHandler::commandSuffix(const MqttDeviceChannel &channel, const char *topic) {
+  size_t length = strlen(channel.topicBase);
+  if (strncmp(topic, channel.topicBase, length) != 0 || topic[length] != '/') {
+    return nullptr;
+  }
+  return topic + length + 1;
+}
+
+void MQTTHandler::publishValue(const MqttDeviceChannel &channel, const char *suffix, const char *value) {
+  char topic[96];
+  snprintf(topic, sizeof(topic), "%s/%s", channel.topicBase, suffix);
+  if (mqttClient.publish(topic, value, true)) {
+    countStatePacket(strlen(topic), strlen(value));
+  }
+}
+
+bool MQTTHandler::admit(MqttDeviceChannel &channel, StateField field, float value, bool force) {
+  if (channel.published.admit(field, value, getDeadband(field), force)) {
+    statePublished.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+  stateSkipped.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void MQTTHandler::republishDiscovery(bool force) {
+  // Будь-яка задача: публікує loop(), що володіє MQTT-клієнтом
+  if (force) {
+    discoveryForced.store(true, std::memory_order_relaxed);
+  }
+  discoveryRequested.store(true, std::memory_order_relaxed);
+  Serial.printf("MQTT Discovery republish requested%s\n", force ? " (forced)" : "");
 }
 
 bool MQTTHandler::ensureConnection() {
@@ -117,24 +360,17 @@ bool MQTTHandler::ensureConnection() {
     if (connected) {
       Serial.println(" ✅ connected!");
       mqttConnecting = false;
-      
-      // Підписуємося на команди від Home Assistant
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/ac_output/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/dc_output/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/charging_speed/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/eco_mode/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/power_lifting/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/led_mode/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/led_switch/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/eco_shutdown/set");
-      mqttClient.subscribe("homeassistant/bluetti/eb3a/power_off");
-      Serial.println("[MQTT] ✅ Subscribed to control commands");
-      
-      yield();
-      publishDiscovery();
-      yield();
-      publishStatus();
-      yield();
+      connectedAt = millis();
+      firstStatePending = true;
+
+      // Рестарт Home Assistant - єдина причина повторити незмінний discovery
+      mqttClient.subscribe(HA_STATUS_TOPIC);
+
+      // Підписки, discovery та стан кожного пристрою - у loop() одразу після
+      // підключення (нове з'єднання не має підписок попереднього)
+      for (MqttDeviceChannel &channel : channels) {
+        channel.announced = false;
+      }
       return true;
     } else {
       int state = mqttClient.state();
@@ -167,338 +403,447 @@ bool MQTTHandler::ensureConnection() {
   return false;
 }
 
-void MQTTHandler::publishStatus() {
-  if (!mqttClient.connected() || !bluetti) {
-    return;
+// Поточне значення поля стану: топік і ключ JSON, число для deadband та
+// готовий текст для перемикачів і списків
+struct StateValue {
+  StateField field;
+  StatusGroup group;
+  const char *topic; // Відносно topicBase (режим PER_TOPIC)
+  const char *key;   // Ключ у "<base>/state" (режим JSON)
+  float value;
+  const char *text;  // nullptr - число з decimals знаками
+  uint8_t decimals;
+};
+
+// Поля, які має модель, у порядку публікації
+static size_t collectState(const SystemStatus &snap, const DeviceProfile &profile, StateValue out[]) {
+  static const char *const speedNames[] = {"Standard", "Silent", "Turbo"};
+  static const char *const ledNames[] = {"", "Low", "High", "SOS", "Off"};
+  static const char *const ecoShutNames[] = {"", "1h", "2h", "3h", "4h"};
+  size_t count = 0;
+
+  out[count++] = {StateField::BATTERY, StatusGroup::BATTERY, "battery", "battery",
+                  (float)snap.batteryLevel, nullptr, 0};
+  // Напруга батареї
+  float voltage = snap.batteryVoltage / 10.0f;
+  if (voltage > 0 && profile.hasEntity(ProfileEntity::VOLTAGE)) {
+    out[count++] = {StateField::VOLTAGE, StatusGroup::BATTERY, "voltage", "voltage", voltage, nullptr, 1};
   }
-
-  char value[16];
-  
-  // Публікуємо кожне значення окремо для Home Assistant
-  snprintf(value, sizeof(value), "%u", bluetti->getBatteryLevel());
-  mqttClient.publish("homeassistant/bluetti/eb3a/battery", value, true);
-  
-  snprintf(value, sizeof(value), "%u", bluetti->getACOutputPower());
-  mqttClient.publish("homeassistant/bluetti/eb3a/ac_power", value, true);
-  
-  snprintf(value, sizeof(value), "%u", bluetti->getDCOutputPower());
-  mqttClient.publish("homeassistant/bluetti/eb3a/dc_power", value, true);
-  
-  snprintf(value, sizeof(value), "%u", bluetti->getInputPower());
-  mqttClient.publish("homeassistant/bluetti/eb3a/input_power", value, true);
-  
+  out[count++] = {StateField::AC_POWER, StatusGroup::AC_POWER, "ac_power", "ac_power",
+                  (float)snap.acPower, nullptr, 0};
+  out[count++] = {StateField::DC_POWER, StatusGroup::DC_POWER, "dc_power", "dc_power",
+                  (float)snap.dcPower, nullptr, 0};
+  out[count++] = {StateField::INPUT_POWER, StatusGroup::INPUT_POWER, "input_power", "input_power",
+                  (float)snap.inputPower, nullptr, 0};
   // Температура (якщо доступна)
-  float temp = bluetti->getTemperature();
+  float temp = snap.temperature / 10.0f;
   if (temp > 0 && temp < 100) {
-    snprintf(value, sizeof(value), "%.1f", temp);
-    mqttClient.publish("homeassistant/bluetti/eb3a/temperature", value, true);
-  }
-  
-  // Напруга батареї
-  float voltage = bluetti->getBatteryVoltage();
-  if (voltage > 0) {
-    snprintf(value, sizeof(value), "%.1f", voltage);
-    mqttClient.publish("homeassistant/bluetti/eb3a/voltage", value, true);
+    out[count++] = {StateField::TEMPERATURE, StatusGroup::TEMPERATURE, "temperature", "temperature",
+                    temp, nullptr, 1};
   }
-  
-  mqttClient.publish("homeassistant/bluetti/eb3a/ac_output/state",
-                     bluetti->getACOutputState() ? "ON" : "OFF", true);
-  mqttClient.publish("homeassistant/bluetti/eb3a/dc_output/state",
-                     bluetti->getDCOutputState() ? "ON" : "OFF", true);
-  
+  out[count++] = {StateField::AC_OUTPUT, StatusGroup::OUTPUT_STATES, "ac_output/state", "ac_output",
+                  (float)snap.acOutputState, snap.acOutputState ? "ON" : "OFF", 0};
+  out[count++] = {StateField::DC_OUTPUT, StatusGroup::OUTPUT_STATES, "dc_output/state", "dc_output",
+                  (float)snap.dcOutputState, snap.dcOutputState ? "ON" : "OFF", 0};
+
   // Charging speed
-  const char* speedNames[] = {"Standard", "Silent", "Turbo"};
-  uint8_t speedIdx = status->chargingSpeed;
-  if (speedIdx > 2) speedIdx = 0;
-  mqttClient.publish("homeassistant/bluetti/eb3a/charging_speed", speedNames[speedIdx], true);
-  
+  if (profile.hasEntity(ProfileEntity::CHARGING_SPEED)) {
+    uint8_t speedIdx = snap.chargingSpeed;
+    if (speedIdx > 2) speedIdx = 0;
+    out[count++] = {StateField::CHARGING_SPEED, StatusGroup::SETTINGS, "charging_speed", "charging_speed",
+                    (float)speedIdx, speedNames[speedIdx], 0};
+  }
   // ECO mode
-  mqttClient.publish("homeassistant/bluetti/eb3a/eco_mode/state",
-                     status->ecoMode ? "ON" : "OFF", true);
-  
+  if (profile.hasEntity(ProfileEntity::ECO_MODE)) {
+    out[count++] = {StateField::ECO_MODE, StatusGroup::SETTINGS, "eco_mode/state", "eco_mode",
+                    (float)snap.ecoMode, snap.ecoMode ? "ON" : "OFF", 0};
+  }
   // Power Lifting
-  mqttClient.publish("homeassistant/bluetti/eb3a/power_lifting/state",
-                     status->powerLifting ? "ON" : "OFF", true);
-  
+  if (profile.hasEntity(ProfileEntity::POWER_LIFTING)) {
+    out[count++] = {StateField::POWER_LIFTING, StatusGroup::SETTINGS, "power_lifting/state", "power_lifting",
+                    (float)snap.powerLifting, snap.powerLifting ? "ON" : "OFF", 0};
+  }
   // LED mode
-  const char* ledNames[] = {"", "Low", "High", "SOS", "Off"};
-  uint8_t ledIdx = status->ledMode;
+  uint8_t ledIdx = snap.ledMode;
   if (ledIdx < 1 || ledIdx > 4) ledIdx = 4; // Default Off
-  mqttClient.publish("homeassistant/bluetti/eb3a/led_mode", ledNames[ledIdx], true);
-
+  if (profile.hasEntity(ProfileEntity::LED_MODE)) {
+    out[count++] = {StateField::LED_MODE, StatusGroup::SETTINGS, "led_mode", "led_mode",
+                    (float)ledIdx, ledNames[ledIdx], 0};
+  }
   // Flashlight switch convenience (ON when mode not Off)
-  mqttClient.publish("homeassistant/bluetti/eb3a/led_switch/state",
-                     (status->ledMode != 4) ? "ON" : "OFF", true);
-  
+  if (profile.hasEntity(ProfileEntity::LED_SWITCH)) {
+    bool ledOn = snap.ledMode != 4;
+    out[count++] = {StateField::LED_SWITCH, StatusGroup::SETTINGS, "led_switch/state", "led_switch",
+                    (float)ledOn, ledOn ? "ON" : "OFF", 0};
+  }
   // ECO Shutdown
-  const char* ecoShutNames[] = {"", "1h", "2h", "3h", "4h"};
-  uint8_t ecoIdx = status->ecoShutdown;
-  if (ecoIdx < 1 || ecoIdx > 4) ecoIdx = 1; // Default 1h
-  mqttClient.publish("homeassistant/bluetti/eb3a/eco_shutdown", ecoShutNames[ecoIdx], true);
+  if (profile.hasEntity(ProfileEntity::ECO_SHUTDOWN)) {
+    uint8_t ecoIdx = snap.ecoShutdown;
+    if (ecoIdx < 1 || ecoIdx > 4) ecoIdx = 1; // Default 1h
+    out[count++] = {StateField::ECO_SHUTDOWN, StatusGroup::SETTINGS, "eco_shutdown", "eco_shutdown",
+                    (float)ecoIdx, ecoShutNames[ecoIdx], 0};
+  }
+  return count;
 }
 
-void MQTTHandler::publishDiscovery() {
-  Serial.println("[MQTT] 📡 Publishing discovery configuration...");
-  
-  char buffer[768];  // Збільшено буфер для складних JSON
-  JsonDocument doc;
-
-  // Device info - спільний для всіх сенсорів
-  JsonObject device;
-
-  // 1. Battery sensor
-  doc.clear();
-  doc["name"] = "Bluetti Battery";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/battery";
-  doc["unit_of_measurement"] = "%";
-  doc["device_class"] = "battery";
-  doc["unique_id"] = "bluetti_eb3a_battery";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  Serial.printf("[MQTT] JSON: %s\n", buffer);
-  bool result = mqttClient.publish("homeassistant/sensor/bluetti_eb3a/battery/config", buffer, true);
-  Serial.printf("[MQTT] Battery config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+void MQTTHandler::publishStatus(MqttDeviceChannel &channel, bool force) {
+  if (!mqttClient.connected()) {
+    return;
+  }
 
-  // 2. AC Power sensor
-  doc.clear();
-  doc["name"] = "Bluetti AC Power";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/ac_power";
-  doc["unit_of_measurement"] = "W";
-  doc["device_class"] = "power";
-  doc["state_class"] = "measurement";
-  doc["unique_id"] = "bluetti_eb3a_ac_power";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/sensor/bluetti_eb3a/ac_power/config", buffer, true);
-  Serial.printf("[MQTT] AC Power config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+  // Одна узгоджена копія на всю публікацію - топіки не змішують два опитування
+  SystemStatus snap;
+  channel.snapshot->read(snap);
+  // Курсор оновлюється і при повній публікації - наступна не повторить ті самі значення
+  uint16_t changed = channel.changes.take(snap.bluettiChanges);
+  if (force) {
+    changed = STATUS_DIRTY_ALL;
+  }
+  if (changed == 0) {
+    return;
+  }
 
-  // 3. DC Power sensor
-  doc.clear();
-  doc["name"] = "Bluetti DC Power";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/dc_power";
-  doc["unit_of_measurement"] = "W";
-  doc["device_class"] = "power";
-  doc["state_class"] = "measurement";
-  doc["unique_id"] = "bluetti_eb3a_dc_power";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/sensor/bluetti_eb3a/dc_power/config", buffer, true);
-  Serial.printf("[MQTT] DC Power config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+  StateValue values[STATE_FIELD_COUNT];
+  size_t count = collectState(snap, *channel.profile, values);
+  if (appliedMode == MqttStateMode::JSON) {
+    publishStateDocument(channel, values, count, changed, force);
+    return;
+  }
 
-  // 4. Input Power sensor
-  doc.clear();
-  doc["name"] = "Bluetti Input Power";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/input_power";
-  doc["unit_of_measurement"] = "W";
-  doc["device_class"] = "power";
-  doc["state_class"] = "measurement";
-  doc["unique_id"] = "bluetti_eb3a_input_power";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/sensor/bluetti_eb3a/input_power/config", buffer, true);
-  Serial.printf("[MQTT] Input Power config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+  // Кожне значення окремим retained топіком; форматується лише тоді,
+  // коли поле справді публікується
+  char value[16];
+  for (size_t i = 0; i < count; i++) {
+    const StateValue &state = values[i];
+    if (!(changed & statusBit(state.group)) || !admit(channel, state.field, state.value, force)) {
+      continue;
+    }
+    const char *payload = state.text;
+    if (!payload) {
+      snprintf(value, sizeof(value), "%.*f", (int)state.decimals, state.value);
+      payload = value;
+    }
+    publishValue(channel, state.topic, payload);
+  }
+}
 
-  // Temperature - прибрано (EB3A не передає температуру через BLE)
-  mqttClient.publish("homeassistant/sensor/bluetti_eb3a/temperature/config", "", true);
-  yield();
+void MQTTHandler::publishStateDocument(MqttDeviceChannel &channel, const StateValue *values, size_t count,
+                                       uint16_t changed, bool force) {
+  // Deadband вирішує, чи документ взагалі потрібен; сам документ - завжди
+  // повний, бо retained "<base>/state" замінює попередній цілком
+  bool publish = false;
+  for (size_t i = 0; i < count; i++) {
+    const StateValue &state = values[i];
+    if ((changed & statusBit(state.group)) && admit(channel, state.field, state.value, force)) {
+      publish = true;
+    }
+  }
+  if (!publish) {
+    return;
+  }
 
-  // 4b. Battery Voltage sensor
-  doc.clear();
-  doc["name"] = "Bluetti Battery Voltage";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/voltage";
-  doc["unit_of_measurement"] = "V";
-  doc["device_class"] = "voltage";
-  doc["state_class"] = "measurement";
-  doc["unique_id"] = "bluetti_eb3a_voltage";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/sensor/bluetti_eb3a/voltage/config", buffer, true);
-  Serial.printf("[MQTT] Voltage config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+  JsonObjectWriter writer(stateJson, sizeof(stateJson));
+  for (size_t i = 0; i < count; i++) {
+    const StateValue &state = values[i];
+    if (state.text) {
+      writer.text(state.key, state.text);
+    } else {
+      writer.number(state.key, state.value, state.decimals);
+    }
+  }
+  const char *payload = writer.finish();
+  if (!payload) {
+    Serial.printf("[MQTT] ❌ Device #%u state document exceeds %u bytes\n", channel.index,
+                  (unsigned)sizeof(stateJson));
+    return;
+  }
+  char topic[64];
+  snprintf(topic, sizeof(topic), "%s/state", channel.topicBase);
+  if (mqttClient.publish(topic, payload, true)) {
+    countStatePacket(strlen(topic), writer.length());
+  }
+}
 
-  // 5. AC Output switch
-  doc.clear();
-  doc["name"] = "Bluetti AC Output";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/ac_output/state";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/ac_output/set";
-  doc["unique_id"] = "bluetti_eb3a_ac_switch";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/switch/bluetti_eb3a/ac_output/config", buffer, true);
-  Serial.printf("[MQTT] AC Switch config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+void MQTTHandler::countStatePacket(size_t topicLength, size_t payloadLength) {
+  statePackets.fetch_add(1, std::memory_order_relaxed);
+  stateBytes.fetch_add(topicLength + payloadLength, std::memory_order_relaxed);
+  rateWindowPackets++;
+  rateWindowBytes += topicLength + payloadLength;
+}
 
-  // 6. DC Output switch
-  doc.clear();
-  doc["name"] = "Bluetti DC Output";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/dc_output/state";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/dc_output/set";
-  doc["unique_id"] = "bluetti_eb3a_dc_switch";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/switch/bluetti_eb3a/dc_output/config", buffer, true);
-  Serial.printf("[MQTT] DC Switch config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+void MQTTHandler::updateTrafficRates(unsigned long now) {
+  unsigned long elapsed = now - rateWindowStart;
+  if (elapsed < MQTT_RATE_WINDOW_MS) {
+    return;
+  }
+  // Нормуємо на хвилину: loop() може запізнитися на кілька секунд
+  packetsPerMinute.store((uint64_t)rateWindowPackets * 60000 / elapsed, std::memory_order_relaxed);
+  bytesPerMinute.store((uint64_t)rateWindowBytes * 60000 / elapsed, std::memory_order_relaxed);
+  Serial.printf("[MQTT] State traffic (%s): %.2f packets/s, %.1f bytes/s\n", mqttStateModeName(appliedMode),
+                getStatePacketsPerSec(), getStateBytesPerSec());
+  rateWindowStart = now;
+  rateWindowPackets = 0;
+  rateWindowBytes = 0;
+}
 
-  // 6. Charging Speed select
-  doc.clear();
-  doc["name"] = "Bluetti Charging Speed";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/charging_speed";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/charging_speed/set";
-  doc["unique_id"] = "bluetti_eb3a_charging_speed";
-  JsonArray options = doc["options"].to<JsonArray>();
-  options.add("Standard");
-  options.add("Silent");
-  options.add("Turbo");
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/select/bluetti_eb3a/charging_speed/config", buffer, true);
-  Serial.printf("[MQTT] Charging Speed config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+void MQTTHandler::applyStateMode(MqttStateMode mode) {
+  MqttStateMode previous = appliedMode;
+  appliedMode = mode;
+  Serial.printf("[MQTT] State mode: %s -> %s\n", mqttStateModeName(previous), mqttStateModeName(mode));
+  char topic[64];
+  for (MqttDeviceChannel &channel : channels) {
+    if (!channel.announced) {
+      continue; // Discovery опублікується в новому режимі при announce()
+    }
+    if (previous == MqttStateMode::JSON) {
+      snprintf(topic, sizeof(topic), "%s/state", channel.topicBase);
+      mqttClient.publish(topic, "", true);
+    }
+    syncDiscovery(channel, false);
+    publishStatus(channel, true);
+    channel.lastHeartbeat = millis();
+    yield();
+  }
+}
 
-  // 7. ECO Mode switch
-  doc.clear();
-  doc["name"] = "Bluetti ECO Mode";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/eco_mode/state";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/eco_mode/set";
-  doc["unique_id"] = "bluetti_eb3a_eco_mode";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/switch/bluetti_eb3a/eco_mode/config", buffer, true);
-  Serial.printf("[MQTT] ECO Mode config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+void MQTTHandler::publishBurstSamples(MqttDeviceChannel &channel) {
+  BluettiDevice *bluetti = channel.device;
+  size_t pending = bluetti->pendingBurstSamples();
+  if (pending == 0) {
+    channel.lastBurstPublish = millis();
+    return;
+  }
+  // Пакет замість retained-публікації на кожну вибірку
+  if (pending < BURST_BATCH_SAMPLES && millis() - channel.lastBurstPublish < BURST_BATCH_MS) {
+    return;
+  }
 
-  // 8. Power Lifting switch
-  doc.clear();
-  doc["name"] = "Bluetti Power Lifting";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/power_lifting/state";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/power_lifting/set";
-  doc["unique_id"] = "bluetti_eb3a_power_lifting";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/switch/bluetti_eb3a/power_lifting/config", buffer, true);
-  Serial.printf("[MQTT] Power Lifting config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+  // {"start": millis першої вибірки, "samples": [[+ms, AC out, DC out, AC in, DC in], ...]}
+  // Пишеться у заздалегідь виділений burstJson - без JsonDocument на кожен пакет
+  BurstSample sample;
+  if (!bluetti->takeBurstSample(sample)) {
+    channel.lastBurstPublish = millis();
+    return;
+  }
+  JsonObjectWriter writer(burstJson, sizeof(burstJson));
+  uint32_t start = sample.at;
+  writer.integer("start", start);
+  writer.beginArray("samples");
+  size_t taken = 0;
+  do {
+    const uint32_t row[] = {sample.at - start, sample.acOutput, sample.dcOutput, sample.acInput,
+                            sample.dcInput};
+    writer.row(row, 5);
+  } while (++taken < BURST_BATCH_SAMPLES && bluetti->takeBurstSample(sample));
+  writer.endArray();
+  const char *payload = writer.finish();
+  if (!payload) {
+    Serial.printf("[MQTT] Burst batch exceeds %u bytes - dropped\n", (unsigned)sizeof(burstJson));
+    channel.lastBurstPublish = millis();
+    return;
+  }
+  char topic[64];
+  snprintf(topic, sizeof(topic), "%s/burst/samples", channel.topicBase);
+  mqttClient.publish(topic, payload, false);
+  channel.lastBurstPublish = millis();
+}
 
-  // 9. LED Mode select
-  doc.clear();
-  doc["name"] = "Bluetti LED Mode";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/led_mode";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/led_mode/set";
-  doc["unique_id"] = "bluetti_eb3a_led_mode";
-  options = doc["options"].to<JsonArray>();
-  options.add("Low");
-  options.add("High");
-  options.add("SOS");
-  options.add("Off");
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/select/bluetti_eb3a/led_mode/config", buffer, true);
-  Serial.printf("[MQTT] LED Mode config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+// Конфіг discovery пишеться фрагментами прямо в сокет: PubSubClient вимагає
+// довжину до початку публікації, тож перший прохід (client == nullptr) лише
+// рахує байти, другий - відправляє ті самі фрагменти
+class DiscoveryStream {
+public:
+  explicit DiscoveryStream(PubSubClient *client) : client(client) {}
+
+  void put(const char *text) {
+    size_t n = strlen(text);
+    length += n;
+    for (size_t i = 0; i < n; i++) { // FNV-1a
+      hash = (hash ^ static_cast<uint8_t>(text[i])) * 16777619u;
+    }
+    if (client) {
+      written += client->write(reinterpret_cast<const uint8_t *>(text), n);
+    }
+  }
 
-  // 9b. Flashlight switch (simple ON/OFF alias for LED)
-  doc.clear();
-  doc["name"] = "Bluetti Flashlight";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/led_switch/state";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/led_switch/set";
-  doc["unique_id"] = "bluetti_eb3a_led_switch";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/switch/bluetti_eb3a/led_switch/config", buffer, true);
-  Serial.printf("[MQTT] LED Switch config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+  size_t length = 0;
+  size_t written = 0;
+  uint32_t hash = 2166136261u;
+
+private:
+  PubSubClient *client;
+};
+
+// Незмінні частини JSON - константи у flash; змінні - поля таблиці та каналу
+static void writeEntityConfig(DiscoveryStream &out, const DiscoveryEntity &entity,
+                              const MqttDeviceChannel &channel, const char *model, bool json) {
+  out.put("{\"name\":\"");
+  out.put(entity.name);
+  if (entity.stateTopic) {
+    out.put("\",\"state_topic\":\"");
+    out.put(channel.topicBase);
+    if (json) {
+      // Усі сутності читають один документ; батарея показує його цілком як атрибути
+      out.put("/state\",\"value_template\":\"{{ value_json.");
+      out.put(entity.stateKey);
+      out.put(" }}");
+      if (entity.attributes) {
+        out.put("\",\"json_attributes_topic\":\"");
+        out.put(channel.topicBase);
+        out.put("/state");
+      }
+    } else {
+      out.put("/");
+      out.put(entity.stateTopic);
+    }
+  }
+  if (entity.commandTopic) {
+    out.put("\",\"command_topic\":\"");
+    out.put(channel.topicBase);
+    out.put("/");
+    out.put(entity.commandTopic);
+  }
+  if (entity.unit) {
+    out.put("\",\"unit_of_measurement\":\"");
+    out.put(entity.unit);
+  }
+  if (entity.deviceClass) {
+    out.put("\",\"device_class\":\"");
+    out.put(entity.deviceClass);
+  }
+  if (entity.stateClass) {
+    out.put("\",\"state_class\":\"");
+    out.put(entity.stateClass);
+  }
+  out.put("\",\"unique_id\":\"");
+  out.put(channel.deviceId);
+  out.put("_");
+  out.put(entity.uniqueId);
+  out.put("\"");
+  if (entity.options[0]) {
+    out.put(",\"options\":[");
+    bool first = true;
+    for (const char *option : entity.options) {
+      if (option) {
+        out.put(first ? "\"" : ",\"");
+        out.put(option);
+        out.put("\"");
+        first = false;
+      }
+    }
+    out.put("]");
+  }
+  // Device info - спільний для всіх сутностей
+  out.put(",\"device\":{\"identifiers\":[\"");
+  out.put(channel.deviceId);
+  out.put("\"],\"manufacturer\":\"Bluetti\",\"model\":\"");
+  out.put(model);
+  out.put("\",\"name\":\"");
+  out.put(channel.deviceName);
+  out.put("\"}}");
+}
 
-  // 10. ECO Shutdown select
-  doc.clear();
-  doc["name"] = "Bluetti ECO Shutdown";
-  doc["state_topic"] = "homeassistant/bluetti/eb3a/eco_shutdown";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/eco_shutdown/set";
-  doc["unique_id"] = "bluetti_eb3a_eco_shutdown";
-  options = doc["options"].to<JsonArray>();
-  options.add("1h");
-  options.add("2h");
-  options.add("3h");
-  options.add("4h");
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/select/bluetti_eb3a/eco_shutdown/config", buffer, true);
-  Serial.printf("[MQTT] ECO Shutdown config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
-  yield();
+uint32_t MQTTHandler::discoveryHash(const MqttDeviceChannel &channel) const {
+  // Усе, що потрапляє в retained конфіги, плюс брокер: інший брокер їх не має
+  DiscoveryStream hasher(nullptr);
+  char port[8];
+  snprintf(port, sizeof(port), ":%u", serverPort);
+  hasher.put(serverHost.c_str());
+  hasher.put(port);
+  hasher.put(channel.deviceId);
+  bool json = appliedMode == MqttStateMode::JSON;
+  for (const DiscoveryEntity &entity : DISCOVERY_ENTITIES) {
+    hasher.put("\n");
+    hasher.put(entity.component);
+    hasher.put(entity.object);
+    if (channel.profile->hasEntity(entity.entity)) {
+      writeEntityConfig(hasher, entity, channel, channel.profile->model, json);
+    }
+  }
+  return hasher.hash;
+}
 
-  // 11. Power Off button
-  doc.clear();
-  doc["name"] = "Bluetti Power Off";
-  doc["command_topic"] = "homeassistant/bluetti/eb3a/power_off";
-  doc["unique_id"] = "bluetti_eb3a_power_off";
-  doc["device_class"] = "restart";
-  device = doc["device"].to<JsonObject>();
-  device["identifiers"][0] = "bluetti_eb3a";
-  device["manufacturer"] = "Bluetti";
-  device["model"] = "EB3A";
-  device["name"] = "Bluetti EB3A";
-  serializeJson(doc, buffer);
-  result = mqttClient.publish("homeassistant/button/bluetti_eb3a/power_off/config", buffer, true);
-  Serial.printf("[MQTT] Power Off config: %s (size: %d)\n", result ? "✅" : "❌", strlen(buffer));
+void MQTTHandler::syncDiscovery(MqttDeviceChannel &channel, bool force) {
+  uint32_t hash = discoveryHash(channel);
+  if (!force && hash == loadDiscoveryHash(channel.index)) {
+    discoverySkipped.fetch_add(1, std::memory_order_relaxed);
+    Serial.printf("[MQTT] Discovery for %s unchanged (hash %08x), broker keeps retained configs\n",
+                  channel.deviceName, (unsigned)hash);
+    return;
+  }
+  // Частково опублікований набір не вважається збереженим - наступного разу повторимо
+  bool published = publishDiscovery(channel);
+  saveDiscoveryHash(channel.index, published ? hash : 0);
+}
+
+bool MQTTHandler::publishDiscovery(MqttDeviceChannel &channel) {
+  Serial.printf("[MQTT] 📡 Publishing discovery configuration for %s...\n", channel.deviceName);
+
+  char topic[96];
+  const DeviceProfile *profile = channel.profile;
+  const char *deviceId = channel.deviceId;
+  bool json = appliedMode == MqttStateMode::JSON;
+  size_t published = 0;
+  size_t bytes = 0;
+  bool complete = true;
+  // Вартість усього burst: час і найбільше падіння вільної heap відносно старту
+  unsigned long started = micros();
+  uint32_t freeBefore = ESP.getFreeHeap();
+  uint32_t freeLowest = freeBefore;
+
+  for (const DiscoveryEntity &entity : DISCOVERY_ENTITIES) {
+    snprintf(topic, sizeof(topic), "homeassistant/%s/%s/%s/config", entity.component, deviceId, entity.object);
+    if (!profile->hasEntity(entity.entity)) {
+      // Модель цього не має - прибираємо з HA
+      complete = mqttClient.publish(topic, "", true) && complete;
+      continue;
+    }
+
+    DiscoveryStream measure(nullptr);
+    writeEntityConfig(measure, entity, channel, profile->model, json);
+    bool result = mqttClient.beginPublish(topic, measure.length, true);
+    if (result) {
+      DiscoveryStream stream(&mqttClient);
+      writeEntityConfig(stream, entity, channel, profile->model, json);
+      result = mqttClient.endPublish() && stream.written == measure.length;
+    }
+    Serial.printf("[MQTT] %s config: %s (size: %u)\n", entity.name, result ? "✅" : "❌",
+                  (unsigned)measure.length);
+    if (result) {
+      published++;
+      bytes += measure.length;
+    } else {
+      complete = false;
+    }
+    uint32_t freeNow = ESP.getFreeHeap();
+    if (freeNow < freeLowest) {
+      freeLowest = freeNow;
+    }
+    yield();
+  }
+
+  // Temperature - прибрано (EB3A не передає температуру через BLE)
+  snprintf(topic, sizeof(topic), "homeassistant/sensor/%s/temperature/config", deviceId);
+  mqttClient.publish(topic, "", true);
   yield();
 
-  Serial.println("[MQTT] ✅ Published 12 entities to Home Assistant");
+  uint32_t elapsed = micros() - started;
+  discoveryMicros.store(elapsed, std::memory_order_relaxed);
+  discoveryHeapPeak.store(freeBefore - freeLowest, std::memory_order_relaxed);
+  discoveryBursts.fetch_add(1, std::memory_order_relaxed);
+  Serial.printf("[MQTT] ✅ Published %u entities to Home Assistant (%u bytes, %lu us, heap peak %u bytes)\n",
+                published, (unsigned)bytes, (unsigned long)elapsed, (unsigned)(freeBefore - freeLowest));
+  return complete;
+}
+
+void MQTTHandler::clearDiscovery(const MqttDeviceChannel &channel) {
+  char topic[96];
+  for (const DiscoveryEntity &entity : DISCOVERY_ENTITIES) {
+    snprintf(topic, sizeof(topic), "homeassistant/%s/%s/%s/config", entity.component, channel.deviceId,
+             entity.object);
+    mqttClient.publish(topic, "", true);
+    yield();
+  }
 }
 
 void MQTTHandler::onMessage(char *topic, byte *payload, unsigned int length) {
@@ -510,12 +855,39 @@ void MQTTHandler::onMessage(char *topic, byte *payload, unsigned int length) {
 
   Serial.printf("[MQTT] RX topic=%s payload=%s\n", topic, message.c_str());
 
-  // Команди від Home Assistant
-  if (strcmp(topic, "homeassistant/bluetti/eb3a/ac_output/set") == 0) {
-    bool ok = bluetti->setACOutput(message == "ON");
-    Serial.printf("[MQTT] AC Output command: %s\n", message.c_str());
-    if (ok) publishStatus();
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/charging_speed/set") == 0) {
+  if (strcmp(topic, HA_STATUS_TOPIC) == 0) {
+    if (message != "online") {
+      return;
+    }
+    if (millis() - connectedAt < HA_BIRTH_GRACE_MS) {
+      Serial.println("[MQTT] Retained Home Assistant birth message (ignored)");
+      return;
+    }
+    // Публікуємо з loop(): payload вказує в буфер клієнта
+    Serial.println("[MQTT] Home Assistant restarted, republishing discovery");
+    discoveryForced.store(true, std::memory_order_relaxed);
+    discoveryRequested.store(true, std::memory_order_relaxed);
+    return;
+  }
+
+  // Команди від Home Assistant - топіки поточного профілю одного з пристроїв
+  const char *command = nullptr;
+  BluettiDevice *bluetti = nullptr;
+  for (const MqttDeviceChannel &channel : channels) {
+    command = commandSuffix(channel, topic);
+    if (command) {
+      bluetti = channel.device;
+      break;
+    }
+  }
+  if (!command) {
+    Serial.println("[MQTT] Topic of another device (ignored)");
+    return;
+  }
+  if (strcmp(command, "ac_output/set") == 0) {
+    WriteTicket ticket = bluetti->setACOutput(message == "ON");
+    Serial.printf("[MQTT] AC Output command: %s (ticket %u)\n", message.c_str(), ticket);
+  } else if (strcmp(command, "charging_speed/set") == 0) {
     uint8_t speed = 0; // Standard
     if (message == "Silent" || message == "silent" || message == "1") {
       speed = 1;
@@ -523,57 +895,56 @@ void MQTTHandler::onMessage(char *topic, byte *payload, unsigned int length) {
       speed = 2;
     }
     Serial.printf("[MQTT] Charging speed command: %s -> %d\n", message.c_str(), speed);
-    if (bluetti->setChargingSpeed(speed)) {
-      publishStatus();
-    }
+    bluetti->setChargingSpeed(speed);
     return;
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/eco_mode/set") == 0) {
-    if (bluetti->setEcoMode(message == "ON")) {
-      publishStatus();
-    }
+  } else if (strcmp(command, "eco_mode/set") == 0) {
+    bluetti->setEcoMode(message == "ON");
     Serial.printf("[MQTT] ECO mode command: %s\n", message.c_str());
     return;
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/power_lifting/set") == 0) {
-    if (bluetti->setPowerLifting(message == "ON")) {
-      publishStatus();
-    }
+  } else if (strcmp(command, "power_lifting/set") == 0) {
+    bluetti->setPowerLifting(message == "ON");
     Serial.printf("[MQTT] Power Lifting command: %s\n", message.c_str());
     return;
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/led_mode/set") == 0) {
+  } else if (strcmp(command, "led_mode/set") == 0) {
     uint8_t mode = 4; // Default Off
     if (message == "Low") mode = 1;
     else if (message == "High") mode = 2;
     else if (message == "SOS") mode = 3;
-    if (bluetti->setLedMode(mode)) {
-      publishStatus();
-    }
+    bluetti->setLedMode(mode);
     Serial.printf("[MQTT] LED mode command: %s -> %d\n", message.c_str(), mode);
     return;
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/led_switch/set") == 0) {
+  } else if (strcmp(command, "led_switch/set") == 0) {
     // Convenience ON/OFF control for flashlight
     uint8_t mode = 4; // Off
     if (message == "ON" || message == "On" || message == "on" || message == "1") {
       mode = 2; // High by default
     }
-    if (bluetti->setLedMode(mode)) {
-      publishStatus();
-    }
+    bluetti->setLedMode(mode);
     Serial.printf("[MQTT] LED switch command: %s -> mode %d\n", message.c_str(), mode);
     return;
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/eco_shutdown/set") == 0) {
+  } else if (strcmp(command, "eco_shutdown/set") == 0) {
     uint8_t hours = 1; // Default 1h
     if (message == "2h") hours = 2;
     else if (message == "3h") hours = 3;
     else if (message == "4h") hours = 4;
-    if (bluetti->setEcoShutdown(hours)) {
-      publishStatus();
-    }
+    bluetti->setEcoShutdown(hours);
     Serial.printf("[MQTT] ECO shutdown command: %s -> %dh\n", message.c_str(), hours);
     return;
-  } else if (strcmp(topic, "homeassistant/bluetti/eb3a/power_off") == 0) {
+  } else if (strcmp(command, "power_off") == 0) {
     bluetti->powerOff();
     Serial.println("[MQTT] Power Off command");
     return;
+  } else if (strcmp(command, "burst/set") == 0) {
+    // Секунди (1..600), "ON" - тривалість за замовчуванням, "0"/"OFF" - зупинити
+    uint16_t seconds = 0;
+    if (message == "ON" || message == "on") {
+      seconds = BURST_DEFAULT_SECONDS;
+    } else if (message != "OFF" && message != "off") {
+      seconds = message.toInt();
+    }
+    bool ok = bluetti->startBurst(seconds);
+    Serial.printf("[MQTT] Burst command: %s -> %us %s\n", message.c_str(), seconds, ok ? "✅" : "❌");
+    return;
   }
 
   Serial.println("[MQTT] Unhandled topic (ignored)");
@@ -588,3 +959,15 @@ void MQTTHandler::callbackThunk(char *topic, byte *payload,
     instance->onMessage(topic, payload, length);
   }
 }
+
+void MQTTHandler::writeResultThunk(const WriteResult &result, void *context) {
+  // Викликається з drainRecords() у loop() - тій самій задачі, що й MQTT
+  MqttDeviceChannel &channel = *static_cast<MqttDeviceChannel *>(context);
+  Serial.printf("[MQTT] Device #%u write ticket %u (0x%04X = %u): %s after %lums\n", channel.index,
+                result.ticket, result.address, result.value, writeOutcomeName(result.outcome),
+                result.latencyMs);
+  channel.writeSettled = true;
+  if (result.outcome != WriteOutcome::CONFIRMED) {
+    channel.writeFailed = true;
+  }
+}
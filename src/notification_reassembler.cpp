@@ -0,0 +1,90 @@
+#include "notification_reassembler.h"
+
+void NotificationReassembler::push(const uint8_t *data, size_t length,
+                                   unsigned long now) {
+  // Хвіст попереднього кадру так і не прийшов - починаємо з чистого буфера
+  if (count > 0 && now - lastFragmentAt > STALE_FRAGMENT_MS) {
+    drop(count);
+  }
+  lastFragmentAt = now;
+
+  // Переповнення: відкидаємо найстаріші байти, щоб вмістити новий фрагмент
+  if (length > CAPACITY) {
+    bytesDropped += length - CAPACITY;
+    data += length - CAPACITY;
+    length = CAPACITY;
+  }
+  if (count + length > CAPACITY) {
+    drop(count + length - CAPACITY);
+  }
+
+  size_t tail = (head + count) % CAPACITY;
+  for (size_t i = 0; i < length; i++) {
+    buffer[tail] = data[i];
+    buffer[tail + CAPACITY] = data[i];
+    tail = (tail + 1) % CAPACITY;
+  }
+  count += length;
+  if (fragmentsInFrame < 0xFF) {
+    fragmentsInFrame++;
+  }
+}
+
+bool NotificationReassembler::nextFrame(ModbusFrameView &frame) {
+  while (count > 0) {
+    const uint8_t *start = buffer + head;
+    size_t frameLength = modbusFrameLength(start, count);
+    if (frameLength == 0 || (frameLength <= CAPACITY && frameLength > count)) {
+      return false; // Чекаємо наступний фрагмент
+    }
+    if (frameLength == SIZE_MAX || frameLength > CAPACITY) {
+      drop(1); // Ресинхронізація: шукаємо початок кадру
+      continue;
+    }
+
+    ModbusFrameError error = parseModbusFrame(start, frameLength, frame);
+    if (error != ModbusFrameError::NONE) {
+      // Помилковий початок або пошкоджений кадр - зсуваємося на байт
+      rejected[static_cast<size_t>(error)]++;
+      drop(1);
+      continue;
+    }
+
+    framesAssembled++;
+    if (fragmentsInFrame > 1) {
+      fragmentedFrames++;
+    }
+    lastFrameFragments = fragmentsInFrame;
+    fragmentsInFrame = 0;
+
+    // Байти лишаються в буфері до наступного push(), тож view дійсний
+    head = (head + frameLength) % CAPACITY;
+    count -= frameLength;
+    return true;
+  }
+  fragmentsInFrame = 0;
+  return false;
+}
+
+uint32_t NotificationReassembler::getRejectedTotal() const {
+  uint32_t total = 0;
+  for (size_t i = 0; i < MODBUS_FRAME_ERROR_COUNT; i++) {
+    total += rejected[i];
+  }
+  return total;
+}
+
+void NotificationReassembler::reset() {
+  head = 0;
+  count = 0;
+  fragmentsInFrame = 0;
+}
+
+void NotificationReassembler::drop(size_t bytes) {
+  if (bytes > count) {
+    bytes = count;
+  }
+  head = (head + bytes) % CAPACITY;
+  count -= bytes;
+  bytesDropped += bytes;
+}
@@ -0,0 +1,55 @@
+#include "poll_planner.h"
+
+// Списки регістрів короткі (одиниці), тож сортуємо вставками на стеку
+static constexpr size_t MAX_PLANNED_REGISTERS = 32;
+
+size_t planRegisterReads(const uint16_t *registers, size_t count,
+                         uint16_t maxRegistersPerRead, uint16_t maxGap,
+                         PollRange *ranges, size_t maxRanges) {
+  if (count == 0 || maxRanges == 0) {
+    return 0;
+  }
+  if (count > MAX_PLANNED_REGISTERS) {
+    count = MAX_PLANNED_REGISTERS;
+  }
+  if (maxRegistersPerRead == 0) {
+    maxRegistersPerRead = 1;
+  }
+  if (maxRegistersPerRead > MODBUS_MAX_READ_REGISTERS) {
+    maxRegistersPerRead = MODBUS_MAX_READ_REGISTERS;
+  }
+
+  uint16_t sorted[MAX_PLANNED_REGISTERS];
+  for (size_t i = 0; i < count; i++) {
+    uint16_t reg = registers[i];
+    size_t pos = i;
+    while (pos > 0 && sorted[pos - 1] > reg) {
+      sorted[pos] = sorted[pos - 1];
+      pos--;
+    }
+    sorted[pos] = reg;
+  }
+
+  size_t used = 0;
+  ranges[0].start = sorted[0];
+  ranges[0].count = 1;
+  for (size_t i = 1; i < count; i++) {
+    PollRange &range = ranges[used];
+    uint32_t end = (uint32_t)range.start + range.count; // Перший регістр після діапазону
+    if (sorted[i] < end) {
+      continue; // Дублікат
+    }
+    uint32_t extended = (uint32_t)sorted[i] - range.start + 1;
+    if (sorted[i] - end <= maxGap && extended <= maxRegistersPerRead) {
+      range.count = (uint16_t)extended;
+      continue;
+    }
+    if (used + 1 == maxRanges) {
+      break; // Решта не вміщується - опитається в наступному циклі
+    }
+    used++;
+    ranges[used].start = sorted[i];
+    ranges[used].count = 1;
+  }
+  return used + 1;
+}
@@ -0,0 +1,79 @@
+#include "register_cache.h"
+
+const CachedRegister *RegisterCacheTable::find(uint16_t address) const {
+  size_t low = 0;
+  size_t high = count < REGISTER_CACHE_CAPACITY ? count : REGISTER_CACHE_CAPACITY;
+  while (low < high) {
+    size_t mid = (low + high) / 2;
+    if (entries[mid].address < address) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+  return low < count && entries[low].address == address ? &entries[low] : nullptr;
+}
+
+void RegisterCache::store(uint16_t address, uint16_t value, uint32_t ttlMs, unsigned long now) {
+  CachedRegister *entry = const_cast<CachedRegister *>(working.find(address));
+  if (!entry) {
+    if (working.count >= REGISTER_CACHE_CAPACITY) {
+      dropped++;
+      return;
+    }
+    // Вставка зі зсувом: нові адреси з'являються лише на перших відповідях
+    size_t position = working.count;
+    while (position > 0 && working.entries[position - 1].address > address) {
+      working.entries[position] = working.entries[position - 1];
+      position--;
+    }
+    working.count++;
+    entry = &working.entries[position];
+    entry->address = address;
+  }
+  entry->value = value;
+  entry->ttlMs = ttlMs;
+  entry->capturedAt = now;
+  changed = true;
+}
+
+void RegisterCache::publish() {
+  if (changed) {
+    changed = false;
+    published.write(working);
+  }
+}
+
+CacheLookup RegisterCache::lookup(const uint16_t *addresses, size_t count, unsigned long now,
+                                  CachedRegister *out) const {
+  RegisterCacheTable table;
+  published.read(table);
+
+  CacheLookup worst = CacheLookup::HIT;
+  for (size_t i = 0; i < count; i++) {
+    const CachedRegister *entry = table.find(addresses[i]);
+    CacheLookup result;
+    if (!entry) {
+      out[i] = {addresses[i], 0, 0, 0};
+      result = CacheLookup::MISS;
+      misses.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      out[i] = *entry;
+      result = now - entry->capturedAt > entry->ttlMs ? CacheLookup::STALE : CacheLookup::HIT;
+      (result == CacheLookup::HIT ? hits : stale).fetch_add(1, std::memory_order_relaxed);
+    }
+    if (result > worst) {
+      worst = result;
+    }
+  }
+  return worst;
+}
+
+const char *cacheLookupName(CacheLookup result) {
+  switch (result) {
+    case CacheLookup::HIT:   return "hit";
+    case CacheLookup::STALE: return "stale";
+    case CacheLookup::MISS:  return "miss";
+  }
+  return "unknown";
+}
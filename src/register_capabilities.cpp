@@ -0,0 +1,212 @@
+#include "register_capabilities.h"
+#include <Arduino.h>
+#include <Preferences.h>
+#include <cctype>
+#include <cstring>
+
+static constexpr char REGISTER_CAPS_NAMESPACE[] = "reg_caps";
+
+// Ключ NVS - назва моделі лише з літер і цифр (EB3A, AC200...)
+static bool modelToKey(const char *model, char (&key)[REGISTER_CAPS_MODEL_SIZE]) {
+  size_t length = 0;
+  for (const char *p = model; p && *p && length < sizeof(key) - 1; p++) {
+    if (isalnum((unsigned char)*p)) {
+      key[length++] = (char)toupper((unsigned char)*p);
+    }
+  }
+  key[length] = '\0';
+  return length > 0;
+}
+
+static bool loadCapabilities(const char *key, RegisterCapabilityTable &out) {
+  Preferences prefs;
+  prefs.begin(REGISTER_CAPS_NAMESPACE, true); // read-only
+  RegisterCapabilityTable table = {};
+  size_t length = 0;
+  if (prefs.isKey(key) && prefs.getBytesLength(key) == sizeof(table)) {
+    length = prefs.getBytes(key, &table, sizeof(table));
+  }
+  prefs.end();
+
+  if (length != sizeof(table) || table.version != REGISTER_CAPS_VERSION ||
+      table.count > REGISTER_CAPS_CAPACITY) {
+    return false;
+  }
+  out = table;
+  return true;
+}
+
+bool RegisterCapabilities::select(const char *model) {
+  char key[REGISTER_CAPS_MODEL_SIZE];
+  if (!modelToKey(model, key) || strcmp(key, working.model) == 0) {
+    return false;
+  }
+
+  if (working.model[0] != '\0') {
+    // Інша модель за тією ж адресою - попередні знання до неї не стосуються
+    saveIfDirty();
+    working = {};
+    dirty = false;
+  }
+
+  RegisterCapabilityTable learned = working; // Дізнане, поки модель була невідома
+  RegisterCapabilityTable stored = {};
+  if (loadCapabilities(key, stored)) {
+    working = stored;
+    Serial.printf("[Caps] Loaded %u register capabilities for %s\n", stored.count, key);
+  } else {
+    working = {};
+  }
+  working.version = REGISTER_CAPS_VERSION;
+  memcpy(working.model, key, sizeof(working.model));
+
+  for (uint8_t i = 0; i < learned.count; i++) {
+    const RegisterCapability &entry = learned.entries[i];
+    if (entry.read != RegisterSupport::UNKNOWN) {
+      markRead(entry.address, entry.read);
+    }
+    if (entry.write != RegisterSupport::UNKNOWN) {
+      markWrite(entry.address, entry.write);
+    }
+    if (entry.writeFallback != 0) {
+      setWriteFallback(entry.address, entry.writeFallback);
+    }
+  }
+  if (learned.rangeReadsRejected) {
+    rejectRangeReads();
+  }
+  published.write(working);
+  return true;
+}
+
+RegisterSupport RegisterCapabilities::readSupport(uint16_t address) const {
+  const RegisterCapability *entry = find(address);
+  return entry ? entry->read : RegisterSupport::UNKNOWN;
+}
+
+RegisterSupport RegisterCapabilities::writeSupport(uint16_t address) const {
+  const RegisterCapability *entry = find(address);
+  return entry ? entry->write : RegisterSupport::UNKNOWN;
+}
+
+uint16_t RegisterCapabilities::writeFallback(uint16_t address) const {
+  const RegisterCapability *entry = find(address);
+  return entry ? entry->writeFallback : 0;
+}
+
+bool RegisterCapabilities::markRead(uint16_t address, RegisterSupport support) {
+  if (readSupport(address) == support) {
+    return false;
+  }
+  RegisterCapability *entry = findOrAdd(address);
+  if (!entry) {
+    return false;
+  }
+  entry->read = support;
+  changed();
+  return true;
+}
+
+bool RegisterCapabilities::markWrite(uint16_t address, RegisterSupport support) {
+  if (writeSupport(address) == support) {
+    return false;
+  }
+  RegisterCapability *entry = findOrAdd(address);
+  if (!entry) {
+    return false;
+  }
+  entry->write = support;
+  changed();
+  return true;
+}
+
+bool RegisterCapabilities::setWriteFallback(uint16_t address, uint16_t fallback) {
+  if (writeFallback(address) == fallback) {
+    return false;
+  }
+  RegisterCapability *entry = findOrAdd(address);
+  if (!entry) {
+    return false;
+  }
+  entry->writeFallback = fallback;
+  changed();
+  return true;
+}
+
+bool RegisterCapabilities::rejectRangeReads() {
+  if (working.rangeReadsRejected) {
+    return false;
+  }
+  working.rangeReadsRejected = true;
+  changed();
+  return true;
+}
+
+bool RegisterCapabilities::saveIfDirty() {
+  if (!dirty || working.model[0] == '\0') {
+    return false;
+  }
+  Preferences prefs;
+  prefs.begin(REGISTER_CAPS_NAMESPACE, false); // read-write
+  size_t written = prefs.putBytes(working.model, &working, sizeof(working));
+  prefs.end();
+  dirty = written != sizeof(working);
+  if (!dirty) {
+    Serial.printf("[Caps] Saved %u register capabilities for %s\n", working.count, working.model);
+  }
+  return !dirty;
+}
+
+void RegisterCapabilities::reset() {
+  Preferences prefs;
+  prefs.begin(REGISTER_CAPS_NAMESPACE, false); // read-write
+  prefs.clear();
+  prefs.end();
+
+  char model[REGISTER_CAPS_MODEL_SIZE];
+  memcpy(model, working.model, sizeof(model));
+  working = {};
+  working.version = REGISTER_CAPS_VERSION;
+  memcpy(working.model, model, sizeof(working.model));
+  dirty = false;
+  published.write(working);
+  Serial.println("[Caps] Register capability cache cleared");
+}
+
+RegisterCapability *RegisterCapabilities::find(uint16_t address) {
+  for (uint8_t i = 0; i < working.count; i++) {
+    if (working.entries[i].address == address) {
+      return &working.entries[i];
+    }
+  }
+  return nullptr;
+}
+
+const RegisterCapability *RegisterCapabilities::find(uint16_t address) const {
+  return const_cast<RegisterCapabilities *>(this)->find(address);
+}
+
+RegisterCapability *RegisterCapabilities::findOrAdd(uint16_t address) {
+  RegisterCapability *entry = find(address);
+  if (entry || working.count >= REGISTER_CAPS_CAPACITY) {
+    return entry; // Повна таблиця: нове знання не зберігаємо, поведінка як без кешу
+  }
+  entry = &working.entries[working.count++];
+  *entry = {address, RegisterSupport::UNKNOWN, RegisterSupport::UNKNOWN, 0};
+  return entry;
+}
+
+void RegisterCapabilities::changed() {
+  working.version = REGISTER_CAPS_VERSION;
+  dirty = true;
+  published.write(working);
+}
+
+const char *registerSupportName(RegisterSupport support) {
+  switch (support) {
+    case RegisterSupport::UNKNOWN:   return "unknown";
+    case RegisterSupport::SUPPORTED: return "supported";
+    case RegisterSupport::REJECTED:  return "rejected";
+  }
+  return "unknown";
+}
@@ -0,0 +1,74 @@
+#include "register_map.h"
+
+// Чи проходить сире значення межі запису (ASCII - побайтово)
+static bool registerInRange(const RegisterDescriptor &descriptor, uint16_t raw) {
+  if (descriptor.type == RegisterType::ASCII || descriptor.type == RegisterType::ASCII_TAIL) {
+    // Кожен символ окремо: 0x3A7F лежить між "00" та "ZZ", але 0x7F - не символ моделі
+    uint8_t high = raw >> 8;
+    uint8_t low = raw & 0xFF;
+    return high >= (descriptor.minRaw >> 8) && high <= (descriptor.maxRaw >> 8) &&
+           low >= (descriptor.minRaw & 0xFF) && low <= (descriptor.maxRaw & 0xFF);
+  }
+  return raw >= descriptor.minRaw && raw <= descriptor.maxRaw;
+}
+
+void storeRegister(const RegisterDescriptor &descriptor, uint16_t raw, SystemStatus &out) {
+  if (descriptor.type == RegisterType::ASCII || descriptor.type == RegisterType::ASCII_TAIL) {
+    size_t pos = descriptor.index;
+    if (pos + 2 < sizeof(out.modelName)) {
+      out.modelName[pos] = (char)((raw >> 8) & 0xFF);
+      out.modelName[pos + 1] = (char)(raw & 0xFF);
+    }
+    return;
+  }
+
+  bool flag = (raw == 1);
+  int32_t scaled = ((int32_t)raw + descriptor.offset) / descriptor.divisor;
+
+  switch (descriptor.field) {
+    case StatusField::MODEL_NAME:
+      break; // Лише ASCII
+    case StatusField::BATTERY_LEVEL:
+      out.batteryLevel = scaled > 100 ? 100 : (uint8_t)scaled;
+      out.batteryRaw = raw;
+      break;
+    case StatusField::BATTERY_VOLTAGE: out.batteryVoltage = (uint16_t)scaled; break;
+    case StatusField::TEMPERATURE:     out.temperature = (uint16_t)scaled; break;
+    case StatusField::DC_INPUT_POWER:  out.dcInputPower = scaled; break;
+    case StatusField::AC_INPUT_POWER:  out.acInputPower = scaled; break;
+    case StatusField::AC_OUTPUT_POWER: out.acPower = scaled; break;
+    case StatusField::DC_OUTPUT_POWER: out.dcPower = scaled; break;
+    case StatusField::MAX_DC_LIMIT:    out.maxDcLimit = (uint16_t)scaled; break;
+    case StatusField::AC_OUTPUT_STATE: out.acOutputState = flag; break;
+    case StatusField::DC_OUTPUT_STATE: out.dcOutputState = flag; break;
+  }
+}
+
+uint32_t decodeRegisterBlock(const RegisterDescriptor *map, size_t mapSize, uint16_t baseAddress,
+                             const uint8_t *payload, uint16_t registerCount, SystemStatus &out) {
+  uint32_t decoded = 0;
+  bool asciiAccepted = false; // Останній ASCII-регістр цього проходу пройшов перевірку
+  uint16_t asciiAddress = 0;
+  for (size_t i = 0; i < mapSize; i++) {
+    const RegisterDescriptor &descriptor = map[i];
+    uint16_t index = descriptor.address - baseAddress;
+    if (descriptor.address < baseAddress || index >= registerCount) {
+      continue;
+    }
+    if (descriptor.type == RegisterType::ASCII_TAIL &&
+        !(asciiAccepted && asciiAddress + 1 == descriptor.address)) {
+      continue; // Хвіст назви без своєї голови - не чіпаємо вже прийняту назву
+    }
+    uint16_t raw = (payload[index * 2] << 8) | payload[index * 2 + 1];
+    if (!registerInRange(descriptor, raw)) {
+      continue;
+    }
+    storeRegister(descriptor, raw, out);
+    decoded |= statusFieldBit(descriptor.field);
+    if (descriptor.type == RegisterType::ASCII) {
+      asciiAccepted = true;
+      asciiAddress = descriptor.address;
+    }
+  }
+  return decoded;
+}
@@ -0,0 +1,42 @@
+#include "status_changes.h"
+#include <cstring>
+
+uint16_t diffBluettiRecords(const BluettiRecord &prev, const BluettiRecord &next) {
+  uint16_t dirty = 0;
+  if (prev.bluettiConnected != next.bluettiConnected) {
+    dirty |= statusBit(StatusGroup::CONNECTION);
+  }
+  if (prev.batteryLevel != next.batteryLevel || prev.batteryRaw != next.batteryRaw ||
+      prev.batteryVoltage != next.batteryVoltage) {
+    dirty |= statusBit(StatusGroup::BATTERY);
+  }
+  if (prev.acPower != next.acPower) {
+    dirty |= statusBit(StatusGroup::AC_POWER);
+  }
+  if (prev.dcPower != next.dcPower) {
+    dirty |= statusBit(StatusGroup::DC_POWER);
+  }
+  if (prev.inputPower != next.inputPower || prev.dcInputPower != next.dcInputPower ||
+      prev.acInputPower != next.acInputPower) {
+    dirty |= statusBit(StatusGroup::INPUT_POWER);
+  }
+  if (prev.acOutputState != next.acOutputState || prev.dcOutputState != next.dcOutputState) {
+    dirty |= statusBit(StatusGroup::OUTPUT_STATES);
+  }
+  if (prev.temperature != next.temperature) {
+    dirty |= statusBit(StatusGroup::TEMPERATURE);
+  }
+  if (prev.ecoMode != next.ecoMode || prev.powerLifting != next.powerLifting ||
+      prev.ledMode != next.ledMode || prev.ecoShutdown != next.ecoShutdown ||
+      prev.chargingSpeed != next.chargingSpeed) {
+    dirty |= statusBit(StatusGroup::SETTINGS);
+  }
+  if (prev.maxDcLimit != next.maxDcLimit ||
+      memcmp(prev.modelName, next.modelName, sizeof(prev.modelName)) != 0) {
+    dirty |= statusBit(StatusGroup::DEVICE_INFO);
+  }
+  if (memcmp(prev.registers, next.registers, sizeof(prev.registers)) != 0) {
+    dirty |= statusBit(StatusGroup::REGISTERS);
+  }
+  return dirty;
+}
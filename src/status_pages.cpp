@@ -0,0 +1,24 @@
+#include "status_pages.h"
+#include <cstring>
+
+uint16_t statusPageSize(uint16_t statusCount, uint16_t perNotification, bool mtuNegotiated) {
+  if (!mtuNegotiated || perNotification == 0 || perNotification >= statusCount) {
+    return statusCount;
+  }
+  return perNotification;
+}
+
+void StatusPageAssembler::begin(uint16_t count) {
+  total = count > STATUS_REGISTER_COUNT ? STATUS_REGISTER_COUNT : count;
+  received = 0;
+}
+
+bool StatusPageAssembler::accept(uint16_t offset, const uint8_t *payload, uint16_t registers) {
+  if (total == 0 || offset != received || registers == 0 || registers > total - received) {
+    total = 0; // Розрив у послідовності - блок уже не зібрати
+    return false;
+  }
+  memcpy(data + offset * 2, payload, registers * 2);
+  received += registers;
+  return true;
+}
@@ -6,8 +6,32 @@
 #include <Preferences.h>
 #include <Update.h>
 
-WebServerManager::WebServerManager(BluettiDevice* device, SystemStatus* sharedStatus)
-    : server(80), bluetti(device), status(sharedStatus) {}
+WebServerManager::WebServerManager(BluettiManager* bluettiManager, SystemStatus* sharedStatus,
+                                   SeqLock<SystemStatus>* statusSnapshot)
+    : server(80), manager(bluettiManager), status(sharedStatus), snapshot(statusSnapshot) {}
+
+int WebServerManager::deviceIndex(AsyncWebServerRequest* request) const {
+    const AsyncWebParameter* param = nullptr;
+    if (request->hasParam("device")) {
+        param = request->getParam("device");
+    } else if (request->hasParam("device", true)) {
+        param = request->getParam("device", true);
+    }
+    if (!param) {
+        return 0;
+    }
+    char* end = nullptr;
+    unsigned long index = strtoul(param->value().c_str(), &end, 10);
+    if (param->value().isEmpty() || *end != '\0' || index >= BluettiManager::deviceCount()) {
+        return -1;
+    }
+    return (int)index;
+}
+
+BluettiDevice* WebServerManager::deviceFor(AsyncWebServerRequest* request) {
+    int index = deviceIndex(request);
+    return index < 0 ? nullptr : &manager->device(index);
+}
 
 void WebServerManager::begin() {
     // Головна сторінка
@@ -17,50 +41,195 @@ void WebServerManager::begin() {
     
     // Toggle Bluetti
     server.on("/toggle", HTTP_GET, [this](AsyncWebServerRequest *request) {
-        status->bluettiEnabled = !status->bluettiEnabled;
+        setBluettiEnabled(!status->bluettiEnabled);
         Serial.printf("Bluetti enabled set to: %s\n", status->bluettiEnabled ? "true" : "false");
-        if (!status->bluettiEnabled && bluetti && bluetti->isConnected()) {
-            bluetti->disconnect();
-        }
         request->redirect("/");
     });
     
     // Status JSON
     server.on("/status", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        int index = deviceIndex(request);
+        if (index < 0) {
+            request->send(400, "text/plain", "Unknown device");
+            return;
+        }
+        BluettiDevice* bluetti = &manager->device(index);
+        // Копія з seqlock: AsyncTCP не бачить напівоновлений стан і не блокує loop()
+        SystemStatus snap;
+        uint32_t version = snapshot->read(snap);
+        // Поля Bluetti - зі знімка обраного пристрою, системні - з основного
+        SystemStatus deviceSnap;
+        const SystemStatus* dev = &snap;
+        if (index != 0) {
+            version = manager->snapshot(index)->read(deviceSnap);
+            dev = &deviceSnap;
+        }
         JsonDocument doc;
-        doc["wifi_connected"] = status->wifiConnected;
-        doc["wifi_ip"] = status->wifiConnected ? status->wifiIp.toString() : "0.0.0.0";
-        doc["wifi_rssi"] = status->wifiRssi;
-        doc["mqtt_connected"] = status->mqttConnected;
-        doc["battery_level"] = status->batteryLevel;
-        doc["ac_power"] = status->acPower;
-        doc["dc_power"] = status->dcPower;
-        doc["input_power"] = status->inputPower;
-        doc["ac_input_power"] = status->acInputPower;
-        doc["dc_input_power"] = status->dcInputPower;
-        doc["ac_state"] = status->acOutputState;
-        doc["dc_state"] = status->dcOutputState;
-        doc["charging_speed"] = status->chargingSpeed; // 0=Standard, 1=Silent, 2=Turbo
-        doc["eco_mode"] = status->ecoMode;
-        doc["power_lifting"] = status->powerLifting;
-        doc["led_mode"] = status->ledMode; // 1=Low, 2=High, 3=SOS, 4=Off
-        doc["eco_shutdown"] = status->ecoShutdown; // 1-4 години
-        doc["battery_voltage"] = status->esp32UsbPowered ? status->esp32BatteryVoltage : status->esp32Voltage;
-        doc["battery_percent"] = status->esp32BatteryPercent;
-        doc["usb_powered"] = status->esp32UsbPowered;
-        doc["uptime"] = status->uptime;
+        doc["device"] = index;
+        doc["wifi_connected"] = snap.wifiConnected;
+        doc["wifi_ip"] = snap.wifiConnected ? snap.wifiIp.toString() : "0.0.0.0";
+        doc["wifi_rssi"] = snap.wifiRssi;
+        doc["mqtt_connected"] = snap.mqttConnected;
+        doc["battery_level"] = dev->batteryLevel;
+        doc["ac_power"] = dev->acPower;
+        doc["dc_power"] = dev->dcPower;
+        doc["input_power"] = dev->inputPower;
+        doc["ac_input_power"] = dev->acInputPower;
+        doc["dc_input_power"] = dev->dcInputPower;
+        doc["ac_state"] = dev->acOutputState;
+        doc["dc_state"] = dev->dcOutputState;
+        doc["charging_speed"] = dev->chargingSpeed; // 0=Standard, 1=Silent, 2=Turbo
+        doc["eco_mode"] = dev->ecoMode;
+        doc["power_lifting"] = dev->powerLifting;
+        doc["led_mode"] = dev->ledMode; // 1=Low, 2=High, 3=SOS, 4=Off
+        doc["eco_shutdown"] = dev->ecoShutdown; // 1-4 години
+        doc["battery_voltage"] = snap.esp32UsbPowered ? snap.esp32BatteryVoltage : snap.esp32Voltage;
+        doc["battery_percent"] = snap.esp32BatteryPercent;
+        doc["usb_powered"] = snap.esp32UsbPowered;
+        doc["uptime"] = snap.uptime;
         doc["free_heap"] = ESP.getFreeHeap();
         doc["total_heap"] = ESP.getHeapSize();
         doc["max_heap"] = ESP.getMaxAllocHeap();
         doc["cpu_freq"] = ESP.getCpuFreqMHz();
-        doc["bluetti_connected"] = status->bluettiConnected;
-        doc["bluetti_enabled"] = status->bluettiEnabled;
+        doc["bluetti_connected"] = dev->bluettiConnected;
+        doc["bluetti_enabled"] = snap.bluettiEnabled;
+        doc["snapshot_version"] = version;
+        {
+            // Вік кожного поля з кешу регістрів (-1 - ще не читали); застарілі
+            // поля BLE worker оновить наступним запитом
+            const DeviceProfile& profile = bluetti->getProfile();
+            uint16_t addresses[PROFILE_MAX_FIELD_REGISTERS];
+            CachedRegister cached[PROFILE_MAX_FIELD_REGISTERS];
+            for (size_t i = 0; i < profile.fieldCount; i++) {
+                addresses[i] = profile.fields[i].address;
+            }
+            bluetti->readRegisters(addresses, profile.fieldCount, cached);
+            unsigned long now = millis();
+            doc["model_profile"] = profile.slug;
+            JsonObject ages = doc["age_ms"].to<JsonObject>();
+            for (size_t i = 0; i < profile.fieldCount; i++) {
+                if (cached[i].ttlMs != 0) {
+                    ages[profile.fields[i].name] = now - cached[i].capturedAt;
+                } else {
+                    ages[profile.fields[i].name] = -1;
+                }
+            }
+        }
         
         String response;
         serializeJson(doc, response);
         request->send(200, "application/json", response);
     });
     
+    // Діагностика BLE-каналу
+    server.on("/diagnostics", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        BluettiDevice* bluetti = deviceFor(request);
+        JsonDocument doc;
+        {
+            // Публікація стану в MQTT (спільна для всіх пристроїв)
+            extern MQTTHandler mqtt;
+            doc["mqtt_state_published"] = mqtt.getStatePublished();
+            doc["mqtt_state_skipped"] = mqtt.getStateSkipped();
+            doc["mqtt_heartbeats"] = mqtt.getHeartbeats();
+            doc["mqtt_state_mode"] = mqttStateModeName(mqtt.getStateMode());
+            doc["mqtt_state_packets"] = mqtt.getStatePackets();
+            doc["mqtt_state_bytes"] = mqtt.getStateBytes();
+            doc["mqtt_packets_per_sec"] = mqtt.getStatePacketsPerSec();
+            doc["mqtt_bytes_per_sec"] = mqtt.getStateBytesPerSec();
+            doc["discovery_us"] = mqtt.getDiscoveryMicros();
+            doc["discovery_heap_peak"] = mqtt.getDiscoveryHeapPeak();
+            doc["discovery_bursts"] = mqtt.getDiscoveryBursts();
+            doc["discovery_skipped"] = mqtt.getDiscoverySkipped();
+            doc["mqtt_first_state_ms"] = mqtt.getFirstStateMs();
+        }
+        if (bluetti) {
+            doc["device"] = bluetti->getIndex();
+            doc["dispatch_grants"] = bluetti->getDispatchGrants();
+            BluettiDiagnostics diag = bluetti->getDiagnostics();
+            doc["ble_mtu"] = diag.mtu;
+            doc["max_registers_per_notification"] = diag.maxRegistersPerNotification;
+            doc["single_notification_mode"] = diag.singleNotificationMode;
+            doc["poll_rtt_ms"] = diag.pollRttMs;
+            doc["poll_rtt_single_ms"] = diag.pollRttSingleMs;
+            doc["poll_rtt_fragmented_ms"] = diag.pollRttFragmentedMs;
+            doc["status_polls"] = diag.statusPolls;
+            doc["status_timeouts"] = diag.statusTimeouts;
+            doc["write_ack_ms"] = diag.writeAckMs;
+            doc["write_ack_avg_ms"] = diag.writeAckAvgMs;
+            doc["write_ack_max_ms"] = diag.writeAckMaxMs;
+            doc["write_acks"] = diag.writeAcks;
+            doc["write_failures"] = diag.writeFailures;
+            const RegisterCache& cache = bluetti->getRegisterCache();
+            doc["register_cache_hits"] = cache.getHits();
+            doc["register_cache_stale"] = cache.getStale();
+            doc["register_cache_misses"] = cache.getMisses();
+            doc["register_cache_refreshes"] = cache.getRefreshes();
+            doc["register_cache_dropped"] = cache.getDropped();
+            if (diag.lastWrite.ticket != 0) {
+                JsonObject lastWrite = doc["last_write"].to<JsonObject>();
+                lastWrite["ticket"] = diag.lastWrite.ticket;
+                lastWrite["address"] = diag.lastWrite.address;
+                lastWrite["value"] = diag.lastWrite.value;
+                lastWrite["outcome"] = writeOutcomeName(diag.lastWrite.outcome);
+                lastWrite["latency_ms"] = diag.lastWrite.latencyMs;
+            }
+            doc["feature_reads_per_cycle"] = diag.featureReadsPerCycle;
+            doc["feature_round_trips_saved"] = diag.featureRoundTripsSaved;
+            doc["feature_round_trips_saved_total"] = diag.featureRoundTripsSavedTotal;
+            doc["fragments_dropped"] = diag.fragmentsDropped;
+            doc["commands_dropped"] = diag.commandsDropped;
+            doc["records_published"] = diag.recordsPublished;
+            doc["records_unchanged"] = diag.recordsUnchanged;
+            doc["poll_interval_ms"] = diag.pollIntervalMs;
+            doc["poll_min_ms"] = bluetti->getPollMinMs();
+            doc["poll_max_ms"] = bluetti->getPollMaxMs();
+            doc["poll_transients"] = diag.pollTransients;
+            // Фактична частота опитування статусу
+            doc["poll_samples_per_min"] = diag.pollAverageGapMs ? 60000.0f / diag.pollAverageGapMs : 0.0f;
+            doc["burst_active"] = diag.burstActive;
+            doc["burst_remaining_ms"] = diag.burstRemainingMs;
+            doc["burst_samples"] = diag.burstSamples;
+            doc["burst_samples_dropped"] = diag.burstSamplesDropped;
+            doc["burst_rate_hz"] = diag.burstAverageGapMs ? 1000.0f / diag.burstAverageGapMs : 0.0f;
+            doc["time_to_first_data_ms"] = diag.timeToFirstDataMs;
+            doc["last_connect_fast"] = diag.lastConnectFast;
+            doc["fast_reconnects"] = diag.fastReconnects;
+            doc["fast_reconnect_fallbacks"] = diag.fastReconnectFallbacks;
+            doc["advertisements_seen"] = diag.advertisementsSeen;
+            doc["connects_from_cache"] = diag.connectsFromCache;
+            doc["connects_after_scan"] = diag.connectsAfterScan;
+            doc["connect_median_cached_ms"] = diag.connectMedianCachedMs;
+            doc["connect_median_scan_ms"] = diag.connectMedianScanMs;
+            doc["link_state"] = linkStateName(diag.linkState);
+            doc["connect_failures"] = diag.connectFailures;
+            doc["next_retry_ms"] = diag.nextRetryMs;
+            JsonObject stateMs = doc["link_state_ms"].to<JsonObject>();
+            for (size_t i = 0; i < LINK_STATE_COUNT; i++) {
+                stateMs[linkStateName(static_cast<BluettiLinkState>(i))] = diag.stateDurationMs[i];
+            }
+            const ModbusTransactionEngine& txns = bluetti->getTransactions();
+            doc["queue_depth"] = txns.queued();
+            doc["txn_completed"] = txns.getCompleted();
+            doc["txn_timeouts"] = txns.getTimeouts();
+            doc["txn_retries"] = txns.getRetries();
+            doc["txn_dropped"] = txns.getDropped();
+            const NotificationReassembler& reasm = bluetti->getReassembler();
+            doc["frames_assembled"] = reasm.getFramesAssembled();
+            doc["frames_fragmented"] = reasm.getFragmentedFrames();
+            doc["frame_crc_errors"] = reasm.getCrcErrors();
+            doc["frames_rejected"] = reasm.getRejectedTotal();
+            JsonObject rejects = doc["frame_rejects"].to<JsonObject>();
+            for (size_t i = 1; i < MODBUS_FRAME_ERROR_COUNT; i++) {
+                ModbusFrameError reason = static_cast<ModbusFrameError>(i);
+                rejects[modbusFrameErrorName(reason)] = reasm.getRejected(reason);
+            }
+            doc["bytes_dropped"] = reasm.getBytesDropped();
+        }
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+    
     // Restart
     server.on("/restart", HTTP_GET, [this](AsyncWebServerRequest *request) {
         request->send(200, "text/plain", "Restarting...");
@@ -146,19 +315,149 @@ void WebServerManager::begin() {
     
     // Power Off
     server.on("/power_off", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        BluettiDevice* bluetti = deviceFor(request);
         if (bluetti) {
-            bluetti->powerOff();
-            request->send(200, "text/plain", "Power Off command sent");
+            WriteTicket ticket = bluetti->powerOff();
+            if (ticket) {
+                request->send(202, "text/plain", String("Power Off command sent (ticket ") + ticket + ")");
+            } else {
+                request->send(503, "text/plain", "Bluetti not connected");
+            }
+        } else {
+            request->send(400, "text/plain", "Bluetti not available");
+        }
+    });
+    
+    // Burst-вибірки потужності: seconds=1..600, 0 - зупинити. Вибірки йдуть пакетами в MQTT
+    server.on("/burst", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        BluettiDevice* bluetti = deviceFor(request);
+        if (!bluetti) {
+            request->send(400, "text/plain", "Bluetti not available");
+            return;
+        }
+        if (!request->hasParam("seconds", true)) {
+            request->send(400, "text/plain", "Missing seconds");
+            return;
+        }
+        long seconds = request->getParam("seconds", true)->value().toInt();
+        if (seconds < 0 || seconds > BURST_MAX_SECONDS) {
+            request->send(400, "text/plain", "Invalid seconds. Use 0-600");
+            return;
+        }
+        if (bluetti->startBurst((uint16_t)seconds)) {
+            request->send(200, "text/plain", seconds ? String("Burst: ") + seconds + "s" : String("Burst stopped"));
         } else {
+            request->send(500, "text/plain", "Failed to start burst (not connected?)");
+        }
+    });
+    
+    // Read-through читання регістра: address=0x0BF9 (або десяткове). Відповідь -
+    // значення з кешу та його вік; застаріле значення оновиться у фоні
+    server.on("/register", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        BluettiDevice* bluetti = deviceFor(request);
+        if (!bluetti) {
+            request->send(400, "text/plain", "Bluetti not available");
+            return;
+        }
+        if (!request->hasParam("address")) {
+            request->send(400, "text/plain", "Missing address");
+            return;
+        }
+        String addressStr = request->getParam("address")->value();
+        char* end = nullptr;
+        unsigned long address = strtoul(addressStr.c_str(), &end, 0);
+        if (addressStr.isEmpty() || *end != '\0' || address > 0xFFFF) {
+            request->send(400, "text/plain", "Invalid address");
+            return;
+        }
+        uint16_t reg = (uint16_t)address;
+        CachedRegister cached;
+        CacheLookup result = bluetti->readRegisters(&reg, 1, &cached);
+        JsonDocument doc;
+        doc["address"] = reg;
+        doc["result"] = cacheLookupName(result);
+        if (result != CacheLookup::MISS) {
+            doc["value"] = cached.value;
+            doc["age_ms"] = millis() - cached.capturedAt;
+            doc["ttl_ms"] = cached.ttlMs;
+        }
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Можливості регістрів, дізнані з exception-відповідей (для поточної моделі)
+    server.on("/capabilities", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        BluettiDevice* bluetti = deviceFor(request);
+        if (!bluetti) {
             request->send(400, "text/plain", "Bluetti not available");
+            return;
+        }
+        RegisterCapabilityTable caps;
+        bluetti->getCapabilities(caps);
+        JsonDocument doc;
+        doc["model"] = caps.model;
+        doc["range_reads_rejected"] = caps.rangeReadsRejected;
+        JsonArray registers = doc["registers"].to<JsonArray>();
+        char address[7];
+        for (uint8_t i = 0; i < caps.count && i < REGISTER_CAPS_CAPACITY; i++) {
+            const RegisterCapability& entry = caps.entries[i];
+            JsonObject item = registers.add<JsonObject>();
+            snprintf(address, sizeof(address), "0x%04X", entry.address);
+            item["address"] = address;
+            item["read"] = registerSupportName(entry.read);
+            item["write"] = registerSupportName(entry.write);
+            if (entry.writeFallback != 0) {
+                snprintf(address, sizeof(address), "0x%04X", entry.writeFallback);
+                item["write_fallback"] = address;
+            }
+        }
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    server.on("/capabilities/reset", HTTP_POST, [this](AsyncWebServerRequest *request) {
+        BluettiDevice* bluetti = deviceFor(request);
+        if (bluetti && bluetti->resetCapabilities()) {
+            request->send(200, "text/plain", "Register capability cache cleared");
+        } else {
+            request->send(500, "text/plain", "Failed to reset capability cache");
         }
     });
     
-    // Republish MQTT Discovery
+    // Усі пристрої менеджера: ціль, з'єднання, модель та частка ефіру
+    server.on("/devices", HTTP_GET, [this](AsyncWebServerRequest *request) {
+        JsonDocument doc;
+        doc["setup_grants"] = manager->getSetupGrants();
+        JsonArray devices = doc["devices"].to<JsonArray>();
+        for (size_t i = 0; i < BluettiManager::deviceCount(); i++) {
+            BluettiDevice& device = manager->device(i);
+            SystemStatus snap;
+            manager->snapshot(i)->read(snap);
+            BluettiDiagnostics diag = device.getDiagnostics();
+            JsonObject item = devices.add<JsonObject>();
+            item["device"] = i;
+            item["mac"] = device.getPeerMac();
+            item["connected"] = snap.bluettiConnected;
+            item["model"] = snap.modelName;
+            item["model_profile"] = device.getProfile().slug;
+            item["link_state"] = linkStateName(diag.linkState);
+            item["dispatch_grants"] = device.getDispatchGrants();
+            item["connect_failures"] = diag.connectFailures;
+        }
+        String response;
+        serializeJson(doc, response);
+        request->send(200, "application/json", response);
+    });
+
+    // Republish MQTT Discovery: лише змінений набір, ?force=1 - безумовно
     server.on("/republish_discovery", HTTP_GET, [this](AsyncWebServerRequest *request) {
         extern MQTTHandler mqtt;
-        mqtt.republishDiscovery();
-        request->send(200, "text/plain", "MQTT Discovery republished");
+        bool force = request->hasParam("force") && request->getParam("force")->value() == "1";
+        mqtt.republishDiscovery(force);
+        request->send(200, "text/plain", force ? "MQTT Discovery republish queued (forced)"
+                                               : "MQTT Discovery republish queued (if changed)");
     });
     
     server.begin();
@@ -175,9 +474,8 @@ bool WebServerManager::isBluettiEnabled() const {
 
 void WebServerManager::setBluettiEnabled(bool enabled) {
     status->bluettiEnabled = enabled;
-    if (!enabled && bluetti && bluetti->isConnected()) {
-        bluetti->disconnect();
-    }
+    // Вимкнення відключить пристрої вже в BLE worker
+    manager->requestEnabled(enabled);
 }
 
 String WebServerManager::buildHtml() {
@@ -354,12 +652,13 @@ String WebServerManager::buildHtml() {
 String WebServerManager::buildConfigHtml() {
     extern char mqttServer[64];
     extern char bluettiMac[18];
+    extern char extraBluettiMacs[BLUETTI_MAX_DEVICES - 1][18];
     extern char wifiSsid[64];
     extern char wifiPassword[64];
-    extern BluettiDevice bluetti;
+    BluettiDevice& bluetti = manager->device(0);
     
     String html;
-    html.reserve(2000);
+    html.reserve(3200);
     html += F("<!DOCTYPE html><html><head><meta charset='UTF-8'>");
     html += F("<meta name='viewport' content='width=device-width,initial-scale=1'>");
     html += F("<title>ESP32 Configuration</title>");
@@ -385,16 +684,58 @@ String WebServerManager::buildConfigHtml() {
     html += F("<input type='text' name='mqtt_server' value='");
     html += mqttServer;
     html += F("' placeholder='192.168.1.100'><br>");
+    {
+        extern MQTTHandler mqtt;
+        Deadband powerBand = mqtt.getDeadband(StateField::AC_POWER);
+        html += F("<label>Deadband потужності (W):</label>");
+        html += F("<input type='number' name='mqtt_power_db' value='");
+        html += String((int)powerBand.absolute);
+        html += F("' min='0' max='500' placeholder='5'>");
+        html += F("<label>Deadband потужності (%):</label>");
+        html += F("<input type='number' name='mqtt_power_pct' value='");
+        html += String((int)(powerBand.relative * 100.0f + 0.5f));
+        html += F("' min='0' max='50' placeholder='5'>");
+        html += F("<div class='hint'>Потужність публікується, лише коли зміниться більше за обидва пороги</div>");
+        html += F("<label>Heartbeat (секунди):</label>");
+        html += F("<input type='number' name='mqtt_heartbeat' value='");
+        html += String(mqtt.getHeartbeatMs() / 1000);
+        html += F("' min='30' max='3600' placeholder='300'>");
+        html += F("<div class='hint'>Як часто публікувати всі значення незалежно від змін</div>");
+        bool jsonState = mqtt.getStateMode() == MqttStateMode::JSON;
+        html += F("<label>Публікація стану:</label>");
+        html += F("<select name='mqtt_state_mode'>");
+        html += jsonState ? F("<option value='0'>") : F("<option value='0' selected>");
+        html += F("Окремий топік на поле</option>");
+        html += jsonState ? F("<option value='1' selected>") : F("<option value='1'>");
+        html += F("Один JSON-документ</option></select>");
+        html += F("<div class='hint'>JSON - один retained пакет замість десятка; discovery переопублікується</div>");
+    }
     html += F("<h2>Bluetti Settings</h2>");
     html += F("<label>Bluetti MAC Address:</label>");
     html += F("<input type='text' name='bluetti_mac' value='");
     html += bluettiMac;
     html += F("' placeholder='D1:4C:11:6B:6A:3D'><br>");
-    html += F("<label>Інтервал опитування (секунди):</label>");
+    for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+        html += F("<label>Bluetti #");
+        html += String(i + 1);
+        html += F(" MAC Address:</label>");
+        html += F("<input type='text' name='bluetti_mac_");
+        html += String(i);
+        html += F("' value='");
+        html += extraBluettiMacs[i - 1];
+        html += F("' placeholder='Не використовується'><br>");
+    }
+    html += F("<div class='hint'>Додаткові електростанції опитуються по черзі з основною</div>");
+    html += F("<label>Мінімальний інтервал опитування (секунди):</label>");
+    html += F("<input type='number' name='poll_min' value='");
+    html += String(bluetti.getPollMinMs() / 1000);
+    html += F("' min='2' max='60' placeholder='3'>");
+    html += F("<div class='hint'>Використовується одразу після зміни навантаження</div>");
+    html += F("<label>Максимальний інтервал опитування (секунди):</label>");
     html += F("<input type='number' name='update_interval' value='");
-    html += String(bluetti.getUpdateInterval() / 1000);
+    html += String(bluetti.getPollMaxMs() / 1000);
     html += F("' min='5' max='300' placeholder='20'>");
-    html += F("<div class='hint'>Рекомендовано: 20-30 сек (економить батарею)</div>");
+    html += F("<div class='hint'>Поки показники стабільні, інтервал подвоюється до цього значення (економить батарею)</div>");
     html += F("<button type='submit'>💾 Save</button>");
     html += F("<a href='/'><button type='button' class='back'>← Back</button></a>");
     html += F("</form></body></html>");
@@ -472,9 +813,10 @@ String WebServerManager::buildUpdateHtml() {
 void WebServerManager::handleSaveConfig(AsyncWebServerRequest *request) {
     extern char mqttServer[64];
     extern char bluettiMac[18];
+    extern char extraBluettiMacs[BLUETTI_MAX_DEVICES - 1][18];
     extern char wifiSsid[64];
     extern char wifiPassword[64];
-    extern BluettiDevice bluetti;
+    BluettiDevice& bluetti = manager->device(0);
     
     bool changed = false;
     String newMqtt, newMac, newSsid, newPassword;
@@ -511,22 +853,115 @@ void WebServerManager::handleSaveConfig(AsyncWebServerRequest *request) {
         newMac.trim();
         if (newMac.length() > 0 && newMac != String(bluettiMac)) {
             newMac.toCharArray(bluettiMac, sizeof(bluettiMac));
+            manager->requestTarget(0, bluettiMac);
+            changed = true;
+        }
+    }
+
+    // Додаткові пристрої: порожнє поле - пристрій вимкнено
+    bool extraMacChanged[BLUETTI_MAX_DEVICES] = {};
+    for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+        char name[16];
+        snprintf(name, sizeof(name), "bluetti_mac_%u", (unsigned)i);
+        if (!request->hasParam(name, true)) {
+            continue;
+        }
+        String extraMac = request->getParam(name, true)->value();
+        extraMac.trim();
+        if (extraMac != String(extraBluettiMacs[i - 1])) {
+            extraMac.toCharArray(extraBluettiMacs[i - 1], sizeof(extraBluettiMacs[i - 1]));
+            manager->requestTarget(i, extraBluettiMacs[i - 1]);
+            extraMacChanged[i] = true;
             changed = true;
         }
     }
     
-    // Зберігаємо інтервал опитування
+    // Зберігаємо межі інтервалу опитування
+    unsigned long pollMinMs = bluetti.getPollMinMs();
+    unsigned long pollMaxMs = bluetti.getPollMaxMs();
+    bool pollChanged = false;
+    if (request->hasParam("poll_min", true)) {
+        int minSec = request->getParam("poll_min", true)->value().toInt();
+        if (minSec >= 2 && minSec <= 60) {
+            pollMinMs = minSec * 1000UL;
+            pollChanged = true;
+        }
+    }
     if (request->hasParam("update_interval", true)) {
         int intervalSec = request->getParam("update_interval", true)->value().toInt();
         if (intervalSec >= 5 && intervalSec <= 300) {
-            unsigned long intervalMs = intervalSec * 1000;
-            bluetti.setUpdateInterval(intervalMs);
-            Preferences prefs;
-            prefs.begin("config", false);
-            prefs.putULong("update_interval", intervalMs);
-            prefs.end();
-            changed = true;
+            pollMaxMs = intervalSec * 1000UL;
+            pollChanged = true;
+        }
+    }
+    if (pollChanged) {
+        if (pollMaxMs < pollMinMs) {
+            pollMaxMs = pollMinMs;
+        }
+        for (size_t i = 0; i < BluettiManager::deviceCount(); i++) {
+            manager->device(i).setPollBounds(pollMinMs, pollMaxMs);
         }
+        Preferences prefs;
+        prefs.begin("config", false);
+        prefs.putULong("poll_min", pollMinMs);
+        prefs.putULong("update_interval", pollMaxMs);
+        prefs.end();
+        changed = true;
+    }
+    
+    // Deadband потужностей та heartbeat MQTT - діють одразу, без перезапуску
+    extern MQTTHandler mqtt;
+    Deadband powerBand = mqtt.getDeadband(StateField::AC_POWER);
+    unsigned long heartbeatMs = mqtt.getHeartbeatMs();
+    MqttStateMode stateMode = mqtt.getStateMode();
+    bool publishChanged = false;
+    if (request->hasParam("mqtt_power_db", true)) {
+        long watts = request->getParam("mqtt_power_db", true)->value().toInt();
+        if (watts >= 0 && watts <= 500 && watts != (long)powerBand.absolute) {
+            powerBand.absolute = watts;
+            publishChanged = true;
+        }
+    }
+    if (request->hasParam("mqtt_power_pct", true)) {
+        long percent = request->getParam("mqtt_power_pct", true)->value().toInt();
+        if (percent >= 0 && percent <= 50 && percent != (long)(powerBand.relative * 100.0f + 0.5f)) {
+            powerBand.relative = percent / 100.0f;
+            publishChanged = true;
+        }
+    }
+    if (request->hasParam("mqtt_heartbeat", true)) {
+        long seconds = request->getParam("mqtt_heartbeat", true)->value().toInt();
+        if (seconds >= 30 && seconds <= 3600 && seconds * 1000UL != heartbeatMs) {
+            heartbeatMs = seconds * 1000UL;
+            publishChanged = true;
+        }
+    }
+    if (request->hasParam("mqtt_state_mode", true)) {
+        MqttStateMode mode = request->getParam("mqtt_state_mode", true)->value() == "1"
+                                 ? MqttStateMode::JSON
+                                 : MqttStateMode::PER_TOPIC;
+        if (mode != stateMode) {
+            stateMode = mode;
+            publishChanged = true;
+        }
+    }
+    if (publishChanged) {
+        mqtt.setDeadband(StateField::AC_POWER, powerBand);
+        mqtt.setDeadband(StateField::DC_POWER, powerBand);
+        mqtt.setDeadband(StateField::INPUT_POWER, powerBand);
+        mqtt.setHeartbeatMs(heartbeatMs);
+        mqtt.setStateMode(stateMode);
+        Preferences prefs;
+        prefs.begin("config", false);
+        prefs.putFloat("mqtt_power_db", powerBand.absolute);
+        prefs.putFloat("mqtt_power_pct", powerBand.relative * 100.0f);
+        prefs.putULong("mqtt_heartbeat", heartbeatMs);
+        prefs.putUChar("mqtt_state_mode", static_cast<uint8_t>(stateMode));
+        prefs.end();
+        Serial.printf("MQTT publishing: power deadband %.0f W / %.0f%%, heartbeat %lu s, state %s\n",
+                      powerBand.absolute, powerBand.relative * 100.0f, heartbeatMs / 1000,
+                      mqttStateModeName(stateMode));
+        changed = true;
     }
     
     if (changed) {
@@ -536,6 +971,13 @@ void WebServerManager::handleSaveConfig(AsyncWebServerRequest *request) {
         if (newPassword.length() >= 0) prefs.putString("wifi_password", wifiPassword);
         if (newMqtt.length() > 0) prefs.putString("mqtt_server", mqttServer);
         if (newMac.length() > 0) prefs.putString("bluetti_mac", bluettiMac);
+        for (size_t i = 1; i < BLUETTI_MAX_DEVICES; i++) {
+            if (extraMacChanged[i]) {
+                char key[16];
+                snprintf(key, sizeof(key), "bluetti_mac_%u", (unsigned)i);
+                prefs.putString(key, extraBluettiMacs[i - 1]);
+            }
+        }
         prefs.end();
         
         Serial.printf("Configuration saved - WiFi: %s, MQTT: %s, MAC: %s\n", wifiSsid, mqttServer, bluettiMac);
@@ -630,6 +1072,7 @@ void WebServerManager::handleUpdateProgress(AsyncWebServerRequest *request, Stri
 }
 
 void WebServerManager::handleSetACOutput(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (!bluetti || !bluetti->isConnected()) {
         request->send(400, "text/plain", "Bluetti not connected");
         return;
@@ -638,9 +1081,9 @@ void WebServerManager::handleSetACOutput(AsyncWebServerRequest *request) {
     if (request->hasParam("state", true)) {
         String state = request->getParam("state", true)->value();
         bool newState = (state == "on");
-        bool success = bluetti->setACOutput(newState);
+        WriteTicket ticket = bluetti->setACOutput(newState);
         
-        if (success) {
+        if (ticket) {
             Serial.printf("AC output set to: %s\n", newState ? "ON" : "OFF");
             request->redirect("/");
         } else {
@@ -652,6 +1095,7 @@ void WebServerManager::handleSetACOutput(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleSetDCOutput(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (!bluetti || !bluetti->isConnected()) {
         request->send(400, "text/plain", "Bluetti not connected");
         return;
@@ -660,9 +1104,9 @@ void WebServerManager::handleSetDCOutput(AsyncWebServerRequest *request) {
     if (request->hasParam("state", true)) {
         String state = request->getParam("state", true)->value();
         bool newState = (state == "on");
-        bool success = bluetti->setDCOutput(newState);
+        WriteTicket ticket = bluetti->setDCOutput(newState);
         
-        if (success) {
+        if (ticket) {
             Serial.printf("DC output set to: %s\n", newState ? "ON" : "OFF");
             request->redirect("/");
         } else {
@@ -674,6 +1118,7 @@ void WebServerManager::handleSetDCOutput(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleSetChargingSpeed(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (!bluetti || !bluetti->isConnected()) {
         request->send(400, "text/plain", "Bluetti not connected");
         return;
@@ -694,9 +1139,9 @@ void WebServerManager::handleSetChargingSpeed(AsyncWebServerRequest *request) {
             return;
         }
         
-        bool success = bluetti->setChargingSpeed(speed);
+        WriteTicket ticket = bluetti->setChargingSpeed(speed);
         
-        if (success) {
+        if (ticket) {
             const char* modeNames[] = {"STANDARD", "SILENT", "TURBO"};
             Serial.printf("Charging speed set to: %s\n", modeNames[speed]);
             request->redirect("/");
@@ -709,15 +1154,16 @@ void WebServerManager::handleSetChargingSpeed(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleSetEcoMode(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (bluetti) {
         String stateStr = "";
         if (request->hasParam("state", true)) {
             stateStr = request->getParam("state", true)->value();
         }
         bool state = (stateStr == "on" || stateStr == "ON" || stateStr == "1" || stateStr == "true");
-        bool success = bluetti->setEcoMode(state);
-        if (success) {
-            request->send(200, "text/plain", state ? "ECO Mode ON" : "ECO Mode OFF");
+        WriteTicket ticket = bluetti->setEcoMode(state);
+        if (ticket) {
+            request->send(202, "text/plain", String(state ? "ECO Mode ON" : "ECO Mode OFF") + " (ticket " + ticket + ")");
         } else {
             request->send(500, "text/plain", "Failed to set ECO mode");
         }
@@ -727,15 +1173,16 @@ void WebServerManager::handleSetEcoMode(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleSetPowerLifting(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (bluetti) {
         String stateStr = "";
         if (request->hasParam("state", true)) {
             stateStr = request->getParam("state", true)->value();
         }
         bool state = (stateStr == "on" || stateStr == "ON" || stateStr == "1" || stateStr == "true");
-        bool success = bluetti->setPowerLifting(state);
-        if (success) {
-            request->send(200, "text/plain", state ? "Power Lifting ON" : "Power Lifting OFF");
+        WriteTicket ticket = bluetti->setPowerLifting(state);
+        if (ticket) {
+            request->send(202, "text/plain", String(state ? "Power Lifting ON" : "Power Lifting OFF") + " (ticket " + ticket + ")");
         } else {
             request->send(500, "text/plain", "Failed to set Power Lifting");
         }
@@ -745,6 +1192,7 @@ void WebServerManager::handleSetPowerLifting(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleSetLedMode(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (bluetti) {
         String modeStr = "";
         if (request->hasParam("mode", true)) {
@@ -757,10 +1205,10 @@ void WebServerManager::handleSetLedMode(AsyncWebServerRequest *request) {
         else if (modeStr == "off" || modeStr == "Off" || modeStr == "4") { mode = 4; }
         else if (modeStr == "on" || modeStr == "On") { mode = 2; } // convenience ON=High
         else { request->send(400, "text/plain", "Invalid mode"); return; }
-        bool success = bluetti->setLedMode(mode);
-        if (success) {
+        WriteTicket ticket = bluetti->setLedMode(mode);
+        if (ticket) {
             const char* modeNames[] = {"", "Low", "High", "SOS", "Off"};
-            request->send(200, "text/plain", String("LED Mode: ") + modeNames[mode]);
+            request->send(202, "text/plain", String("LED Mode: ") + modeNames[mode] + " (ticket " + ticket + ")");
         } else {
             request->send(500, "text/plain", "Failed to set LED mode");
         }
@@ -770,6 +1218,7 @@ void WebServerManager::handleSetLedMode(AsyncWebServerRequest *request) {
 }
 
 void WebServerManager::handleSetEcoShutdown(AsyncWebServerRequest *request) {
+    BluettiDevice* bluetti = deviceFor(request);
     if (bluetti) {
         String hoursStr = "";
         if (request->hasParam("hours", true)) {
@@ -780,9 +1229,9 @@ void WebServerManager::handleSetEcoShutdown(AsyncWebServerRequest *request) {
             request->send(400, "text/plain", "Invalid hours. Use 1-4");
             return;
         }
-        bool success = bluetti->setEcoShutdown(hours);
-        if (success) {
-            request->send(200, "text/plain", String("ECO Shutdown: ") + hours + "h");
+        WriteTicket ticket = bluetti->setEcoShutdown(hours);
+        if (ticket) {
+            request->send(202, "text/plain", String("ECO Shutdown: ") + hours + "h (ticket " + ticket + ")");
         } else {
             request->send(500, "text/plain", "Failed to set ECO shutdown");
         }
@@ -0,0 +1,172 @@
+// libFuzzer target для parseModbusFrame() та NotificationReassembler: `make fuzz`
+// (clang, -fsanitize=fuzzer,address,undefined).
+//
+// Без clang (лише g++) той самий файл збирається з -DFUZZ_STANDALONE
+// (`make fuzz-standalone`): main() проганяє файли з аргументів або мільйон
+// мутацій валідних кадрів під ASan/UBSan.
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "modbus_crc.h"
+#include "modbus_frame.h"
+#include "notification_reassembler.h"
+
+#define FUZZ_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            fprintf(stderr, "invariant failed: %s (%s:%d)\n", #condition, __FILE__, __LINE__); \
+            __builtin_trap(); \
+        } \
+    } while (0)
+
+// Валідний view лежить повністю всередині [data, data + length)
+static void checkView(const ModbusFrameView& view, const uint8_t* data, size_t length) {
+    FUZZ_CHECK(view.data == data);
+    FUZZ_CHECK(view.length == length);
+    FUZZ_CHECK(view.length >= MODBUS_MIN_FRAME);
+    FUZZ_CHECK(calculateCRC16(data, length - 2) == (data[length - 2] | (data[length - 1] << 8)));
+    FUZZ_CHECK(view.requestFunction() == 0x03 || view.requestFunction() == 0x06);
+    switch (view.type) {
+        case ModbusFrameType::READ_RESPONSE: {
+            FUZZ_CHECK(view.payload == data + 3);
+            FUZZ_CHECK(view.payload + view.byteCount + 2 == data + length);
+            FUZZ_CHECK((view.byteCount & 1) == 0);
+            uint32_t sum = 0;
+            for (uint16_t i = 0; i < view.registerCount(); i++) {
+                sum += view.registerAt(i); // ASan ловить читання за межами
+            }
+            (void)sum;
+            break;
+        }
+        case ModbusFrameType::WRITE_ECHO:
+            FUZZ_CHECK(length == MODBUS_REQUEST_SIZE);
+            FUZZ_CHECK(view.address == ((data[2] << 8) | data[3]));
+            break;
+        case ModbusFrameType::EXCEPTION:
+            FUZZ_CHECK(length == 5 && (view.function & 0x80));
+            break;
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    // 1. Парсер на рівно size байтах
+    ModbusFrameView view;
+    ModbusFrameError error = parseModbusFrame(data, size, view);
+    FUZZ_CHECK(error < ModbusFrameError::COUNT);
+    FUZZ_CHECK(modbusFrameErrorName(error) != nullptr);
+    if (error == ModbusFrameError::NONE) {
+        checkView(view, data, size);
+    } else {
+        FUZZ_CHECK(view.data == nullptr && view.length == 0);
+    }
+    size_t expected = modbusFrameLength(data, size);
+    FUZZ_CHECK(expected == 0 || expected == SIZE_MAX || expected >= MODBUS_MIN_FRAME);
+
+    // 2. Той самий потік байт як notifications: перший байт задає розмір фрагментів
+    if (size == 0) {
+        return 0;
+    }
+    static NotificationReassembler reassembler;
+    reassembler.reset();
+    size_t fragment = 1 + data[0] % 64;
+    unsigned long now = 0;
+    uint32_t framesBefore = reassembler.getFramesAssembled();
+    uint32_t frames = 0;
+    for (size_t offset = 1; offset < size; offset += fragment) {
+        size_t chunk = size - offset < fragment ? size - offset : fragment;
+        reassembler.push(data + offset, chunk, now);
+        now += data[offset] & 0x0F ? 10 : NotificationReassembler::STALE_FRAGMENT_MS + 1;
+        while (reassembler.nextFrame(view)) {
+            frames++;
+            ModbusFrameView again;
+            FUZZ_CHECK(parseModbusFrame(view.data, view.length, again) == ModbusFrameError::NONE);
+            checkView(again, view.data, view.length);
+        }
+        FUZZ_CHECK(reassembler.pending() <= NotificationReassembler::CAPACITY);
+    }
+    FUZZ_CHECK(reassembler.getFramesAssembled() - framesBefore == frames);
+    return 0;
+}
+
+#ifdef FUZZ_STANDALONE
+#include <cstdlib>
+#include <vector>
+
+static uint32_t rngState = 0x9E3779B9;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+static void appendCrc(std::vector<uint8_t>& frame) {
+    uint16_t crc = calculateCRC16(frame.data(), frame.size());
+    frame.push_back(crc & 0xFF);
+    frame.push_back(crc >> 8);
+}
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        for (int i = 1; i < argc; i++) {
+            FILE* file = fopen(argv[i], "rb");
+            if (!file) {
+                perror(argv[i]);
+                return 1;
+            }
+            std::vector<uint8_t> input;
+            int c;
+            while ((c = fgetc(file)) != EOF) {
+                input.push_back((uint8_t)c);
+            }
+            fclose(file);
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+        }
+        return 0;
+    }
+
+    // Зерна: відповідь статусу, echo запису, exception
+    std::vector<std::vector<uint8_t>> seeds;
+    std::vector<uint8_t> status = {0x01, 0x03, 80};
+    for (int i = 0; i < 80; i++) {
+        status.push_back((uint8_t)i);
+    }
+    appendCrc(status);
+    seeds.push_back(status);
+    seeds.push_back(std::vector<uint8_t>(MODBUS_AC_ON_BYTES, MODBUS_AC_ON_BYTES + MODBUS_REQUEST_SIZE));
+    std::vector<uint8_t> exception = {0x01, 0x83, 0x02};
+    appendCrc(exception);
+    seeds.push_back(exception);
+
+    const uint32_t iterations = 1000000;
+    for (uint32_t n = 0; n < iterations; n++) {
+        std::vector<uint8_t> input(1, (uint8_t)nextRandom());
+        uint32_t pieces = 1 + nextRandom() % 4;
+        for (uint32_t p = 0; p < pieces; p++) {
+            const std::vector<uint8_t>& seed = seeds[nextRandom() % seeds.size()];
+            input.insert(input.end(), seed.begin(), seed.end());
+        }
+        uint32_t mutations = nextRandom() % 4;
+        for (uint32_t m = 0; m < mutations; m++) {
+            size_t at = nextRandom() % input.size();
+            switch (nextRandom() % 4) {
+                case 0: input[at] ^= (uint8_t)(1u << (nextRandom() % 8)); break;
+                case 1: input[at] = (uint8_t)nextRandom(); break;
+                case 2: input.erase(input.begin() + at); break;
+                default: input.insert(input.begin() + at, (uint8_t)nextRandom()); break;
+            }
+            if (input.empty()) {
+                input.push_back(0);
+            }
+        }
+        if (nextRandom() % 2) {
+            LLVMFuzzerTestOneInput(input.data() + 1, input.size() - 1); // Кадр без байта фрагментації
+        }
+        LLVMFuzzerTestOneInput(input.data(), input.size());
+    }
+    printf("%u inputs, no invariant violations\n", iterations);
+    return 0;
+}
+#endif
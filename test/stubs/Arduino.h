@@ -0,0 +1,11 @@
+#ifndef ARDUINO_H_NATIVE_STUB
+#define ARDUINO_H_NATIVE_STUB
+
+// Хостова заміна Arduino.h для [env:native]: чисті модулі тягнуть її лише
+// транзитивно через system_status.h і нічого з неї не викликають
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#endif
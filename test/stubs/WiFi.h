@@ -0,0 +1,17 @@
+#ifndef WIFI_H_NATIVE_STUB
+#define WIFI_H_NATIVE_STUB
+
+#include <cstdint>
+
+// Хостова заміна WiFi.h для [env:native]: SystemStatus зберігає лише IPAddress
+class IPAddress {
+public:
+    IPAddress() = default;
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : octets{a, b, c, d} {}
+    uint8_t operator[](int index) const { return octets[index]; }
+
+private:
+    uint8_t octets[4] = {};
+};
+
+#endif
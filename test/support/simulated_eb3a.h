@@ -0,0 +1,93 @@
+#ifndef SIMULATED_EB3A_H
+#define SIMULATED_EB3A_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include "modbus_crc.h"
+#include "modbus_frame.h"
+
+// Імітація EB3A для хостових тестів: приймає запит 0x03/0x06 і віддає
+// відповідь через latencyMs віртуального часу (або мовчить). Регістри -
+// плоский масив, запис 0x06 змінює його, як це робить пристрій.
+class SimulatedEb3a {
+public:
+    static constexpr size_t REGISTER_COUNT = 0x1000;
+    static constexpr size_t MAX_REPLY = 5 + 2 * 125;
+
+    unsigned long latencyMs = 0;
+    bool silent = false;
+
+    SimulatedEb3a() { memset(registers, 0, sizeof(registers)); }
+
+    void setRegister(uint16_t address, uint16_t value) {
+        if (address < REGISTER_COUNT) {
+            registers[address] = value;
+        }
+    }
+    uint16_t getRegister(uint16_t address) const {
+        return address < REGISTER_COUNT ? registers[address] : 0;
+    }
+
+    // Запит з characteristic write. Новий запит замінює відповідь, що ще не
+    // пішла: EB3A обробляє лише один запит за раз.
+    void receive(const uint8_t* frame, size_t length, unsigned long now) {
+        requests++;
+        pending = false;
+        if (silent || length != MODBUS_REQUEST_SIZE) {
+            return;
+        }
+        uint8_t function = frame[1];
+        uint16_t address = (frame[2] << 8) | frame[3];
+        uint16_t value = (frame[4] << 8) | frame[5];
+
+        if (function == 0x03 && value > 0 && value <= 125) {
+            reply[0] = MODBUS_DEVICE_ID;
+            reply[1] = 0x03;
+            reply[2] = (uint8_t)(value * 2);
+            for (uint16_t i = 0; i < value; i++) {
+                uint16_t reg = getRegister(address + i);
+                reply[3 + i * 2] = reg >> 8;
+                reply[4 + i * 2] = reg & 0xFF;
+            }
+            replyLength = 3 + value * 2;
+        } else if (function == 0x06) {
+            setRegister(address, value);
+            memcpy(reply, frame, 6); // Echo запиту
+            replyLength = 6;
+        } else {
+            reply[0] = MODBUS_DEVICE_ID;
+            reply[1] = function | 0x80;
+            reply[2] = 0x01; // Illegal function
+            replyLength = 3;
+        }
+        uint16_t crc = calculateCRC16(reply, replyLength);
+        reply[replyLength++] = crc & 0xFF;
+        reply[replyLength++] = crc >> 8;
+        pending = true;
+        replyAt = now + latencyMs;
+    }
+
+    // Notification, якщо відповідь готова до now
+    bool poll(unsigned long now, const uint8_t*& data, size_t& length) {
+        if (!pending || (long)(now - replyAt) < 0) {
+            return false;
+        }
+        pending = false;
+        data = reply;
+        length = replyLength;
+        return true;
+    }
+
+    uint32_t requestCount() const { return requests; }
+
+private:
+    uint16_t registers[REGISTER_COUNT];
+    uint8_t reply[MAX_REPLY];
+    size_t replyLength = 0;
+    bool pending = false;
+    unsigned long replyAt = 0;
+    uint32_t requests = 0;
+};
+
+#endif
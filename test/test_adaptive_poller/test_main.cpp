@@ -0,0 +1,199 @@
+#include <unity.h>
+#include <cstdio>
+#include <vector>
+#include "adaptive_poller.h"
+
+// Година навантаження на AC-виході (мілісекунди від початку, вати):
+// фон 50 W, два чайники, мікрохвильовка з циклами потужності та фен зі
+// ступенями. Кожна зміна потужності - подія, яку має побачити опитування
+struct LoadStep {
+    unsigned long at;
+    int watts;
+};
+
+static constexpr unsigned long REPLAY_MS = 60UL * 60 * 1000;
+static constexpr int IDLE_LOAD_W = 50;
+
+// phaseMs зсуває всі події відносно першого опитування: інакше кратні 20 с
+// моменти збігалися б із сіткою фіксованого інтервалу
+static std::vector<LoadStep> buildProfile(unsigned long phaseMs) {
+    std::vector<LoadStep> steps;
+    steps.push_back({0, IDLE_LOAD_W});
+    // Чайник: 2 кВт на три хвилини
+    steps.push_back({600000, 2050});
+    steps.push_back({780000, IDLE_LOAD_W});
+    // Мікрохвильовка на 50%: магнетрон 12 с увімкнено / 8 с вимкнено, 4 хвилини
+    for (unsigned long t = 1500000; t < 1740000; t += 20000) {
+        steps.push_back({t, 1250});
+        steps.push_back({t + 12000, 150});
+    }
+    steps.push_back({1740000, IDLE_LOAD_W});
+    steps.push_back({2400000, 2050});
+    steps.push_back({2580000, IDLE_LOAD_W});
+    // Фен: ступені по 30 с
+    steps.push_back({3000000, 850});
+    steps.push_back({3030000, 1650});
+    steps.push_back({3060000, 850});
+    steps.push_back({3090000, IDLE_LOAD_W});
+    for (size_t i = 1; i < steps.size(); i++) {
+        steps[i].at += phaseMs;
+    }
+    return steps;
+}
+
+static int loadAt(const std::vector<LoadStep>& steps, unsigned long t) {
+    int watts = IDLE_LOAD_W;
+    for (const LoadStep& step : steps) {
+        if (step.at > t) {
+            break;
+        }
+        watts = step.watts;
+    }
+    return watts;
+}
+
+struct ReplayResult {
+    double polls = 0;
+    double meanLatencyMs = 0;
+    unsigned long worstLatencyMs = 0;
+};
+
+static constexpr unsigned PHASES = 20; // Зсуви 0..19 с - усереднення по фазі
+
+// Середнє по всіх фазах (найгірша затримка - найгірша з усіх)
+template <typename Run>
+static ReplayResult overPhases(Run run) {
+    ReplayResult total;
+    for (unsigned phase = 0; phase < PHASES; phase++) {
+        ReplayResult one = run(buildProfile(phase * 1000 + 370));
+        total.polls += one.polls / PHASES;
+        total.meanLatencyMs += one.meanLatencyMs / PHASES;
+        total.worstLatencyMs = one.worstLatencyMs > total.worstLatencyMs ? one.worstLatencyMs : total.worstLatencyMs;
+    }
+    return total;
+}
+
+// Затримка виявлення: від зміни навантаження до першого опитування після неї.
+// Подія, яку перекрила наступна до опитування, рахується до тієї наступної
+template <typename NextInterval>
+static ReplayResult replay(const std::vector<LoadStep>& steps, NextInterval nextInterval) {
+    std::vector<unsigned long> polls;
+    for (unsigned long t = 0; t < REPLAY_MS; t += nextInterval(t, loadAt(steps, t))) {
+        polls.push_back(t);
+    }
+    ReplayResult result;
+    result.polls = polls.size();
+    unsigned counted = 0;
+    double total = 0;
+    size_t p = 0;
+    for (size_t i = 1; i < steps.size(); i++) {
+        while (p < polls.size() && polls[p] < steps[i].at) {
+            p++;
+        }
+        if (p == polls.size()) {
+            break;
+        }
+        unsigned long latency = polls[p] - steps[i].at;
+        total += latency;
+        counted++;
+        result.worstLatencyMs = latency > result.worstLatencyMs ? latency : result.worstLatencyMs;
+    }
+    result.meanLatencyMs = counted ? total / counted : 0;
+    return result;
+}
+
+static ReplayResult replayAdaptive(const std::vector<LoadStep>& steps, unsigned long minMs, unsigned long maxMs) {
+    AdaptivePoller poller;
+    poller.setBounds(minMs, maxMs);
+    return replay(steps, [&poller](unsigned long t, int watts) {
+        PollSample sample = {80, watts, 0, 0};
+        poller.observe(sample, t + 1); // 0 для poller означає "ще не було"
+        return poller.interval();
+    });
+}
+
+static ReplayResult replayFixed(const std::vector<LoadStep>& steps, unsigned long intervalMs) {
+    return replay(steps, [intervalMs](unsigned long, int) { return intervalMs; });
+}
+
+static void report(const char* name, const ReplayResult& result) {
+    char line[128];
+    snprintf(line, sizeof(line), "%-22s %5.1f polls, detection mean %5.1f s, worst %5.1f s", name, result.polls,
+             result.meanLatencyMs / 1000.0, result.worstLatencyMs / 1000.0);
+    TEST_MESSAGE(line);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_replay_against_fixed_interval(void) {
+    ReplayResult fixed = overPhases([](const std::vector<LoadStep>& steps) {
+        return replayFixed(steps, POLL_MAX_DEFAULT_MS);
+    });
+    ReplayResult adaptive = overPhases([](const std::vector<LoadStep>& steps) {
+        return replayAdaptive(steps, POLL_MIN_DEFAULT_MS, POLL_MAX_DEFAULT_MS);
+    });
+    // Той самий бюджет опитувань, що в адаптивного, але рівномірно
+    unsigned long sameBudgetMs = (unsigned long)(REPLAY_MS / adaptive.polls);
+    ReplayResult sameBudget = overPhases([sameBudgetMs](const std::vector<LoadStep>& steps) {
+        return replayFixed(steps, sameBudgetMs);
+    });
+    // Адаптивне зі стелею 60 с - менше опитувань, ніж фіксовані 20 с
+    ReplayResult relaxed = overPhases([](const std::vector<LoadStep>& steps) {
+        return replayAdaptive(steps, POLL_MIN_DEFAULT_MS, 60000);
+    });
+    report("fixed 20 s", fixed);
+    report("adaptive 3..20 s", adaptive);
+    report("fixed, same poll count", sameBudget);
+    report("adaptive 3..60 s", relaxed);
+
+    // Стеля 20 с: стабільні періоди коштують стільки ж, додаткові опитування -
+    // лише під час перехідних процесів, а їхні наступні кроки видно за 3-6 с
+    TEST_ASSERT_TRUE(adaptive.meanLatencyMs < fixed.meanLatencyMs * 8 / 10);
+    TEST_ASSERT_TRUE(adaptive.worstLatencyMs <= POLL_MAX_DEFAULT_MS);
+    TEST_ASSERT_TRUE(adaptive.polls < fixed.polls * 12 / 10);
+    // За рівної кількості опитувань адаптивне виявляє зміни швидше за рівномірне
+    TEST_ASSERT_TRUE(adaptive.meanLatencyMs < sameBudget.meanLatencyMs);
+    // Вища стеля економить опитування ціною початку перехідного процесу
+    TEST_ASSERT_TRUE(relaxed.polls < fixed.polls);
+    TEST_ASSERT_TRUE(relaxed.worstLatencyMs <= 60000);
+}
+
+void test_interval_bounds(void) {
+    AdaptivePoller poller;
+    poller.setBounds(3000, 20000);
+    PollSample idle = {80, 50, 0, 0};
+    unsigned long now = 1;
+    for (int i = 0; i < 10; i++) {
+        poller.observe(idle, now);
+        now += poller.interval();
+    }
+    TEST_ASSERT_EQUAL_UINT32(20000, poller.interval());
+
+    PollSample kettle = {80, 2050, 0, 0};
+    TEST_ASSERT_TRUE(poller.observe(kettle, now));
+    TEST_ASSERT_EQUAL_UINT32(3000, poller.interval());
+    // Шум у межах порогу - не перехідний процес
+    kettle.acPower += POLL_POWER_DELTA_W - 1;
+    TEST_ASSERT_FALSE(poller.observe(kettle, now + 3000));
+    TEST_ASSERT_EQUAL_UINT32(6000, poller.interval());
+    // SoC: 1% - звичайний крок, 2% - стрибок
+    kettle.batteryLevel = 79;
+    TEST_ASSERT_FALSE(poller.observe(kettle, now + 9000));
+    kettle.batteryLevel = 77;
+    TEST_ASSERT_TRUE(poller.observe(kettle, now + 21000));
+    TEST_ASSERT_EQUAL(2, poller.getTransients());
+
+    // Межі обмежуються допустимими значеннями
+    poller.setBounds(500, 900000);
+    TEST_ASSERT_EQUAL_UINT32(POLL_MIN_LIMIT_MS, poller.getMinMs());
+    TEST_ASSERT_EQUAL_UINT32(POLL_MAX_LIMIT_MS, poller.getMaxMs());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_replay_against_fixed_interval);
+    RUN_TEST(test_interval_bounds);
+    return UNITY_END();
+}
@@ -0,0 +1,176 @@
+#include <unity.h>
+#include <cstdio>
+#include "modbus_frame.h"
+#include "modbus_transaction.h"
+#include "simulated_eb3a.h"
+
+// Ті самі значення, що й у BluettiDevice
+static constexpr unsigned long STATUS_RESPONSE_TIMEOUT_MS = 2000;
+static constexpr unsigned long REGISTER_RESPONSE_TIMEOUT_MS = 3000;
+static constexpr unsigned long WRITE_RESPONSE_TIMEOUT_MS = 2000;
+static constexpr unsigned long POST_STATUS_QUIET_MS = 1000;
+static constexpr uint8_t WRITE_RETRIES = 1;
+static constexpr unsigned long TICK_MS = 10;
+static constexpr unsigned long PEER_LATENCY_MS = 150;
+
+static constexpr uint16_t AC_OUTPUT_REGISTER = 0x0BBF;
+
+// Черга під постійним навантаженням опитування: статус і читання налаштувань
+// доливаються щотіку, команди користувача приходять у довільні моменти
+struct PollLoad {
+    ModbusTransactionEngine engine;
+    SimulatedEb3a peer;
+    unsigned long now = 0;
+    uint16_t nextTicket = 1;
+    unsigned long writeEnqueuedAt[64] = {};
+    unsigned long ackLatency[64] = {};
+    uint32_t acked = 0;
+    uint32_t pollsCompleted = 0;
+
+    void topUpPolls() {
+        ModbusTransaction status;
+        status.address = 0x000A;
+        status.value = 40;
+        status.timeoutMs = STATUS_RESPONSE_TIMEOUT_MS;
+        engine.enqueue(status, now);
+        for (uint16_t address = 0x0BB8; address < 0x0BBE; address++) {
+            ModbusTransaction read;
+            read.kind = ModbusTxnKind::READ_REGISTER;
+            read.address = address;
+            read.value = 1;
+            read.timeoutMs = REGISTER_RESPONSE_TIMEOUT_MS;
+            engine.enqueue(read, now);
+        }
+    }
+
+    uint16_t userWrite(uint16_t value) {
+        ModbusTransaction txn;
+        txn.kind = ModbusTxnKind::WRITE_REGISTER;
+        txn.priority = ModbusPriority::USER_WRITE;
+        txn.function = 0x06;
+        txn.address = AC_OUTPUT_REGISTER;
+        txn.value = value;
+        txn.retriesLeft = WRITE_RETRIES;
+        txn.timeoutMs = WRITE_RESPONSE_TIMEOUT_MS;
+        txn.ticket = nextTicket++;
+        writeEnqueuedAt[txn.ticket] = now;
+        TEST_ASSERT_TRUE(engine.enqueue(txn, now));
+        return txn.ticket;
+    }
+
+    void tick() {
+        const uint8_t* data;
+        size_t length;
+        if (peer.poll(now, data, length)) {
+            ModbusFrameView view;
+            if (parseModbusFrame(data, length, view) == ModbusFrameError::NONE &&
+                engine.complete(view, now)) {
+                const ModbusTransaction& done = engine.current();
+                if (done.kind == ModbusTxnKind::WRITE_REGISTER) {
+                    ackLatency[done.ticket] = now - writeEnqueuedAt[done.ticket];
+                    acked++;
+                } else {
+                    pollsCompleted++;
+                }
+                if (done.kind == ModbusTxnKind::STATUS_POLL) {
+                    engine.holdOff(now + POST_STATUS_QUIET_MS);
+                }
+            }
+        }
+        engine.expire(now);
+        topUpPolls();
+        ModbusTransaction txn;
+        if (engine.startNext(now, txn)) {
+            uint8_t frame[ModbusTransactionEngine::FRAME_SIZE];
+            peer.receive(frame, ModbusTransactionEngine::buildFrame(txn, frame), now);
+        }
+        now += TICK_MS;
+    }
+
+    void run(unsigned long durationMs) {
+        for (unsigned long end = now + durationMs; (long)(end - now) > 0;) {
+            tick();
+        }
+    }
+};
+
+static PollLoad* load;
+
+void setUp(void) {
+    load = new PollLoad();
+    load->peer.latencyMs = PEER_LATENCY_MS;
+}
+
+void tearDown(void) {
+    delete load;
+}
+
+void test_write_preempts_full_poll_queue(void) {
+    load->topUpPolls();
+    TEST_ASSERT_EQUAL(7, load->engine.queued());
+    load->userWrite(1);
+
+    ModbusTransaction next;
+    TEST_ASSERT_TRUE(load->engine.startNext(0, next));
+    TEST_ASSERT_EQUAL(ModbusTxnKind::WRITE_REGISTER, next.kind);
+    TEST_ASSERT_EQUAL_HEX16(AC_OUTPUT_REGISTER, next.address);
+}
+
+void test_command_to_ack_latency_under_poll_load(void) {
+    // Найгірший випадок: запис приходить одразу після відправки опитування -
+    // чекає відповідь на нього, паузу після статусу і власний round trip
+    static constexpr unsigned long BOUND_MS =
+        PEER_LATENCY_MS + POST_STATUS_QUIET_MS + PEER_LATENCY_MS + 2 * TICK_MS;
+    static constexpr uint32_t WRITES = 40;
+
+    load->run(5000);
+    uint32_t seed = 12345;
+    for (uint32_t i = 0; i < WRITES; i++) {
+        seed = seed * 1103515245u + 12345u;
+        load->run(TICK_MS * (1 + (seed >> 16) % 300)); // Довільна фаза циклу опитування
+        load->userWrite(i & 1);
+        load->run(BOUND_MS + TICK_MS);
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(WRITES, load->acked);
+    TEST_ASSERT_GREATER_THAN_UINT32(WRITES, load->pollsCompleted);
+    unsigned long worst = 0;
+    unsigned long total = 0;
+    for (uint16_t ticket = 1; ticket <= WRITES; ticket++) {
+        TEST_ASSERT_LESS_OR_EQUAL(BOUND_MS, load->ackLatency[ticket]);
+        total += load->ackLatency[ticket];
+        if (load->ackLatency[ticket] > worst) {
+            worst = load->ackLatency[ticket];
+        }
+    }
+    TEST_ASSERT_EQUAL_HEX16((WRITES - 1) & 1, load->peer.getRegister(AC_OUTPUT_REGISTER));
+
+    char line[128];
+    snprintf(line, sizeof(line), "command-to-ack: avg %lu ms, worst %lu ms (bound %lu ms, %u polls alongside)",
+             total / WRITES, worst, BOUND_MS, load->pollsCompleted);
+    TEST_MESSAGE(line);
+}
+
+void test_lost_write_is_retried_ahead_of_polls(void) {
+    load->run(2000);
+    load->peer.silent = true;
+    load->userWrite(1);
+    while (!(load->engine.isBusy() && load->engine.current().kind == ModbusTxnKind::WRITE_REGISTER)) {
+        load->tick();
+    }
+    load->peer.silent = false;
+    load->run(WRITE_RESPONSE_TIMEOUT_MS + PEER_LATENCY_MS + TICK_MS);
+
+    // Перша спроба пропала, повтор пішов раніше за опитування, що чекали в черзі
+    TEST_ASSERT_EQUAL_UINT32(1, load->acked);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, load->engine.getRetries());
+    TEST_ASSERT_EQUAL_HEX16(1, load->peer.getRegister(AC_OUTPUT_REGISTER));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_write_preempts_full_poll_queue);
+    RUN_TEST(test_command_to_ack_latency_under_poll_load);
+    RUN_TEST(test_lost_write_is_retried_ahead_of_polls);
+    return UNITY_END();
+}
@@ -0,0 +1,371 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "device_profile.h"
+#include "eb3a_registers.h"
+#include "modbus_crc.h"
+#include "modbus_frame.h"
+#include "register_map.h"
+
+// Відповіді 0x03 на опитування блоку статусу (0x000A, 40 регістрів) разом з CRC.
+// EB3A - за польовими логами (POWER_DISPLAY_FIX.md, BLUETTI_EB3A_REGISTERS.md):
+// "EB3A" у 0x000E-0x000F, 0x0010 "залип" на 1019, SoC 84% у 0x002B,
+// AC in 122 W, AC out 17 W, 0x0028 = 2981 (25.0 °C у Кельвінах ×10).
+// Решта - блок device_type/потужностей за bluetti_mqtt для AC200M, EB70S та AC180.
+
+static const uint8_t EB3A_FRAME[] = {
+    0x01, 0x03, 0x50, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x45, 0x42, 0x33, 0x41, 0x03,
+    0xFB, 0xCB, 0xB8, 0x5F, 0xA6, 0x02, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7A, 0x00, 0x11, 0x00, 0x00, 0x0B,
+    0xA5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x54, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0xB7, 0x30,
+};
+static const uint8_t AC200M_FRAME[] = {
+    0x01, 0x03, 0x50, 0x41, 0x43, 0x32, 0x30, 0x30, 0x4D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x19, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0xC2, 0x00, 0x00, 0x03, 0x34, 0x00, 0x23, 0x0B,
+    0xA5, 0x00, 0x00, 0x00, 0x00, 0x00, 0x43, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x01, 0xBB, 0x54,
+};
+static const uint8_t EB70S_FRAME[] = {
+    0x01, 0x03, 0x50, 0x45, 0x42, 0x37, 0x30, 0x53, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+    0xFB, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x01, 0xB6, 0xA7,
+};
+static const uint8_t AC180_FRAME[] = {
+    0x01, 0x03, 0x50, 0x41, 0x43, 0x31, 0x38, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x36, 0x00, 0x91, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x2D, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x01, 0x00, 0x00, 0x3A, 0x7F,
+};
+
+static uint8_t frame[sizeof(EB3A_FRAME)];
+
+// Змінює регістр у копії кадру та перераховує CRC
+static void patchRegister(uint16_t address, uint16_t value) {
+    size_t offset = 3 + (address - 0x000A) * 2;
+    frame[offset] = value >> 8;
+    frame[offset + 1] = value & 0xFF;
+    uint16_t crc = calculateCRC16(frame, sizeof(frame) - 2);
+    frame[sizeof(frame) - 2] = crc & 0xFF;
+    frame[sizeof(frame) - 1] = crc >> 8;
+}
+
+// Як BluettiDevice::handleNotification: декодування таблицею поточного профілю,
+// вибір профілю за назвою моделі й повторне декодування того самого кадру
+struct Decoded {
+    const DeviceProfile* profile;
+    uint32_t mask;
+    SystemStatus status;
+};
+
+static Decoded decodeStatusFrame(const uint8_t* data, size_t length) {
+    Decoded result{&defaultDeviceProfile(), 0, SystemStatus()};
+    ModbusFrameView view;
+    TEST_ASSERT_EQUAL(ModbusFrameError::NONE, parseModbusFrame(data, length, view));
+    TEST_ASSERT_EQUAL(ModbusFrameType::READ_RESPONSE, view.type);
+    TEST_ASSERT_EQUAL(40, view.registerCount());
+
+    const DeviceProfile* active = result.profile;
+    result.mask = decodeRegisterBlock(active->statusMap, active->statusMapSize, active->statusBase,
+                                      view.payload, view.registerCount(), result.status);
+    const DeviceProfile* detected = findDeviceProfile(result.status.modelName);
+    if (detected && detected != active) {
+        result.profile = detected;
+        result.status.temperature = 0;
+        result.status.batteryVoltage = 0;
+        result.status.maxDcLimit = 0;
+        result.mask = decodeRegisterBlock(detected->statusMap, detected->statusMapSize, detected->statusBase,
+                                          view.payload, view.registerCount(), result.status);
+    }
+    return result;
+}
+
+// Попередній декодер з handleNotification (до таблиці регістрів): фіксовані
+// зсуви, вибір SoC гілками та пошук температури перебором. Без Serial-виводу -
+// порівнюється лише сам розбір
+__attribute__((noinline)) static void legacyDecodeStatus(const uint8_t* data, size_t length, SystemStatus& status) {
+    if (length >= 15) {
+        if (data[11] == 0x45 && data[12] == 0x42) {
+            memcpy(status.modelName, data + 11, 4);
+        } else {
+            memcpy(status.modelName, data + 3, 4);
+        }
+        status.modelName[4] = '\0';
+    }
+    uint16_t reg0010 = length >= 17 ? (data[15] << 8) | data[16] : 0;
+    uint16_t reg002B = length >= 71 ? (data[69] << 8) | data[70] : 0;
+    int battery = -1;
+    if (reg002B > 0 && reg002B <= 100) {
+        battery = reg002B;
+        status.batteryRaw = reg002B;
+    } else if (reg0010 > 100 && reg0010 <= 1100) {
+        battery = reg0010 / 10;
+        status.batteryRaw = reg0010;
+    } else if (reg0010 > 0 && reg0010 <= 100) {
+        battery = reg0010;
+        status.batteryRaw = reg0010;
+    }
+    if (battery < 0) {
+        battery = 100;
+        status.batteryRaw = 1000;
+    }
+    status.batteryLevel = battery > 100 ? 100 : battery;
+    if (length >= 23) {
+        status.batteryVoltage = (data[21] << 8) | data[22];
+    }
+    status.temperature = 0;
+    if (length >= 35) {
+        for (int address = 0x28; address <= 0x29 && status.temperature == 0; address++) {
+            int offset = 3 + (address - 0x0A) * 2;
+            if (offset + 1 < (int)length) {
+                uint16_t value = (data[offset] << 8) | data[offset + 1];
+                if (value >= 100 && value <= 700) {
+                    status.temperature = value;
+                } else if (value >= 2731 && value <= 3531) {
+                    status.temperature = value - 2731;
+                }
+            }
+        }
+        for (int i = 0; i < 40 && status.temperature == 0; i++) {
+            int offset = 3 + i * 2;
+            if (offset + 1 < (int)length) {
+                uint16_t value = (data[offset] << 8) | data[offset + 1];
+                uint16_t address = 0x000A + i;
+                if (value >= 150 && value <= 500 && address != 0x0010 && address != 0x0013 &&
+                    address != 0x0017 && address != 0x0019 && address != 0x002B) {
+                    status.temperature = value;
+                }
+            }
+        }
+    }
+    if (length >= 57) status.dcInputPower = (data[55] << 8) | data[56];
+    if (length >= 59) status.acInputPower = (data[57] << 8) | data[58];
+    status.acPower = length >= 61 ? (data[59] << 8) | data[60] : 0;
+    status.dcPower = length >= 63 ? (data[61] << 8) | data[62] : 0;
+    if (length >= 71) status.maxDcLimit = (data[69] << 8) | data[70];
+    status.acOutputState = length >= 81 ? ((data[79] << 8) | data[80]) == 1 : status.acPower > 0;
+    status.dcOutputState = length >= 83 ? ((data[81] << 8) | data[82]) == 1 : status.dcPower > 0;
+}
+
+// Той самий розбір разом із форматуванням його журналу (рядок на поле та дамп
+// усіх 40 регістрів) - у буфер, без UART: так старий парсер працював на пристрої
+static char logSink[128];
+static uint32_t logBytes = 0;
+
+__attribute__((noinline)) static void legacyDecodeStatusLogged(const uint8_t* data, size_t length,
+                                                               SystemStatus& status) {
+    legacyDecodeStatus(data, length, status);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] Модель: %s\n", status.modelName);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] Батарея: %d%% (raw: %d)\n", status.batteryLevel,
+                         status.batteryRaw);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] Напруга батареї: %d (%.1fV)\n",
+                         status.batteryVoltage, status.batteryVoltage / 10.0f);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] Температура: %d (%.1f°C)\n", status.temperature,
+                         status.temperature / 10.0f);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] Вхідна потужність: %dW (DC: %dW, AC: %dW)\n",
+                         status.dcInputPower + status.acInputPower, status.dcInputPower, status.acInputPower);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] AC вихідна потужність: %dW\n", status.acPower);
+    logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] DC вихідна потужність: %dW\n", status.dcPower);
+    for (int i = 0; i < 40; i++) {
+        uint16_t value = (data[3 + i * 2] << 8) | data[4 + i * 2];
+        logBytes += snprintf(logSink, sizeof(logSink), "[Bluetti] Reg 0x%04X [%2d]: %5d (0x%04X)\n", 0x000A + i,
+                             i, value, value);
+    }
+}
+
+__attribute__((noinline)) static void tableDecodeStatus(const uint8_t* data, size_t, SystemStatus& status) {
+    status.temperature = 0;
+    decodeRegisterBlock(EB3A_STATUS_REGISTERS, EB3A_STATUS_BASE, data + 3, EB3A_STATUS_COUNT, status);
+}
+
+void setUp(void) {
+    memcpy(frame, EB3A_FRAME, sizeof(frame));
+}
+
+void tearDown(void) {}
+
+void test_eb3a_frame(void) {
+    Decoded d = decodeStatusFrame(EB3A_FRAME, sizeof(EB3A_FRAME));
+    TEST_ASSERT_EQUAL_STRING("eb3a", d.profile->slug);
+    TEST_ASSERT_EQUAL_STRING("EB3A", d.status.modelName);
+    TEST_ASSERT_EQUAL(84, d.status.batteryLevel); // 0x002B перекриває "залиплий" 0x0010
+    TEST_ASSERT_EQUAL(84, d.status.batteryRaw);
+    TEST_ASSERT_EQUAL(537, d.status.batteryVoltage);
+    TEST_ASSERT_EQUAL(250, d.status.temperature);
+    TEST_ASSERT_EQUAL(0, d.status.dcInputPower);
+    TEST_ASSERT_EQUAL(122, d.status.acInputPower);
+    TEST_ASSERT_EQUAL(17, d.status.acPower);
+    TEST_ASSERT_EQUAL(0, d.status.dcPower);
+    TEST_ASSERT_TRUE(d.status.acOutputState);
+    TEST_ASSERT_FALSE(d.status.dcOutputState);
+    TEST_ASSERT_TRUE(d.mask & statusFieldBit(StatusField::BATTERY_LEVEL));
+}
+
+void test_eb3a_soc_register_forms(void) {
+    // 0x002B порожній: 0x0010 ×10 (1019 -> 100%, обмежено)
+    patchRegister(0x002B, 0);
+    Decoded d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(100, d.status.batteryLevel);
+    TEST_ASSERT_EQUAL(1019, d.status.batteryRaw);
+
+    patchRegister(0x0010, 763);
+    d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(76, d.status.batteryLevel);
+
+    // Старі прошивки віддають у 0x0010 просто відсотки
+    patchRegister(0x0010, 76);
+    d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(76, d.status.batteryLevel);
+    TEST_ASSERT_EQUAL(76, d.status.batteryRaw);
+
+    // Жоден регістр SoC не валідний - маска без BATTERY_LEVEL (пристрій покаже 100%)
+    patchRegister(0x0010, 0);
+    d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_FALSE(d.mask & statusFieldBit(StatusField::BATTERY_LEVEL));
+    TEST_ASSERT_TRUE(d.mask & statusFieldBit(StatusField::AC_OUTPUT_POWER));
+}
+
+void test_eb3a_model_guard_and_ascii(void) {
+    // Лог POWER_DISPLAY_FIX.md: "EB3A" у 0x000A-0x000B, 0x000E порожній
+    patchRegister(0x000A, 0x4542);
+    patchRegister(0x000B, 0x3341);
+    patchRegister(0x000E, 0);
+    Decoded d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_STRING("EB3A", d.status.modelName);
+
+    // 0x000E не "EB" - 0x000F (хвіст) не застосовується до чужої назви
+    patchRegister(0x000E, 0x4543);
+    patchRegister(0x000F, 0x3939);
+    d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_STRING("EB3A", d.status.modelName);
+
+    // Кожен байт перевіряється окремо: 0x3A7F вкладається в 0x3030..0x5A5A
+    // як число, але 0x7F - не символ моделі
+    memcpy(frame, EB3A_FRAME, sizeof(frame));
+    patchRegister(0x000F, 0x3A7F);
+    d = decodeStatusFrame(frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_STRING("EB", d.status.modelName);
+    TEST_ASSERT_EQUAL_STRING("eb3a", d.profile->slug); // Невідома модель - профіль за замовчуванням
+}
+
+void test_ac200m_frame(void) {
+    Decoded d = decodeStatusFrame(AC200M_FRAME, sizeof(AC200M_FRAME));
+    TEST_ASSERT_EQUAL_STRING("ac200", d.profile->slug);
+    TEST_ASSERT_EQUAL_STRING("AC20", d.status.modelName);
+    TEST_ASSERT_EQUAL(67, d.status.batteryLevel);
+    TEST_ASSERT_EQUAL(450, d.status.dcInputPower);
+    TEST_ASSERT_EQUAL(0, d.status.acInputPower);
+    TEST_ASSERT_EQUAL(820, d.status.acPower);
+    TEST_ASSERT_EQUAL(35, d.status.dcPower);
+    TEST_ASSERT_TRUE(d.status.acOutputState);
+    TEST_ASSERT_TRUE(d.status.dcOutputState);
+    // Напруга й температура EB3A в ядрі не декодуються - скинуті після вибору профілю
+    TEST_ASSERT_EQUAL(0, d.status.batteryVoltage);
+    TEST_ASSERT_EQUAL(0, d.status.temperature);
+}
+
+void test_eb70s_frame(void) {
+    // "EB70" спершу проходить таблицею EB3A (0x000A), але 0x0010 = 1019 не
+    // повинен потрапити в SoC - ядро бере лише 0x002B
+    Decoded d = decodeStatusFrame(EB70S_FRAME, sizeof(EB70S_FRAME));
+    TEST_ASSERT_EQUAL_STRING("eb70", d.profile->slug);
+    TEST_ASSERT_EQUAL_STRING("EB70", d.status.modelName);
+    TEST_ASSERT_EQUAL(91, d.status.batteryLevel);
+    TEST_ASSERT_EQUAL(96, d.status.dcInputPower);
+    TEST_ASSERT_EQUAL(12, d.status.dcPower);
+    TEST_ASSERT_FALSE(d.status.acOutputState);
+    TEST_ASSERT_TRUE(d.status.dcOutputState);
+}
+
+void test_ac180_frame(void) {
+    Decoded d = decodeStatusFrame(AC180_FRAME, sizeof(AC180_FRAME));
+    TEST_ASSERT_EQUAL_STRING("ac180", d.profile->slug);
+    TEST_ASSERT_EQUAL_STRING("AC18", d.status.modelName);
+    TEST_ASSERT_EQUAL(45, d.status.batteryLevel);
+    TEST_ASSERT_EQUAL(310, d.status.acInputPower);
+    TEST_ASSERT_EQUAL(145, d.status.acPower);
+    TEST_ASSERT_TRUE(d.status.acOutputState);
+    TEST_ASSERT_FALSE(d.status.dcOutputState);
+}
+
+void test_profile_lookup(void) {
+    TEST_ASSERT_NULL(findDeviceProfile(""));
+    TEST_ASSERT_NULL(findDeviceProfile(nullptr));
+    TEST_ASSERT_NULL(findDeviceProfile("AC30"));
+    TEST_ASSERT_EQUAL_STRING("eb3a", defaultDeviceProfile().slug);
+}
+
+void test_table_decoder_matches_legacy_parser(void) {
+    SystemStatus legacy;
+    SystemStatus table;
+    legacyDecodeStatus(EB3A_FRAME, sizeof(EB3A_FRAME), legacy);
+    tableDecodeStatus(EB3A_FRAME, sizeof(EB3A_FRAME), table);
+    TEST_ASSERT_EQUAL_STRING(legacy.modelName, table.modelName);
+    TEST_ASSERT_EQUAL(legacy.batteryLevel, table.batteryLevel);
+    TEST_ASSERT_EQUAL(legacy.batteryRaw, table.batteryRaw);
+    TEST_ASSERT_EQUAL(legacy.batteryVoltage, table.batteryVoltage);
+    TEST_ASSERT_EQUAL(legacy.temperature, table.temperature);
+    TEST_ASSERT_EQUAL(legacy.dcInputPower, table.dcInputPower);
+    TEST_ASSERT_EQUAL(legacy.acInputPower, table.acInputPower);
+    TEST_ASSERT_EQUAL(legacy.acPower, table.acPower);
+    TEST_ASSERT_EQUAL(legacy.dcPower, table.dcPower);
+    TEST_ASSERT_EQUAL(legacy.maxDcLimit, table.maxDcLimit);
+    TEST_ASSERT_EQUAL(legacy.acOutputState, table.acOutputState);
+    TEST_ASSERT_EQUAL(legacy.dcOutputState, table.dcOutputState);
+}
+
+template <typename Decode>
+static double nanosecondsPerFrame(Decode decode, uint32_t rounds, uint32_t& sink) {
+    SystemStatus status;
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++) {
+        frame[60] = (uint8_t)i; // AC out змінюється - розбір не винесеться з циклу
+        decode(frame, sizeof(frame), status);
+        sink += status.acPower + status.batteryLevel + status.temperature;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return elapsed * 1e9 / rounds;
+}
+
+void test_benchmark_table_vs_legacy_decoder(void) {
+    // Ціна розбору кадру EB3A (40 регістрів) без CRC. Голий старий розбір
+    // дешевший за таблицю (фіксовані зсуви проти проходу по описах), але на
+    // пристрої кожен кадр ще й форматував ~2 КБ журналу
+    static constexpr uint32_t ROUNDS = 200000;
+    uint32_t sink = 0;
+    double legacy = nanosecondsPerFrame(legacyDecodeStatus, ROUNDS, sink);
+    double logged = nanosecondsPerFrame(legacyDecodeStatusLogged, ROUNDS / 10, sink);
+    double table = nanosecondsPerFrame(tableDecodeStatus, ROUNDS, sink);
+
+    char line[160];
+    snprintf(line, sizeof(line),
+             "Status decode per frame: legacy %.1f ns (with log formatting %.1f ns, %u B), table %.1f ns, sink %u",
+             legacy, logged, (unsigned)(logBytes / (ROUNDS / 10)), table, sink);
+    TEST_MESSAGE(line);
+    // Таблиця - у межах мікросекунди на кадр і дешевша за старий шлях з журналом
+    TEST_ASSERT_TRUE(table < 1000.0);
+    TEST_ASSERT_TRUE(table < logged);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_eb3a_frame);
+    RUN_TEST(test_eb3a_soc_register_forms);
+    RUN_TEST(test_eb3a_model_guard_and_ascii);
+    RUN_TEST(test_ac200m_frame);
+    RUN_TEST(test_eb70s_frame);
+    RUN_TEST(test_ac180_frame);
+    RUN_TEST(test_profile_lookup);
+    RUN_TEST(test_table_decoder_matches_legacy_parser);
+    RUN_TEST(test_benchmark_table_vs_legacy_decoder);
+    return UNITY_END();
+}
@@ -0,0 +1,207 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include "link_state.h"
+
+// Тривалості кроків спроби в мілісекундах (симульований час)
+static constexpr unsigned long TICK_MS = 10;      // Період BLE worker
+static constexpr unsigned long SCAN_MS = 1200;    // Пристрій знайдено через 1.2 с
+static constexpr unsigned long CONNECT_MS = 3000; // Відмова приходить після таймауту connect
+static constexpr unsigned long SETUP_MS = 200;    // Discovery та підписка
+
+static uint32_t rngState = 12345;
+
+static uint32_t nextRandom() {
+    rngState = rngState * 1664525u + 1013904223u;
+    return rngState;
+}
+
+// Bluetti, зайнятий іншим клієнтом: відхиляє перші refusals підключень
+struct RefusingPeer {
+    unsigned refusals;
+    unsigned connects = 0;
+
+    bool accept() {
+        connects++;
+        if (refusals > 0) {
+            refusals--;
+            return false;
+        }
+        return true;
+    }
+};
+
+// Пристрій у мініатюрі: ті самі переходи, що BluettiDevice::serviceConnection,
+// але кожен крок - дедлайн у симульованому часі, а не блокуючий виклик
+struct SimulatedLink {
+    LinkStateMachine link;
+    RefusingPeer* peer;
+    unsigned long failedAt[64] = {};
+    unsigned long backoffs[64] = {};
+    unsigned long attemptsAt[64] = {};
+    unsigned failures = 0;
+    unsigned attempts = 0;
+
+    void step(unsigned long now) {
+        switch (link.state()) {
+            case BluettiLinkState::IDLE:
+                if (link.attemptDue(now)) {
+                    attemptsAt[attempts++ % 64] = now;
+                    link.enter(BluettiLinkState::SCANNING, now);
+                }
+                break;
+            case BluettiLinkState::SCANNING:
+                if (now - link.enteredAt() >= SCAN_MS) {
+                    link.enter(BluettiLinkState::CONNECTING, now);
+                }
+                break;
+            case BluettiLinkState::CONNECTING:
+                if (now - link.enteredAt() < CONNECT_MS) {
+                    break;
+                }
+                if (peer->accept()) {
+                    link.enter(BluettiLinkState::DISCOVERING, now);
+                } else {
+                    failedAt[failures % 64] = now;
+                    backoffs[failures % 64] = link.recordFailure(now, nextRandom());
+                    failures++;
+                    link.enter(BluettiLinkState::IDLE, now);
+                }
+                break;
+            case BluettiLinkState::DISCOVERING:
+                if (now - link.enteredAt() >= SETUP_MS) {
+                    link.enter(BluettiLinkState::SUBSCRIBING, now);
+                }
+                break;
+            case BluettiLinkState::SUBSCRIBING:
+                if (now - link.enteredAt() >= SETUP_MS) {
+                    link.recordSuccess();
+                    link.enter(BluettiLinkState::ONLINE, now);
+                }
+                break;
+            case BluettiLinkState::ONLINE:
+            case BluettiLinkState::COUNT:
+                break;
+        }
+    }
+};
+
+// Межі паузи після failures відмов: база ×2 до стелі, ±25%
+static unsigned long nominalBackoff(unsigned failures) {
+    unsigned long delay = LINK_BACKOFF_BASE_MS;
+    for (unsigned i = 1; i < failures && delay < LINK_BACKOFF_MAX_MS; i++) {
+        delay *= 2;
+    }
+    return delay < LINK_BACKOFF_MAX_MS ? delay : LINK_BACKOFF_MAX_MS;
+}
+
+void setUp(void) {
+    rngState = 12345;
+}
+
+void tearDown(void) {}
+
+void test_backoff_ceiling_and_jitter_range(void) {
+    for (unsigned failures = 1; failures < 255; failures++) {
+        unsigned long nominal = nominalBackoff(failures);
+        unsigned long low = linkBackoffMs(failures, 0);
+        unsigned long high = linkBackoffMs(failures, nominal / 2); // randomValue % (spread + 1) == spread
+        TEST_ASSERT_EQUAL_UINT32(nominal - nominal / 4, low);
+        TEST_ASSERT_EQUAL_UINT32(nominal - nominal / 4 + nominal / 2, high);
+        for (int i = 0; i < 64; i++) {
+            unsigned long value = linkBackoffMs(failures, nextRandom());
+            TEST_ASSERT_TRUE(value >= low && value <= high);
+        }
+    }
+    // Стеля: 5 хвилин +25%, і лічильник не переповнює зсув
+    TEST_ASSERT_EQUAL_UINT32(LINK_BACKOFF_MAX_MS, nominalBackoff(200));
+    TEST_ASSERT_TRUE(linkBackoffMs(255, UINT32_MAX) <= LINK_BACKOFF_MAX_MS + LINK_BACKOFF_MAX_MS / 4);
+    TEST_ASSERT_EQUAL_UINT32(LINK_BACKOFF_BASE_MS * 3 / 4, linkBackoffMs(1, 0));
+}
+
+void test_jitter_spreads_retries(void) {
+    // Кілька мостів після спільного збою не повинні стукати в одну мілісекунду
+    unsigned long minimum = ~0UL;
+    unsigned long maximum = 0;
+    for (int i = 0; i < 1000; i++) {
+        unsigned long value = linkBackoffMs(3, nextRandom());
+        minimum = value < minimum ? value : minimum;
+        maximum = value > maximum ? value : maximum;
+    }
+    // Номінал 8 с: розкид має покрити більшу частину [6 с, 10 с]
+    TEST_ASSERT_TRUE(minimum < 6400);
+    TEST_ASSERT_TRUE(maximum > 9600);
+}
+
+void test_refused_connections_back_off_then_recover(void) {
+    static constexpr unsigned REFUSALS = 12;
+    RefusingPeer peer{REFUSALS};
+    SimulatedLink device;
+    device.peer = &peer;
+    device.link.retryNow(0);
+
+    // Основний цикл (дисплей, кнопки, MQTT) крутиться поруч з worker: кожна
+    // ітерація має відбутися вчасно, хоч би скільки тривали спроби
+    unsigned long mainLoops = 0;
+    double worstStepUs = 0;
+    unsigned long now = 0;
+    for (; now < 60UL * 60 * 1000 && device.link.state() != BluettiLinkState::ONLINE; now += TICK_MS) {
+        auto started = std::chrono::steady_clock::now();
+        device.step(now);
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+        worstStepUs = us > worstStepUs ? us : worstStepUs;
+        mainLoops++;
+    }
+
+    TEST_ASSERT_EQUAL(BluettiLinkState::ONLINE, device.link.state());
+    TEST_ASSERT_EQUAL(REFUSALS + 1, peer.connects);
+    TEST_ASSERT_EQUAL(REFUSALS, device.failures);
+    TEST_ASSERT_EQUAL(0, device.link.failures()); // Успіх скидає лічильник
+    TEST_ASSERT_EQUAL(now / TICK_MS, mainLoops);
+    TEST_ASSERT_TRUE(worstStepUs < 1000.0);
+
+    // Кожна наступна спроба - рівно після своєї паузи, у межах ±25% номіналу
+    for (unsigned k = 0; k < REFUSALS; k++) {
+        unsigned long nominal = nominalBackoff(k + 1);
+        unsigned long gap = device.attemptsAt[k + 1] - device.failedAt[k];
+        TEST_ASSERT_TRUE(device.backoffs[k] >= nominal - nominal / 4);
+        TEST_ASSERT_TRUE(device.backoffs[k] <= nominal + nominal / 4);
+        TEST_ASSERT_TRUE(gap >= device.backoffs[k] && gap < device.backoffs[k] + TICK_MS);
+    }
+    TEST_ASSERT_TRUE(device.backoffs[REFUSALS - 1] <= LINK_BACKOFF_MAX_MS + LINK_BACKOFF_MAX_MS / 4);
+
+    // Тривалість кожного стану записана за останнім перебуванням
+    TEST_ASSERT_EQUAL_UINT32(SCAN_MS, device.link.durationMs(BluettiLinkState::SCANNING));
+    TEST_ASSERT_EQUAL_UINT32(CONNECT_MS, device.link.durationMs(BluettiLinkState::CONNECTING));
+    TEST_ASSERT_EQUAL_UINT32(SETUP_MS, device.link.durationMs(BluettiLinkState::SUBSCRIBING));
+
+    char line[128];
+    snprintf(line, sizeof(line), "%u refusals: online after %lu s, %lu main loop ticks, worst step %.1f us",
+             REFUSALS, now / 1000, mainLoops, worstStepUs);
+    TEST_MESSAGE(line);
+}
+
+void test_retry_now_skips_backoff(void) {
+    LinkStateMachine link;
+    link.recordFailure(1000, 0);
+    link.recordFailure(3000, 0);
+    TEST_ASSERT_FALSE(link.attemptDue(3000));
+    TEST_ASSERT_EQUAL(2, link.failures());
+    // Нова ціль або розрив робочого з'єднання - одразу
+    link.retryNow(3000);
+    TEST_ASSERT_TRUE(link.attemptDue(3000));
+    TEST_ASSERT_EQUAL(0, link.failures());
+    TEST_ASSERT_FALSE(link.enter(BluettiLinkState::IDLE, 3000));
+    TEST_ASSERT_TRUE(link.enter(BluettiLinkState::SCANNING, 3000));
+    TEST_ASSERT_TRUE(link.inSetup());
+    TEST_ASSERT_FALSE(link.attemptDue(4000));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_backoff_ceiling_and_jitter_range);
+    RUN_TEST(test_jitter_spreads_retries);
+    RUN_TEST(test_refused_connections_back_off_then_recover);
+    RUN_TEST(test_retry_now_skips_backoff);
+    return UNITY_END();
+}
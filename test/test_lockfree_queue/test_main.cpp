@@ -0,0 +1,206 @@
+#include <unity.h>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "lockfree_queue.h"
+
+// Запис розміром з BLE-фрагмент у мініатюрі: кожен байт payload повторює
+// номер запису, тож розірваний (напівзаписаний) запис видно одразу
+struct Record {
+    uint32_t producer;
+    uint32_t sequence;
+    uint8_t payload[56];
+
+    void fill(uint32_t from, uint32_t seq) {
+        producer = from;
+        sequence = seq;
+        for (size_t i = 0; i < sizeof(payload); i++) {
+            payload[i] = (uint8_t)(seq + i + from);
+        }
+    }
+
+    bool intact() const {
+        for (size_t i = 0; i < sizeof(payload); i++) {
+            if (payload[i] != (uint8_t)(sequence + i + producer)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+static constexpr uint32_t RECORDS = 2000000;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_spsc_blocking_producer_loses_nothing(void) {
+    static SpscQueue<Record, 16> queue;
+    std::thread producer([] {
+        for (uint32_t seq = 0; seq < RECORDS; seq++) {
+            Record* slot;
+            while (!(slot = queue.reserve())) {
+                std::this_thread::yield();
+            }
+            slot->fill(0, seq); // Пишемо прямо в слот, як acceptNotification()
+            queue.commit();
+        }
+    });
+
+    uint32_t expected = 0;
+    uint32_t torn = 0;
+    uint32_t outOfOrder = 0;
+    while (expected < RECORDS) {
+        Record* record = queue.front();
+        if (!record) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (!record->intact()) {
+            torn++;
+        }
+        if (record->sequence != expected) {
+            outOfOrder++;
+        }
+        expected = record->sequence + 1;
+        queue.release();
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32(0, queue.size());
+}
+
+void test_spsc_dropping_producer_accounts_for_every_record(void) {
+    // NimBLE callback не може чекати: повна черга - запис відкидається і рахується
+    static SpscQueue<Record, 8> queue;
+    static std::atomic<bool> started{false};
+    static std::atomic<bool> done{false};
+    static std::atomic<uint32_t> dropped{0};
+
+    std::thread producer([] {
+        while (!started.load(std::memory_order_acquire)) {
+        }
+        for (uint32_t seq = 0; seq < RECORDS; seq++) {
+            // Нерівномірні паузи між notifications - черга то порожня, то повна
+            for (volatile uint32_t spin = 0; spin < (seq * 2654435761u) >> 26; spin++) {
+            }
+            Record* slot = queue.reserve();
+            if (!slot) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            slot->fill(0, seq);
+            queue.commit();
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint32_t received = 0;
+    uint32_t torn = 0;
+    int64_t last = -1;
+    uint32_t notIncreasing = 0;
+    Record record;
+    started.store(true, std::memory_order_release);
+    for (;;) {
+        if (queue.pop(record)) {
+            received++;
+            torn += record.intact() ? 0 : 1;
+            notIncreasing += (int64_t)record.sequence > last ? 0 : 1;
+            last = record.sequence;
+        } else if (done.load(std::memory_order_acquire) && queue.size() == 0) {
+            break;
+        }
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, notIncreasing);
+    TEST_ASSERT_EQUAL_UINT32(RECORDS, received + dropped.load());
+    TEST_ASSERT_GREATER_THAN_UINT32(0, received);
+
+    char line[96];
+    snprintf(line, sizeof(line), "spsc drop mode: %u received, %u dropped", received, dropped.load());
+    TEST_MESSAGE(line);
+}
+
+void test_mpsc_producers_lose_and_tear_nothing(void) {
+    // loop, AsyncTCP та кнопки одночасно шлють команди в BLE worker
+    static constexpr uint32_t PRODUCERS = 4;
+    static constexpr uint32_t PER_PRODUCER = RECORDS / PRODUCERS;
+    static MpscQueue<Record, 16> queue;
+
+    std::vector<std::thread> producers;
+    for (uint32_t id = 0; id < PRODUCERS; id++) {
+        producers.emplace_back([id] {
+            Record record;
+            for (uint32_t seq = 0; seq < PER_PRODUCER; seq++) {
+                record.fill(id, seq);
+                while (!queue.push(record)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    uint32_t next[PRODUCERS] = {};
+    uint32_t received = 0;
+    uint32_t torn = 0;
+    uint32_t outOfOrder = 0;
+    uint32_t unknown = 0;
+    Record record;
+    while (received < PRODUCERS * PER_PRODUCER) {
+        if (!queue.pop(record)) {
+            std::this_thread::yield();
+            continue;
+        }
+        received++;
+        if (record.producer >= PRODUCERS) {
+            unknown++;
+            continue;
+        }
+        torn += record.intact() ? 0 : 1;
+        // Від кожного виробника - рівно по порядку, без пропусків
+        outOfOrder += record.sequence == next[record.producer] ? 0 : 1;
+        next[record.producer] = record.sequence + 1;
+    }
+    for (std::thread& producer : producers) {
+        producer.join();
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(0, unknown);
+    TEST_ASSERT_EQUAL_UINT32(0, torn);
+    TEST_ASSERT_EQUAL_UINT32(0, outOfOrder);
+    for (uint32_t id = 0; id < PRODUCERS; id++) {
+        TEST_ASSERT_EQUAL_UINT32(PER_PRODUCER, next[id]);
+    }
+    TEST_ASSERT_FALSE(queue.pop(record));
+}
+
+void test_mpsc_full_queue_rejects_push(void) {
+    MpscQueue<uint32_t, 4> queue;
+    for (uint32_t i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(queue.push(i));
+    }
+    TEST_ASSERT_FALSE(queue.push(99));
+    uint32_t value;
+    TEST_ASSERT_TRUE(queue.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(0, value);
+    TEST_ASSERT_TRUE(queue.push(4));
+    for (uint32_t i = 1; i <= 4; i++) {
+        TEST_ASSERT_TRUE(queue.pop(value));
+        TEST_ASSERT_EQUAL_UINT32(i, value);
+    }
+    TEST_ASSERT_FALSE(queue.pop(value));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_spsc_blocking_producer_loses_nothing);
+    RUN_TEST(test_spsc_dropping_producer_accounts_for_every_record);
+    RUN_TEST(test_mpsc_producers_lose_and_tear_nothing);
+    RUN_TEST(test_mpsc_full_queue_rejects_push);
+    return UNITY_END();
+}
@@ -0,0 +1,137 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include "modbus_crc.h"
+#include "modbus_frame.h"
+#include "modbus_transaction.h"
+
+// Побітовий CRC16 і ручна збірка кадру - рівно так, як це робили
+// setACOutput()/writeSingleRegister()/requestRegister() до таблиць
+static uint16_t bitwiseCRC16(const uint8_t* data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x0001) {
+                crc = (crc >> 1) ^ 0xA001;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+static void handRolledFrame(uint8_t function, uint16_t reg, uint16_t value, uint8_t* cmd) {
+    cmd[0] = 0x01;
+    cmd[1] = function;
+    cmd[2] = (reg >> 8) & 0xFF;
+    cmd[3] = reg & 0xFF;
+    cmd[4] = (value >> 8) & 0xFF;
+    cmd[5] = value & 0xFF;
+    uint16_t crc = bitwiseCRC16(cmd, 6);
+    cmd[6] = crc & 0xFF;
+    cmd[7] = (crc >> 8) & 0xFF;
+}
+
+static uint32_t rngState = 0x12345678;
+
+static uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_constant_frames_match_hand_rolled_bytes(void) {
+    uint8_t expected[MODBUS_REQUEST_SIZE];
+    handRolledFrame(0x03, 0x000A, 40, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MODBUS_STATUS_POLL_BYTES, MODBUS_REQUEST_SIZE);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, (MODBUS_CONSTANT_REQUEST<0x03, 0x000A, 40>.bytes), MODBUS_REQUEST_SIZE);
+
+    handRolledFrame(0x06, 0x0BBF, 1, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MODBUS_AC_ON_BYTES, MODBUS_REQUEST_SIZE);
+    handRolledFrame(0x06, 0x0BBF, 0, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MODBUS_AC_OFF_BYTES, MODBUS_REQUEST_SIZE);
+    handRolledFrame(0x06, 0x0BC0, 1, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MODBUS_DC_ON_BYTES, MODBUS_REQUEST_SIZE);
+    handRolledFrame(0x06, 0x0BC0, 0, expected);
+    TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, MODBUS_DC_OFF_BYTES, MODBUS_REQUEST_SIZE);
+}
+
+void test_runtime_frames_match_for_every_register(void) {
+    // Усі адреси для запису й читання одного регістра, значення - з різними байтами
+    static const uint16_t values[] = {0x0000, 0x0001, 0x0002, 0x00FF, 0x0100, 0x1234, 0xFFFF};
+    uint8_t expected[MODBUS_REQUEST_SIZE];
+    uint8_t built[ModbusTransactionEngine::FRAME_SIZE];
+    for (uint32_t reg = 0; reg <= 0xFFFF; reg++) {
+        handRolledFrame(0x03, (uint16_t)reg, 1, expected);
+        ModbusRequestFrame read = buildModbusRequest(0x03, (uint16_t)reg, 1);
+        TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, read.bytes, MODBUS_REQUEST_SIZE);
+
+        for (uint16_t value : values) {
+            handRolledFrame(0x06, (uint16_t)reg, value, expected);
+            ModbusTransaction txn;
+            txn.function = 0x06;
+            txn.address = (uint16_t)reg;
+            txn.value = value;
+            TEST_ASSERT_EQUAL(MODBUS_REQUEST_SIZE, ModbusTransactionEngine::buildFrame(txn, built));
+            TEST_ASSERT_EQUAL_HEX8_ARRAY(expected, built, MODBUS_REQUEST_SIZE);
+        }
+    }
+}
+
+void test_table_crc_matches_bitwise_on_random_buffers(void) {
+    uint8_t buffer[300];
+    for (int round = 0; round < 20000; round++) {
+        size_t length = nextRandom() % sizeof(buffer);
+        for (size_t i = 0; i < length; i++) {
+            buffer[i] = (uint8_t)nextRandom();
+        }
+        TEST_ASSERT_EQUAL_HEX16(bitwiseCRC16(buffer, length), calculateCRC16(buffer, length));
+    }
+}
+
+template <typename Crc>
+static double crcMegabytesPerSecond(Crc crc, const uint8_t* data, size_t length, uint32_t rounds,
+                                    uint32_t& sink) {
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++) {
+        sink += crc(data, length - (i & 7)); // Довжина змінюється - виклик не винесеться з циклу
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return (double)rounds * length / elapsed / 1e6;
+}
+
+void test_benchmark_table_vs_bitwise_crc(void) {
+    // Типовий розмір: відповідь статусу без CRC (83 байти)
+    static constexpr size_t LENGTH = 83;
+    static constexpr uint32_t ROUNDS = 500000;
+    uint8_t frame[LENGTH];
+    for (size_t i = 0; i < LENGTH; i++) {
+        frame[i] = (uint8_t)nextRandom();
+    }
+    uint32_t sink = 0;
+    double bitwise = crcMegabytesPerSecond(bitwiseCRC16, frame, LENGTH, ROUNDS, sink);
+    double table = crcMegabytesPerSecond(
+        [](const uint8_t* data, size_t length) { return calculateCRC16(data, length); }, frame, LENGTH,
+        ROUNDS, sink);
+
+    char line[128];
+    snprintf(line, sizeof(line), "CRC16 over %u bytes: bitwise %.1f MB/s, table %.1f MB/s (x%.1f), sink %u",
+             (unsigned)LENGTH, bitwise, table, table / bitwise, sink);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_TRUE(table > bitwise);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_constant_frames_match_hand_rolled_bytes);
+    RUN_TEST(test_runtime_frames_match_for_every_register);
+    RUN_TEST(test_table_crc_matches_bitwise_on_random_buffers);
+    RUN_TEST(test_benchmark_table_vs_bitwise_crc);
+    return UNITY_END();
+}
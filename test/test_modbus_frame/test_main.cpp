@@ -0,0 +1,127 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include "modbus_crc.h"
+#include "modbus_frame.h"
+
+static uint8_t statusFrame[5 + 80];
+
+static void sealFrame(uint8_t* frame, size_t lengthWithoutCrc) {
+    uint16_t crc = calculateCRC16(frame, lengthWithoutCrc);
+    frame[lengthWithoutCrc] = crc & 0xFF;
+    frame[lengthWithoutCrc + 1] = crc >> 8;
+}
+
+void setUp(void) {
+    statusFrame[0] = 0x01;
+    statusFrame[1] = 0x03;
+    statusFrame[2] = 80;
+    for (int i = 0; i < 80; i++) {
+        statusFrame[3 + i] = (uint8_t)(i * 3);
+    }
+    sealFrame(statusFrame, 83);
+}
+
+void tearDown(void) {}
+
+void test_read_response_view_points_into_buffer(void) {
+    ModbusFrameView view;
+    TEST_ASSERT_EQUAL(ModbusFrameError::NONE, parseModbusFrame(statusFrame, sizeof(statusFrame), view));
+    TEST_ASSERT_EQUAL(ModbusFrameType::READ_RESPONSE, view.type);
+    TEST_ASSERT_TRUE(view.data == statusFrame);
+    TEST_ASSERT_TRUE(view.payload == statusFrame + 3);
+    TEST_ASSERT_EQUAL(40, view.registerCount());
+    TEST_ASSERT_EQUAL_HEX16(0x0003, view.registerAt(0));
+    TEST_ASSERT_EQUAL_HEX16((234 << 8) | 237, view.registerAt(39));
+}
+
+void test_write_echo_and_exception(void) {
+    ModbusFrameView view;
+    TEST_ASSERT_EQUAL(ModbusFrameError::NONE, parseModbusFrame(MODBUS_AC_ON_BYTES, sizeof(MODBUS_AC_ON_BYTES), view));
+    TEST_ASSERT_EQUAL(ModbusFrameType::WRITE_ECHO, view.type);
+    TEST_ASSERT_EQUAL_HEX16(0x0BBF, view.address);
+    TEST_ASSERT_EQUAL_HEX16(1, view.value);
+
+    uint8_t exception[5] = {0x01, 0x86, 0x02};
+    sealFrame(exception, 3);
+    TEST_ASSERT_EQUAL(ModbusFrameError::NONE, parseModbusFrame(exception, sizeof(exception), view));
+    TEST_ASSERT_EQUAL(ModbusFrameType::EXCEPTION, view.type);
+    TEST_ASSERT_EQUAL_HEX8(0x06, view.requestFunction());
+    TEST_ASSERT_EQUAL_HEX8(0x02, view.exceptionCode);
+}
+
+void test_each_rejection_reason(void) {
+    ModbusFrameView view;
+    TEST_ASSERT_EQUAL(ModbusFrameError::TOO_SHORT, parseModbusFrame(statusFrame, 4, view));
+
+    uint8_t frame[sizeof(statusFrame)];
+    memcpy(frame, statusFrame, sizeof(frame));
+    frame[0] = 0x02;
+    TEST_ASSERT_EQUAL(ModbusFrameError::BAD_DEVICE_ID, parseModbusFrame(frame, sizeof(frame), view));
+
+    memcpy(frame, statusFrame, sizeof(frame));
+    frame[1] = 0x04;
+    TEST_ASSERT_EQUAL(ModbusFrameError::BAD_FUNCTION, parseModbusFrame(frame, sizeof(frame), view));
+
+    TEST_ASSERT_EQUAL(ModbusFrameError::BAD_LENGTH, parseModbusFrame(statusFrame, sizeof(statusFrame) - 1, view));
+    memcpy(frame, statusFrame, sizeof(frame));
+    frame[2] = 79; // Непарний byte count
+    TEST_ASSERT_EQUAL(ModbusFrameError::BAD_LENGTH, parseModbusFrame(frame, 84, view));
+
+    memcpy(frame, statusFrame, sizeof(frame));
+    frame[40] ^= 0x01;
+    TEST_ASSERT_EQUAL(ModbusFrameError::BAD_CRC, parseModbusFrame(frame, sizeof(frame), view));
+    TEST_ASSERT_NULL(view.data); // Відкинутий кадр не лишає view на буфер
+    TEST_ASSERT_EQUAL_STRING("bad_crc", modbusFrameErrorName(ModbusFrameError::BAD_CRC));
+}
+
+void test_every_single_bit_flip_is_rejected(void) {
+    // CRC16 ловить будь-яку однобітову помилку - пошкоджений кадр не дійде до SystemStatus
+    uint8_t frame[sizeof(statusFrame)];
+    ModbusFrameView view;
+    for (size_t bit = 0; bit < sizeof(frame) * 8; bit++) {
+        memcpy(frame, statusFrame, sizeof(frame));
+        frame[bit / 8] ^= (uint8_t)(1u << (bit % 8));
+        TEST_ASSERT_TRUE(parseModbusFrame(frame, sizeof(frame), view) != ModbusFrameError::NONE);
+    }
+}
+
+void test_benchmark_parse_throughput(void) {
+    static constexpr uint32_t FRAMES = 2000000;
+    static constexpr size_t VARIANTS = 64;
+    // Різні кадри по колу - компілятор не винесе парсер з циклу
+    static uint8_t frames[VARIANTS][sizeof(statusFrame)];
+    for (size_t v = 0; v < VARIANTS; v++) {
+        memcpy(frames[v], statusFrame, sizeof(statusFrame));
+        frames[v][3] = (uint8_t)v;
+        sealFrame(frames[v], 83);
+    }
+
+    ModbusFrameView view;
+    uint32_t accepted = 0;
+    uint32_t checksum = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        if (parseModbusFrame(frames[i % VARIANTS], sizeof(statusFrame), view) == ModbusFrameError::NONE) {
+            accepted++;
+            checksum += view.registerAt(0);
+        }
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+
+    TEST_ASSERT_EQUAL_UINT32(FRAMES, accepted);
+    char line[128];
+    snprintf(line, sizeof(line), "parse 85-byte status frame: %.0f frames/s, %.1f MB/s, checksum %u",
+             FRAMES / elapsed, FRAMES * sizeof(statusFrame) / elapsed / 1e6, checksum);
+    TEST_MESSAGE(line);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_read_response_view_points_into_buffer);
+    RUN_TEST(test_write_echo_and_exception);
+    RUN_TEST(test_each_rejection_reason);
+    RUN_TEST(test_every_single_bit_flip_is_rejected);
+    RUN_TEST(test_benchmark_parse_throughput);
+    return UNITY_END();
+}
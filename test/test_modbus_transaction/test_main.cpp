@@ -0,0 +1,336 @@
+#include <unity.h>
+#include <chrono>
+#include "modbus_frame.h"
+#include "modbus_transaction.h"
+#include "simulated_eb3a.h"
+
+// Ті самі значення, що й у BluettiDevice
+static constexpr unsigned long STATUS_RESPONSE_TIMEOUT_MS = 2000;
+static constexpr unsigned long POST_STATUS_QUIET_MS = 1000;
+static constexpr unsigned long STATUS_INTERVAL_MS = 3000;
+static constexpr unsigned long TICK_MS = 10; // Період BLE worker
+// "Кілька мілісекунд" з вимоги - із запасом на повільний CI
+static constexpr long long MAX_TICK_US = 2000;
+
+// Один прохід online-гілки BluettiDevice::loop() над віртуальним часом:
+// notification -> complete, дедлайн, планування опитування, відправка
+struct DeviceLoop {
+    ModbusTransactionEngine engine;
+    SimulatedEb3a peer;
+    unsigned long now = 0;
+    unsigned long lastPoll = 0 - STATUS_INTERVAL_MS; // Перше опитування одразу
+    uint32_t completed = 0;
+    uint32_t failed = 0;
+    long long worstTickUs = 0;
+
+    void tick() {
+        auto started = std::chrono::steady_clock::now();
+
+        const uint8_t* data;
+        size_t length;
+        if (peer.poll(now, data, length)) {
+            ModbusFrameView view;
+            if (parseModbusFrame(data, length, view) == ModbusFrameError::NONE &&
+                engine.complete(view, now)) {
+                completed++;
+                engine.holdOff(now + POST_STATUS_QUIET_MS);
+            }
+        }
+        if (engine.expire(now) == ModbusExpireResult::FAILED) {
+            failed++;
+        }
+        if (now - lastPoll >= STATUS_INTERVAL_MS) {
+            ModbusTransaction txn;
+            txn.address = 0x000A;
+            txn.value = 40;
+            txn.timeoutMs = STATUS_RESPONSE_TIMEOUT_MS;
+            engine.enqueue(txn, now);
+            lastPoll = now;
+        }
+        ModbusTransaction txn;
+        if (engine.startNext(now, txn)) {
+            uint8_t frame[ModbusTransactionEngine::FRAME_SIZE];
+            size_t frameLength = ModbusTransactionEngine::buildFrame(txn, frame);
+            peer.receive(frame, frameLength, now);
+        }
+
+        auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - started).count();
+        if (elapsed > worstTickUs) {
+            worstTickUs = elapsed;
+        }
+        now += TICK_MS;
+    }
+
+    void run(unsigned long durationMs) {
+        unsigned long until = now + durationMs;
+        while ((long)(until - now) > 0) {
+            tick();
+        }
+    }
+};
+
+static DeviceLoop* loop;
+
+void setUp(void) {
+    loop = new DeviceLoop();
+}
+
+void tearDown(void) {
+    delete loop;
+}
+
+static void reportWorstTick(const char* name) {
+    char line[96];
+    snprintf(line, sizeof(line), "%s: worst loop tick %lld us", name, loop->worstTickUs);
+    TEST_MESSAGE(line);
+}
+
+void test_responsive_peer_completes_every_poll(void) {
+    loop->peer.latencyMs = 120;
+    loop->run(60000);
+
+    TEST_ASSERT_EQUAL_UINT32(0, loop->failed);
+    TEST_ASSERT_UINT32_WITHIN(1, 60000 / STATUS_INTERVAL_MS, loop->completed);
+    TEST_ASSERT_UINT32_WITHIN(TICK_MS, 120, loop->engine.getLastLatency());
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_TICK_US, loop->worstTickUs);
+    reportWorstTick("responsive");
+}
+
+void test_slow_peer_never_blocks_the_loop(void) {
+    // Відповідь на межі таймауту: старий код весь цей час крутив delay(50)
+    loop->peer.latencyMs = STATUS_RESPONSE_TIMEOUT_MS - 100;
+    loop->run(60000);
+
+    TEST_ASSERT_EQUAL_UINT32(0, loop->failed);
+    TEST_ASSERT_UINT32_WITHIN(1, 60000 / STATUS_INTERVAL_MS, loop->completed);
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_TICK_US, loop->worstTickUs);
+    reportWorstTick("slow");
+}
+
+void test_silent_peer_fails_at_deadline(void) {
+    loop->peer.silent = true;
+    loop->run(STATUS_RESPONSE_TIMEOUT_MS); // Тіки 0..1990 мс
+    TEST_ASSERT_TRUE(loop->engine.isBusy());
+    TEST_ASSERT_EQUAL_UINT32(0, loop->failed);
+
+    loop->run(TICK_MS);
+    TEST_ASSERT_FALSE(loop->engine.isBusy());
+    TEST_ASSERT_EQUAL_UINT32(1, loop->failed);
+    TEST_ASSERT_EQUAL_UINT32(1, loop->engine.getTimeouts());
+}
+
+void test_silent_peer_keeps_loop_latency_and_queue_bounded(void) {
+    loop->peer.silent = true;
+    loop->run(10 * 60 * 1000);
+
+    TEST_ASSERT_EQUAL_UINT32(0, loop->completed);
+    TEST_ASSERT_EQUAL_UINT32(loop->engine.getTimeouts(), loop->failed);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, loop->failed);
+    TEST_ASSERT_LESS_OR_EQUAL(ModbusTransactionEngine::QUEUE_CAPACITY, loop->engine.queued());
+    TEST_ASSERT_LESS_OR_EQUAL(MAX_TICK_US, loop->worstTickUs);
+    reportWorstTick("silent");
+}
+
+void test_peer_recovers_after_silence(void) {
+    loop->peer.silent = true;
+    loop->run(20000);
+    uint32_t failedWhileSilent = loop->failed;
+    TEST_ASSERT_GREATER_THAN_UINT32(0, failedWhileSilent);
+
+    loop->peer.silent = false;
+    loop->peer.latencyMs = 200;
+    loop->run(20000);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, loop->completed);
+    // Запит, відправлений ще в тишу, може завершитися таймаутом
+    TEST_ASSERT_LESS_OR_EQUAL(failedWhileSilent + 1, loop->failed);
+}
+
+void test_retry_goes_back_to_queue_head(void) {
+    loop->peer.silent = true;
+    ModbusTransaction poll;
+    poll.address = 0x000A;
+    poll.value = 40;
+    loop->engine.enqueue(poll, 0);
+
+    ModbusTransaction write;
+    write.kind = ModbusTxnKind::WRITE_REGISTER;
+    write.priority = ModbusPriority::USER_WRITE;
+    write.function = 0x06;
+    write.address = 0x0BBF;
+    write.value = 1;
+    write.retriesLeft = 1;
+    write.timeoutMs = 500;
+    loop->engine.enqueue(write, 0);
+
+    ModbusTransaction sent;
+    TEST_ASSERT_TRUE(loop->engine.startNext(0, sent));
+    TEST_ASSERT_EQUAL_HEX16(0x0BBF, sent.address);
+    TEST_ASSERT_EQUAL(ModbusExpireResult::NONE, loop->engine.expire(499));
+    TEST_ASSERT_EQUAL(ModbusExpireResult::RETRY, loop->engine.expire(500));
+
+    TEST_ASSERT_TRUE(loop->engine.startNext(500, sent));
+    TEST_ASSERT_EQUAL_HEX16(0x0BBF, sent.address);
+    TEST_ASSERT_EQUAL(0, sent.retriesLeft);
+    TEST_ASSERT_EQUAL(ModbusExpireResult::FAILED, loop->engine.expire(1000));
+    TEST_ASSERT_EQUAL_UINT32(1, loop->engine.getRetries());
+    TEST_ASSERT_EQUAL_UINT32(1, loop->engine.queued());
+}
+
+void test_response_to_other_request_is_ignored(void) {
+    ModbusTransaction poll;
+    poll.address = 0x000A;
+    poll.value = 40;
+    loop->engine.enqueue(poll, 0);
+    ModbusTransaction sent;
+    TEST_ASSERT_TRUE(loop->engine.startNext(0, sent));
+
+    // Відповідь на запит одного регістра не завершує читання 40
+    uint8_t request[MODBUS_REQUEST_SIZE];
+    ModbusRequestFrame single = buildModbusRequest(0x03, 0x000A, 1);
+    memcpy(request, single.bytes, sizeof(request));
+    loop->peer.receive(request, sizeof(request), 0);
+    const uint8_t* data;
+    size_t length;
+    TEST_ASSERT_TRUE(loop->peer.poll(0, data, length));
+    ModbusFrameView view;
+    TEST_ASSERT_EQUAL(ModbusFrameError::NONE, parseModbusFrame(data, length, view));
+    TEST_ASSERT_FALSE(loop->engine.complete(view, 10));
+    TEST_ASSERT_TRUE(loop->engine.isBusy());
+}
+
+static ModbusTransaction ticketedWrite(uint16_t address, uint16_t ticket) {
+    ModbusTransaction write;
+    write.kind = ModbusTxnKind::WRITE_REGISTER;
+    write.priority = ModbusPriority::USER_WRITE;
+    write.function = 0x06;
+    write.address = address;
+    write.value = 1;
+    write.retriesLeft = 1;
+    write.timeoutMs = 500;
+    write.ticket = ticket;
+    return write;
+}
+
+static ModbusTransaction backgroundRead(uint16_t address) {
+    ModbusTransaction read;
+    read.kind = ModbusTxnKind::READ_REGISTER;
+    read.address = address;
+    read.value = 1;
+    read.retriesLeft = 1;
+    read.timeoutMs = 500;
+    return read;
+}
+
+void test_retry_eviction_returns_ticketed_write(void) {
+    ModbusTransactionEngine& engine = loop->engine;
+    TEST_ASSERT_TRUE(engine.enqueue(ticketedWrite(0x0BB0, 100), 0));
+    ModbusTransaction sent;
+    TEST_ASSERT_TRUE(engine.startNext(0, sent)); // Запис у польоті, черга - записи з ticket і одне читання
+    for (uint16_t i = 1; i < ModbusTransactionEngine::QUEUE_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(engine.enqueue(ticketedWrite(0x0BB0 + i, 100 + i), 0));
+    }
+    ModbusTransaction ticketedRead = backgroundRead(0x0BC0);
+    ticketedRead.priority = ModbusPriority::USER_READ;
+    ticketedRead.ticket = 99;
+    TEST_ASSERT_TRUE(engine.enqueue(ticketedRead, 0));
+    TEST_ASSERT_EQUAL(ModbusTransactionEngine::QUEUE_CAPACITY, engine.queued());
+    ModbusTransaction evicted;
+    TEST_ASSERT_FALSE(engine.takeEvicted(evicted));
+
+    // Повтор запису стає в голову і витісняє наймолодший запит нижчого пріоритету
+    TEST_ASSERT_EQUAL(ModbusExpireResult::RETRY, engine.expire(500));
+    TEST_ASSERT_TRUE(engine.takeEvicted(evicted));
+    TEST_ASSERT_EQUAL_UINT16(99, evicted.ticket);
+    TEST_ASSERT_FALSE(engine.takeEvicted(evicted));
+    TEST_ASSERT_EQUAL_UINT32(1, engine.getDropped());
+
+    ModbusTransaction next;
+    TEST_ASSERT_TRUE(engine.startNext(500, next));
+    TEST_ASSERT_EQUAL_UINT16(100, next.ticket);
+}
+
+// Транзакція inFlight у польоті, черга повна записами користувача: повтор
+// відкидається (FAILED), жоден запис не витіснено
+static void expectRetryDropped(const ModbusTransaction& inFlight, uint16_t firstTicket) {
+    ModbusTransactionEngine& engine = loop->engine;
+    engine.clear();
+    uint32_t dropped = engine.getDropped();
+    uint32_t retries = engine.getRetries();
+    TEST_ASSERT_TRUE(engine.enqueue(inFlight, 0));
+    ModbusTransaction sent;
+    TEST_ASSERT_TRUE(engine.startNext(0, sent));
+    for (uint16_t i = 0; i < ModbusTransactionEngine::QUEUE_CAPACITY; i++) {
+        TEST_ASSERT_TRUE(engine.enqueue(ticketedWrite(0x0BB0 + i, firstTicket + i), 0));
+    }
+
+    TEST_ASSERT_EQUAL(ModbusExpireResult::FAILED, engine.expire(inFlight.timeoutMs));
+    ModbusTransaction evicted;
+    TEST_ASSERT_FALSE(engine.takeEvicted(evicted));
+    TEST_ASSERT_EQUAL(ModbusTransactionEngine::QUEUE_CAPACITY, engine.queued());
+    TEST_ASSERT_EQUAL_UINT32(dropped + 1, engine.getDropped());
+    TEST_ASSERT_EQUAL_UINT32(retries, engine.getRetries());
+    ModbusTransaction next;
+    TEST_ASSERT_TRUE(engine.startNext(inFlight.timeoutMs, next));
+    TEST_ASSERT_EQUAL_UINT16(firstTicket, next.ticket);
+}
+
+void test_retry_never_evicts_higher_or_equal_priority(void) {
+    // Фонове читання
+    expectRetryDropped(backgroundRead(0x0BE0), 200);
+    // Читання користувача з ticket
+    ModbusTransaction userRead = backgroundRead(0x0BE1);
+    userRead.priority = ModbusPriority::USER_READ;
+    userRead.ticket = 50;
+    expectRetryDropped(userRead, 300);
+    // Запис того самого пріоритету - жоден з двох не важливіший
+    expectRetryDropped(ticketedWrite(0x0BE2, 60), 400);
+}
+
+void test_enqueue_eviction_returns_only_ticketed_entries(void) {
+    ModbusTransactionEngine& engine = loop->engine;
+    // Повна черга фонових читань: витіснене опитування не має кому звітувати
+    for (uint16_t i = 0; i < ModbusTransactionEngine::QUEUE_CAPACITY; i++) {
+        ModbusTransaction read;
+        read.kind = ModbusTxnKind::READ_REGISTER;
+        read.address = 0x0BF0 + i;
+        read.value = 1;
+        TEST_ASSERT_TRUE(engine.enqueue(read, 0));
+    }
+    TEST_ASSERT_TRUE(engine.enqueue(ticketedWrite(0x0BBF, 7), 0));
+    ModbusTransaction evicted;
+    TEST_ASSERT_FALSE(engine.takeEvicted(evicted));
+    TEST_ASSERT_EQUAL_UINT32(1, engine.getDropped());
+
+    // Читання з ticket витісняє запис вищого пріоритету - викликач дізнається про нього
+    ModbusTransaction ticketedRead;
+    ticketedRead.kind = ModbusTxnKind::READ_REGISTER;
+    ticketedRead.priority = ModbusPriority::USER_READ;
+    ticketedRead.value = 1;
+    engine.clear();
+    for (uint16_t i = 0; i < ModbusTransactionEngine::QUEUE_CAPACITY; i++) {
+        ticketedRead.address = 0x0BD0 + i;
+        ticketedRead.ticket = 10 + i;
+        TEST_ASSERT_TRUE(engine.enqueue(ticketedRead, 0));
+    }
+    TEST_ASSERT_TRUE(engine.enqueue(ticketedWrite(0x0BC0, 9), 0));
+    engine.clear(); // Витіснене переживає clear() - звіт ще не забрали
+    TEST_ASSERT_TRUE(engine.takeEvicted(evicted));
+    TEST_ASSERT_EQUAL_UINT16(10 + ModbusTransactionEngine::QUEUE_CAPACITY - 1, evicted.ticket);
+    TEST_ASSERT_FALSE(engine.takeEvicted(evicted));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_responsive_peer_completes_every_poll);
+    RUN_TEST(test_slow_peer_never_blocks_the_loop);
+    RUN_TEST(test_silent_peer_fails_at_deadline);
+    RUN_TEST(test_silent_peer_keeps_loop_latency_and_queue_bounded);
+    RUN_TEST(test_peer_recovers_after_silence);
+    RUN_TEST(test_retry_goes_back_to_queue_head);
+    RUN_TEST(test_response_to_other_request_is_ignored);
+    RUN_TEST(test_retry_eviction_returns_ticketed_write);
+    RUN_TEST(test_retry_never_evicts_higher_or_equal_priority);
+    RUN_TEST(test_enqueue_eviction_returns_only_ticketed_entries);
+    return UNITY_END();
+}
@@ -0,0 +1,57 @@
+#include <unity.h>
+#include "mqtt_deadband.h"
+
+static const Deadband& powerBand = DEFAULT_DEADBANDS[static_cast<size_t>(StateField::AC_POWER)];
+static DeadbandFilter filter;
+
+void setUp(void) {
+    filter = DeadbandFilter();
+}
+
+void tearDown(void) {}
+
+void test_noise_inside_band_is_suppressed(void) {
+    TEST_ASSERT_TRUE(filter.admit(StateField::AC_POWER, 120, powerBand, false)); // Перша публікація
+    TEST_ASSERT_FALSE(filter.admit(StateField::AC_POWER, 123, powerBand, false));
+    TEST_ASSERT_FALSE(filter.admit(StateField::AC_POWER, 116, powerBand, false));
+    TEST_ASSERT_TRUE(filter.admit(StateField::AC_POWER, 126, powerBand, false)); // 5% від 120 = 6 W
+    // Heartbeat публікує і в межах deadband
+    TEST_ASSERT_TRUE(filter.admit(StateField::AC_POWER, 127, powerBand, true));
+}
+
+void test_relative_band_for_large_loads(void) {
+    TEST_ASSERT_TRUE(deadbandExceeded(2000, 2100, powerBand));
+    TEST_ASSERT_FALSE(deadbandExceeded(2000, 2090, powerBand));
+    TEST_ASSERT_FALSE(deadbandExceeded(20, 24, powerBand));
+    TEST_ASSERT_TRUE(deadbandExceeded(20, 25, powerBand));
+}
+
+void test_transitions_to_and_from_zero_always_publish(void) {
+    // Зарядник телефону на 1-4 W вимкнули: 0 W має потрапити в MQTT
+    for (int watts = 1; watts <= 4; watts++) {
+        TEST_ASSERT_TRUE(deadbandExceeded((float)watts, 0.0f, powerBand));
+        TEST_ASSERT_TRUE(deadbandExceeded(0.0f, (float)watts, powerBand));
+    }
+    TEST_ASSERT_TRUE(filter.admit(StateField::AC_POWER, 3, powerBand, false));
+    TEST_ASSERT_TRUE(filter.admit(StateField::AC_POWER, 0, powerBand, false));
+    TEST_ASSERT_FALSE(filter.admit(StateField::AC_POWER, 0, powerBand, false));
+    TEST_ASSERT_TRUE(filter.admit(StateField::AC_POWER, 2, powerBand, false));
+    // Між ненульовими значеннями поріг діє як раніше
+    TEST_ASSERT_FALSE(filter.admit(StateField::AC_POWER, 4, powerBand, false));
+}
+
+void test_forget_republishes_everything(void) {
+    TEST_ASSERT_TRUE(filter.admit(StateField::BATTERY, 80, DEFAULT_DEADBANDS[0], false));
+    TEST_ASSERT_FALSE(filter.admit(StateField::BATTERY, 80, DEFAULT_DEADBANDS[0], false));
+    filter.forget();
+    TEST_ASSERT_TRUE(filter.admit(StateField::BATTERY, 80, DEFAULT_DEADBANDS[0], false));
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_noise_inside_band_is_suppressed);
+    RUN_TEST(test_relative_band_for_large_loads);
+    RUN_TEST(test_transitions_to_and_from_zero_always_publish);
+    RUN_TEST(test_forget_republishes_everything);
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include "modbus_crc.h"
+#include "notification_reassembler.h"
+
+// Лічильник алокацій: реассемблер не має виділяти пам'ять на кадр
+static std::atomic<uint32_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations++;
+    void* p = malloc(size ? size : 1);
+    if (!p) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Фрагмент при стандартному ATT MTU 23
+static constexpr size_t DEFAULT_MTU_PAYLOAD = 20;
+
+static uint8_t statusFrame[5 + 80];
+
+static size_t buildReadResponse(uint8_t* out, uint8_t registers, uint16_t seed) {
+    out[0] = 0x01;
+    out[1] = 0x03;
+    out[2] = registers * 2;
+    for (uint8_t i = 0; i < registers; i++) {
+        uint16_t value = seed + i;
+        out[3 + i * 2] = value >> 8;
+        out[4 + i * 2] = value & 0xFF;
+    }
+    size_t length = 3 + registers * 2;
+    uint16_t crc = calculateCRC16(out, length);
+    out[length++] = crc & 0xFF;
+    out[length++] = crc >> 8;
+    return length;
+}
+
+static void pushFragmented(NotificationReassembler& reassembler, const uint8_t* data,
+                           size_t length, size_t fragment, unsigned long now) {
+    for (size_t offset = 0; offset < length; offset += fragment) {
+        size_t chunk = length - offset < fragment ? length - offset : fragment;
+        reassembler.push(data + offset, chunk, now);
+    }
+}
+
+void setUp(void) {
+    buildReadResponse(statusFrame, 40, 0x1000);
+}
+
+void tearDown(void) {}
+
+void test_whole_frame_in_one_notification(void) {
+    NotificationReassembler reassembler;
+    reassembler.push(statusFrame, sizeof(statusFrame), 0);
+
+    ModbusFrameView view;
+    TEST_ASSERT_TRUE(reassembler.nextFrame(view));
+    TEST_ASSERT_EQUAL(40, view.registerCount());
+    TEST_ASSERT_EQUAL_HEX16(0x1000, view.registerAt(0));
+    TEST_ASSERT_EQUAL_HEX16(0x1027, view.registerAt(39));
+    TEST_ASSERT_EQUAL(1, reassembler.getLastFrameFragments());
+    TEST_ASSERT_FALSE(reassembler.nextFrame(view));
+}
+
+void test_frame_split_at_default_mtu(void) {
+    NotificationReassembler reassembler;
+    ModbusFrameView view;
+    for (size_t offset = 0; offset < sizeof(statusFrame); offset += DEFAULT_MTU_PAYLOAD) {
+        TEST_ASSERT_FALSE(reassembler.nextFrame(view));
+        size_t chunk = sizeof(statusFrame) - offset;
+        reassembler.push(statusFrame + offset, chunk < DEFAULT_MTU_PAYLOAD ? chunk : DEFAULT_MTU_PAYLOAD, 0);
+    }
+    TEST_ASSERT_TRUE(reassembler.nextFrame(view));
+    TEST_ASSERT_EQUAL_HEX16(0x1027, view.registerAt(39));
+    TEST_ASSERT_EQUAL(5, reassembler.getLastFrameFragments());
+    TEST_ASSERT_EQUAL_UINT32(1, reassembler.getFragmentedFrames());
+}
+
+void test_every_split_point_yields_the_same_frame(void) {
+    for (size_t split = 1; split < sizeof(statusFrame); split++) {
+        NotificationReassembler reassembler;
+        reassembler.push(statusFrame, split, 0);
+        reassembler.push(statusFrame + split, sizeof(statusFrame) - split, 0);
+        ModbusFrameView view;
+        TEST_ASSERT_TRUE(reassembler.nextFrame(view));
+        TEST_ASSERT_EQUAL_MEMORY(statusFrame, view.data, sizeof(statusFrame));
+    }
+}
+
+void test_resyncs_after_garbage_and_bad_crc(void) {
+    NotificationReassembler reassembler;
+    const uint8_t garbage[] = {0xFF, 0x00, 0x42};
+    uint8_t corrupted[sizeof(statusFrame)];
+    memcpy(corrupted, statusFrame, sizeof(corrupted));
+    corrupted[10] ^= 0x55;
+
+    reassembler.push(garbage, sizeof(garbage), 0);
+    reassembler.push(corrupted, sizeof(corrupted), 0);
+    reassembler.push(statusFrame, sizeof(statusFrame), 0);
+
+    ModbusFrameView view;
+    TEST_ASSERT_TRUE(reassembler.nextFrame(view));
+    TEST_ASSERT_EQUAL_MEMORY(statusFrame, view.data, sizeof(statusFrame));
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(1, reassembler.getCrcErrors());
+    TEST_ASSERT_FALSE(reassembler.nextFrame(view));
+}
+
+void test_stale_fragment_is_dropped(void) {
+    NotificationReassembler reassembler;
+    reassembler.push(statusFrame, 30, 0);
+    // Хвіст не прийшов - новий кадр через секунду не склеюється зі старим
+    reassembler.push(statusFrame, sizeof(statusFrame),
+                     NotificationReassembler::STALE_FRAGMENT_MS + 1);
+    ModbusFrameView view;
+    TEST_ASSERT_TRUE(reassembler.nextFrame(view));
+    TEST_ASSERT_EQUAL_MEMORY(statusFrame, view.data, sizeof(statusFrame));
+    TEST_ASSERT_EQUAL_UINT32(30, reassembler.getBytesDropped());
+}
+
+void test_benchmark_frames_per_second_without_allocations(void) {
+    static constexpr uint32_t FRAMES = 200000;
+    NotificationReassembler reassembler;
+    ModbusFrameView view;
+    uint32_t assembled = 0;
+    uint32_t checksum = 0;
+
+    uint32_t allocationsBefore = allocations.load();
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        pushFragmented(reassembler, statusFrame, sizeof(statusFrame), DEFAULT_MTU_PAYLOAD, i);
+        while (reassembler.nextFrame(view)) {
+            assembled++;
+            checksum += view.registerAt(i % 40);
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    uint32_t allocationsDuring = allocations.load() - allocationsBefore;
+
+    TEST_ASSERT_EQUAL_UINT32(FRAMES, assembled);
+    TEST_ASSERT_EQUAL_UINT32(0, allocationsDuring);
+    TEST_ASSERT_EQUAL_UINT32(FRAMES, reassembler.getFragmentedFrames());
+    TEST_ASSERT_EQUAL_UINT32(0, reassembler.getRejectedTotal());
+
+    char line[128];
+    snprintf(line, sizeof(line), "%.0f frames/s (85 bytes in %u-byte fragments), %u allocations, checksum %u",
+             FRAMES / elapsed, (unsigned)DEFAULT_MTU_PAYLOAD, allocationsDuring, checksum);
+    TEST_MESSAGE(line);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_frame_in_one_notification);
+    RUN_TEST(test_frame_split_at_default_mtu);
+    RUN_TEST(test_every_split_point_yields_the_same_frame);
+    RUN_TEST(test_resyncs_after_garbage_and_bad_crc);
+    RUN_TEST(test_stale_fragment_is_dropped);
+    RUN_TEST(test_benchmark_frames_per_second_without_allocations);
+    return UNITY_END();
+}
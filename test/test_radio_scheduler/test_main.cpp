@@ -0,0 +1,197 @@
+#include <unity.h>
+#include <cstdint>
+#include <cstdio>
+#include "radio_scheduler.h"
+
+static constexpr size_t PEERS = 3;
+
+// Пристрій у мініатюрі: налаштування з'єднання триває setupTicks ітерацій
+// (або одразу провалюється), після нього пристрій відправляє запит щоразу,
+// коли має що відправити і отримав слот
+struct SimulatedPeer {
+    bool wantsSetup = false;
+    bool failsSetup = false;     // Спроба відразу повертає в IDLE і хоче нову
+    unsigned setupTicks = 0;
+    unsigned setupLeft = 0;
+    bool online = false;
+    bool alwaysReady = true;     // Черга запитів ніколи не порожніє
+    unsigned pending = 0;
+
+    unsigned grants = 0;
+    unsigned dispatches = 0;
+    unsigned loops = 0;
+
+    bool wantsLinkSetup(unsigned long) const { return wantsSetup && setupLeft == 0; }
+    bool inLinkSetup() const { return setupLeft > 0; }
+
+    bool loop(const RadioSlot& slot) {
+        loops++;
+        if (slot.maySetup) {
+            grants++;
+            if (failsSetup) {
+                return false;
+            }
+            wantsSetup = false;
+            setupLeft = setupTicks;
+        }
+        if (setupLeft > 0 && --setupLeft == 0) {
+            online = true;
+        }
+        bool ready = online && (alwaysReady || pending > 0);
+        if (!slot.mayDispatch || !ready) {
+            return false;
+        }
+        if (pending > 0) {
+            pending--;
+        }
+        dispatches++;
+        return true;
+    }
+};
+
+static SimulatedPeer peers[PEERS];
+static RadioScheduler<PEERS> scheduler;
+
+// Одна ітерація BLE worker, як у BluettiManager::loop(); перевіряє інваріанти
+static int tick(unsigned long now) {
+    unsigned before[PEERS];
+    for (size_t i = 0; i < PEERS; i++) {
+        before[i] = peers[i].dispatches;
+    }
+    int grant = scheduler.grantSetup(peers, now);
+    if (grant >= 0) {
+        TEST_ASSERT_TRUE(peers[grant].wantsLinkSetup(now));
+    }
+    int dispatcher = scheduler.run(peers, grant);
+
+    unsigned sent = 0;
+    unsigned settingUp = 0;
+    for (size_t i = 0; i < PEERS; i++) {
+        TEST_ASSERT_EQUAL(now + 1, peers[i].loops); // Кожен обслуговується щоітерації
+        sent += peers[i].dispatches - before[i];
+        settingUp += peers[i].inLinkSetup() ? 1 : 0;
+    }
+    TEST_ASSERT_TRUE(sent <= 1);
+    TEST_ASSERT_TRUE(settingUp <= 1);
+    TEST_ASSERT_EQUAL(sent == 1, dispatcher >= 0);
+    return grant;
+}
+
+void setUp(void) {
+    for (SimulatedPeer& peer : peers) {
+        peer = SimulatedPeer();
+    }
+    scheduler = RadioScheduler<PEERS>();
+}
+
+void tearDown(void) {}
+
+void test_one_setup_at_a_time(void) {
+    for (SimulatedPeer& peer : peers) {
+        peer.wantsSetup = true;
+        peer.setupTicks = 20;
+    }
+    int order[PEERS];
+    size_t granted = 0;
+    for (unsigned long now = 0; now < 100; now++) {
+        int grant = tick(now);
+        if (grant >= 0) {
+            order[granted++] = grant;
+        }
+    }
+    // Налаштування по черзі, кожен рівно один раз, і всі врешті онлайн
+    TEST_ASSERT_EQUAL(PEERS, granted);
+    for (size_t i = 0; i < PEERS; i++) {
+        TEST_ASSERT_EQUAL((int)i, order[i]);
+        TEST_ASSERT_EQUAL(1, peers[i].grants);
+        TEST_ASSERT_TRUE(peers[i].online);
+    }
+}
+
+void test_dispatch_round_robin(void) {
+    for (SimulatedPeer& peer : peers) {
+        peer.online = true;
+    }
+    const unsigned long ticks = 3000;
+    for (unsigned long now = 0; now < ticks; now++) {
+        tick(now);
+    }
+    char message[64];
+    for (size_t i = 0; i < PEERS; i++) {
+        snprintf(message, sizeof(message), "peer %u: %u dispatches", (unsigned)i, peers[i].dispatches);
+        TEST_MESSAGE(message);
+        TEST_ASSERT_EQUAL(ticks / PEERS, peers[i].dispatches);
+    }
+}
+
+void test_busy_peer_does_not_starve_others(void) {
+    // Пристрій 0 завжди має запит; решта - лише зрідка. Кожен запит решти
+    // має піти в ефір не пізніше ніж за PEERS ітерацій
+    for (SimulatedPeer& peer : peers) {
+        peer.online = true;
+    }
+    peers[1].alwaysReady = false;
+    peers[2].alwaysReady = false;
+    unsigned long queuedAt[PEERS] = {};
+    unsigned long worstWait = 0;
+    for (unsigned long now = 0; now < 3000; now++) {
+        for (size_t i = 1; i < PEERS; i++) {
+            if (peers[i].pending == 0 && now % (7 + i) == 0) {
+                peers[i].pending = 1;
+                queuedAt[i] = now;
+            }
+        }
+        unsigned sentBefore[PEERS] = {peers[0].dispatches, peers[1].dispatches, peers[2].dispatches};
+        tick(now);
+        for (size_t i = 1; i < PEERS; i++) {
+            if (peers[i].dispatches != sentBefore[i]) {
+                unsigned long wait = now - queuedAt[i];
+                worstWait = wait > worstWait ? wait : worstWait;
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(worstWait < PEERS);
+    TEST_ASSERT_TRUE(peers[0].dispatches > peers[1].dispatches);
+    TEST_ASSERT_TRUE(peers[1].dispatches > 0 && peers[2].dispatches > 0);
+}
+
+void test_failing_setup_does_not_starve_others(void) {
+    // Пристрій 0 без кінця провалює спроби й одразу хоче наступну
+    peers[0].wantsSetup = true;
+    peers[0].failsSetup = true;
+    peers[1].wantsSetup = true;
+    peers[1].setupTicks = 5;
+    peers[2].wantsSetup = true;
+    peers[2].setupTicks = 5;
+    for (unsigned long now = 0; now < 30; now++) {
+        tick(now);
+    }
+    TEST_ASSERT_TRUE(peers[1].online);
+    TEST_ASSERT_TRUE(peers[2].online);
+    TEST_ASSERT_TRUE(peers[0].grants > 1);
+}
+
+void test_dispatch_continues_during_setup(void) {
+    // Довге сканування одного пристрою не зупиняє опитування підключених
+    peers[0].online = true;
+    peers[1].online = true;
+    peers[2].wantsSetup = true;
+    peers[2].setupTicks = 500;
+    for (unsigned long now = 0; now < 400; now++) {
+        tick(now);
+    }
+    TEST_ASSERT_TRUE(peers[2].inLinkSetup());
+    TEST_ASSERT_EQUAL(2, scheduler.setupOwner());
+    TEST_ASSERT_EQUAL(200, peers[0].dispatches);
+    TEST_ASSERT_EQUAL(200, peers[1].dispatches);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_one_setup_at_a_time);
+    RUN_TEST(test_dispatch_round_robin);
+    RUN_TEST(test_busy_peer_does_not_starve_others);
+    RUN_TEST(test_failing_setup_does_not_starve_others);
+    RUN_TEST(test_dispatch_continues_during_setup);
+    return UNITY_END();
+}
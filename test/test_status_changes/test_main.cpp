@@ -0,0 +1,139 @@
+#include <unity.h>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include "status_changes.h"
+
+static BluettiRecord base;
+
+// Типовий кадр EB3A: заряджається від мережі, AC-вихід під навантаженням
+static void fillBase(BluettiRecord& record) {
+    memset(&record, 0, sizeof(record));
+    record.bluettiConnected = true;
+    record.batteryLevel = 84;
+    record.acPower = 17;
+    record.dcPower = 0;
+    record.inputPower = 122;
+    record.acInputPower = 122;
+    record.acOutputState = true;
+    record.ledMode = 4;
+    record.ecoShutdown = 1;
+    record.batteryVoltage = 537;
+    record.batteryRaw = 84;
+    record.temperature = 250;
+    record.maxDcLimit = 84;
+    memcpy(record.modelName, "EB3A", 5);
+    for (size_t i = 0; i < STATUS_REGISTER_COUNT; i++) {
+        record.registers[i] = (uint16_t)(i * 37);
+    }
+    record.lastBluettiUpdate = 1000;
+}
+
+void setUp(void) {
+    fillBase(base);
+}
+
+void tearDown(void) {}
+
+// Зміна одного поля позначає рівно свою групу
+template <typename Mutate>
+static void expectDirty(StatusGroup group, Mutate mutate) {
+    BluettiRecord next = base;
+    mutate(next);
+    TEST_ASSERT_EQUAL_HEX16(statusBit(group), diffBluettiRecords(base, next));
+}
+
+void test_each_field_marks_its_group(void) {
+    expectDirty(StatusGroup::CONNECTION, [](BluettiRecord& r) { r.bluettiConnected = false; });
+    expectDirty(StatusGroup::BATTERY, [](BluettiRecord& r) { r.batteryLevel = 85; });
+    expectDirty(StatusGroup::BATTERY, [](BluettiRecord& r) { r.batteryRaw = 1019; });
+    expectDirty(StatusGroup::BATTERY, [](BluettiRecord& r) { r.batteryVoltage = 536; });
+    expectDirty(StatusGroup::AC_POWER, [](BluettiRecord& r) { r.acPower = 18; });
+    expectDirty(StatusGroup::DC_POWER, [](BluettiRecord& r) { r.dcPower = 5; });
+    expectDirty(StatusGroup::INPUT_POWER, [](BluettiRecord& r) { r.inputPower = 0; });
+    expectDirty(StatusGroup::INPUT_POWER, [](BluettiRecord& r) { r.dcInputPower = 90; });
+    expectDirty(StatusGroup::INPUT_POWER, [](BluettiRecord& r) { r.acInputPower = 0; });
+    expectDirty(StatusGroup::OUTPUT_STATES, [](BluettiRecord& r) { r.acOutputState = false; });
+    expectDirty(StatusGroup::OUTPUT_STATES, [](BluettiRecord& r) { r.dcOutputState = true; });
+    expectDirty(StatusGroup::TEMPERATURE, [](BluettiRecord& r) { r.temperature = 251; });
+    expectDirty(StatusGroup::SETTINGS, [](BluettiRecord& r) { r.ecoMode = true; });
+    expectDirty(StatusGroup::SETTINGS, [](BluettiRecord& r) { r.powerLifting = true; });
+    expectDirty(StatusGroup::SETTINGS, [](BluettiRecord& r) { r.ledMode = 1; });
+    expectDirty(StatusGroup::SETTINGS, [](BluettiRecord& r) { r.ecoShutdown = 2; });
+    expectDirty(StatusGroup::SETTINGS, [](BluettiRecord& r) { r.chargingSpeed = 2; });
+    expectDirty(StatusGroup::DEVICE_INFO, [](BluettiRecord& r) { r.maxDcLimit = 0; });
+    expectDirty(StatusGroup::DEVICE_INFO, [](BluettiRecord& r) { r.modelName[3] = 'B'; });
+    expectDirty(StatusGroup::REGISTERS, [](BluettiRecord& r) { r.registers[STATUS_REGISTER_COUNT - 1]++; });
+}
+
+void test_unchanged_and_bookkeeping_fields(void) {
+    BluettiRecord next = base;
+    TEST_ASSERT_EQUAL_HEX16(0, diffBluettiRecords(base, next));
+    // Час оновлення та попередня маска - не дані: групу не позначають
+    next.lastBluettiUpdate = 5000;
+    next.dirty = STATUS_DIRTY_ALL;
+    TEST_ASSERT_EQUAL_HEX16(0, diffBluettiRecords(base, next));
+
+    next.acPower = 900;
+    next.inputPower = 1022;
+    next.registers[28] = 900;
+    TEST_ASSERT_EQUAL_HEX16(statusBit(StatusGroup::AC_POWER) | statusBit(StatusGroup::INPUT_POWER) |
+                                statusBit(StatusGroup::REGISTERS),
+                            diffBluettiRecords(base, next));
+}
+
+void test_cursor_sees_only_its_groups(void) {
+    uint32_t versions[STATUS_GROUP_COUNT] = {};
+    StatusChangeCursor display(statusBit(StatusGroup::BATTERY) | statusBit(StatusGroup::AC_POWER));
+    TEST_ASSERT_EQUAL_HEX16(statusBit(StatusGroup::BATTERY) | statusBit(StatusGroup::AC_POWER),
+                            display.take(versions));
+    TEST_ASSERT_EQUAL_HEX16(0, display.take(versions));
+    versions[static_cast<size_t>(StatusGroup::TEMPERATURE)]++;
+    TEST_ASSERT_EQUAL_HEX16(0, display.take(versions));
+    versions[static_cast<size_t>(StatusGroup::AC_POWER)]++;
+    TEST_ASSERT_EQUAL_HEX16(statusBit(StatusGroup::AC_POWER), display.take(versions));
+}
+
+template <typename Prepare>
+static double nanosecondsPerDiff(Prepare prepare, uint32_t rounds, uint32_t& sink) {
+    BluettiRecord next = base;
+    auto started = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < rounds; i++) {
+        prepare(next, i);
+        sink += diffBluettiRecords(base, next);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return elapsed * 1e9 / rounds;
+}
+
+void test_benchmark_diff_per_frame(void) {
+    static constexpr uint32_t ROUNDS = 1000000;
+    uint32_t sink = 0;
+    // Найчастіший випадок: нічого не змінилося (порівнюються всі 40 регістрів)
+    double unchanged = nanosecondsPerDiff(
+        [](BluettiRecord& r, uint32_t i) { r.lastBluettiUpdate = i; }, ROUNDS, sink);
+    // Потужність шумить щокадру - змінюються поле та його регістр
+    double noisy = nanosecondsPerDiff(
+        [](BluettiRecord& r, uint32_t i) {
+            r.acPower = 17 + (i & 3);
+            r.registers[28] = (uint16_t)r.acPower;
+        },
+        ROUNDS, sink);
+
+    char line[128];
+    snprintf(line, sizeof(line), "Dirty-mask diff per frame: unchanged %.1f ns, power change %.1f ns, sink %u",
+             unchanged, noisy, sink);
+    TEST_MESSAGE(line);
+    // Навіть на ESP32 (у ~10 разів повільніший) - частки мікросекунди на кадр
+    TEST_ASSERT_TRUE(unchanged < 200.0);
+    TEST_ASSERT_TRUE(noisy < 200.0);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_each_field_marks_its_group);
+    RUN_TEST(test_unchanged_and_bookkeeping_fields);
+    RUN_TEST(test_cursor_sees_only_its_groups);
+    RUN_TEST(test_benchmark_diff_per_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,97 @@
+#include <unity.h>
+#include <cstring>
+#include "device_profile.h"
+#include "register_map.h"
+#include "status_pages.h"
+
+// Регістрів в одній notification при заданому ATT MTU (як refreshLinkMtu)
+static uint16_t perNotification(uint16_t mtu) {
+    return (mtu - 3 - 5) / 2;
+}
+
+static uint8_t block[STATUS_REGISTER_COUNT * 2];
+
+void setUp(void) {
+    // EB3A: "EB3A" у 0x000E-0x000F, SoC 84% у 0x002B, AC in 122 W, AC out 17 W
+    memset(block, 0, sizeof(block));
+    memcpy(block + 8, "EB3A", 4);
+    block[(0x002B - 0x000A) * 2 + 1] = 84;
+    block[(0x0025 - 0x000A) * 2 + 1] = 122;
+    block[(0x0026 - 0x000A) * 2 + 1] = 17;
+}
+
+void tearDown(void) {}
+
+void test_page_size_follows_mtu(void) {
+    // Пристрій не погодив MTU - один запит, фрагменти збирає reassembler
+    TEST_ASSERT_EQUAL_UINT16(40, statusPageSize(40, perNotification(23), false));
+    TEST_ASSERT_EQUAL_UINT16(40, statusPageSize(40, 0, true));
+    // Більший, але недостатній MTU - сторінки по одній notification
+    TEST_ASSERT_EQUAL_UINT16(21, statusPageSize(40, perNotification(50), true));
+    TEST_ASSERT_EQUAL_UINT16(8, statusPageSize(40, perNotification(24), true));
+    // Весь блок вміщується - один запит
+    TEST_ASSERT_EQUAL_UINT16(40, statusPageSize(40, perNotification(88), true));
+    TEST_ASSERT_EQUAL_UINT16(40, statusPageSize(40, perNotification(517), true));
+}
+
+void test_pages_reassemble_the_block(void) {
+    const DeviceProfile& profile = defaultDeviceProfile();
+    SystemStatus whole = {};
+    decodeRegisterBlock(profile.statusMap, profile.statusMapSize, profile.statusBase, block,
+                        STATUS_REGISTER_COUNT, whole);
+    TEST_ASSERT_EQUAL(84, whole.batteryLevel);
+    TEST_ASSERT_EQUAL(17, whole.acPower);
+
+    for (uint16_t mtu = 24; mtu < 88; mtu++) {
+        uint16_t pageSize = statusPageSize(STATUS_REGISTER_COUNT, perNotification(mtu), true);
+        StatusPageAssembler pages;
+        pages.begin(STATUS_REGISTER_COUNT);
+        unsigned count = 0;
+        for (uint16_t offset = 0; offset < STATUS_REGISTER_COUNT; offset += pageSize) {
+            uint16_t registers = STATUS_REGISTER_COUNT - offset < pageSize ? STATUS_REGISTER_COUNT - offset : pageSize;
+            // Кожна відповідь разом із заголовком і CRC вміщується в notification
+            TEST_ASSERT_TRUE(5 + registers * 2 <= mtu - 3);
+            TEST_ASSERT_FALSE(pages.complete());
+            TEST_ASSERT_TRUE(pages.accept(offset, block + offset * 2, registers));
+            count++;
+        }
+        TEST_ASSERT_TRUE(pages.complete());
+        TEST_ASSERT_TRUE(count <= 5);
+        TEST_ASSERT_EQUAL_UINT8_ARRAY(block, pages.payload(), sizeof(block));
+
+        SystemStatus paged = {};
+        decodeRegisterBlock(profile.statusMap, profile.statusMapSize, profile.statusBase, pages.payload(),
+                            pages.registerCount(), paged);
+        TEST_ASSERT_EQUAL_STRING(whole.modelName, paged.modelName);
+        TEST_ASSERT_EQUAL(whole.batteryLevel, paged.batteryLevel);
+        TEST_ASSERT_EQUAL(whole.acPower, paged.acPower);
+        TEST_ASSERT_EQUAL(whole.acInputPower, paged.acInputPower);
+    }
+}
+
+void test_lost_page_drops_the_block(void) {
+    StatusPageAssembler pages;
+    pages.begin(STATUS_REGISTER_COUNT);
+    TEST_ASSERT_TRUE(pages.accept(0, block, 21));
+    // Друга сторінка не прийшла (таймаут) - третя не на своєму місці
+    TEST_ASSERT_FALSE(pages.accept(30, block + 60, 10));
+    TEST_ASSERT_FALSE(pages.complete());
+    TEST_ASSERT_FALSE(pages.accept(21, block + 42, 19));
+    // Наступне опитування починає з першої сторінки
+    pages.begin(STATUS_REGISTER_COUNT);
+    TEST_ASSERT_TRUE(pages.accept(0, block, 21));
+    TEST_ASSERT_TRUE(pages.accept(21, block + 42, 19));
+    TEST_ASSERT_TRUE(pages.complete());
+    // Без begin() (перша сторінка втрачена) нічого не збирається
+    StatusPageAssembler late;
+    TEST_ASSERT_FALSE(late.accept(21, block + 42, 19));
+    TEST_ASSERT_FALSE(late.complete());
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_page_size_follows_mtu);
+    RUN_TEST(test_pages_reassemble_the_block);
+    RUN_TEST(test_lost_page_drops_the_block);
+    return UNITY_END();
+}
@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "seqlock.h"
+#include "system_status.h"
+
+// Як у BluettiDevice: сирі регістри потужності лежать у блоці з 0x000A
+static constexpr uint16_t STATUS_BASE = 0x000A;
+static constexpr uint16_t DC_INPUT_REGISTER = 0x0024;
+static constexpr uint16_t AC_INPUT_REGISTER = 0x0025;
+
+static void fillStatus(SystemStatus& status, uint32_t i) {
+    // Сонце + мережа разом - сотні ват на кожному вході
+    status.dcInputPower = 100 + i % 900;
+    status.acInputPower = 200 + (i * 7) % 1500;
+    status.inputPower = status.dcInputPower + status.acInputPower;
+    status.acPower = (int)(i % 1800);
+    status.batteryLevel = i % 101;
+    status.registers[DC_INPUT_REGISTER - STATUS_BASE] = status.dcInputPower;
+    status.registers[AC_INPUT_REGISTER - STATUS_BASE] = status.acInputPower;
+    status.lastBluettiUpdate = i;
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_input_power_above_255_w_survives_the_snapshot(void) {
+    SeqLock<SystemStatus> snapshot;
+    SystemStatus status;
+    status.dcInputPower = 320;
+    status.acInputPower = 410;
+    status.inputPower = status.dcInputPower + status.acInputPower;
+    snapshot.write(status);
+
+    SystemStatus view;
+    TEST_ASSERT_EQUAL_UINT32(1, snapshot.read(view));
+    TEST_ASSERT_EQUAL_INT(730, view.inputPower);
+    TEST_ASSERT_EQUAL_INT(view.dcInputPower + view.acInputPower, view.inputPower);
+}
+
+void test_concurrent_readers_see_consistent_snapshots(void) {
+    // loop() пише, дисплей, вебсервер і MQTT читають одночасно
+    static constexpr uint32_t WRITES = 300000;
+    static constexpr int READERS = 3;
+    static SeqLock<SystemStatus> snapshot;
+    static std::atomic<bool> done{false};
+
+    std::thread writer([] {
+        SystemStatus status;
+        for (uint32_t i = 1; i <= WRITES; i++) {
+            fillStatus(status, i);
+            snapshot.write(status);
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    struct ReaderResult {
+        uint32_t reads = 0;
+        uint32_t broken = 0;      // inputPower != DC + AC або розбіжність з регістрами
+        uint32_t wentBack = 0;    // Версія зменшилася
+        uint32_t stale = 0;       // Версія не відповідає вмісту знімка
+        int maxInputPower = 0;
+    };
+    ReaderResult results[READERS];
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&results, r] {
+            ReaderResult& result = results[r];
+            SystemStatus view;
+            uint32_t lastVersion = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                uint32_t version = snapshot.read(view);
+                if (version == 0) {
+                    continue;
+                }
+                result.reads++;
+                SystemStatus expected;
+                fillStatus(expected, view.lastBluettiUpdate);
+                if (view.inputPower != view.dcInputPower + view.acInputPower ||
+                    view.registers[DC_INPUT_REGISTER - STATUS_BASE] != view.dcInputPower ||
+                    view.registers[AC_INPUT_REGISTER - STATUS_BASE] != view.acInputPower ||
+                    view.acPower != expected.acPower || view.batteryLevel != expected.batteryLevel) {
+                    result.broken++;
+                }
+                if (version < lastVersion) {
+                    result.wentBack++;
+                }
+                if (version != view.lastBluettiUpdate) {
+                    result.stale++;
+                }
+                if (view.inputPower > result.maxInputPower) {
+                    result.maxInputPower = view.inputPower;
+                }
+                lastVersion = version;
+            }
+        });
+    }
+
+    writer.join();
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    SystemStatus last;
+    TEST_ASSERT_EQUAL_UINT32(WRITES, snapshot.read(last));
+    TEST_ASSERT_EQUAL_UINT32(WRITES, last.lastBluettiUpdate);
+    uint32_t totalReads = 0;
+    for (int r = 0; r < READERS; r++) {
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].broken);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].wentBack);
+        TEST_ASSERT_EQUAL_UINT32(0, results[r].stale);
+        totalReads += results[r].reads;
+        if (results[r].reads > 0) {
+            TEST_ASSERT_GREATER_THAN(255, results[r].maxInputPower);
+        }
+    }
+    TEST_ASSERT_GREATER_THAN_UINT32(0, totalReads);
+
+    char line[96];
+    snprintf(line, sizeof(line), "%u writes, %u consistent reads by %d readers", WRITES, totalReads, READERS);
+    TEST_MESSAGE(line);
+}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_input_power_above_255_w_survives_the_snapshot);
+    RUN_TEST(test_concurrent_readers_see_consistent_snapshots);
+    return UNITY_END();
+}